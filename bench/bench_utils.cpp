@@ -0,0 +1,53 @@
+#include "bench_utils.h"
+
+#include <boost/format.hpp>
+
+#include <fstream>
+
+using namespace std;
+
+namespace gamgee {
+namespace bench {
+
+BenchmarkRunner::BenchmarkRunner(const BenchmarkOptions& options) :
+  m_options {options},
+  m_results {}
+{}
+
+bool BenchmarkRunner::enabled(const std::string& name) const {
+  return m_options.filter.empty() || name.find(m_options.filter) != string::npos;
+}
+
+bool BenchmarkRunner::suite_enabled(const std::string& suite) const {
+  return m_options.suite.empty() || m_options.suite == suite;
+}
+
+void BenchmarkRunner::add_result(const BenchmarkResult& result) {
+  m_results.push_back(result);
+  if (!m_options.csv)  ///< give some feedback while long benchmark suites are running
+    cerr << "finished " << result.name << endl;
+}
+
+void BenchmarkRunner::report(std::ostream& out) const {
+  if (m_options.csv) {
+    out << "benchmark,axis,axis_value,records,bytes,seconds,records_per_second,mb_per_second,allocations,allocated_bytes,allocations_per_record,ns_per_record_per_unit" << endl;
+    for (const auto& r : m_results)
+      out << boost::format("%s,%s,%d,%d,%d,%.6f,%.1f,%.2f,%d,%d,%.3f,%.3f") % r.name % r.axis % r.axis_value % r.records % r.bytes % r.seconds %
+        r.records_per_second() % r.megabytes_per_second() % r.allocations % r.allocated_bytes % r.allocations_per_record() % r.nanoseconds_per_record_per_unit() << endl;
+    return;
+  }
+  out << boost::format("%-56s %12s %10s %14s %10s %12s") % "benchmark" % "records" % "seconds" % "records/s" % "MB/s" % "allocs/rec" << endl;
+  for (const auto& r : m_results) {
+    const auto name = r.axis.empty() ? r.name : (boost::format("%s [%s=%d]") % r.name % r.axis % r.axis_value).str();
+    out << boost::format("%-56s %12d %10.4f %14.0f %10.2f %12.3f") % name % r.records % r.seconds %
+      r.records_per_second() % r.megabytes_per_second() % r.allocations_per_record() << endl;
+  }
+}
+
+uint64_t file_size(const std::string& filename) {
+  auto in = ifstream{filename, ios::binary | ios::ate};
+  return in ? uint64_t(in.tellg()) : 0;
+}
+
+}  // end of namespace bench
+}  // end of namespace gamgee
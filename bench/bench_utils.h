@@ -0,0 +1,155 @@
+#ifndef gamgee__bench_utils__guard
+#define gamgee__bench_utils__guard
+
+#include "utils/allocation_counter.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gamgee {
+namespace bench {
+
+/**
+ * @brief command line configurable options shared by all benchmarks
+ */
+struct BenchmarkOptions {
+  uint64_t seed = 42;                     ///< seed for the synthetic data generator (same seed => byte-identical inputs)
+  uint32_t scale = 1;                     ///< multiplier applied to the default number of synthetic records
+  uint32_t repetitions = 3;               ///< number of times each benchmark is run (the fastest run is reported)
+  std::string filter = "";                ///< only run benchmarks whose name contains this string
+  std::string work_dir = "bench_data";    ///< directory where the synthetic inputs are written
+  std::string suite = "";                 ///< only run this benchmark suite (sam, fastq, reference or variant)
+  uint32_t max_samples = 10000;           ///< largest sample count in the variant scaling benchmarks
+  uint32_t max_inputs = 100;              ///< largest number of input files in the multi-file variant scaling benchmarks
+  bool csv = false;                       ///< report results as CSV instead of a human readable table
+};
+
+/**
+ * @brief outcome of a single benchmark (fastest repetition)
+ */
+struct BenchmarkResult {
+  std::string name;         ///< name of the benchmark
+  std::string axis;         ///< name of the scaling parameter (e.g. "samples"), empty if this is not a scaling benchmark
+  uint64_t axis_value;      ///< value of the scaling parameter for this run (1 if this is not a scaling benchmark)
+  uint64_t records;         ///< number of records processed in one repetition
+  uint64_t bytes;           ///< number of input bytes processed in one repetition (0 if not meaningful)
+  double seconds;           ///< wall clock time of the fastest repetition
+  uint64_t allocations;     ///< heap allocations (including htslib's, see utils::allocation_counting_includes_malloc()) made during the fastest repetition
+  uint64_t allocated_bytes; ///< bytes requested in those allocations
+
+  double records_per_second() const { return seconds > 0 ? records / seconds : 0.0; }
+  double megabytes_per_second() const { return seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0; }
+  double allocations_per_record() const { return records > 0 ? double(allocations) / records : 0.0; }
+  double nanoseconds_per_record_per_unit() const { return records > 0 ? seconds * 1e9 / records / axis_value : 0.0; } ///< e.g. cost per sample per record
+};
+
+/**
+ * @brief runs benchmarks, keeps the results and reports them
+ *
+ * Each benchmark is a callable that processes some records and returns how many it processed. The
+ * runner times it, counts the heap allocations it made and keeps the fastest of all repetitions:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * runner.run("sam_iterator", file_size(bam), [&bam]() {
+ *   auto records = 0u;
+ *   for (const auto& record : SingleSamReader{bam})
+ *     ++records;
+ *   return records;
+ * });
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class BenchmarkRunner {
+ public:
+  explicit BenchmarkRunner(const BenchmarkOptions& options);
+
+  /**
+   * @brief whether or not a benchmark with this name passes the user provided filter
+   */
+  bool enabled(const std::string& name) const;
+
+  /**
+   * @brief whether or not the suite with this name should run
+   */
+  bool suite_enabled(const std::string& suite) const;
+
+  /**
+   * @brief times body over all repetitions and records the fastest one
+   *
+   * @param name the name of the benchmark (used for filtering and reporting)
+   * @param bytes number of input bytes processed by one call to body (used for MB/s)
+   * @param body callable returning the number of records it processed
+   */
+  template<class BODY>
+  void run(const std::string& name, const uint64_t bytes, BODY&& body) {
+    run(name, "", 1, bytes, std::forward<BODY>(body));
+  }
+
+  /**
+   * @brief times body over all repetitions and records the fastest one as a point of a scaling curve
+   *
+   * @param name the name of the benchmark (used for filtering and reporting)
+   * @param axis the name of the scaling parameter (e.g. "samples" or "inputs")
+   * @param axis_value the value of the scaling parameter for this point of the curve
+   * @param bytes number of input bytes processed by one call to body (used for MB/s)
+   * @param body callable returning the number of records it processed
+   */
+  template<class BODY>
+  void run(const std::string& name, const std::string& axis, const uint64_t axis_value, const uint64_t bytes, BODY&& body) {
+    if (!enabled(name))
+      return;
+    auto best = BenchmarkResult{name, axis, axis_value, 0, bytes, 0.0, 0, 0};
+    for (auto repetition = 0u; repetition < m_options.repetitions; ++repetition) {
+      const auto allocations = utils::AllocationScope{};
+      const auto start = std::chrono::steady_clock::now();
+      const auto records = uint64_t(body());
+      const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      const auto counts = allocations.counts();
+      if (repetition == 0 || elapsed < best.seconds) {
+        best.records = records;
+        best.seconds = elapsed;
+        best.allocations = counts.allocations;
+        best.allocated_bytes = counts.bytes;
+      }
+    }
+    add_result(best);
+  }
+
+  /**
+   * @brief records a result that was measured outside of run() (e.g. with a custom timing loop)
+   */
+  void add_result(const BenchmarkResult& result);
+
+  /**
+   * @brief writes all results collected so far in the format chosen in the options
+   */
+  void report(std::ostream& out) const;
+
+  const BenchmarkOptions& options() const { return m_options; }
+  const std::vector<BenchmarkResult>& results() const { return m_results; }
+
+ private:
+  BenchmarkOptions m_options;
+  std::vector<BenchmarkResult> m_results;
+};
+
+/**
+ * @brief size of a file in bytes (0 if the file can't be opened)
+ */
+uint64_t file_size(const std::string& filename);
+
+/**
+ * @brief prevents the compiler from optimizing away a computation whose result is otherwise unused
+ */
+template<class T>
+inline void do_not_optimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+}  // end of namespace bench
+}  // end of namespace gamgee
+
+#endif // gamgee__bench_utils__guard
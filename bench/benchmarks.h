@@ -0,0 +1,23 @@
+#ifndef gamgee__benchmarks__guard
+#define gamgee__benchmarks__guard
+
+#include "bench_utils.h"
+#include "synthetic_data.h"
+
+namespace gamgee {
+namespace bench {
+
+/**
+ * @brief every benchmark suite generates its inputs (in options().work_dir) with the shared
+ * generator and then runs its benchmarks through the runner. The reference is always generated
+ * (by main) before any suite runs.
+ */
+void sam_benchmarks(BenchmarkRunner& runner, SyntheticDataGenerator& generator);       ///< SamIterator, tags, Cigar, ReadBases and BaseQuals
+void fastq_benchmarks(BenchmarkRunner& runner, SyntheticDataGenerator& generator);     ///< FastqIterator
+void reference_benchmarks(BenchmarkRunner& runner, SyntheticDataGenerator& generator); ///< ReferenceMap loading and get_sequence
+void variant_benchmarks(BenchmarkRunner& runner, SyntheticDataGenerator& generator);   ///< scaling of the variant API with the number of samples and of input files
+
+}  // end of namespace bench
+}  // end of namespace gamgee
+
+#endif // gamgee__benchmarks__guard
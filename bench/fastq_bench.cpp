@@ -0,0 +1,63 @@
+#include "benchmarks.h"
+
+#include "fastq_reader.h"
+#include "interval.h"
+#include "reference_map.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace gamgee {
+namespace bench {
+
+void fastq_benchmarks(BenchmarkRunner& runner, SyntheticDataGenerator& generator) {
+  const auto n_records = 200000u * runner.options().scale;
+  const auto fastq = runner.options().work_dir + "/reads.fq";
+  generator.write_fastq(fastq, n_records, 101);
+
+  runner.run("fastq_iterator/fastq", file_size(fastq), [&fastq]() {
+    auto records = 0u;
+    auto checksum = 0ull;
+    for (const auto& record : FastqReader{fastq}) {
+      checksum += record.sequence().size();
+      ++records;
+    }
+    do_not_optimize(checksum);
+    return records;
+  });
+}
+
+void reference_benchmarks(BenchmarkRunner& runner, SyntheticDataGenerator& generator) {
+  const auto reference = runner.options().work_dir + "/reference.fa";
+
+  runner.run("reference_map/load", file_size(reference), [&reference]() {
+    const auto reference_map = ReferenceMap{reference};
+    return reference_map.size();
+  });
+
+  const auto reference_map = ReferenceMap{reference};
+  const auto n_queries = 1000000u * runner.options().scale;
+  auto intervals = vector<Interval>{};
+  intervals.reserve(n_queries);
+  for (auto i = 0u; i < n_queries; ++i) {
+    const auto chr = generator.uniform(generator.chromosome_names().size());
+    const auto length = 1 + generator.uniform(300);
+    const auto start = 1 + generator.uniform(generator.chromosome_sequences()[chr].size() - length);
+    intervals.emplace_back(generator.chromosome_names()[chr], start, start + length - 1);
+  }
+
+  for (const auto reverse_strand : {false, true}) {
+    runner.run(reverse_strand ? "reference_map/get_sequence_reverse" : "reference_map/get_sequence", 0, [&]() {
+      auto checksum = 0ull;
+      for (const auto& interval : intervals)
+        checksum += reference_map.get_sequence(interval, reverse_strand).size();
+      do_not_optimize(checksum);
+      return intervals.size();
+    });
+  }
+}
+
+}  // end of namespace bench
+}  // end of namespace gamgee
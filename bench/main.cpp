@@ -0,0 +1,88 @@
+#include "benchmarks.h"
+
+#include <sys/stat.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace gamgee::bench;
+
+namespace {
+
+void usage(const char* program) {
+  cerr << "usage: " << program << " [options]\n"
+       << "  --seed N          seed for the synthetic data generator (default: 42)\n"
+       << "  --scale N         multiply the number of synthetic records by N (default: 1)\n"
+       << "  --repetitions N   run each benchmark N times and report the fastest (default: 3)\n"
+       << "  --filter STRING   only run benchmarks whose name contains STRING\n"
+       << "  --work-dir DIR    where to write the synthetic inputs (default: bench_data)\n"
+       << "  --suite NAME      only run one suite: sam, fastq, reference or variant (default: all)\n"
+       << "  --max-samples N   largest cohort in the variant sample scaling curves (default: 10000)\n"
+       << "  --max-inputs N    largest number of merged gVCFs in the variant input scaling curves (default: 100)\n"
+       << "  --csv             report results as CSV\n";
+}
+
+BenchmarkOptions parse_options(const int argc, char* argv[]) {
+  auto options = BenchmarkOptions{};
+  for (auto i = 1; i < argc; ++i) {
+    const auto option = string{argv[i]};
+    const auto next_value = [&]() {
+      if (i + 1 >= argc)
+        throw invalid_argument{"missing value for option " + option};
+      return string{argv[++i]};
+    };
+    if (option == "--seed") options.seed = stoull(next_value());
+    else if (option == "--scale") options.scale = stoul(next_value());
+    else if (option == "--repetitions") options.repetitions = stoul(next_value());
+    else if (option == "--filter") options.filter = next_value();
+    else if (option == "--work-dir") options.work_dir = next_value();
+    else if (option == "--suite") options.suite = next_value();
+    else if (option == "--max-samples") options.max_samples = stoul(next_value());
+    else if (option == "--max-inputs") options.max_inputs = stoul(next_value());
+    else if (option == "--csv") options.csv = true;
+    else throw invalid_argument{"unknown option " + option};
+  }
+  if (options.scale == 0 || options.repetitions == 0 || options.max_samples == 0 || options.max_inputs == 0)
+    throw invalid_argument{"--scale, --repetitions, --max-samples and --max-inputs must be positive"};
+  return options;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  if (argc > 1 && (string{argv[1]} == "--help" || string{argv[1]} == "-h")) {
+    usage(argv[0]);
+    return EXIT_SUCCESS;
+  }
+  auto options = BenchmarkOptions{};
+  try {
+    options = parse_options(argc, argv);
+  } catch (const exception& e) {
+    cerr << e.what() << endl;
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  mkdir(options.work_dir.c_str(), 0755);  ///< it's fine if it already exists
+
+  auto runner = BenchmarkRunner{options};
+  auto generator = SyntheticDataGenerator{options.seed};
+  generator.write_reference(options.work_dir + "/reference.fa", 4, 2000000 * options.scale);
+
+  // every suite restarts the random sequence so its inputs don't depend on which other suites ran
+  const auto suites = vector<pair<string, void(*)(BenchmarkRunner&, SyntheticDataGenerator&)>>{
+    {"sam", sam_benchmarks}, {"fastq", fastq_benchmarks}, {"reference", reference_benchmarks}, {"variant", variant_benchmarks}};
+  for (auto i = 0u; i < suites.size(); ++i) {
+    if (!runner.suite_enabled(suites[i].first))
+      continue;
+    generator.reseed(options.seed + i + 1);
+    suites[i].second(runner, generator);
+  }
+
+  runner.report(cout);
+  return EXIT_SUCCESS;
+}
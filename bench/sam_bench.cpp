@@ -0,0 +1,132 @@
+#include "benchmarks.h"
+
+#include "sam/sam_reader.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace gamgee {
+namespace bench {
+
+void sam_benchmarks(BenchmarkRunner& runner, SyntheticDataGenerator& generator) {
+  const auto n_records = 200000u * runner.options().scale;
+  const auto read_length = 101u;
+  const auto bam = runner.options().work_dir + "/reads.bam";
+  const auto sam = runner.options().work_dir + "/reads.sam";
+  generator.write_alignments(sam, bam, n_records, read_length);   // the same reads in both formats
+
+  /******************************************************************************
+   * End-to-end throughput                                                      *
+   ******************************************************************************/
+  for (const auto& input : {make_pair(string{"bam"}, bam), make_pair(string{"sam"}, sam)}) {
+    runner.run("sam_iterator/" + input.first, file_size(input.second), [&input]() {
+      auto records = 0u;
+      auto checksum = 0ull;
+      for (const auto& record : SingleSamReader{input.second}) {
+        checksum += record.alignment_start();
+        ++records;
+      }
+      do_not_optimize(checksum);
+      return records;
+    });
+  }
+
+  runner.run("sam_iterator/bam_full_decode", file_size(bam), [&bam]() {
+    auto records = 0u;
+    auto checksum = 0ull;
+    for (const auto& record : SingleSamReader{bam}) {
+      checksum += record.cigar().size() + record.bases().to_string().size() + record.base_quals().to_string().size();
+      checksum += record.integer_tag("NM").value() + record.string_tag("MD").value().size();
+      ++records;
+    }
+    do_not_optimize(checksum);
+    return records;
+  });
+
+  runner.run("sam_pair_iterator/bam", file_size(bam), [&bam]() {
+    auto records = 0u;
+    for (const auto& pair : PairSamReader{bam})
+      records += pair.second.empty() ? 1 : 2;
+    return records;
+  });
+
+  /******************************************************************************
+   * Micro-benchmarks over records already in memory                            *
+   ******************************************************************************/
+  auto records = vector<Sam>{};
+  records.reserve(n_records);
+  for (const auto& record : SingleSamReader{bam})
+    records.push_back(record);  ///< deep copies so the records outlive the iterator
+
+  runner.run("sam_tag/integer_tag", 0, [&records]() {
+    auto checksum = 0ll;
+    for (const auto& record : records)
+      checksum += record.integer_tag("NM").value();
+    do_not_optimize(checksum);
+    return records.size();
+  });
+
+  runner.run("sam_tag/string_tag", 0, [&records]() {
+    auto checksum = 0ull;
+    for (const auto& record : records)
+      checksum += record.string_tag("MD").value().size();
+    do_not_optimize(checksum);
+    return records.size();
+  });
+
+  runner.run("sam_tag/missing_tag", 0, [&records]() {
+    auto missing = 0u;
+    for (const auto& record : records)
+      missing += record.string_tag("XA").missing();
+    do_not_optimize(missing);
+    return records.size();
+  });
+
+  runner.run("cigar/iterate_elements", 0, [&records]() {
+    auto checksum = 0ull;
+    for (const auto& record : records) {
+      const auto cigar = record.cigar();
+      for (auto i = 0u; i < cigar.size(); ++i)
+        checksum += Cigar::cigar_oplen(cigar[i]);
+    }
+    do_not_optimize(checksum);
+    return records.size();
+  });
+
+  runner.run("cigar/to_string", 0, [&records]() {
+    auto checksum = 0ull;
+    for (const auto& record : records)
+      checksum += record.cigar().to_string().size();
+    do_not_optimize(checksum);
+    return records.size();
+  });
+
+  runner.run("read_bases/to_string", 0, [&records]() {
+    auto checksum = 0ull;
+    for (const auto& record : records)
+      checksum += record.bases().to_string().size();
+    do_not_optimize(checksum);
+    return records.size();
+  });
+
+  runner.run("base_quals/to_string", 0, [&records]() {
+    auto checksum = 0ull;
+    for (const auto& record : records)
+      checksum += record.base_quals().to_string().size();
+    do_not_optimize(checksum);
+    return records.size();
+  });
+
+  runner.run("sam/mate_alignment_stop", 0, [&records]() {
+    auto checksum = 0ull;
+    for (const auto& record : records)
+      checksum += record.mate_alignment_stop();
+    do_not_optimize(checksum);
+    return records.size();
+  });
+}
+
+}  // end of namespace bench
+}  // end of namespace gamgee
@@ -0,0 +1,353 @@
+#include "synthetic_data.h"
+
+#include "sam/sam_reader.h"
+#include "sam/sam_writer.h"
+#include "variant/variant_reader.h"
+#include "variant/variant_writer.h"
+
+#include <boost/format.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+namespace gamgee {
+namespace bench {
+
+namespace {
+
+constexpr auto ERROR_RATE = 0.01;  ///< per base probability of a sequencing error
+constexpr char BASES[] = "ACGT";
+
+/**
+ * @brief accumulates the MD tag of an alignment as its operations are walked
+ */
+class MdTagBuilder {
+ public:
+  void match() { ++m_run; }
+  void mismatch(const char reference_base) { m_md += to_string(m_run); m_md += reference_base; m_run = 0; }
+  void deletion(const string& reference_bases) { m_md += to_string(m_run) + "^" + reference_bases; m_run = 0; }
+  string finish() const { return m_md + to_string(m_run); }
+ private:
+  string m_md {};
+  uint32_t m_run {0};
+};
+
+/**
+ * @brief one simulated alignment (a single end of a pair)
+ */
+struct SyntheticAlignment {
+  uint32_t position;     ///< 0-based leftmost reference position
+  uint32_t reference_span;
+  string cigar;
+  string bases;
+  uint32_t edit_distance;
+  string md;
+};
+
+const auto FORMAT_FIELD_HEADERS = vector<pair<string, string>>{
+  {"GT", "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">"},
+  {"GQ", "##FORMAT=<ID=GQ,Number=1,Type=Integer,Description=\"Genotype Quality\">"},
+  {"DP", "##FORMAT=<ID=DP,Number=1,Type=Integer,Description=\"Approximate read depth\">"},
+  {"AD", "##FORMAT=<ID=AD,Number=R,Type=Integer,Description=\"Allelic depths for the ref and alt alleles\">"},
+  {"PL", "##FORMAT=<ID=PL,Number=G,Type=Integer,Description=\"Phred-scaled genotype likelihoods\">"},
+  {"SB", "##FORMAT=<ID=SB,Number=4,Type=Integer,Description=\"Per-sample strand bias counts\">"}
+};
+
+ofstream open_output(const std::string& filename) {
+  auto out = ofstream{filename};
+  if (!out)
+    throw runtime_error{"could not create synthetic data file " + filename};
+  return out;
+}
+
+}
+
+SyntheticDataGenerator::SyntheticDataGenerator(const uint64_t seed) :
+  m_random {seed},
+  m_chromosome_names {},
+  m_chromosome_sequences {}
+{}
+
+uint64_t SyntheticDataGenerator::uniform(const uint64_t n) {
+  return n == 0 ? 0 : m_random() % n;
+}
+
+bool SyntheticDataGenerator::chance(const double probability) {
+  return (m_random() >> 11) * (1.0 / 9007199254740992.0) < probability;  ///< 53 random bits mapped to [0,1)
+}
+
+void SyntheticDataGenerator::write_reference(const std::string& filename, const uint32_t n_chromosomes, const uint32_t chromosome_length) {
+  m_chromosome_names.clear();
+  m_chromosome_sequences.clear();
+  auto out = open_output(filename);
+  for (auto chr = 0u; chr < n_chromosomes; ++chr) {
+    auto sequence = string(chromosome_length, 'N');
+    for (auto& base : sequence)
+      base = BASES[uniform(4)];
+    out << ">chr" << chr + 1 << "\n";
+    for (auto i = 0u; i < chromosome_length; i += 60)
+      out << sequence.substr(i, 60) << "\n";
+    m_chromosome_names.push_back("chr" + to_string(chr + 1));
+    m_chromosome_sequences.push_back(move(sequence));
+  }
+}
+
+string SyntheticDataGenerator::random_quals(const uint32_t length) {
+  auto quals = string(length, '!');
+  for (auto i = 0u; i < length; ++i) {
+    const auto decay = i * 10 / length;  ///< qualities degrade towards the end of the read like in real Illumina data
+    const auto qual = chance(0.005) ? 2 : 40 - decay - uniform(6);
+    quals[i] = char(qual + 33);
+  }
+  return quals;
+}
+
+string SyntheticDataGenerator::mutate(const std::string& sequence) {
+  auto result = sequence;
+  for (auto& base : result)
+    if (chance(ERROR_RATE))
+      base = BASES[(string{BASES}.find(base) + 1 + uniform(3)) % 4];
+  return result;
+}
+
+void SyntheticDataGenerator::write_fastq(const std::string& filename, const uint32_t n_records, const uint32_t read_length) {
+  if (m_chromosome_sequences.empty())
+    throw logic_error{"a reference must be generated before simulating reads"};
+  auto out = open_output(filename);
+  for (auto i = 0u; i < n_records; ++i) {
+    const auto& chr = m_chromosome_sequences[uniform(m_chromosome_sequences.size())];
+    const auto start = uniform(chr.size() - read_length);
+    out << boost::format("@SYN:1:FC01:%d:%d:%d:%d 1:N:0:ACGTACGT\n") % (1 + i % 8) % (1101 + i % 16) % uniform(20000) % uniform(200000);
+    out << mutate(chr.substr(start, read_length)) << "\n+\n" << random_quals(read_length) << "\n";
+  }
+}
+
+void SyntheticDataGenerator::write_sam(const std::string& filename, const uint32_t n_records, const uint32_t read_length) {
+  if (m_chromosome_sequences.empty())
+    throw logic_error{"a reference must be generated before simulating reads"};
+
+  // simulates one end of a pair starting at position: mostly plain matches, with some soft-clips, insertions and deletions
+  const auto simulate = [this, read_length](const string& chr, const uint32_t position) {
+    auto operations = vector<pair<char, uint32_t>>{};
+    const auto kind = uniform(100);
+    if (kind < 85) {
+      operations = {{'M', read_length}};
+    } else if (kind < 92) {
+      const auto clip = uint32_t(1 + uniform(20));
+      operations = {{'S', clip}, {'M', read_length - clip}};
+    } else if (kind < 96) {
+      const auto length = uint32_t(1 + uniform(3));
+      const auto offset = uint32_t(10 + uniform(read_length - 20 - length));
+      operations = {{'M', offset}, {'I', length}, {'M', read_length - offset - length}};
+    } else {
+      const auto length = uint32_t(1 + uniform(3));
+      const auto offset = uint32_t(10 + uniform(read_length - 20));
+      operations = {{'M', offset}, {'D', length}, {'M', read_length - offset}};
+    }
+    auto alignment = SyntheticAlignment{position, 0, "", "", 0, ""};
+    auto md = MdTagBuilder{};
+    auto reference_position = position;
+    for (const auto& op : operations) {
+      alignment.cigar += to_string(op.second) + op.first;
+      switch (op.first) {
+        case 'S':
+          for (auto i = 0u; i < op.second; ++i)
+            alignment.bases += BASES[uniform(4)];
+          break;
+        case 'I':
+          for (auto i = 0u; i < op.second; ++i)
+            alignment.bases += BASES[uniform(4)];
+          alignment.edit_distance += op.second;
+          break;
+        case 'D':
+          md.deletion(chr.substr(reference_position, op.second));
+          reference_position += op.second;
+          alignment.edit_distance += op.second;
+          break;
+        default:
+          for (auto i = 0u; i < op.second; ++i, ++reference_position) {
+            const auto reference_base = chr[reference_position];
+            if (chance(ERROR_RATE)) {
+              alignment.bases += BASES[(string{BASES}.find(reference_base) + 1 + uniform(3)) % 4];
+              md.mismatch(reference_base);
+              ++alignment.edit_distance;
+            } else {
+              alignment.bases += reference_base;
+              md.match();
+            }
+          }
+      }
+    }
+    alignment.reference_span = reference_position - position;
+    alignment.md = md.finish();
+    return alignment;
+  };
+
+  auto records = vector<pair<pair<uint32_t, uint32_t>, string>>{};  ///< ((chromosome, position), sam line) so we can sort by coordinate
+  records.reserve(n_records);
+  for (auto fragment = 0u; records.size() < n_records; ++fragment) {
+    const auto chr_index = uint32_t(uniform(m_chromosome_sequences.size()));
+    const auto& chr = m_chromosome_sequences[chr_index];
+    const auto fragment_length = uint32_t(2 * read_length + 50 + uniform(200));
+    const auto start = uint32_t(uniform(chr.size() - fragment_length - 2 * read_length));
+    const auto first = simulate(chr, start);
+    const auto second = simulate(chr, start + fragment_length - read_length);
+    const auto insert_size = int32_t(second.position + second.reference_span - first.position);
+    const auto name = (boost::format("SYN:1:FC01:%d:%d:%d") % (1 + fragment % 8) % (1101 + fragment % 16) % fragment).str();
+    const auto mapq = chance(0.05) ? uniform(60) : 60;
+    const auto format_line = [&](const SyntheticAlignment& read, const SyntheticAlignment& mate, const uint32_t flag, const int32_t tlen) {
+      return (boost::format("%s\t%d\t%s\t%d\t%d\t%s\t=\t%d\t%d\t%s\t%s\tNM:i:%d\tMD:Z:%s\tAS:i:%d\tRG:Z:rg1\tMC:Z:%s") %
+          name % flag % m_chromosome_names[chr_index] % (read.position + 1) % mapq % read.cigar % (mate.position + 1) % tlen %
+          read.bases % random_quals(read_length) % read.edit_distance % read.md % (read_length - 4 * read.edit_distance) % mate.cigar).str();
+    };
+    records.emplace_back(make_pair(chr_index, first.position), format_line(first, second, 99, insert_size));
+    if (records.size() < n_records)
+      records.emplace_back(make_pair(chr_index, second.position), format_line(second, first, 147, -insert_size));
+  }
+  stable_sort(records.begin(), records.end(), [](const pair<pair<uint32_t, uint32_t>, string>& lhs, const pair<pair<uint32_t, uint32_t>, string>& rhs) { return lhs.first < rhs.first; });
+
+  auto out = open_output(filename);
+  out << "@HD\tVN:1.4\tSO:coordinate\n";
+  for (auto i = 0u; i < m_chromosome_names.size(); ++i)
+    out << "@SQ\tSN:" << m_chromosome_names[i] << "\tLN:" << m_chromosome_sequences[i].size() << "\n";
+  out << "@RG\tID:rg1\tSM:synthetic_sample\tPL:ILLUMINA\tLB:lib1\n";
+  out << "@PG\tID:gamgee_bench\tPN:gamgee_bench\n";
+  for (const auto& record : records)
+    out << record.second << "\n";
+}
+
+void SyntheticDataGenerator::write_bam(const std::string& filename, const uint32_t n_records, const uint32_t read_length) {
+  const auto sam_filename = filename + ".tmp.sam";
+  write_sam(sam_filename, n_records, read_length);
+  convert_sam_to_bam(sam_filename, filename);
+  remove(sam_filename.c_str());
+}
+
+void SyntheticDataGenerator::write_alignments(const std::string& sam_filename, const std::string& bam_filename, const uint32_t n_records,
+                                              const uint32_t read_length) {
+  write_sam(sam_filename, n_records, read_length);
+  convert_sam_to_bam(sam_filename, bam_filename);
+}
+
+void SyntheticDataGenerator::convert_sam_to_bam(const std::string& sam_filename, const std::string& bam_filename) {
+  auto reader = SingleSamReader{sam_filename};
+  auto writer = SamWriter{reader.header(), bam_filename};
+  for (const auto& record : reader)
+    writer.add_record(record);
+}  // writer goes out of scope here, flushing and closing the BAM file
+
+void SyntheticDataGenerator::write_vcf(const std::string& filename, const SyntheticVariantParameters& parameters) {
+  if (m_chromosome_sequences.empty())
+    throw logic_error{"a reference must be generated before simulating variants"};
+  if (parameters.n_format_fields > FORMAT_FIELD_HEADERS.size())
+    throw invalid_argument{"at most " + to_string(FORMAT_FIELD_HEADERS.size()) + " FORMAT fields are supported"};
+
+  auto out = open_output(filename);
+  out << "##fileformat=VCFv4.2\n";
+  out << "##INFO=<ID=END,Number=1,Type=Integer,Description=\"Stop position of the interval\">\n";
+  out << "##INFO=<ID=DP,Number=1,Type=Integer,Description=\"Approximate read depth\">\n";
+  out << "##ALT=<ID=NON_REF,Description=\"Represents any possible alternative allele at this location\">\n";
+  for (auto i = 0u; i < parameters.n_format_fields; ++i)
+    out << FORMAT_FIELD_HEADERS[i].second << "\n";
+  for (auto i = 0u; i < m_chromosome_names.size(); ++i)
+    out << "##contig=<ID=" << m_chromosome_names[i] << ",length=" << m_chromosome_sequences[i].size() << ">\n";
+  out << "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO";
+  if (parameters.n_format_fields > 0) {
+    out << "\tFORMAT";
+    for (auto sample = 0u; sample < parameters.n_samples; ++sample)
+      out << "\t" << parameters.sample_prefix << sample;
+  }
+  out << "\n";
+
+  auto format = string{};
+  for (auto i = 0u; i < parameters.n_format_fields; ++i)
+    format += (i == 0 ? "" : ":") + FORMAT_FIELD_HEADERS[i].first;
+
+  auto line = string{};
+  auto chr_index = 0u;
+  auto position = 1u;
+  for (auto record = 0u; record < parameters.n_records; ++record) {
+    const auto is_block = parameters.gvcf && record % 2 == 0;  ///< gVCFs alternate between reference blocks and variant sites
+    const auto length = is_block ? uint32_t(1 + uniform(2 * parameters.mean_block_length)) : 1u;
+    if (!parameters.gvcf)
+      position += uint32_t(uniform(2 * parameters.mean_block_length));  ///< without reference blocks the sites are spread out by a random gap
+    if (position + length >= m_chromosome_sequences[chr_index].size()) {
+      if (chr_index + 1 == m_chromosome_sequences.size())
+        break;  ///< ran out of reference
+      ++chr_index;
+      position = 1u;
+    }
+    const auto ref = m_chromosome_sequences[chr_index][position - 1];
+
+    auto alleles = vector<char>{ref};
+    if (!is_block) {
+      const auto n_alts = 1 + uniform(min(parameters.max_alt_alleles, 3u));  ///< single base alleles only, so at most 3 alts
+      for (auto base = (string{BASES}.find(ref) + 1 + uniform(3)) % 4; alleles.size() <= n_alts; base = (base + 1) % 4)
+        if (BASES[base] != ref)
+          alleles.push_back(BASES[base]);
+    }
+    const auto n_alleles = uint32_t(alleles.size() + (parameters.gvcf ? 1 : 0));  ///< gVCF records always carry <NON_REF>
+
+    line.clear();
+    line += m_chromosome_names[chr_index] + "\t" + to_string(position) + "\t.\t" + ref + "\t";
+    for (auto i = 1u; i < alleles.size(); ++i)
+      line += (i == 1 ? "" : ",") + string(1, alleles[i]);
+    if (parameters.gvcf)
+      line += alleles.size() > 1 ? ",<NON_REF>" : "<NON_REF>";
+    line += is_block ? "\t.\t.\t" : "\t" + to_string(20 + uniform(1000)) + "\tPASS\t";
+    line += is_block ? "END=" + to_string(position + length - 1) + ";DP=" + to_string(10 + uniform(40)) : "DP=" + to_string(10 + uniform(40));
+    if (parameters.n_format_fields > 0)
+      line += "\t" + format;
+
+    for (auto sample = 0u; sample < parameters.n_samples && parameters.n_format_fields > 0; ++sample) {
+      const auto missing = chance(0.02);
+      const auto first = is_block || chance(0.7) ? 0u : uint32_t(uniform(alleles.size()));
+      const auto second = is_block || chance(0.5) ? first : uint32_t(uniform(alleles.size()));
+      const auto depth = uint32_t(uniform(60));
+      for (auto field = 0u; field < parameters.n_format_fields; ++field) {
+        line += field == 0 ? "\t" : ":";
+        switch (field) {
+          case 0:  // GT
+            line += missing ? "./." : to_string(min(first, second)) + "/" + to_string(max(first, second));
+            break;
+          case 1:  // GQ
+          case 2:  // DP
+            line += missing ? "." : to_string(field == 1 ? uniform(100) : depth);
+            break;
+          case 3:  // AD
+            for (auto allele = 0u; allele < n_alleles; ++allele)
+              line += (allele == 0 ? "" : ",") + (missing ? string{"."} : to_string(allele == first || allele == second ? depth / 2 : 0));
+            break;
+          case 4:  // PL
+            for (auto genotype = 0u; genotype < n_alleles * (n_alleles + 1) / 2; ++genotype)
+              line += (genotype == 0 ? "" : ",") + (missing ? string{"."} : to_string(uniform(1000)));
+            break;
+          default: // SB
+            line += missing ? ".,.,.,." : to_string(depth / 4) + "," + to_string(depth / 4) + "," + to_string(uniform(10)) + "," + to_string(uniform(10));
+        }
+      }
+    }
+    out << line << "\n";
+    position += length;
+  }
+}
+
+void SyntheticDataGenerator::write_bcf(const std::string& filename, const SyntheticVariantParameters& parameters) {
+  const auto vcf_filename = filename + ".tmp.vcf";
+  write_vcf(vcf_filename, parameters);
+  {
+    auto reader = SingleVariantReader{vcf_filename};
+    auto writer = VariantWriter{reader.header(), filename};
+    for (const auto& record : reader)
+      writer.add_record(record);
+  }  // writer goes out of scope here, flushing and closing the BCF file
+  remove(vcf_filename.c_str());
+}
+
+}  // end of namespace bench
+}  // end of namespace gamgee
@@ -0,0 +1,112 @@
+#ifndef gamgee__synthetic_data__guard
+#define gamgee__synthetic_data__guard
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace gamgee {
+namespace bench {
+
+/**
+ * @brief shape of the synthetic VCF/BCF/gVCF files produced by SyntheticDataGenerator
+ */
+struct SyntheticVariantParameters {
+  uint32_t n_samples = 1;                ///< number of samples (columns) in the file
+  uint32_t n_records = 1000;             ///< number of records (variant sites plus reference blocks)
+  uint32_t n_format_fields = 4;          ///< number of FORMAT fields per record, taken in order from GT, GQ, DP, AD, PL and SB
+  uint32_t max_alt_alleles = 2;          ///< variant sites have between 1 and max_alt_alleles (at most 3) alternate alleles
+  bool gvcf = false;                     ///< whether to emit reference blocks (<NON_REF> with END) between the variant sites
+  uint32_t mean_block_length = 50;       ///< average length of a reference block (gVCF) or of the gap between sites (VCF)
+  std::string sample_prefix = "SAMPLE";  ///< samples are named sample_prefix0, sample_prefix1, ...
+};
+
+/**
+ * @brief deterministic generator of realistic looking sequencing data for the benchmarks
+ *
+ * Every file is a pure function of the seed and the requested sizes, so two runs (or two machines)
+ * with the same parameters benchmark exactly the same bytes. To guarantee that, the generator only
+ * uses the raw output of std::mt19937_64 (whose sequence is fixed by the standard) and never the
+ * implementation-defined std:: distributions.
+ *
+ * A reference has to be generated first; reads (FASTQ/SAM/BAM) are then sampled from it with
+ * sequencing errors, soft-clips, small indels, paired-end structure and the usual tags (NM, MD, AS,
+ * RG and MC):
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * auto generator = SyntheticDataGenerator{42};
+ * generator.write_reference("ref.fa", 4, 1000000);
+ * generator.write_bam("reads.bam", 100000, 101);
+ * generator.write_fastq("reads.fq", 100000, 101);
+ * generator.write_bcf("cohort.bcf", SyntheticVariantParameters{1000, 5000});
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class SyntheticDataGenerator {
+ public:
+  explicit SyntheticDataGenerator(const uint64_t seed);
+
+  /**
+   * @brief creates a random reference and writes it as a FASTA file (60 bases per line)
+   * @param filename output file
+   * @param n_chromosomes number of contigs (named chr1, chr2, ...)
+   * @param chromosome_length length of each contig
+   */
+  void write_reference(const std::string& filename, const uint32_t n_chromosomes, const uint32_t chromosome_length);
+
+  /**
+   * @brief writes n_records unaligned reads sampled from the reference as a FASTQ file
+   */
+  void write_fastq(const std::string& filename, const uint32_t n_records, const uint32_t read_length);
+
+  /**
+   * @brief writes n_records coordinate sorted paired-end alignments as a SAM text file
+   * @note every call draws new reads, use write_alignments() to get the same reads in SAM and BAM
+   */
+  void write_sam(const std::string& filename, const uint32_t n_records, const uint32_t read_length);
+
+  /**
+   * @brief writes n_records coordinate sorted paired-end alignments as a BAM file
+   * @note the records are generated as SAM text (in a temporary file next to the output) and converted by gamgee's SamWriter
+   */
+  void write_bam(const std::string& filename, const uint32_t n_records, const uint32_t read_length);
+
+  /**
+   * @brief writes the same n_records coordinate sorted paired-end alignments both as a SAM text file and as a BAM file
+   *
+   * The reads are simulated once, so the two files can be compared format against format.
+   */
+  void write_alignments(const std::string& sam_filename, const std::string& bam_filename, const uint32_t n_records, const uint32_t read_length);
+
+  /**
+   * @brief writes a coordinate sorted VCF (text) file with variants (and optionally reference blocks) on the reference
+   */
+  void write_vcf(const std::string& filename, const SyntheticVariantParameters& parameters);
+
+  /**
+   * @brief writes a coordinate sorted BCF file with variants (and optionally reference blocks) on the reference
+   * @note the records are generated as VCF text (in a temporary file next to the output) and converted by gamgee's VariantWriter
+   */
+  void write_bcf(const std::string& filename, const SyntheticVariantParameters& parameters);
+
+  const std::vector<std::string>& chromosome_names() const { return m_chromosome_names; }
+  const std::vector<std::string>& chromosome_sequences() const { return m_chromosome_sequences; }
+
+  void reseed(const uint64_t seed) { m_random.seed(seed); } ///< @brief restarts the random sequence (keeps the reference)
+  uint64_t uniform(const uint64_t n);  ///< @brief uniformly distributed integer in [0, n)
+  bool chance(const double probability); ///< @brief true with the given probability
+
+ private:
+  std::mt19937_64 m_random;
+  std::vector<std::string> m_chromosome_names;
+  std::vector<std::string> m_chromosome_sequences;
+
+  std::string random_quals(const uint32_t length);
+  std::string mutate(const std::string& sequence);
+  static void convert_sam_to_bam(const std::string& sam_filename, const std::string& bam_filename);
+};
+
+}  // end of namespace bench
+}  // end of namespace gamgee
+
+#endif // gamgee__synthetic_data__guard
@@ -0,0 +1,417 @@
+#include "benchmarks.h"
+
+#include "prefetching_reader.h"
+#include "variant/genotype_matrix.h"
+#include "variant/genotype_summary.h"
+#include "variant/gvcf_combiner.h"
+#include "variant/multiple_variant_reader.h"
+#include "variant/multiple_variant_iterator.h"
+#include "variant/packed_genotypes.h"
+#include "variant/reference_block_splitting_variant_iterator.h"
+#include "variant/sample_predicate.h"
+#include "variant/site_statistics.h"
+#include "variant/variant_builder.h"
+#include "variant/variant_reader.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+namespace gamgee {
+namespace bench {
+
+namespace {
+
+/**
+ * @brief geometric series 1, 10, 100, ... up to (and including) max_value
+ */
+vector<uint32_t> scaling_points(const uint32_t max_value) {
+  auto points = vector<uint32_t>{};
+  for (auto point = 1ull; point < max_value; point *= 10)
+    points.push_back(uint32_t(point));
+  points.push_back(max_value);
+  return points;
+}
+
+void sample_scaling_benchmarks(BenchmarkRunner& runner, SyntheticDataGenerator& generator, const uint32_t n_samples) {
+  // keep the total number of genotypes roughly constant at the high end so the largest cohorts finish in reasonable time
+  const auto n_records = max(100u, min(5000u, 5000000u / n_samples)) * runner.options().scale;
+  const auto prefix = runner.options().work_dir + "/cohort_" + to_string(n_samples);
+  auto parameters = SyntheticVariantParameters{};
+  parameters.n_samples = n_samples;
+  parameters.n_records = n_records;
+  parameters.n_format_fields = 5;
+  generator.write_vcf(prefix + ".vcf", parameters);
+  generator.write_bcf(prefix + ".bcf", parameters);
+
+  for (const auto& extension : {string{"vcf"}, string{"bcf"}}) {
+    const auto filename = prefix + "." + extension;
+    runner.run("variant_iterator/" + extension, "samples", n_samples, file_size(filename), [&filename]() {
+      auto records = 0u;
+      auto checksum = 0ull;
+      for (const auto& record : SingleVariantReader{filename}) {
+        checksum += record.alignment_start();
+        ++records;
+      }
+      do_not_optimize(checksum);
+      return records;
+    });
+  }
+
+  const auto bcf = prefix + ".bcf";
+  runner.run("variant_iterator/bcf_alt_alleles", "samples", n_samples, file_size(bcf), [&bcf]() {
+    auto records = 0u;
+    auto checksum = 0ull;
+    for (const auto& record : SingleVariantReader{bcf}) {
+      checksum += record.alt().size();
+      ++records;
+    }
+    do_not_optimize(checksum);
+    return records;
+  });
+
+  runner.run("variant_iterator/bcf_sites_only", "samples", n_samples, file_size(bcf), [&bcf]() {
+    auto records = 0u;
+    auto checksum = 0ull;
+    for (const auto& record : SingleVariantReader{bcf, VariantReaderOptions{0, VariantUnpackLevel::INFO}}) {
+      checksum += record.alt().size();
+      ++records;
+    }
+    do_not_optimize(checksum);
+    return records;
+  });
+
+  runner.run("genotypes/hom_ref", "samples", n_samples, file_size(bcf), [&bcf]() {
+    auto records = 0u;
+    auto hom_ref = 0ull;
+    for (const auto& record : SingleVariantReader{bcf}) {
+      for (const auto& genotype : record.genotypes())
+        hom_ref += genotype.hom_ref();
+      ++records;
+    }
+    do_not_optimize(hom_ref);
+    return records;
+  });
+
+  runner.run("site_statistics/stream", "samples", n_samples, file_size(bcf), [&bcf]() {
+    auto reader = SingleVariantReader{bcf};
+    const auto table = SiteStatisticsEngine::stream(reader);
+    do_not_optimize(table.totals.titv().transitions);
+    return table.size();
+  });
+
+  runner.run("genotypes/summary", "samples", n_samples, file_size(bcf), [&bcf]() {
+    auto records = 0u;
+    auto hom_ref = 0ull;
+    auto summary = GenotypeSummary{};
+    for (const auto& record : SingleVariantReader{bcf}) {
+      summary.assign(record);
+      hom_ref += summary.hom_ref();
+      ++records;
+    }
+    do_not_optimize(hom_ref);
+    return records;
+  });
+
+  runner.run("genotypes/hom_ref_prefetching", "samples", n_samples, file_size(bcf), [&bcf]() {
+    auto records = 0u;
+    auto hom_ref = 0ull;
+    for (const auto& record : PrefetchingReader<SingleVariantReader>{SingleVariantReader{bcf}}) {
+      for (const auto& genotype : record.genotypes())
+        hom_ref += genotype.hom_ref();
+      ++records;
+    }
+    do_not_optimize(hom_ref);
+    return records;
+  });
+
+  runner.run("genotypes/allele_keys", "samples", n_samples, file_size(bcf), [&bcf]() {
+    auto records = 0u;
+    auto checksum = 0ull;
+    for (const auto& record : SingleVariantReader{bcf}) {
+      for (const auto& genotype : record.genotypes())
+        checksum += genotype.allele_keys().size();
+      ++records;
+    }
+    do_not_optimize(checksum);
+    return records;
+  });
+
+  runner.run("genotype_matrix/dosage", "samples", n_samples, file_size(bcf), [&bcf, n_samples]() {
+    auto reader = SingleVariantReader{bcf};
+    auto matrix = GenotypeMatrix{n_samples, 256};
+    const auto builder = GenotypeMatrixBuilder{};
+    auto it = reader.begin();
+    const auto end = reader.end();
+    auto records = 0u;
+    auto checksum = 0ll;
+    while (const auto n_variants = builder.fill(it, end, matrix)) {
+      checksum += matrix(0, n_variants - 1);
+      records += n_variants;
+    }
+    do_not_optimize(checksum);
+    return records;
+  });
+
+  runner.run("packed_genotypes/allele_count", "samples", n_samples, file_size(bcf), [&bcf]() {
+    auto records = 0u;
+    auto checksum = 0ull;
+    auto packed = PackedGenotypes{};
+    for (const auto& record : SingleVariantReader{bcf}) {
+      packed.assign(record);
+      checksum += packed.allele_count();
+      ++records;
+    }
+    do_not_optimize(checksum);
+    return records;
+  });
+
+  runner.run("individual_field/integer_gq", "samples", n_samples, file_size(bcf), [&bcf]() {
+    auto records = 0u;
+    auto checksum = 0ll;
+    for (const auto& record : SingleVariantReader{bcf}) {
+      for (const auto& value : record.integer_individual_field("GQ"))
+        checksum += value[0];
+      ++records;
+    }
+    do_not_optimize(checksum);
+    return records;
+  });
+
+  runner.run("individual_field/handle_gq", "samples", n_samples, file_size(bcf), [&bcf]() {
+    auto records = 0u;
+    auto checksum = 0ll;
+    auto reader = SingleVariantReader{bcf};
+    const auto gq = FieldHandle<int32_t>::individual(reader.header(), "GQ");
+    for (const auto& record : reader) {
+      for (const auto& value : record.individual_field(gq))
+        checksum += value[0];
+      ++records;
+    }
+    do_not_optimize(checksum);
+    return records;
+  });
+
+  runner.run("select/gq_select_if", "samples", n_samples, file_size(bcf), [&bcf]() {
+    auto records = 0u;
+    auto checksum = 0ull;
+    for (const auto& record : SingleVariantReader{bcf}) {
+      const auto gqs = record.integer_individual_field("GQ");
+      checksum += Variant::select_if(gqs.begin(), gqs.end(), [](const auto& gq) { return gq[0] >= 20; }).count();
+      ++records;
+    }
+    do_not_optimize(checksum);
+    return records;
+  });
+
+  runner.run("select/gq_sample_predicate", "samples", n_samples, file_size(bcf), [&bcf]() {
+    auto records = 0u;
+    auto checksum = 0ull;
+    const auto high_gq = SamplePredicate::greater_equal(20);
+    for (const auto& record : SingleVariantReader{bcf}) {
+      checksum += high_gq.select(record, "GQ").count();
+      ++records;
+    }
+    do_not_optimize(checksum);
+    return records;
+  });
+
+  runner.run("individual_field/integer_pl", "samples", n_samples, file_size(bcf), [&bcf]() {
+    auto records = 0u;
+    auto checksum = 0ll;
+    for (const auto& record : SingleVariantReader{bcf}) {
+      for (const auto& value : record.integer_individual_field("PL"))
+        for (const auto pl : value)
+          checksum += pl;
+      ++records;
+    }
+    do_not_optimize(checksum);
+    return records;
+  });
+
+  runner.run("individual_field/typed_gq", "samples", n_samples, file_size(bcf), [&bcf]() {
+    auto records = 0u;
+    auto checksum = 0ll;
+    for (const auto& record : SingleVariantReader{bcf}) {
+      checksum += record.visit_individual_field("GQ", [](const auto& gq) {
+        auto sum = 0ll;
+        for (auto sample = 0u; sample < gq.n_samples(); ++sample)
+          sum += gq.value(sample, 0);
+        return sum;
+      });
+      ++records;
+    }
+    do_not_optimize(checksum);
+    return records;
+  });
+
+  runner.run("individual_field/typed_pl", "samples", n_samples, file_size(bcf), [&bcf]() {
+    auto records = 0u;
+    auto checksum = 0ll;
+    for (const auto& record : SingleVariantReader{bcf}) {
+      checksum += record.visit_individual_field("PL", [](const auto& pl) {
+        using traits = typename std::decay_t<decltype(pl)>::traits;
+        const auto values = pl.data();
+        const auto n_values = size_t{pl.n_samples()} * pl.values_per_sample();
+        auto sum = 0ll;
+        for (auto i = size_t{0}; i < n_values; ++i)
+          sum += traits::is_value(values[i]) ? values[i] : 0;
+        return sum;
+      });
+      ++records;
+    }
+    do_not_optimize(checksum);
+    return records;
+  });
+
+  const auto header = SingleVariantReader{bcf}.header();
+  auto builder = VariantBuilder{header};
+  auto genotypes = builder.get_genotype_multi_sample_vector(n_samples, 2);
+  auto genotype_qualities = builder.get_integer_multi_sample_vector(n_samples, 1);
+  for (auto sample = 0u; sample < n_samples; ++sample) {
+    genotypes.set_sample_value(sample, 0, 0);
+    genotypes.set_sample_value(sample, 1, generator.uniform(2));
+    genotype_qualities.set_sample_value(sample, 0, generator.uniform(100));
+  }
+  const auto gq_index = uint32_t(header.field_index("GQ"));
+  runner.run("variant_builder/build", "samples", n_samples, 0, [&]() {
+    auto checksum = 0ull;
+    for (auto record = 0u; record < n_records; ++record) {
+      builder.set_chromosome(0).set_alignment_start(record + 1).set_ref_allele("A").set_alt_allele("C");
+      builder.set_genotypes(genotypes).set_integer_individual_field(gq_index, genotype_qualities);
+      checksum += builder.build().alignment_start();
+    }
+    do_not_optimize(checksum);
+    return n_records;
+  });
+  auto variant = Variant{};
+  runner.run("variant_builder/build_into", "samples", n_samples, 0, [&]() {
+    auto checksum = 0ull;
+    for (auto record = 0u; record < n_records; ++record) {
+      builder.set_chromosome(0).set_alignment_start(record + 1).set_ref_allele("A").set_alt_allele("C");
+      builder.set_genotypes(genotypes).set_integer_individual_field(gq_index, genotype_qualities);
+      builder.build_into(variant);
+      checksum += variant.alignment_start();
+    }
+    do_not_optimize(checksum);
+    return n_records;
+  });
+  // the same values, set as columns of a row per sample table that the builder reads in place
+  struct SampleCall { int32_t alleles[2]; int32_t gq; };
+  auto calls = vector<SampleCall>(n_samples);
+  for (auto sample = 0u; sample < n_samples; ++sample)
+    calls[sample] = SampleCall{{0, int32_t(generator.uniform(2))}, int32_t(generator.uniform(100))};
+  const auto stride = uint32_t(sizeof(SampleCall) / sizeof(int32_t));
+  runner.run("variant_builder/build_columns", "samples", n_samples, 0, [&]() {
+    auto checksum = 0ull;
+    for (auto record = 0u; record < n_records; ++record) {
+      builder.set_chromosome(0).set_alignment_start(record + 1).set_ref_allele("A").set_alt_allele("C");
+      builder.set_genotypes(VariantBuilderColumn<int32_t>{calls[0].alleles, 2, stride})
+             .set_integer_individual_field(gq_index, VariantBuilderColumn<int32_t>{&calls[0].gq, 1, stride});
+      builder.build_into(variant);
+      checksum += variant.alignment_start();
+    }
+    do_not_optimize(checksum);
+    return n_records;
+  });
+  // and with the two fields encoded at the same time, however small the records
+  builder.set_encoding_threads(2, 0);
+  runner.run("variant_builder/build_columns_parallel", "samples", n_samples, 0, [&]() {
+    auto checksum = 0ull;
+    for (auto record = 0u; record < n_records; ++record) {
+      builder.set_chromosome(0).set_alignment_start(record + 1).set_ref_allele("A").set_alt_allele("C");
+      builder.set_genotypes(VariantBuilderColumn<int32_t>{calls[0].alleles, 2, stride})
+             .set_integer_individual_field(gq_index, VariantBuilderColumn<int32_t>{&calls[0].gq, 1, stride});
+      builder.build_into(variant);
+      checksum += variant.alignment_start();
+    }
+    do_not_optimize(checksum);
+    return n_records;
+  });
+}
+
+template<class ITERATOR>
+void merge_benchmark(BenchmarkRunner& runner, const std::string& name, const vector<string>& inputs,
+                     const VariantReaderOptions& options = VariantReaderOptions{}) {
+  auto bytes = 0ull;
+  for (const auto& input : inputs)
+    bytes += file_size(input);
+  runner.run(name, "inputs", inputs.size(), bytes, [&inputs, &options]() {
+    auto records = 0u;
+    for (const auto& position : MultipleVariantReader<ITERATOR>{inputs, false, options})
+      records += position.size();
+    return records;
+  });
+}
+
+void header_merge_benchmark(BenchmarkRunner& runner, const std::string& name, const vector<string>& inputs, const uint32_t n_threads) {
+  const auto headers = MultipleVariantReader<MultipleVariantIterator>{inputs, false}.get_input_vcf_headers();
+  runner.run(name, "inputs", inputs.size(), 0, [&headers, n_threads]() {
+    auto merger = InputOrderedVariantHeaderMerger{};
+    merger.add_headers(headers, n_threads);
+    return uint32_t(bcf_hdr_nsamples(merger.get_raw_merged_header()));
+  });
+}
+
+void combine_benchmark(BenchmarkRunner& runner, const vector<string>& inputs) {
+  auto bytes = 0ull;
+  for (const auto& input : inputs)
+    bytes += file_size(input);
+  runner.run("gvcf_combiner/combine", "inputs", inputs.size(), bytes, [&inputs]() {
+    auto reader = MultipleVariantReader<ReferenceBlockSplittingVariantIterator>{inputs, false};
+    auto combiner = GVCFCombiner{reader.get_variant_header_merger(), reader.get_input_vcf_headers()};
+    auto positions = 0u;
+    auto checksum = 0ull;
+    for (const auto& records : reader) {
+      checksum += combiner.combine(records).n_alleles();
+      ++positions;
+    }
+    do_not_optimize(checksum);
+    return positions;
+  });
+}
+
+}
+
+void variant_benchmarks(BenchmarkRunner& runner, SyntheticDataGenerator& generator) {
+  /******************************************************************************
+   * Scaling with the number of samples in a single file                        *
+   ******************************************************************************/
+  for (const auto n_samples : scaling_points(runner.options().max_samples))
+    sample_scaling_benchmarks(runner, generator, n_samples);
+
+  /******************************************************************************
+   * Scaling with the number of single sample gVCFs being merged                *
+   ******************************************************************************/
+  auto gvcfs = vector<string>{};
+  for (auto input = 0u; input < runner.options().max_inputs; ++input) {
+    auto parameters = SyntheticVariantParameters{};
+    parameters.n_records = 2000 * runner.options().scale;
+    parameters.n_format_fields = 6;
+    parameters.gvcf = true;
+    parameters.sample_prefix = "GVCF" + to_string(input) + "_";
+    gvcfs.push_back(runner.options().work_dir + "/input_" + to_string(input) + ".g.bcf");
+    generator.write_bcf(gvcfs.back(), parameters);
+  }
+  for (const auto n_inputs : scaling_points(runner.options().max_inputs)) {
+    const auto inputs = vector<string>(gvcfs.begin(), gvcfs.begin() + n_inputs);
+    merge_benchmark<MultipleVariantIterator>(runner, "multiple_variant_iterator/gvcf", inputs);
+    merge_benchmark<ReferenceBlockSplittingVariantIterator>(runner, "reference_block_splitting/gvcf", inputs);
+    combine_benchmark(runner, inputs);
+    header_merge_benchmark(runner, "variant_header_merger/add_headers", inputs, 1);
+    header_merge_benchmark(runner, "variant_header_merger/add_headers_threads", inputs, std::max(std::thread::hardware_concurrency(), 1u));
+    auto options = VariantReaderOptions{};
+    options.decoding_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    merge_benchmark<MultipleVariantIterator>(runner, "multiple_variant_iterator/gvcf_decoding_threads", inputs, options);
+    auto budgeted_options = VariantReaderOptions{};
+    budgeted_options.max_open_files = std::max(n_inputs / 10, 1u);
+    merge_benchmark<MultipleVariantIterator>(runner, "multiple_variant_iterator/gvcf_max_open_files", inputs, budgeted_options);
+  }
+}
+
+}  // end of namespace bench
+}  // end of namespace gamgee
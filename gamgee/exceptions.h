@@ -3,6 +3,7 @@
 
 #include <boost/format.hpp>
 
+#include <cstdint>
 #include <exception>
 #include <string>
 
@@ -62,6 +63,15 @@ class HtslibException : public std::runtime_error {
     std::runtime_error{(boost::format("Error: htslib failed with error code %d.  See stderr for details.") % error_code).str()} { }
 };
 
+/**
+ * @brief an exception class for records added out of order to an indexed output
+ */
+class UnsortedRecordException : public std::runtime_error {
+ public:
+  UnsortedRecordException(const std::string& chrom_name, const uint32_t position) :
+    std::runtime_error{(boost::format("Error: record at %s:%d is out of order in an indexed output") % chrom_name % position).str()} { }
+};
+
 /**
  * @brief an exception class for the case where a chromosome is not found in the reference
  */
@@ -7,6 +7,7 @@
 #include "fastq_reader.h"
 #include "interval.h"
 #include "missing.h"
+#include "prefetching_reader.h"
 #include "reference_iterator.h"
 #include "reference_map.h"
 #include "zip.h"
@@ -14,6 +15,7 @@
 #include "utils/file_utils.h"
 #include "utils/genotype_utils.h"
 #include "utils/hts_memory.h"
+#include "utils/loser_tree.h"
 #include "utils/merged_vcf_lut.h"
 #include "utils/short_value_optimized_storage.h"
 #include "utils/utils.h"
@@ -35,7 +37,13 @@
 #include "sam/sam_tag.h"
 #include "sam/sam_writer.h"
 
+#include "variant/budgeted_variant_inputs.h"
+#include "variant/field_handle.h"
+#include "variant/field_slot_table.h"
 #include "variant/genotype.h"
+#include "variant/genotype_matrix.h"
+#include "variant/genotype_summary.h"
+#include "variant/gvcf_combiner.h"
 #include "variant/indexed_variant_iterator.h"
 #include "variant/indexed_variant_reader.h"
 #include "variant/individual_field.h"
@@ -44,17 +52,27 @@
 #include "variant/individual_field_value_iterator.h"
 #include "variant/multiple_variant_iterator.h"
 #include "variant/multiple_variant_reader.h"
+#include "variant/packed_genotypes.h"
 #include "variant/reference_block_splitting_variant_iterator.h"
+#include "variant/sample_mask.h"
+#include "variant/sample_predicate.h"
+#include "variant/sharded_variant_reader.h"
 #include "variant/shared_field.h"
 #include "variant/shared_field_iterator.h"
+#include "variant/site_statistics.h"
 #include "variant/synced_variant_iterator.h"
 #include "variant/synced_variant_reader.h"
+#include "variant/typed_field_value.h"
+#include "variant/typed_individual_field.h"
+#include "variant/typed_shared_field.h"
 #include "variant/variant.h"
 #include "variant/variant_builder.h"
+#include "variant/variant_builder_column.h"
 #include "variant/variant_builder_individual_field.h"
 #include "variant/variant_builder_individual_region.h"
 #include "variant/variant_builder_multi_sample_vector.h"
 #include "variant/variant_builder_shared_region.h"
+#include "variant/variant_decoding_pool.h"
 #include "variant/variant_filters.h"
 #include "variant/variant_filters_iterator.h"
 #include "variant/variant_header.h"
@@ -0,0 +1,387 @@
+#ifndef gamgee__prefetching_reader__guard
+#define gamgee__prefetching_reader__guard
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace gamgee {
+
+namespace utils {
+
+/**
+ * @brief single producer, single consumer ring of reusable records shared by a PrefetchingIterator and its
+ * background thread
+ *
+ * The producer copies records into the slots (reusing their memory) and publishes them by advancing the
+ * tail. The consumer reads the slot at the head and releases it by advancing the head. Both indices only
+ * grow, so the ring never needs a lock. A thread only blocks (on the condition variable) when the ring is
+ * full or empty; the other side wakes it up only if it's actually parked.
+ */
+template<class RECORD>
+class PrefetchingRing {
+ public:
+  explicit PrefetchingRing(const uint32_t capacity) :
+    m_slots(capacity == 0 ? 1 : capacity),
+    m_head {0},
+    m_tail {0},
+    m_finished {false},
+    m_cancelled {false},
+    m_consumer_parked {false},
+    m_producer_parked {false},
+    m_error {},
+    m_mutex {},
+    m_condition {}
+  {}
+
+  PrefetchingRing(const PrefetchingRing&) = delete;
+  PrefetchingRing& operator=(const PrefetchingRing&) = delete;
+
+  /******************************************************************************
+   * Producer side                                                              *
+   ******************************************************************************/
+
+  /**
+   * @brief waits for a free slot and copies the record into it
+   * @return false if the consumer is gone and the producer should stop
+   */
+  template<class SOURCE>
+  bool push(SOURCE& record) {
+    const auto tail = m_tail.load(std::memory_order_relaxed);
+    wait_for(m_producer_parked, [this, tail]() { return tail - m_head.load() < m_slots.size() || m_cancelled.load(); });
+    if (m_cancelled.load())
+      return false;
+    m_slots[tail % m_slots.size()] = record;       // copy assignment reuses the slot's memory
+    m_tail.store(tail + 1, std::memory_order_seq_cst);
+    wake(m_consumer_parked);
+    return true;
+  }
+
+  /**
+   * @brief marks the end of the stream, optionally because of an error
+   */
+  void finish(const std::exception_ptr& error = nullptr) {
+    m_error = error;                               // published by the store to m_finished
+    m_finished.store(true, std::memory_order_seq_cst);
+    wake(m_consumer_parked);
+  }
+
+  bool cancelled() const { return m_cancelled.load(); }
+
+  /******************************************************************************
+   * Consumer side                                                              *
+   ******************************************************************************/
+
+  /**
+   * @brief waits for the next record
+   * @return the record at the head of the ring or nullptr at the end of the stream
+   * @throws whatever exception stopped the producer, once all the records read before it have been consumed
+   */
+  RECORD* front() {
+    const auto head = m_head.load(std::memory_order_relaxed);
+    wait_for(m_consumer_parked, [this, head]() { return head < m_tail.load() || m_finished.load(); });
+    if (head < m_tail.load())   // records published before finishing are always served first
+      return &m_slots[head % m_slots.size()];
+    if (m_error)
+      std::rethrow_exception(m_error);
+    return nullptr;
+  }
+
+  /**
+   * @brief releases the record at the head of the ring back to the producer
+   */
+  void pop() {
+    m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_seq_cst);
+    wake(m_producer_parked);
+  }
+
+  /**
+   * @brief tells the producer to stop (the consumer is going away)
+   */
+  void cancel() {
+    m_cancelled.store(true, std::memory_order_seq_cst);
+    wake(m_producer_parked);
+  }
+
+ private:
+  std::vector<RECORD> m_slots;                   ///< the pooled records (never reallocated)
+  std::atomic<uint64_t> m_head;                  ///< number of records released by the consumer
+  std::atomic<uint64_t> m_tail;                  ///< number of records published by the producer
+  std::atomic<bool> m_finished;                  ///< the producer has published its last record
+  std::atomic<bool> m_cancelled;                 ///< the consumer has gone away
+  std::atomic<bool> m_consumer_parked;           ///< the consumer is (about to be) blocked on the condition variable
+  std::atomic<bool> m_producer_parked;           ///< the producer is (about to be) blocked on the condition variable
+  std::exception_ptr m_error;                    ///< the exception that stopped the producer, if any
+  std::mutex m_mutex;                            ///< only used to park a thread when the ring is full or empty
+  std::condition_variable m_condition;           ///< wakes up a parked thread
+
+  /**
+   * @brief spins briefly for the condition and then parks the thread until the other side wakes it up
+   */
+  template<class CONDITION>
+  void wait_for(std::atomic<bool>& parked, const CONDITION& condition) {
+    for (auto spin = 0u; spin < 64; ++spin) {
+      if (condition())
+        return;
+      std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock {m_mutex};
+    parked.store(true, std::memory_order_seq_cst); // must be visible before the condition is checked again (see wake)
+    m_condition.wait(lock, condition);
+    parked.store(false, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief wakes up the other side if it's parked
+   *
+   * The state change that satisfies the other side's condition is always stored (sequentially consistent)
+   * before the parked flag is read, and the parked flag is stored before the other side re-checks its
+   * condition, so at least one of the two sides sees the other and no wake up is ever lost.
+   */
+  void wake(std::atomic<bool>& parked) {
+    if (parked.load(std::memory_order_seq_cst)) {
+      std::lock_guard<std::mutex> lock {m_mutex};
+      m_condition.notify_all();
+    }
+  }
+};
+
+}  // end of namespace utils
+
+/**
+ * @brief Utility class to enable for-each style iteration in the PrefetchingReader class
+ *
+ * The records are copies (into pooled memory) of the ones produced by the wrapped reader's iterator on
+ * the background thread, served in the same order.
+ *
+ * @warning just like with the other iterators, the record returned by operator* is only valid until the
+ * next call to operator++. Make a copy if you need to hold on to it.
+ */
+template<class RECORD>
+class PrefetchingIterator {
+ public:
+
+  /**
+   * @brief creates an empty iterator (used for the end() method)
+   */
+  PrefetchingIterator() = default;
+
+  /**
+   * @brief starts iterating over a ring filled by a background thread
+   *
+   * @param ring the ring filled by the producer thread
+   * @param producer the producer thread. The iterator stops and joins it when it's destroyed.
+   */
+  PrefetchingIterator(const std::shared_ptr<utils::PrefetchingRing<RECORD>>& ring, std::thread&& producer) :
+    m_ring {ring},
+    m_producer {std::move(producer)},
+    m_record {nullptr}
+  {
+    try {
+      m_record = m_ring->front();
+    }
+    catch (...) {   // the wrapped reader failed before producing its first record
+      stop();
+      throw;
+    }
+  }
+
+  /**
+   * @brief a PrefetchingIterator cannot be copied safely, as it owns the background thread
+   */
+  PrefetchingIterator(const PrefetchingIterator&) = delete;
+  PrefetchingIterator& operator=(const PrefetchingIterator&) = delete;
+
+  /**
+   * @brief a PrefetchingIterator can be moved
+   */
+  PrefetchingIterator(PrefetchingIterator&& other) noexcept :
+    m_ring {std::move(other.m_ring)},
+    m_producer {std::move(other.m_producer)},
+    m_record {other.m_record}
+  {
+    other.m_record = nullptr;
+  }
+
+  PrefetchingIterator& operator=(PrefetchingIterator&& other) noexcept {
+    if (&other == this)
+      return *this;
+    stop();
+    m_ring = std::move(other.m_ring);
+    m_producer = std::move(other.m_producer);
+    m_record = other.m_record;
+    other.m_record = nullptr;
+    return *this;
+  }
+
+  /**
+   * @brief stops the background thread (if the stream wasn't read until the end) and waits for it
+   */
+  ~PrefetchingIterator() {
+    stop();
+  }
+
+  /**
+   * @brief pseudo-inequality operator (needed by for-each loop)
+   *
+   * @warning this method does the minimal work necessary to determine that we have reached the end of iteration.
+   * it is NOT a valid general-purpose inequality method.
+   *
+   * @return whether both iterators have entered their end states
+   */
+  bool operator!=(const PrefetchingIterator& rhs) const {
+    return m_record != rhs.m_record;
+  }
+
+  /**
+   * @brief dereference operator (needed by for-each loop)
+   *
+   * @return a reference to the current record (owned by the ring)
+   */
+  RECORD& operator*() {
+    return *m_record;
+  }
+
+  /**
+   * @brief releases the current record and waits for the next one (usually already there)
+   *
+   * @throws any exception thrown by the wrapped reader while it was producing the next record
+   */
+  RECORD& operator++() {
+    m_ring->pop();
+    m_record = nullptr;                  // in case front() rethrows the producer's exception
+    m_record = m_ring->front();
+    return m_record == nullptr ? m_end_record : *m_record;
+  }
+
+  /**
+   * @brief returns whether the iterator has no additional records
+   */
+  bool empty() const {
+    return m_record == nullptr;
+  }
+
+ private:
+  std::shared_ptr<utils::PrefetchingRing<RECORD>> m_ring;   ///< records handed over by the background thread
+  std::thread m_producer;                                    ///< the background thread running the wrapped iterator
+  RECORD* m_record = nullptr;                                ///< current record (a slot in the ring) or nullptr at the end
+  RECORD m_end_record {};                                    ///< returned by operator++ at the end of the stream
+
+  void stop() {
+    if (m_ring)
+      m_ring->cancel();
+    if (m_producer.joinable())
+      m_producer.join();
+    m_record = nullptr;
+  }
+};
+
+/**
+ * @brief Utility class to read records from any gamgee reader on a background thread, overlapping the
+ * I/O and parsing of the next records with the processing of the current one
+ *
+ * The wrapped reader's iterator runs on a dedicated thread, copying up to lookahead records ahead into a
+ * pool of reusable records. Records are served in the original order, and an exception thrown by the
+ * reader is rethrown by the iterator once all the records read before it have been served. The usage is
+ * the same as for the wrapped reader:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * for (auto& record : PrefetchingReader<SingleVariantReader>{SingleVariantReader{filename}})
+ *   do_something_expensive_with(record);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * It works with SamReader, IndexedSamReader, FastqReader, VariantReader, IndexedVariantReader and
+ * MultipleVariantReader (any reader whose iterator serves copy assignable records).
+ *
+ * @note prefetching pays off when the per record processing is expensive enough to hide the reading. The
+ * extra copy of every record is only cheaper than the parsing that it hides when the records are not
+ * trivial (e.g. compressed input, many samples).
+ * @warning the wrapped reader must not be used by anyone else while it's being iterated.
+ */
+template<class READER>
+class PrefetchingReader {
+ public:
+  using reader_iterator = decltype(std::declval<READER&>().begin());                        ///< the wrapped reader's iterator
+  using record_type = typename std::decay<decltype(*std::declval<reader_iterator&>())>::type; ///< the records served by the wrapped iterator
+  using iterator = PrefetchingIterator<record_type>;                                         ///< the iterator served by this reader
+
+  static constexpr uint32_t default_lookahead = 64;  ///< number of records read ahead by default
+
+  /**
+   * @brief wraps a reader so it's read by a background thread
+   *
+   * @param reader the reader to wrap (e.g. a SingleVariantReader or SingleSamReader)
+   * @param lookahead maximum number of records read ahead of the consumer (also the size of the pool of records)
+   */
+  explicit PrefetchingReader(READER&& reader, const uint32_t lookahead = default_lookahead) :
+    m_reader {std::move(reader)},
+    m_lookahead {lookahead}
+  {}
+
+  /**
+   * @brief a PrefetchingReader cannot be copied safely, as it is iterating over a stream.
+   */
+  PrefetchingReader(const PrefetchingReader&) = delete;
+  PrefetchingReader& operator=(const PrefetchingReader&) = delete;
+
+  /**
+   * @brief a PrefetchingReader can be moved (but not while it's being iterated)
+   */
+  PrefetchingReader(PrefetchingReader&&) = default;
+  PrefetchingReader& operator=(PrefetchingReader&&) = default;
+
+  /**
+   * @brief starts the background thread and returns an iterator pointing at the first record
+   *
+   * @return an iterator ready to serve the records in the original order
+   */
+  iterator begin() {
+    auto ring = std::make_shared<utils::PrefetchingRing<record_type>>(m_lookahead);
+    auto producer = std::thread{[this, ring]() {
+      try {
+        auto end = m_reader.end();
+        for (auto it = m_reader.begin(); it != end && !ring->cancelled(); ++it) {
+          if (!ring->push(*it))
+            break;
+        }
+        ring->finish();
+      }
+      catch (...) {
+        ring->finish(std::current_exception());
+      }
+    }};
+    return iterator{ring, std::move(producer)};
+  }
+
+  /**
+   * @brief creates an iterator in its end state (needed by for-each loop)
+   */
+  iterator end() const {
+    return iterator{};
+  }
+
+  /**
+   * @brief the wrapped reader (e.g. to get its header)
+   */
+  READER& reader() { return m_reader; }
+  const READER& reader() const { return m_reader; }
+
+ private:
+  READER m_reader;        ///< the wrapped reader, only used by the background thread while iterating
+  uint32_t m_lookahead;   ///< maximum number of records read ahead of the consumer
+};
+
+template<class READER>
+constexpr uint32_t PrefetchingReader<READER>::default_lookahead;
+
+}  // end of namespace gamgee
+
+#endif // gamgee__prefetching_reader__guard
@@ -29,7 +29,10 @@ Sam& Sam::operator=(const Sam& other) {
   if ( &other == this )  
     return *this;
   m_header = other.m_header;      ///< shared_ptr assignment will take care of deallocating old sam record if necessary
-  m_body = utils::make_shared_sam(utils::sam_deep_copy(other.m_body.get()));     ///< shared_ptr assignment will take care of deallocating old sam record if necessary
+  if (m_body && other.m_body && m_body.use_count() == 1)  ///< nothing else refers to our record, so its memory can be reused
+    utils::sam_deep_copy_into(other.m_body.get(), m_body.get());
+  else
+    m_body = utils::make_shared_sam(utils::sam_deep_copy(other.m_body.get()));     ///< shared_ptr assignment will take care of deallocating old sam record if necessary
   return *this;
 }
 
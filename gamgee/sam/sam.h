@@ -47,8 +47,11 @@ class Sam {
   Sam(const Sam& other);
 
   /**
-   * @copydoc Sam::Sam(const Sam&)  
-   */ 
+   * @copydoc Sam::Sam(const Sam&)
+   * @note the memory of this record is overwritten in place (and reused) if nothing else refers to it, otherwise a
+   *       new record is allocated, so the data field objects (Cigar, ReadBases, BaseQuals) taken from it before keep
+   *       their values
+   */
   Sam& operator=(const Sam& other);
 
   /**
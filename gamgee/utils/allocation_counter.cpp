@@ -0,0 +1,133 @@
+#include "allocation_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+namespace {
+
+// plain thread local integers in the executable's static TLS block: reading them never allocates, which
+// matters because they are updated from inside malloc itself
+__thread uint64_t t_allocations __attribute__((tls_model("initial-exec"))) = 0;
+__thread uint64_t t_allocated_bytes __attribute__((tls_model("initial-exec"))) = 0;
+
+inline void count_allocation(const size_t size) {
+  ++t_allocations;
+  t_allocated_bytes += size;
+}
+
+}
+
+namespace gamgee {
+namespace utils {
+
+AllocationCounts thread_allocation_counts() {
+  return AllocationCounts{t_allocations, t_allocated_bytes};
+}
+
+#if defined(__GLIBC__)
+bool allocation_counting_includes_malloc() { return true; }
+#else
+bool allocation_counting_includes_malloc() { return false; }
+#endif
+
+}  // end of namespace utils
+}  // end of namespace gamgee
+
+#if defined(__GLIBC__)
+
+/******************************************************************************
+ * glibc: interpose the C allocator so htslib's allocations are counted too.  *
+ * operator new ends up in malloc, so it doesn't need to be replaced. The     *
+ * aligned allocation functions all end up in __libc_memalign.                *
+ ******************************************************************************/
+#include <cerrno>
+#include <cstdint>
+#include <unistd.h>
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size) {
+  count_allocation(size);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) {
+  // an overflowing request is counted as the largest possible one (calloc itself fails it)
+  auto bytes = size_t{0};
+  count_allocation(__builtin_mul_overflow(n, size, &bytes) ? SIZE_MAX : bytes);
+  return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  count_allocation(size);
+  return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) {
+  // the alignment must be a power of two multiple of sizeof(void*), and *ptr is left alone on failure
+  if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0 || alignment == 0)
+    return EINVAL;
+  count_allocation(size);
+  const auto allocated = __libc_memalign(alignment, size);
+  if (allocated == nullptr)
+    return ENOMEM;
+  *ptr = allocated;
+  return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+  count_allocation(size);
+  return __libc_memalign(alignment, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+  count_allocation(size);
+  return __libc_memalign(alignment, size);
+}
+
+void* valloc(size_t size) {
+  count_allocation(size);
+  return __libc_memalign(size_t(getpagesize()), size);
+}
+
+void* pvalloc(size_t size) {
+  const auto page_size = size_t(getpagesize());
+  const auto rounded_size = size + page_size - 1 < size ? SIZE_MAX : (size + page_size - 1) & ~(page_size - 1);
+  count_allocation(rounded_size);
+  return rounded_size == SIZE_MAX ? nullptr : __libc_memalign(page_size, rounded_size);
+}
+
+}
+
+#else
+
+/******************************************************************************
+ * elsewhere: count C++ allocations only                                      *
+ ******************************************************************************/
+namespace {
+
+void* counted_new(const size_t size) {
+  count_allocation(size);
+  auto ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr)
+    throw bad_alloc{};
+  return ptr;
+}
+
+}
+
+void* operator new(size_t size) { return counted_new(size); }
+void* operator new[](size_t size) { return counted_new(size); }
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+
+#endif
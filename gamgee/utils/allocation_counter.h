@@ -0,0 +1,76 @@
+#ifndef gamgee__allocation_counter__guard
+#define gamgee__allocation_counter__guard
+
+#include <cstdint>
+
+namespace gamgee {
+namespace utils {
+
+/**
+ * @brief number of heap allocations (and bytes requested in them) made by a thread
+ */
+struct AllocationCounts {
+  uint64_t allocations; ///< number of allocation calls (malloc, calloc, realloc, operator new, ...)
+  uint64_t bytes;       ///< total number of bytes requested in those calls
+};
+
+/**
+ * @brief difference between two snapshots (end - start)
+ */
+inline AllocationCounts operator-(const AllocationCounts& end, const AllocationCounts& start) {
+  return AllocationCounts{end.allocations - start.allocations, end.bytes - start.bytes};
+}
+
+/**
+ * @brief allocation counters of the calling thread since it started
+ *
+ * @note allocation counting is opt-in: it's only available to executables that link the
+ * gamgee_allocation_counter library (the unit tests and the benchmarks do). Linking it interposes the
+ * process wide allocation functions, so the gamgee library itself pays nothing for it.
+ */
+AllocationCounts thread_allocation_counts();
+
+/**
+ * @brief whether the C allocation functions (malloc, calloc, realloc and the aligned posix_memalign,
+ * aligned_alloc, memalign, valloc and pvalloc) are interposed, so that allocations made inside htslib are
+ * counted as well
+ *
+ * This is the case with glibc. Everywhere else only C++ allocations (operator new) are counted.
+ *
+ * @note memory that doesn't come from these functions is never counted: direct mmap()/sbrk() calls,
+ * allocations glibc makes for itself without going through them (e.g. reallocarray, thread stacks) and
+ * those of allocators other than glibc's malloc
+ */
+bool allocation_counting_includes_malloc();
+
+/**
+ * @brief counts the heap allocations made by the current thread while it's alive
+ *
+ * Useful to assert allocation budgets in tests and to report allocations per record in benchmarks:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * const auto scope = AllocationScope{};
+ * for (; iterator != end; ++iterator)
+ *   do_something(*iterator);
+ * BOOST_CHECK_EQUAL(scope.allocations(), 0u); // steady state iteration must not allocate
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * @warning only the allocations of the thread that created the scope are counted
+ */
+class AllocationScope {
+ public:
+  AllocationScope() : m_start {thread_allocation_counts()} {}
+
+  AllocationCounts counts() const { return thread_allocation_counts() - m_start; } ///< @brief allocations made since the scope was created (or last reset)
+  uint64_t allocations() const { return counts().allocations; }                    ///< @brief number of allocations made since the scope was created (or last reset)
+  uint64_t bytes() const { return counts().bytes; }                                ///< @brief bytes requested since the scope was created (or last reset)
+  void reset() { m_start = thread_allocation_counts(); }                           ///< @brief starts counting from zero again
+
+ private:
+  AllocationCounts m_start;
+};
+
+}  // end of namespace utils
+}  // end of namespace gamgee
+
+#endif // gamgee__allocation_counter__guard
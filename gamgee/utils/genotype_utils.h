@@ -10,6 +10,9 @@
 #include "htslib/vcf.h"
 
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 namespace gamgee {
 
@@ -73,6 +76,68 @@ using namespace std;
     }
   }
 
+  /**
+   * @brief Decodes the GT values of consecutive samples for the kernels that classify whole records at once.
+   *
+   * A BCF GT value is (allele + 1) << 1 | phased, so missing alleles are 0 or 1 (or the type's missing value, which
+   * is negative) and the encoded allele (value >> 1) of the reference is 1. The vector end value (negative) ends the
+   * alleles of the samples with a lower ploidy than the field and is neither missing nor an allele. Diploid fields take
+   * a path without an inner loop.
+   *
+   * @param values the GT values of the samples (ploidy values per sample)
+   * @param sample_function called as sample_function(sample, is_missing, keys, n_keys) for every sample, with the
+   *        encoded alleles of the sample before its vector end (keys is only valid during the call)
+   */
+  template<class TYPE, class SAMPLE_FUNCTION>
+  inline void decode_genotypes(const TYPE* values, const uint32_t n_samples, const uint32_t ploidy, const TYPE vector_end,
+                               const SAMPLE_FUNCTION& sample_function) {
+    if (ploidy == 2) {
+      int32_t keys[2];
+      for (auto sample = 0u; sample < n_samples; ++sample) {
+        const int32_t first = values[2 * sample];
+        const int32_t second = values[2 * sample + 1];
+        const auto haploid = second == vector_end;
+        keys[0] = first >> 1;
+        keys[1] = second >> 1;
+        sample_function(sample, bool((first < 2) | ((second < 2) & !haploid)), keys, haploid ? 1u : 2u);
+      }
+      return;
+    }
+    auto keys = vector<int32_t>(ploidy);
+    for (auto sample = 0u; sample < n_samples; ++sample) {
+      const auto sample_values = values + sample * ploidy;
+      auto is_missing = false;
+      auto n_keys = 0u;
+      for (; n_keys < ploidy && sample_values[n_keys] != vector_end; ++n_keys) {
+        const int32_t value = sample_values[n_keys];
+        is_missing |= value < 2;
+        keys[n_keys] = value >> 1;
+      }
+      sample_function(sample, is_missing, keys.data(), n_keys);
+    }
+  }
+
+  /**
+   * @brief Decodes the GT field of the first n_samples samples of a record, whatever its BCF integer width.
+   * @copydetails decode_genotypes(const TYPE*, const uint32_t, const uint32_t, const TYPE, const SAMPLE_FUNCTION&)
+   * @param format_ptr The GT field from the line.
+   * @throws invalid_argument if the GT field is not an integer field
+   */
+  template<class SAMPLE_FUNCTION>
+  inline void decode_genotypes(const bcf_fmt_t* const format_ptr, const uint32_t n_samples, const SAMPLE_FUNCTION& sample_function) {
+    const auto ploidy = uint32_t(format_ptr->n);
+    switch (format_ptr->type) {
+    case BCF_BT_INT8:
+      return decode_genotypes(reinterpret_cast<const int8_t*>(format_ptr->p), n_samples, ploidy, int8_t(bcf_int8_vector_end), sample_function);
+    case BCF_BT_INT16:
+      return decode_genotypes(reinterpret_cast<const int16_t*>(format_ptr->p), n_samples, ploidy, int16_t(bcf_int16_vector_end), sample_function);
+    case BCF_BT_INT32:
+      return decode_genotypes(reinterpret_cast<const int32_t*>(format_ptr->p), n_samples, ploidy, int32_t(bcf_int32_vector_end), sample_function);
+    default:
+      throw invalid_argument("unknown GT field type: " + to_string(format_ptr->type));
+    }
+  }
+
   /**
    * @brief Returns the genotype allele keys.
    * @param body The shared memory variant "line" from a vcf, or bcf.
@@ -24,6 +24,14 @@ shared_ptr<hts_idx_t> make_shared_hts_index(hts_idx_t* hts_index_ptr) {
   return shared_ptr<hts_idx_t>(hts_index_ptr, HtsIndexDeleter());
 }
 
+/**
+  * @brief wraps a pre-allocated tbx_t in a shared_ptr with correct deleter
+  * @param tabix_index_ptr an htslib raw tabix index pointer
+  */
+shared_ptr<tbx_t> make_shared_tabix_index(tbx_t* tabix_index_ptr) {
+  return shared_ptr<tbx_t>(tabix_index_ptr, TabixIndexDeleter());
+}
+
 /**
   * @brief wraps a pre-allocated hts_itr_t in a shared_ptr with correct deleter
   * @param hts_itr_ptr an htslib raw file iterator pointer
@@ -88,6 +96,13 @@ std::unique_ptr<hts_itr_t, HtsIteratorDeleter> make_unique_hts_itr(hts_itr_t* ht
   return std::unique_ptr<hts_itr_t, HtsIteratorDeleter>(hts_itr_ptr);
 }
 
+/**
+  * @brief creates an empty kstring_t in a unique_ptr that frees it along with its buffer
+  */
+unique_ptr<kstring_t, KStringDeleter> make_unique_kstring() {
+  return unique_ptr<kstring_t, KStringDeleter>(new kstring_t{0, 0, nullptr});
+}
+
 /**
   * @brief creates a deep copy of an existing bam1_t
   * @param original an htslib raw bam pointer
@@ -120,6 +135,24 @@ bcf_hdr_t* variant_header_deep_copy(bcf_hdr_t* original) {
   return bcf_hdr_dup(original);
 }
 
+/**
+  * @brief deep copies a bam1_t into another one, reusing the destination's memory
+  * @param original an htslib raw bam pointer
+  * @param destination an htslib raw bam pointer that will hold the copy
+  */
+void sam_deep_copy_into(bam1_t* original, bam1_t* destination) {
+  bam_copy1(destination, original);
+}
+
+/**
+  * @brief deep copies a bcf1_t into another one, reusing the destination's memory
+  * @param original an htslib raw bcf pointer
+  * @param destination an htslib raw bcf pointer that will hold the copy
+  */
+void variant_deep_copy_into(bcf1_t* original, bcf1_t* destination) {
+  bcf_copy(destination, original);
+}
+
 /**
  * @brief creates a shallow copy of an existing bam1_t: copies
  *        core fields but not the data buffer or fields related
@@ -195,5 +228,19 @@ kstring_t initialize_htslib_buffer(const uint32_t initial_capacity) {
   return buffer;
 }
 
+/**
+ * @brief Empties an htslib byte buffer, growing it to at least the given capacity but keeping any larger
+ *        allocation it already has
+ *
+ * Meant for the kstrings of a bcf1_t that is rebuilt in place, so it only allocates once the record has grown to
+ * its widest.
+ */
+void reserve_htslib_buffer(kstring_t* buffer, const uint32_t capacity) {
+  buffer->l = 0;
+  if ( ks_resize(buffer, capacity) != 0 ) {
+    throw runtime_error{"Out of memory in reserve_htslib_buffer()"};
+  }
+}
+
 }
 }
@@ -4,8 +4,10 @@
 #include "htslib/sam.h"
 #include "htslib/vcf.h"
 #include "htslib/synced_bcf_reader.h"
+#include "htslib/tbx.h"
 #include "htslib/kstring.h"
 
+#include <cstdlib>
 #include <memory>
 #include <vector>
 #include <string>
@@ -27,6 +29,13 @@ struct HtsIndexDeleter {
   void operator()(hts_idx_t* p) const { hts_idx_destroy(p); }
 };
 
+/**
+ * @brief a functor object to delete a tabix index pointer
+ */
+struct TabixIndexDeleter {
+  void operator()(tbx_t* p) const { tbx_destroy(p); }
+};
+
 /**
  * @brief a functor object to delete an hts file iterator pointer
  */
@@ -71,8 +80,16 @@ struct SyncedReaderDeleter {
   void operator()(bcf_srs_t* p) const { bcf_sr_destroy(p); }
 };
 
+/**
+ * @brief a functor object to delete a kstring_t pointer along with its buffer
+ */
+struct KStringDeleter {
+  void operator()(kstring_t* p) const { free(p->s); delete p; }
+};
+
 std::shared_ptr<htsFile> make_shared_hts_file(htsFile* hts_file_ptr);
 std::shared_ptr<hts_idx_t> make_shared_hts_index(hts_idx_t* hts_index_ptr);
+std::shared_ptr<tbx_t> make_shared_tabix_index(tbx_t* tabix_index_ptr);
 std::shared_ptr<hts_itr_t> make_shared_hts_itr(hts_itr_t* hts_itr_ptr);
 std::shared_ptr<bam1_t> make_shared_sam(bam1_t* sam_ptr);
 std::shared_ptr<bam_hdr_t> make_shared_sam_header(bam_hdr_t* sam_header_ptr);
@@ -82,11 +99,14 @@ std::shared_ptr<bcf_srs_t> make_shared_synced_variant_reader(bcf_srs_t* synced_r
 
 std::unique_ptr<htsFile, HtsFileDeleter> make_unique_hts_file(htsFile* hts_file_ptr);
 std::unique_ptr<hts_itr_t, HtsIteratorDeleter> make_unique_hts_itr(hts_itr_t* hts_itr_ptr);
+std::unique_ptr<kstring_t, KStringDeleter> make_unique_kstring();
 
 bam1_t* sam_deep_copy(bam1_t* original);
 bam_hdr_t* sam_header_deep_copy(bam_hdr_t* original);
 bcf1_t* variant_deep_copy(bcf1_t* original); 
 bcf_hdr_t* variant_header_deep_copy(bcf_hdr_t* original);
+void sam_deep_copy_into(bam1_t* original, bam1_t* destination);
+void variant_deep_copy_into(bcf1_t* original, bcf1_t* destination);
 
 bam1_t* sam_shallow_copy(bam1_t* original);
 
@@ -108,6 +128,7 @@ inline uint32_t encoded_size(const int8_t field_type, const uint32_t field_lengt
 }
 
 kstring_t initialize_htslib_buffer(const uint32_t initial_capacity);
+void reserve_htslib_buffer(kstring_t* buffer, const uint32_t capacity);
 
 }
 }
@@ -0,0 +1,9 @@
+#include "loser_tree.h"
+
+namespace gamgee {
+namespace utils {
+
+constexpr uint64_t LoserTree::exhausted;
+
+}
+}
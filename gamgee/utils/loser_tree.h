@@ -0,0 +1,102 @@
+#ifndef gamgee__loser_tree__guard
+#define gamgee__loser_tree__guard
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace gamgee {
+namespace utils {
+
+/**
+ * @brief a tournament (loser) tree to merge many sorted streams by 64-bit keys
+ *
+ * The keys of the streams (one per leaf) are stored contiguously and every internal node keeps the stream that
+ * lost the match played there. The overall winner is the stream with the smallest key (the lowest stream index on
+ * ties, so the merge is stable). Replacing the key of the winner replays its matches from the leaf to the root:
+ * log2(k) comparisons of integers, against one pop and one push of a heap.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * auto tree = LoserTree{first_keys};
+ * while (!tree.empty()) {
+ *   consume(tree.top());
+ *   tree.replace_top(has_next(tree.top()) ? next_key(tree.top()) : LoserTree::exhausted);
+ * }
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class LoserTree {
+ public:
+  static constexpr uint64_t exhausted = std::numeric_limits<uint64_t>::max(); ///< key of a stream with no values left
+
+  /**
+   * @brief packs a genomic location in a key that sorts by chromosome and then by position
+   * @param chromosome the (non-negative) index of the chromosome in the header
+   * @param position the (non-negative) position in the chromosome
+   */
+  static uint64_t location_key(const int32_t chromosome, const int64_t position) {
+    return (uint64_t(uint32_t(chromosome)) << 32) | uint32_t(position);
+  }
+
+  LoserTree() = default; ///< @brief a tree with no streams
+
+  /**
+   * @brief builds the tree with the first key of every stream
+   * @param keys the first key of every stream (exhausted for streams with no values)
+   */
+  explicit LoserTree(std::vector<uint64_t> keys) :
+    m_keys {std::move(keys)},
+    m_losers(m_keys.size()),
+    m_winner {0}
+  {
+    const auto n_leaves = uint32_t(m_keys.size());
+    if (n_leaves == 0)
+      return;
+    // leaves are the implicit nodes n_leaves .. 2 * n_leaves - 1, so every internal node 1 .. n_leaves - 1 has two children
+    auto winners = std::vector<uint32_t>(n_leaves);
+    const auto winner_of = [&](const uint32_t node) { return node >= n_leaves ? node - n_leaves : winners[node]; };
+    for (auto node = n_leaves - 1; node >= 1; --node) {
+      const auto left = winner_of(2 * node);
+      const auto right = winner_of(2 * node + 1);
+      const auto left_wins = wins(left, right);
+      winners[node] = left_wins ? left : right;
+      m_losers[node] = left_wins ? right : left;
+    }
+    m_winner = n_leaves == 1 ? 0 : winners[1];
+  }
+
+  uint32_t size() const { return uint32_t(m_keys.size()); }                        ///< @brief number of streams
+  bool empty() const { return m_keys.empty() || m_keys[m_winner] == exhausted; }   ///< @brief whether all the streams are exhausted
+  uint32_t top() const { return m_winner; }                                       ///< @brief the stream with the smallest key @warning undefined if empty()
+  uint64_t top_key() const { return m_keys[m_winner]; }                           ///< @brief the smallest key @warning undefined if the tree has no streams
+  uint64_t key(const uint32_t stream) const { return m_keys[stream]; }            ///< @brief the current key of a stream
+
+  /**
+   * @brief replaces the key of the winning stream and replays its matches up to the root
+   * @param key the next key of the stream (exhausted if it has no values left)
+   */
+  void replace_top(const uint64_t key) {
+    const auto n_leaves = uint32_t(m_keys.size());
+    auto winner = m_winner;
+    m_keys[winner] = key;
+    for (auto node = (winner + n_leaves) / 2; node >= 1; node /= 2) {
+      if (wins(m_losers[node], winner))
+        std::swap(m_losers[node], winner);
+    }
+    m_winner = winner;
+  }
+
+ private:
+  std::vector<uint64_t> m_keys {};    ///< current key of every stream
+  std::vector<uint32_t> m_losers {};  ///< stream that lost the match of every internal node (index 0 is unused)
+  uint32_t m_winner {0};              ///< stream that won the whole tournament
+
+  bool wins(const uint32_t left, const uint32_t right) const {
+    return m_keys[left] < m_keys[right] || (m_keys[left] == m_keys[right] && left < right);
+  }
+};
+
+}
+}
+
+#endif // gamgee__loser_tree__guard
@@ -1,5 +1,7 @@
 #include "merged_vcf_lut.h"
 
+#include <algorithm>
+
 using namespace std;
 namespace gamgee
 {
@@ -23,57 +25,48 @@ namespace gamgee
       resize_merged_2_inputs_lut_if_needed(numInputGVCFs, numMergedFields);
     }
 
-    template<bool inputs_2_merged_LUT_is_input_ordered, bool merged_2_inputs_LUT_is_input_ordered>
-    void MergedVCFLUTBase<inputs_2_merged_LUT_is_input_ordered, merged_2_inputs_LUT_is_input_ordered>::clear()
+    void FlatLUT::clear()
     {
-      for(auto& vec : m_inputs_2_merged_lut)
-        vec.clear();
-      m_inputs_2_merged_lut.clear();
-      for(auto& vec : m_merged_2_inputs_lut)
-        vec.clear();
-      m_merged_2_inputs_lut.clear();
+      vector<int>{}.swap(m_values);
+      m_num_rows = 0u;
+      m_num_columns = 0u;
     }
 
-    template<bool inputs_2_merged_LUT_is_input_ordered, bool merged_2_inputs_LUT_is_input_ordered>
-    void MergedVCFLUTBase<inputs_2_merged_LUT_is_input_ordered, merged_2_inputs_LUT_is_input_ordered>::reset_vector(vector<int>& vec, unsigned from)
+    void FlatLUT::resize_if_needed(unsigned numRows, unsigned numColumns)
     {
-      for(auto i=from;i<vec.size();++i)
-        vec[i] = gamgee::missing_values::int32;
+      numRows = max(numRows, m_num_rows);
+      numColumns = max(numColumns, m_num_columns);
+      if(numRows == m_num_rows && numColumns == m_num_columns)
+        return;
+      if(numColumns == m_num_columns)  //same stride, existing rows stay where they are
+        m_values.resize(static_cast<size_t>(numRows) * numColumns, gamgee::missing_values::int32);
+      else
+      {
+        auto values = vector<int>(static_cast<size_t>(numRows) * numColumns, gamgee::missing_values::int32);
+        for(auto i=0u;i<m_num_rows;++i)
+          copy(row(i), row(i) + m_num_columns, values.begin() + static_cast<size_t>(i) * numColumns);
+        m_values.swap(values);
+      }
+      m_num_rows = numRows;
+      m_num_columns = numColumns;
     }
 
     template<bool inputs_2_merged_LUT_is_input_ordered, bool merged_2_inputs_LUT_is_input_ordered>
-    void MergedVCFLUTBase<inputs_2_merged_LUT_is_input_ordered, merged_2_inputs_LUT_is_input_ordered>::resize_and_reset_vector(vector<int>& vec, unsigned new_size)
+    void MergedVCFLUTBase<inputs_2_merged_LUT_is_input_ordered, merged_2_inputs_LUT_is_input_ordered>::clear()
     {
-      auto old_size = vec.size();
-      if(new_size > old_size)
-      {
-        vec.resize(new_size);
-        reset_vector(vec, old_size);
-      }
+      m_inputs_2_merged_lut.clear();
+      m_merged_2_inputs_lut.clear();
     }
 
     template<bool inputs_2_merged_LUT_is_input_ordered, bool merged_2_inputs_LUT_is_input_ordered>
     void MergedVCFLUTBase<inputs_2_merged_LUT_is_input_ordered, merged_2_inputs_LUT_is_input_ordered>::resize_and_reset_lut
-    (vector<vector<int>>& lut, unsigned new_lut_size, unsigned new_vector_size, unsigned& numRowsVar, unsigned& numColsVar)
+    (FlatLUT& lut, unsigned new_lut_size, unsigned new_vector_size, unsigned& numRowsVar, unsigned& numColsVar)
     {
-      auto old_lut_size = lut.size();
-      if(new_lut_size > old_lut_size)
-      {
-        lut.resize(new_lut_size);
+      if(new_lut_size > lut.num_rows())
         numRowsVar = new_lut_size;
-      }
-      auto old_vector_size = (lut.size() > 0u) ? lut[0].size() : 0u;
-      //Begin resizing of vectors at start_idx
-      auto start_idx = old_lut_size;
-      if(new_vector_size > old_vector_size)     //every vector needs to be resized
-      {
-        start_idx = 0u;
+      if(new_vector_size > lut.num_columns())
         numColsVar = new_vector_size;
-      }
-      else
-        new_vector_size = old_vector_size;      //new vector size is smaller, don't bother reducing the size of existing rows
-      for(auto i=start_idx;i<new_lut_size;++i)
-        resize_and_reset_vector(lut[i], new_vector_size);
+      lut.resize_if_needed(new_lut_size, new_vector_size);
     }
     //explicit initialization to avoid link errors
     template class MergedVCFLUTBase<true,true>;
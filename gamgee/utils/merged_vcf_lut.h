@@ -2,6 +2,8 @@
 #define __gamgee_merged_vcf_lut__
 
 #include <assert.h>
+#include <algorithm>
+#include <cstddef>
 #include <vector>
 
 #include "htslib/vcf.h"
@@ -21,17 +23,69 @@ namespace gamgee
 
   namespace utils
   {
+    /**
+     * @brief Matrix of LUT values stored in one contiguous row-major buffer (row r starts at r*num_columns())
+     * @note Rows and columns only ever grow: resize_if_needed() keeps every existing value at the same (row, column)
+     * and sets the new ones to missing. A single buffer means a resize is one allocation instead of one per row, and
+     * a lookup is one multiply-add instead of two dependent loads.
+     */
+    class FlatLUT
+    {
+      public:
+      FlatLUT() : m_values{}, m_num_rows{0u}, m_num_columns{0u} {}
+
+      inline int get(unsigned rowIdx, unsigned columnIdx) const
+      {
+        assert(rowIdx < m_num_rows);
+        assert(columnIdx < m_num_columns);
+        return m_values[static_cast<size_t>(rowIdx) * m_num_columns + columnIdx];
+      }
+      inline void set(unsigned rowIdx, unsigned columnIdx, int value)
+      {
+        assert(rowIdx < m_num_rows);
+        assert(columnIdx < m_num_columns);
+        m_values[static_cast<size_t>(rowIdx) * m_num_columns + columnIdx] = value;
+      }
+      /**
+       * @brief pointer to the first value of a row, the values of the row are contiguous
+       */
+      inline const int* row(unsigned rowIdx) const
+      {
+        assert(rowIdx < m_num_rows);
+        return m_values.data() + static_cast<size_t>(rowIdx) * m_num_columns;
+      }
+      inline unsigned num_rows() const { return m_num_rows; }
+      inline unsigned num_columns() const { return m_num_columns; }
+      /**
+       * @brief sets all values to missing
+       */
+      inline void reset() { std::fill(m_values.begin(), m_values.end(), gamgee::missing_values::int32); }
+      /**
+       * @brief deallocates memory
+       */
+      void clear();
+      /**
+       * @brief grows the matrix to at least numRows x numColumns
+       */
+      void resize_if_needed(unsigned numRows, unsigned numColumns);
+
+      private:
+      std::vector<int> m_values;
+      unsigned m_num_rows;
+      unsigned m_num_columns;
+    };
+
     /**
      * LUT = Look Up Table (to avoid confusion with map, unordered_map etc)
      * @brief Base class to store look up information between fields of merged header and input headers
      * @note This is the helper class for VariantHeaderMerger to store mapping for fields and samples
-     * Each MergedVCFLUTBase object contains 2 matrices (vector of vector): one for mapping input field idx to merged field idx (m_inputs_2_merged_lut)
+     * Each MergedVCFLUTBase object contains 2 matrices (FlatLUT): one for mapping input field idx to merged field idx (m_inputs_2_merged_lut)
      * and the second for mapping merged field idx to input field idx (m_merged_2_inputs_lut).
      *
      * Missing field information is stored as bcf_int32_missing, but should be checked with gamgee::missing() function
      * 
-     * The boolean template parameters specify how the 2 tables are laid out in memory - whether the outer vector corresponds to fields or input vcfs.
-     * For example, in object of type MergedVCFLUTBase<true, true>, both LUTs are laid out such that m_inputs_2_merged_lut[0] contains mappings 
+     * The boolean template parameters specify how the 2 tables are laid out in memory - whether the rows correspond to fields or input vcfs.
+     * For example, in object of type MergedVCFLUTBase<true, true>, both LUTs are laid out such that row 0 of m_inputs_2_merged_lut contains mappings 
      * for all fields for input VCF file 0. This would lead to fast traversal of all fields for a given input VCF (cache locality). 
      * However, traversing over all input VCFs for a given field would be slow (many cache misses).
      * The object MergedVCFLUTBase<false,false> would have the exact opposite behavior
@@ -40,7 +94,7 @@ namespace gamgee
      * Almost all the 'complexity' of the code comes from being able to handle the different layouts in a transparent manner
      *
      * Alternate explanation:
-     * This class contains two matrices (vector<vector<int>>) to store the mapping information:
+     * This class contains two matrices (FlatLUT, a contiguous row-major buffer) to store the mapping information:
      * m_inputs_2_merged_lut and m_merged_2_inputs_lut. You can layout each matrix in one of the 2 following ways:
      * (a) LUT[i][j]  corresponds to input VCF i and field j 
      * (b) LUT[i][j]  corresponds to field i and input VCF j
@@ -49,6 +103,11 @@ namespace gamgee
      * The 2 boolean template parameters control the layout of the two matrices. If the parameter value is true,
      * then option (a) is picked, else option (b)
      *
+     * Each matrix is a FlatLUT: one contiguous row-major buffer with a stride, so the mappings of one input are a contiguous
+     * row in layout (a) and a strided column in layout (b). The bulk functions (get_merged_idxs_for_input(),
+     * get_input_idxs_for_merged(), gather_input_values()) read all the mappings of an input at once, which is a plain copy
+     * or gather over a contiguous row in the input ordered layouts.
+     *
      * Although the class provides functions to resize the tables, for obtaining good performance, reallocations should be extremely
      * infrequent. Making the resize_luts_if_needed() a protected member forces developers to think twice instead of blindly calling this function.
      *
@@ -68,10 +127,8 @@ namespace gamgee
        */
       inline void reset_luts()
       {
-        for(auto& vec : m_inputs_2_merged_lut)
-          reset_vector(vec);
-        for(auto& vec : m_merged_2_inputs_lut)
-          reset_vector(vec);
+        m_inputs_2_merged_lut.reset();
+        m_merged_2_inputs_lut.reset();
       }
 
       /*
@@ -134,6 +191,55 @@ namespace gamgee
       inline void reset_input_idx_for_merged(unsigned inputGVCFIdx, int mergedIdx)
       { set_input_idx_for_merged(inputGVCFIdx, gamgee::missing_values::int32, mergedIdx); }
 
+      /**
+       * @brief Get the merged field idx of the first numInputFields fields of input VCF inputGVCFIdx at once
+       * @note a copy of a contiguous row if inputs_2_merged_LUT_is_input_ordered = true, a strided copy otherwise
+       * @param inputGVCFIdx index of the input VCF file
+       * @param numInputFields number of fields to look up (fields 0 to numInputFields-1 of the input VCF)
+       * @param mergedIdxs array of numInputFields values, filled with the merged idxs (missing where there's no mapping)
+       */
+      inline void get_merged_idxs_for_input(unsigned inputGVCFIdx, unsigned numInputFields, int* mergedIdxs) const
+      { copy_input_mappings<inputs_2_merged_LUT_is_input_ordered>(m_inputs_2_merged_lut, inputGVCFIdx, numInputFields, mergedIdxs); }
+
+      /**
+       * @brief Get the input field idx in input VCF inputGVCFIdx of the first numMergedFields fields of the merged VCF at once
+       * @note a copy of a contiguous row if merged_2_inputs_LUT_is_input_ordered = true, a strided copy otherwise
+       * @param inputGVCFIdx index of the input VCF file
+       * @param numMergedFields number of fields to look up (fields 0 to numMergedFields-1 of the merged VCF)
+       * @param inputIdxs array of numMergedFields values, filled with the input idxs (missing where there's no mapping)
+       */
+      inline void get_input_idxs_for_merged(unsigned inputGVCFIdx, unsigned numMergedFields, int* inputIdxs) const
+      { copy_input_mappings<merged_2_inputs_LUT_is_input_ordered>(m_merged_2_inputs_lut, inputGVCFIdx, numMergedFields, inputIdxs); }
+
+      /**
+       * @brief Rearrange the per field values of input VCF inputGVCFIdx (e.g. one value per sample) into merged order
+       * mergedValues[j] = inputValues[input idx of merged field j], or missingValue if merged field j has no valid input field
+       * @note branch free gather over the row of the input, which the compiler can vectorize when
+       * merged_2_inputs_LUT_is_input_ordered = true
+       * @param inputGVCFIdx index of the input VCF file
+       * @param inputValues values of the fields of the input VCF
+       * @param numInputFields number of values in inputValues (mappings to input fields beyond it count as missing)
+       * @param mergedValues array of numMergedFields values to fill
+       * @param numMergedFields number of merged fields to fill
+       * @param missingValue value for the merged fields without a valid input field
+       */
+      template<class VALUE>
+      inline void gather_input_values(unsigned inputGVCFIdx, const VALUE* inputValues, unsigned numInputFields,
+          VALUE* mergedValues, unsigned numMergedFields, const VALUE missingValue) const
+      {
+        assert(numMergedFields <= (merged_2_inputs_LUT_is_input_ordered ? m_merged_2_inputs_lut.num_columns() : m_merged_2_inputs_lut.num_rows()));
+        if(numInputFields == 0u)
+        {
+          std::fill(mergedValues, mergedValues + numMergedFields, missingValue);
+          return;
+        }
+        if(merged_2_inputs_LUT_is_input_ordered)
+          gather(m_merged_2_inputs_lut.row(inputGVCFIdx), 1u, inputValues, numInputFields, mergedValues, numMergedFields, missingValue);
+        else
+          gather(m_merged_2_inputs_lut.row(0u) + inputGVCFIdx, m_merged_2_inputs_lut.num_columns(), inputValues, numInputFields,
+              mergedValues, numMergedFields, missingValue);
+      }
+
       protected:
       //Only inherited classes should call constructor,destructor etc
       MergedVCFLUTBase(); 
@@ -180,25 +286,48 @@ namespace gamgee
       }
       private:
       //why not unordered_map? because I feel the need, the need for speed
-      std::vector<std::vector<int>> m_inputs_2_merged_lut;
-      std::vector<std::vector<int>> m_merged_2_inputs_lut;
+      FlatLUT m_inputs_2_merged_lut;
+      FlatLUT m_merged_2_inputs_lut;
       /**
-       * @brief invalidate/reset all mappings in a vector
-       * @note sets all elements to missing
-       * @param vec the vector to reset
-       * @param from offset in the vector from which to start reset, 0 by default
+       * @brief resize and reset a LUT
+       * @note resize and reset is done only if new_size > old_size
        */
-      void reset_vector(std::vector<int>& vec, unsigned from=0u);
+      void resize_and_reset_lut(FlatLUT& lut, unsigned new_lut_size, unsigned new_size, unsigned& numRowsVar, unsigned& numColsVar);
+
       /**
-       * @brief resize and reset a vector
-       * @note resize and reset is done only if new_size > vec.size()
+       * @brief copy the first num mappings of an input out of a LUT
+       * @note the mappings of an input are a row of the LUT if input_ordered, else a column
        */
-      void resize_and_reset_vector(std::vector<int>& vec, unsigned new_size);
+      template<bool input_ordered>
+      static void copy_input_mappings(const FlatLUT& lut, unsigned inputGVCFIdx, unsigned num, int* values)
+      {
+        if(input_ordered)
+        {
+          assert(num <= lut.num_columns());
+          const auto row = lut.row(inputGVCFIdx);
+          std::copy(row, row + num, values);
+        }
+        else
+          for(auto i=0u;i<num;++i)
+            values[i] = lut.get(i, inputGVCFIdx);
+      }
+
       /**
-       * @brief resize and reset a LUT
-       * @note resize and reset is done only if new_size > old_size
+       * @brief mergedValues[j] = inputValues[idxs[j*stride]] for the valid idxs, missingValue for the others
+       * @note reads inputValues[0] for invalid idxs and selects afterwards, so that the loop has no branches
        */
-      void resize_and_reset_lut(std::vector<std::vector<int>>& lut, unsigned new_lut_size, unsigned new_size, unsigned& numRowsVar, unsigned& numColsVar);
+      template<class VALUE>
+      static void gather(const int* idxs, unsigned stride, const VALUE* inputValues, unsigned numInputFields,
+          VALUE* mergedValues, unsigned numMergedFields, const VALUE missingValue)
+      {
+        for(auto j=0u;j<numMergedFields;++j)
+        {
+          const auto idx = idxs[static_cast<size_t>(j) * stride];
+          const auto valid = static_cast<unsigned>(idx) < numInputFields;     //missing (negative) idxs wrap around
+          const auto value = inputValues[valid ? idx : 0];
+          mergedValues[j] = valid ? value : missingValue;
+        }
+      }
 
       /**
        * @brief get LUT value at a particular row,column
@@ -208,13 +337,11 @@ namespace gamgee
        * @param columnIdx column
        * @return value at lut[row][column], could be invalid, check with is_missing()
        */
-      inline int get_lut_value(const std::vector<std::vector<int>>& lut, int rowIdx, int columnIdx) const
+      inline int get_lut_value(const FlatLUT& lut, int rowIdx, int columnIdx) const
       {
         assert(rowIdx >= 0);
-        assert(rowIdx < static_cast<int>(lut.size()));
         assert(columnIdx >= 0);
-        assert(columnIdx < static_cast<int>(lut[rowIdx].size()));
-        return lut[rowIdx][columnIdx];
+        return lut.get(rowIdx, columnIdx);
       }
 
       /**
@@ -225,13 +352,11 @@ namespace gamgee
        * @param columnIdx column
        * @param value value to write at lut[row][column] 
        */
-      inline void set_lut_value(std::vector<std::vector<int>>& lut, int rowIdx, int columnIdx, int value)
+      inline void set_lut_value(FlatLUT& lut, int rowIdx, int columnIdx, int value)
       {
         assert(rowIdx >= 0);
-        assert(rowIdx < static_cast<int>(lut.size()));
         assert(columnIdx >= 0);
-        assert(columnIdx < static_cast<int>(lut[rowIdx].size()));
-        lut[rowIdx][columnIdx] = value;
+        lut.set(rowIdx, columnIdx, value);
       }
 
       /**
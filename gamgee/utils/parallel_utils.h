@@ -0,0 +1,52 @@
+#ifndef gamgee__parallel_utils__guard
+#define gamgee__parallel_utils__guard
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gamgee {
+namespace utils {
+
+/**
+ * @brief runs function(i) for every i < n on up to n_threads threads (the calling thread is one of them)
+ *
+ * The indices are handed out one at a time, so uneven work items balance across the threads.
+ *
+ * @exception rethrows the first exception thrown by function once all the threads are done; the indices that
+ * weren't started by then are skipped
+ */
+template<class FUNCTION>
+void for_each_index(const std::size_t n, const unsigned n_threads, const FUNCTION& function) {
+  std::atomic<std::size_t> next_index {0};
+  auto error = std::exception_ptr{};
+  std::mutex error_mutex {};
+  const auto worker = [&] () {
+    for (auto i = next_index++; i < n; i = next_index++) {
+      try {
+        function(i);
+      }
+      catch (...) {
+        std::lock_guard<std::mutex> lock {error_mutex};
+        if (!error) error = std::current_exception();
+        next_index = n;
+      }
+    }
+  };
+  auto threads = std::vector<std::thread>{};
+  for (auto i = std::size_t{1}; i < std::min(std::size_t{n_threads}, n); ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (auto& thread : threads)
+    thread.join();
+  if (error) std::rethrow_exception(error);
+}
+
+} // end utils namespace
+} // end gamgee namespace
+
+#endif // gamgee__parallel_utils__guard
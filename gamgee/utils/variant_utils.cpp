@@ -12,6 +12,25 @@
 
 namespace gamgee {
 
+namespace {
+
+constexpr auto fnv_offset_basis = uint64_t{14695981039346656037ull};
+constexpr auto fnv_prime = uint64_t{1099511628211ull};
+
+uint64_t fnv_hash(uint64_t hash, const char* text) {
+  if (text != nullptr) {
+    for (; *text != '\0'; ++text)
+      hash = (hash ^ uint8_t(*text)) * fnv_prime;
+  }
+  return (hash ^ 0xff) * fnv_prime;   // terminates every string, so {"ab", "c"} and {"a", "bc"} differ
+}
+
+uint64_t fnv_hash(const uint64_t hash, const int value) {
+  return (hash ^ uint32_t(value)) * fnv_prime;
+}
+
+}
+
 void subset_variant_samples(bcf_hdr_t* hdr_ptr, const std::vector<std::string>& samples, const bool include) {
   if (samples.empty() && include) // exclude all samples
     bcf_hdr_set_samples(hdr_ptr, NULL, false);
@@ -29,18 +48,78 @@ void subset_variant_samples(bcf_hdr_t* hdr_ptr, const std::vector<std::string>&
   // NOTE: must NOT call bcf_hdr_sync() here, since htslib calls it for us in bcf_hdr_set_samples()
 }
 
+void add_variant_header_samples(bcf_hdr_t* dest_hdr_ptr, const bcf_hdr_t* src_hdr_ptr) {
+  // TODO: there is probably a more efficient way
+  for (auto sample_counter = 0; sample_counter < bcf_hdr_nsamples(src_hdr_ptr); ++sample_counter) {
+    // don't check for error code because the only "error" is ignoring a duplicate sample, not an error for us
+    bcf_hdr_add_sample(dest_hdr_ptr, src_hdr_ptr->samples[sample_counter]);
+  }
+}
+
 void merge_variant_headers(const std::shared_ptr<bcf_hdr_t>& dest_hdr_ptr, const std::shared_ptr<bcf_hdr_t>& src_hdr_ptr) {
   auto success = bcf_hdr_combine(dest_hdr_ptr.get(), src_hdr_ptr.get());
   if (success != 0)
     throw HtslibException(success);
+  add_variant_header_samples(dest_hdr_ptr.get(), src_hdr_ptr.get());
+  bcf_hdr_sync(dest_hdr_ptr.get());
+}
 
-  // TODO: there is probably a more efficient way
-  for (auto sample_counter = 0; sample_counter < bcf_hdr_nsamples(src_hdr_ptr.get()); ++sample_counter) {
-    // don't check for error code because the only "error" is ignoring a duplicate sample, not an error for us
-    bcf_hdr_add_sample(dest_hdr_ptr.get(), src_hdr_ptr->samples[sample_counter]);
+uint64_t variant_header_lines_fingerprint(const bcf_hdr_t* hdr_ptr) {
+  auto hash = fnv_offset_basis;
+  for (auto i = 0; i < hdr_ptr->nhrec; ++i) {
+    const auto* hrec = hdr_ptr->hrec[i];
+    hash = fnv_hash(hash, hrec->type);
+    hash = fnv_hash(hash, hrec->key);
+    hash = fnv_hash(hash, hrec->value);
+    hash = fnv_hash(hash, hrec->nkeys);
+    for (auto j = 0; j < hrec->nkeys; ++j) {
+      hash = fnv_hash(hash, hrec->keys[j]);
+      hash = fnv_hash(hash, hrec->vals[j]);
+    }
   }
-  
-  bcf_hdr_sync(dest_hdr_ptr.get());
+  return hash;
+}
+
+uint64_t variant_header_samples_fingerprint(const bcf_hdr_t* hdr_ptr) {
+  auto hash = fnv_hash(fnv_offset_basis, bcf_hdr_nsamples(hdr_ptr));
+  for (auto i = 0; i < bcf_hdr_nsamples(hdr_ptr); ++i)
+    hash = fnv_hash(hash, hdr_ptr->samples[i]);
+  return hash;
+}
+
+uint64_t variant_header_fingerprint(const bcf_hdr_t* hdr_ptr) {
+  const auto lines = variant_header_lines_fingerprint(hdr_ptr);
+  const auto samples = variant_header_samples_fingerprint(hdr_ptr);
+  return (((fnv_offset_basis ^ lines) * fnv_prime) ^ samples) * fnv_prime;
+}
+
+uint64_t variant_header_chromosomes_fingerprint(const bcf_hdr_t* hdr_ptr) {
+  auto hash = fnv_offset_basis;
+  for (auto i = 0; i < hdr_ptr->nhrec; ++i) {
+    if (hdr_ptr->hrec[i]->type == BCF_HL_CTG)   // same chromosomes as VariantHeader::chromosomes()
+      hash = fnv_hash(hash, *(hdr_ptr->hrec[i]->vals));
+  }
+  return hash;
+}
+
+void set_variant_decompression_threads(htsFile* file_ptr, const uint32_t n_threads) {
+  // the return value is deliberately ignored: older htslib versions (and non BGZF files) can only be read by
+  // the calling thread, in which case reading is just as correct only not any faster
+  if (n_threads > 0)
+    hts_set_threads(file_ptr, int(n_threads));
+}
+
+void unpack_variant_record(bcf1_t* record_ptr, const bcf_hdr_t* header_ptr, const VariantUnpackLevel unpack_level) {
+  if (unpack_level == VariantUnpackLevel::ALL) // keep the lazy decoding of the individual fields
+    return;
+  // drop the per sample data so nothing (including deep copies of the record) ever decodes or copies it, but keep
+  // the samples of the header (which the VCF parser doesn't set when it stops before the FORMAT column), so that the
+  // record is still consistent with it: all its individual fields are just missing
+  record_ptr->n_fmt = 0;
+  record_ptr->n_sample = bcf_hdr_nsamples(header_ptr);
+  record_ptr->indiv.l = 0;
+  bcf_unpack(record_ptr, int(unpack_level));
+  record_ptr->unpacked |= BCF_UN_FMT;
 }
 
 }
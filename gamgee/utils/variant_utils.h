@@ -5,6 +5,7 @@
 
 #include "htslib/vcf.h"
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -23,6 +24,15 @@ enum class AlleleType { REFERENCE, SNP, INSERTION, DELETION };
 
 using AlleleMask = std::vector<AlleleType>;
 
+/**
+ * @brief adds to a variant header the samples of another one that it doesn't have yet (after its own)
+ *
+ * @param dest_hdr_ptr the header to add the samples to
+ * @param src_hdr_ptr the header with the samples to add
+ * @note call bcf_hdr_sync() on dest_hdr_ptr once done adding samples (so many headers can be added for one sync)
+ */
+void add_variant_header_samples(bcf_hdr_t* dest_hdr_ptr, const bcf_hdr_t* src_hdr_ptr);
+
 /**
  * @brief merges a variant header into another
  *
@@ -30,6 +40,101 @@ using AlleleMask = std::vector<AlleleType>;
  * @param src_hdr_ptr a shared pointer to a bcf_hdr_t containing the header to be merged from
  */
 void merge_variant_headers(const std::shared_ptr<bcf_hdr_t>& dest_hdr_ptr, const std::shared_ptr<bcf_hdr_t>& src_hdr_ptr);
+
+/**
+ * @brief hashes the header lines of a variant header (everything but the samples), in order
+ *
+ * Headers with the same lines have the same fields and chromosomes at the same indices, regardless of their samples
+ * or the file they were read from, so it finds the headers of a large cohort that only differ by their samples (e.g.
+ * single sample gVCFs from the same pipeline) without comparing them line by line.
+ *
+ * @param hdr_ptr the header to fingerprint
+ * @return a 64 bit FNV-1a hash of the header lines
+ */
+uint64_t variant_header_lines_fingerprint(const bcf_hdr_t* hdr_ptr);
+
+/**
+ * @brief hashes the samples of a variant header, in order
+ *
+ * @param hdr_ptr the header to fingerprint
+ * @return a 64 bit FNV-1a hash of the sample names
+ */
+uint64_t variant_header_samples_fingerprint(const bcf_hdr_t* hdr_ptr);
+
+/**
+ * @brief hashes the whole content of a variant header: the fingerprints of its lines and of its samples
+ *
+ * @param hdr_ptr the header to fingerprint
+ * @return a 64 bit hash, the same for headers with the same lines and samples
+ */
+uint64_t variant_header_fingerprint(const bcf_hdr_t* hdr_ptr);
+
+/**
+ * @brief hashes the names of the chromosomes (contig lines) of a variant header, in order
+ *
+ * @param hdr_ptr the header to fingerprint
+ * @return a 64 bit FNV-1a hash of the chromosome names (same as that of any header with the same chromosomes)
+ */
+uint64_t variant_header_chromosomes_fingerprint(const bcf_hdr_t* hdr_ptr);
+
+/**
+ * @brief how much of each record the variant iterators decode as they read it
+ *
+ * Every level includes the ones before it. Anything below ALL drops the per sample (FORMAT) data of
+ * every record as soon as it's read, so site only workloads never pay for parsing, decoding or copying
+ * the genotypes of large cohorts. Records read at these levels keep the samples of their header, with all
+ * their individual fields missing.
+ *
+ * @note site fields beyond the level are still available, they are just decoded on first access
+ * instead of eagerly by the iterator
+ */
+enum class VariantUnpackLevel {
+  STRINGS = BCF_UN_STR,  ///< decodes the id, reference and alternate alleles
+  FILTERS = BCF_UN_FLT,  ///< STRINGS + filters
+  INFO    = BCF_UN_INFO, ///< FILTERS + shared (INFO) fields
+  ALL     = BCF_UN_ALL   ///< keeps the individual (FORMAT) fields too. Everything is decoded lazily on first access. This is the default.
+};
+
+/**
+ * @brief options shared by all the variant readers
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * for (const auto& record : SingleVariantReader{filename, VariantReaderOptions{4, VariantUnpackLevel::INFO}})
+ *   do_something_with_sites(record);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+struct VariantReaderOptions {
+  uint32_t decompression_threads = 0;                        ///< worker threads inflating BGZF blocks for each input file (0 = inflate in the reading thread)
+  VariantUnpackLevel unpack_level = VariantUnpackLevel::ALL; ///< how much of each record to decode
+  uint32_t decoding_threads = 0;                             ///< worker threads reading and decoding the files of a MultipleVariantReader ahead of the merge (0 = read them in the merging thread)
+  uint32_t max_open_files = 0;                               ///< maximum number of files a MultipleVariantReader keeps open (0 = no limit, see BudgetedVariantInputs)
+  uint64_t max_buffered_bytes = uint64_t{256} << 20;         ///< memory budget for the records read ahead of the merge when the open files are limited
+  uint32_t header_merging_threads = 0;                       ///< worker threads mapping the fields and samples of the headers of a MultipleVariantReader (0 = map them in the calling thread)
+  std::string header_merger_cache = "";                      ///< file caching the merged header of a MultipleVariantReader (empty = no cache, see VariantHeaderMerger::read_cache())
+};
+
+/**
+ * @brief hands the BGZF decompression of an open variant file to a pool of worker threads
+ *
+ * @param file_ptr an htsFile opened for reading (but not read from yet, other than its header)
+ * @param n_threads number of worker threads. 0 leaves the file alone.
+ *
+ * @note this is a best effort: plain text files and htslib versions without multi-threaded reading
+ * simply keep decompressing in the calling thread
+ */
+void set_variant_decompression_threads(htsFile* file_ptr, const uint32_t n_threads);
+
+/**
+ * @brief decodes a freshly read record up to the unpack level, dropping its per sample data if the level excludes it
+ *
+ * Without its per sample data the record keeps the samples of its header, all with missing individual fields.
+ *
+ * @param record_ptr a record just filled in by bcf_read() (or an index iterator)
+ * @param header_ptr the header the record was read with
+ * @param unpack_level how much of the record to decode
+ */
+void unpack_variant_record(bcf1_t* record_ptr, const bcf_hdr_t* header_ptr, const VariantUnpackLevel unpack_level);
+
 }
 
 #endif /* gamgee__variant_utils__guard */
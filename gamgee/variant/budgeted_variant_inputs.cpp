@@ -0,0 +1,156 @@
+#include "budgeted_variant_inputs.h"
+
+#include "../exceptions.h"
+#include "../utils/hts_memory.h"
+
+#include "htslib/bgzf.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace gamgee {
+
+BudgetedVariantInputs::BudgetedVariantInputs(const std::vector<std::string>& filenames, const std::vector<std::shared_ptr<htsFile>>& variant_files,
+                                             const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers, const std::vector<int64_t>& data_offsets,
+                                             const VariantReaderOptions& options) :
+  m_inputs {},
+  m_open {},
+  m_max_open {1},
+  m_batch_bytes {1},
+  m_decompression_threads {options.decompression_threads},
+  m_unpack_level {options.unpack_level},
+  m_line {utils::make_unique_kstring()}
+{
+  m_inputs.reserve(filenames.size());
+  auto n_pinned = 0u;
+  for (auto i = 0u; i < filenames.size(); ++i) {
+    const auto pinned = data_offsets[i] < 0;
+    m_inputs.push_back(Input{filenames[i], pinned ? variant_files[i] : nullptr, variant_headers[i], data_offsets[i], false, {}, 0, 0});
+    n_pinned += pinned;
+  }
+  // files that can't be reopened are open anyway, the others share what's left of the budget (at least one of them)
+  const auto n_needed = n_pinned + (n_pinned < m_inputs.size() ? 1u : 0u);
+  if (n_pinned > 0 && n_needed > options.max_open_files)
+    throw std::invalid_argument{std::to_string(n_pinned) + " variant files can't be reopened (uncompressed or not BGZF compressed VCF, or streams), "
+                                "they don't fit in a budget of " + std::to_string(options.max_open_files) + " open files along with the files that can"};
+  m_max_open = std::max(options.max_open_files > n_pinned ? options.max_open_files - n_pinned : 0u, 1u);
+  m_open.reserve(m_max_open);
+  if (!m_inputs.empty())
+    m_batch_bytes = std::max(options.max_buffered_bytes / m_inputs.size(), uint64_t{1});
+}
+
+bool BudgetedVariantInputs::next(const uint32_t input, std::shared_ptr<bcf1_t>& record) {
+  auto& state = m_inputs[input];
+  if (state.head == state.n_records) {
+    if (state.finished)
+      return false;
+    read_batch(state, input);
+    if (state.n_records == 0)
+      return false;
+  }
+  std::swap(record, state.records[state.head++]);   // the consumer's record goes back to the pool of the file
+  return true;
+}
+
+uint32_t BudgetedVariantInputs::open_files() const {
+  return uint32_t(std::count_if(m_inputs.begin(), m_inputs.end(), [](const auto& input) { return input.file != nullptr; }));
+}
+
+bool BudgetedVariantInputs::resumable(const std::string& filename, const htsFile* file_ptr) {
+  if (filename.empty() || filename == "-")
+    return false;
+  if (file_ptr->is_bin)
+    return !file_ptr->is_kstream;
+  // text files are read through a buffer on top of the BGZF stream, so reopened VCF files are read from the stream itself
+  return bgzf_is_bgzf(filename.c_str()) == 1;
+}
+
+int64_t BudgetedVariantInputs::tell(const htsFile* file_ptr) {
+  return file_ptr->is_bin ? bgzf_tell(file_ptr->fp.bgzf) : 0;
+}
+
+namespace {
+
+/**
+ * @brief the memory held by a record: its encoded data and the buffers of its decoding
+ */
+uint64_t record_bytes(const bcf1_t* record) {
+  const auto& decoded = record->d;
+  return sizeof(bcf1_t) + record->shared.m + record->indiv.m + decoded.m_fmt * sizeof(bcf_fmt_t) + decoded.m_info * sizeof(bcf_info_t) +
+    decoded.m_id + decoded.m_als + decoded.m_allele * sizeof(char*) + decoded.m_flt * sizeof(int);
+}
+
+}
+
+/**
+ * @brief reads the next records of a file, as many as fit in its share of the memory budget (at least one)
+ */
+void BudgetedVariantInputs::read_batch(Input& input, const uint32_t index) {
+  if (!input.file)
+    open(input, index);
+  else if (input.offset >= 0) {   // it's the most recently read file now
+    m_open.erase(std::find(m_open.begin(), m_open.end(), index));
+    m_open.push_back(index);
+  }
+  input.head = 0;
+  input.n_records = 0;
+  auto bytes = uint64_t{0};
+  while (bytes < m_batch_bytes) {
+    if (input.n_records == input.records.size())
+      input.records.push_back(utils::make_shared_variant(bcf_init1()));
+    auto* record = input.records[input.n_records].get();
+    if (m_unpack_level != VariantUnpackLevel::ALL)
+      record->max_unpack = BCF_UN_SHR;   // stops the VCF parser before the per sample columns (the BCF reader ignores it)
+    if (read_record(input, record) < 0) {
+      input.finished = true;
+      close(input, index);
+      return;
+    }
+    unpack_variant_record(record, input.header.get(), m_unpack_level);
+    bytes += record_bytes(record);
+    ++input.n_records;
+  }
+  if (input.offset >= 0)
+    input.offset = bgzf_tell(hts_get_bgzfp(input.file.get()));
+}
+
+/**
+ * @brief reads the next record of an open file, the lines of a reopened VCF file straight from its BGZF stream
+ */
+int BudgetedVariantInputs::read_record(Input& input, bcf1_t* record) {
+  if (input.offset < 0 || input.file->is_bin)
+    return bcf_read1(input.file.get(), input.header.get(), record);
+  auto* line = m_line.get();
+  do {
+    if (bgzf_getline(hts_get_bgzfp(input.file.get()), '\n', line) < 0)
+      return -1;
+  } while (line->l == 0 || line->s[0] == '#');   // the header lines when the file is read from its start
+  return vcf_parse(line, input.header.get(), record);
+}
+
+void BudgetedVariantInputs::open(Input& input, const uint32_t index) {
+  if (m_open.size() == m_max_open)   // closes the least recently read file
+    close(m_inputs[m_open.front()], m_open.front());
+  auto* file_ptr = bcf_open(input.filename.c_str(), "r");
+  if (file_ptr == nullptr)
+    throw FileOpenException{input.filename};
+  input.file = utils::make_shared_hts_file(file_ptr);
+  const auto error = bgzf_seek(hts_get_bgzfp(file_ptr), input.offset, SEEK_SET);
+  if (error < 0) {
+    input.file.reset();
+    throw HtslibException{int(error)};
+  }
+  set_variant_decompression_threads(file_ptr, m_decompression_threads);
+  m_open.push_back(index);
+}
+
+void BudgetedVariantInputs::close(Input& input, const uint32_t index) {
+  input.file.reset();
+  const auto position = std::find(m_open.begin(), m_open.end(), index);
+  if (position != m_open.end())
+    m_open.erase(position);
+}
+
+}
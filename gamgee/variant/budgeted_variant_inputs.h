@@ -0,0 +1,110 @@
+#ifndef gamgee__budgeted_variant_inputs__guard
+#define gamgee__budgeted_variant_inputs__guard
+
+#include "../utils/hts_memory.h"
+#include "../utils/variant_utils.h"
+
+#include "htslib/vcf.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gamgee {
+
+/**
+ * @brief reads many variant files while keeping only a few of them open
+ *
+ * Merging tens of thousands of files can't keep them all open: it runs into the limit on open files and every
+ * open BGZF stream holds its own buffers. Instead, every file is read in batches of records that fit in a share
+ * of the memory budget. A file is opened (or reopened, seeking to the virtual offset where its last batch
+ * ended) only to read a batch, and the least recently read files are closed to keep at most max_open_files of
+ * them open. The records are served file by file with next(), in the same order as the files have them, so a
+ * merge over them produces exactly the same output as a merge over open files.
+ *
+ * BCF and bgzipped VCF files can be reopened at a virtual offset (the lines of a VCF file are then read straight from
+ * its BGZF stream, skipping the header lines). Other inputs (uncompressed or plain gzipped VCF files, streams) stay
+ * open for the whole merge, on top of the reopened ones (at least one of which can always be open), so there can't be
+ * as many of them as the budget of open files.
+ *
+ * The memory budget counts the encoded records and the buffers their decoding (see VariantUnpackLevel) keeps, but not
+ * the BGZF buffers of the open files.
+ *
+ * @note the records are pooled: next() exchanges the next record of a file for a record the consumer is done with
+ */
+class BudgetedVariantInputs {
+ public:
+  /**
+   * @brief prepares the files for reading, without opening any
+   *
+   * @param filenames       the names of the files ("-" or empty for stdin)
+   * @param variant_files   the files that can't be reopened (opened via bcf_open(), header already read), nullptr for the others
+   * @param variant_headers the headers of the files
+   * @param data_offsets    the virtual offset of the first record of every file that can be reopened
+   * @param options         decompression threads, unpack level, open files and memory budget (see VariantReaderOptions)
+   * @throws std::invalid_argument if the files that can't be reopened (and one that can, if any) don't fit in the budget
+   *         of open files
+   */
+  BudgetedVariantInputs(const std::vector<std::string>& filenames, const std::vector<std::shared_ptr<htsFile>>& variant_files,
+                        const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers, const std::vector<int64_t>& data_offsets,
+                        const VariantReaderOptions& options);
+
+  BudgetedVariantInputs(const BudgetedVariantInputs&) = delete;
+  BudgetedVariantInputs& operator=(const BudgetedVariantInputs&) = delete;
+  BudgetedVariantInputs(BudgetedVariantInputs&&) = default;
+  BudgetedVariantInputs& operator=(BudgetedVariantInputs&&) = default;
+
+  /**
+   * @brief exchanges the next record of a file with a record the consumer is done with
+   *
+   * @param input the index of the file
+   * @param record a record nothing else refers to, replaced by the next record of the file
+   * @return false at the end of the file (record is left untouched)
+   * @throws FileOpenException if a file can't be reopened, HtslibException if it can't seek back to where it was
+   */
+  bool next(const uint32_t input, std::shared_ptr<bcf1_t>& record);
+
+  uint32_t open_files() const;   ///< @brief number of files open right now
+
+  /**
+   * @brief whether a file that was just opened (and had its header read) can be reopened at a virtual offset (a BCF or
+   * bgzipped VCF file)
+   */
+  static bool resumable(const std::string& filename, const htsFile* file_ptr);
+
+  /**
+   * @brief the virtual offset to start reading a file that can be reopened from, once its header is read: where the
+   * records start for BCF, and the start of the file for VCF (whose header lines are skipped as they are read)
+   */
+  static int64_t tell(const htsFile* file_ptr);
+
+ private:
+  struct Input {
+    std::string filename;
+    std::shared_ptr<htsFile> file;                 ///< nullptr while closed
+    std::shared_ptr<bcf_hdr_t> header;
+    int64_t offset;                                ///< virtual offset of the record after the last batch (-1 if the file can't be reopened)
+    bool finished;
+    std::vector<std::shared_ptr<bcf1_t>> records;  ///< the last batch, followed by pooled records to read into
+    uint32_t head;                                 ///< next record of the batch to serve
+    uint32_t n_records;                            ///< size of the batch
+  };
+
+  std::vector<Input> m_inputs;
+  std::vector<uint32_t> m_open;                    ///< the reopened files that are open, least recently read first
+  uint32_t m_max_open;                             ///< maximum size of m_open
+  uint64_t m_batch_bytes;                          ///< share of the memory budget of every file
+  uint32_t m_decompression_threads;
+  VariantUnpackLevel m_unpack_level;
+  std::unique_ptr<kstring_t, utils::KStringDeleter> m_line;   ///< the last line read from a VCF file
+
+  void read_batch(Input& input, const uint32_t index);
+  int read_record(Input& input, bcf1_t* record);
+  void open(Input& input, const uint32_t index);
+  void close(Input& input, const uint32_t index);
+};
+
+}
+
+#endif // gamgee__budgeted_variant_inputs__guard
@@ -0,0 +1,90 @@
+#ifndef gamgee__field_handle__guard
+#define gamgee__field_handle__guard
+
+#include "variant_header.h"
+
+#include "../missing.h"
+
+#include "htslib/vcf.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace gamgee {
+
+/**
+ * @brief the htslib header type (BCF_HT_*) of the values of a FieldHandle
+ */
+template<class TYPE> struct FieldHandleType;
+template<> struct FieldHandleType<int32_t>     { static constexpr uint8_t value = BCF_HT_INT; };
+template<> struct FieldHandleType<float>       { static constexpr uint8_t value = BCF_HT_REAL; };
+template<> struct FieldHandleType<std::string> { static constexpr uint8_t value = BCF_HT_STR; };
+
+/**
+ * @brief a shared or individual field resolved once against a header
+ *
+ * Accessing a field by tag (e.g. Variant::integer_individual_field("GQ")) hashes the tag and checks the header
+ * type of the field for every record. A handle does both once, and records look the field up through a table of
+ * their fields that is built on the first lookup of each record, so every following lookup is O(1):
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * auto reader = SingleVariantReader{filename};
+ * const auto gq = FieldHandle<int32_t>::individual(reader.header(), "GQ");
+ * const auto dp = FieldHandle<int32_t>::shared(reader.header(), "DP");
+ * for (const auto& record : reader) {
+ *   const auto gqs = record.individual_field(gq);
+ *   const auto depth = record.shared_field(dp);
+ *   ...
+ * }
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * A handle of a field the header doesn't declare is valid: it just returns empty fields, like the tag accessors.
+ *
+ * @warning a handle is only meaningful for records with the header it was resolved against (or a header with the same field indices)
+ * @tparam TYPE the type of the values (int32_t, float or std::string), which must match the header type of the field
+ */
+template<class TYPE>
+class FieldHandle {
+ public:
+  FieldHandle() = default; ///< @brief a handle to no field: every access returns an empty field
+
+  /**
+   * @brief resolves an individual (FORMAT) field
+   * @throws std::runtime_error if the field is declared with another type
+   */
+  static FieldHandle individual(const VariantHeader& header, const std::string& tag) { return FieldHandle{header, header.field_index(tag), BCF_HL_FMT}; }
+  static FieldHandle individual(const VariantHeader& header, const int32_t index) { return FieldHandle{header, index, BCF_HL_FMT}; }  ///< @copydoc individual(const VariantHeader&, const std::string&)
+
+  /**
+   * @brief resolves a shared (INFO) field
+   * @throws std::runtime_error if the field is declared with another type
+   */
+  static FieldHandle shared(const VariantHeader& header, const std::string& tag) { return FieldHandle{header, header.field_index(tag), BCF_HL_INFO}; }
+  static FieldHandle shared(const VariantHeader& header, const int32_t index) { return FieldHandle{header, index, BCF_HL_INFO}; }      ///< @copydoc shared(const VariantHeader&, const std::string&)
+
+  int32_t index() const { return m_index; }                        ///< @brief the index of the field in the header (missing_values::int32 if the header doesn't declare it)
+  int32_t category() const { return m_category; }                  ///< @brief BCF_HL_FMT for individual fields, BCF_HL_INFO for shared fields
+  uint8_t type() const { return FieldHandleType<TYPE>::value; }     ///< @brief the header type of the field (BCF_HT_INT, BCF_HT_REAL or BCF_HT_STR)
+  bool present() const { return m_present; }                       ///< @brief whether the header declares the field
+  bool is_individual() const { return m_category == BCF_HL_FMT; }  ///< @brief whether this is an individual (FORMAT) field
+  bool is_shared() const { return m_category == BCF_HL_INFO; }     ///< @brief whether this is a shared (INFO) field
+
+ private:
+  int32_t m_index {missing_values::int32};
+  int32_t m_category {BCF_HL_FMT};
+  bool m_present {false};
+
+  FieldHandle(const VariantHeader& header, const int32_t index, const int32_t category) :
+    m_index {index},
+    m_category {category},
+    m_present {header.has_field(index, category)}
+  {
+    if (m_present && header.field_type(index, category) != FieldHandleType<TYPE>::value)
+      throw std::runtime_error("field requested is not of the right type");
+  }
+};
+
+}
+
+#endif // gamgee__field_handle__guard
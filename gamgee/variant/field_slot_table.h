@@ -0,0 +1,82 @@
+#ifndef gamgee__field_slot_table__guard
+#define gamgee__field_slot_table__guard
+
+#include "htslib/vcf.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace gamgee {
+
+/**
+ * @brief maps the header index of a field to its position in the FORMAT (or INFO) list of a record
+ *
+ * htslib finds a field of a record by scanning the list of fields the record has. The table is built with one
+ * scan the first time a field is looked up after invalidate() (i.e. once per record) and answers all the following
+ * lookups in O(1). Every slot is stamped with the generation of the record it was built for, so invalidating the
+ * table between records is O(1) too: slots of a previous record are simply ignored.
+ *
+ * @note used internally by Variant, which invalidates the table whenever the record it holds changes
+ */
+class FieldSlotTable {
+ public:
+  /**
+   * @brief forgets the fields of the current record
+   */
+  void invalidate() {
+    if (++m_generation == 0) {   // wrapped around: clear the stamps so no old slot can match again
+      for (auto& slot : m_slots)
+        slot.generation = 0;
+      m_generation = 1;
+      m_built_generation = 0;
+    }
+  }
+
+  /**
+   * @brief the field with a header index in a list of fields (d.fmt or d.info of the record), or nullptr if the record doesn't have it
+   * @param fields the fields of the record, which must be the same (same record, same order) until the next invalidate()
+   * @param n_fields the number of fields
+   * @param index the header index of the field
+   */
+  template<class FIELD>
+  FIELD* find(FIELD* const fields, const uint32_t n_fields, const int32_t index) {
+    if (m_built_generation != m_generation)
+      build(fields, n_fields);
+    if (index < 0 || uint32_t(index) >= m_slots.size())
+      return nullptr;
+    const auto& slot = m_slots[index];
+    return slot.generation == m_generation ? fields + slot.position : nullptr;
+  }
+
+ private:
+  struct Slot {
+    uint32_t generation;
+    uint32_t position;
+  };
+
+  std::vector<Slot> m_slots {};        ///< indexed by header index
+  uint32_t m_generation {1};           ///< generation of the current record
+  uint32_t m_built_generation {0};     ///< generation the slots were last built for
+
+  static int32_t field_id(const bcf_fmt_t& field) { return field.id; }
+  static int32_t field_id(const bcf_info_t& field) { return field.key; }
+
+  template<class FIELD>
+  void build(const FIELD* const fields, const uint32_t n_fields) {
+    for (auto position = 0u; position < n_fields; ++position) {
+      const auto id = field_id(fields[position]);
+      if (id < 0)
+        continue;
+      if (uint32_t(id) >= m_slots.size())
+        m_slots.resize(id + 1, Slot{0, 0});
+      auto& slot = m_slots[id];
+      if (slot.generation != m_generation)   // the first occurrence wins, as in htslib
+        slot = Slot{m_generation, position};
+    }
+    m_built_generation = m_generation;
+  }
+};
+
+}
+
+#endif // gamgee__field_slot_table__guard
@@ -2,8 +2,6 @@
 
 #include <algorithm>
 
-#include "boost/algorithm/cxx11/all_of.hpp"
-
 namespace gamgee {
 
 using namespace std;
@@ -56,14 +54,35 @@ bool Genotype::non_ref_het() const {
 }
 
 bool Genotype::hom_var() const {
-  const auto keys = allele_keys();
-  const auto allele_1 = keys[0];
-  return allele_1 != 0 && boost::algorithm::all_of_equal(keys, allele_1);
+  // same as comparing all of allele_keys() to the first one, without allocating the keys
+  const auto count = size();
+  auto allele_1 = 0;
+  auto i = 0u;
+  for (; i != count; ++i) {
+    auto key = allele_key(i);
+    if (key == bcf_int32_vector_end)
+      break;
+    if (key >= m_body->n_allele)
+      key = missing_values::int32;
+    if (i == 0)
+      allele_1 = key;
+    else if (key != allele_1)
+      return false;
+  }
+  return i != 0 && allele_1 != 0;
 }
 
 bool Genotype::hom_ref() const {
-  const auto keys = allele_keys();
-  return boost::algorithm::all_of_equal(keys, 0);
+  // same as comparing all of allele_keys() to 0, without allocating the keys
+  const auto count = size();
+  for (auto i = 0u; i != count; ++i) {
+    const auto key = allele_key(i);
+    if (key == bcf_int32_vector_end)
+      break;
+    if (key != 0)
+      return false;
+  }
+  return true;
 }
 
 uint32_t Genotype::fast_diploid_key_generation() const {
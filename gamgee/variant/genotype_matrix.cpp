@@ -0,0 +1,40 @@
+#include "genotype_matrix.h"
+
+#include "../utils/genotype_utils.h"
+
+#include "htslib/vcf.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+namespace gamgee {
+
+constexpr int8_t GenotypeMatrix::missing;
+constexpr uint32_t GenotypeMatrix::alignment;
+
+GenotypeMatrixBuilder::GenotypeMatrixBuilder(const GenotypeMatrixEncoding encoding, const uint32_t allele) :
+  m_first_key {encoding == GenotypeMatrixEncoding::DOSAGE ? 2 : int32_t(allele) + 1},
+  m_last_key {encoding == GenotypeMatrixEncoding::DOSAGE ? numeric_limits<int32_t>::max() : int32_t(allele) + 1}
+{}
+
+void GenotypeMatrixBuilder::decode(const Variant& variant, int8_t* column) const {
+  const auto n_samples = variant.n_samples();
+  const auto format_ptr = variant.raw_individual_field("GT");
+  if (format_ptr == nullptr || format_ptr->n == 0) {
+    fill_n(column, n_samples, GenotypeMatrix::missing);
+    return;
+  }
+  // counts the alleles of every sample whose key falls in [m_first_key, m_last_key]
+  const auto first_key = m_first_key;
+  const auto last_key = m_last_key;
+  utils::decode_genotypes(format_ptr, n_samples, [column, first_key, last_key](const uint32_t sample, const bool is_missing, const int32_t* keys, const uint32_t n_keys) {
+    auto count = 0;
+    for (auto allele = 0u; allele < n_keys; ++allele)
+      count += (keys[allele] >= first_key) & (keys[allele] <= last_key);
+    column[sample] = is_missing ? GenotypeMatrix::missing : int8_t(min(count, int(numeric_limits<int8_t>::max())));
+  });
+}
+
+}
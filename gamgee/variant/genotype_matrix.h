@@ -0,0 +1,143 @@
+#ifndef gamgee__genotype_matrix__guard
+#define gamgee__genotype_matrix__guard
+
+#include "variant.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace gamgee {
+
+/**
+ * @brief what the values of a GenotypeMatrix count
+ */
+enum class GenotypeMatrixEncoding {
+  DOSAGE,       ///< number of non-reference alleles in the genotype (0, 1 or 2 for diploids)
+  ALLELE_COUNT  ///< number of copies of one given allele in the genotype (see GenotypeMatrixBuilder)
+};
+
+/**
+ * @brief dense samples x variants matrix of int8 genotype values
+ *
+ * Every variant is a column holding the values of all samples contiguously in memory. Columns start at
+ * cache line (64 byte) boundaries, so they can be handed directly to vectorised numerical code (PCA,
+ * regressions, ...). Missing genotypes are encoded as GenotypeMatrix::missing.
+ *
+ * @note the matrix can be reused for as many blocks of variants as needed, see GenotypeMatrixBuilder
+ */
+class GenotypeMatrix {
+ public:
+  static constexpr int8_t missing = -1;       ///< value of a genotype with at least one missing allele
+  static constexpr uint32_t alignment = 64;   ///< every column starts at a multiple of this many bytes
+
+  /**
+   * @brief allocates a zeroed matrix
+   *
+   * @param n_samples number of rows (must match the number of samples of the variants it's filled with)
+   * @param n_variants number of columns (maximum number of variants in a block)
+   */
+  GenotypeMatrix(const uint32_t n_samples, const uint32_t n_variants) :
+    m_n_samples {n_samples},
+    m_n_variants {n_variants},
+    m_stride {(size_t{n_samples} + alignment - 1) / alignment * alignment},
+    m_storage {new int8_t[m_stride * n_variants + alignment]()},
+    m_data {align(m_storage.get())}
+  {}
+
+  GenotypeMatrix(const GenotypeMatrix&) = delete;
+  GenotypeMatrix& operator=(const GenotypeMatrix&) = delete;
+  GenotypeMatrix(GenotypeMatrix&&) = default;
+  GenotypeMatrix& operator=(GenotypeMatrix&&) = default;
+
+  uint32_t n_samples() const { return m_n_samples; }                                                     ///< @brief number of rows
+  uint32_t n_variants() const { return m_n_variants; }                                                   ///< @brief number of columns
+  size_t stride() const { return m_stride; }                                                             ///< @brief distance in bytes between the starts of two consecutive columns
+  int8_t* column(const uint32_t variant) { return m_data + variant * m_stride; }                         ///< @brief values of all samples for a variant @warning no bounds checking
+  const int8_t* column(const uint32_t variant) const { return m_data + variant * m_stride; }             ///< @brief values of all samples for a variant @warning no bounds checking
+  int8_t operator()(const uint32_t sample, const uint32_t variant) const { return column(variant)[sample]; } ///< @brief value of a sample for a variant @warning no bounds checking
+  int8_t* data() { return m_data; }                                                                      ///< @brief start of the first column
+  const int8_t* data() const { return m_data; }                                                          ///< @brief start of the first column
+
+ private:
+  uint32_t m_n_samples;                   ///< number of rows
+  uint32_t m_n_variants;                  ///< number of columns
+  size_t m_stride;                        ///< column size rounded up to the alignment
+  std::unique_ptr<int8_t[]> m_storage;    ///< over-allocated buffer holding the aligned columns
+  int8_t* m_data;                         ///< first aligned byte of the storage
+
+  static int8_t* align(int8_t* ptr) {
+    const auto address = reinterpret_cast<uintptr_t>(ptr);
+    return ptr + (alignment - address % alignment) % alignment;
+  }
+};
+
+/**
+ * @brief decodes the GT field of variants straight into the columns of a GenotypeMatrix
+ *
+ * The packed GT values are read directly from the htslib record, without creating Genotype objects, with
+ * branch-free loops specialized for every BCF integer width and for diploid calls (the common case), which
+ * the compiler vectorises. Blocks of variants can be extracted from any variant iterator:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * auto reader = SingleVariantReader{filename};
+ * auto matrix = GenotypeMatrix{reader.header().n_samples(), 4096};
+ * const auto builder = GenotypeMatrixBuilder{};
+ * auto it = reader.begin();
+ * const auto end = reader.end();
+ * while (const auto n_variants = builder.fill(it, end, matrix))
+ *   update_pca(matrix, n_variants);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * Genotypes with any missing allele are encoded as GenotypeMatrix::missing, and so are all the samples of
+ * variants without a GT field. Alleles past the ploidy of a sample (vector end values) are ignored.
+ */
+class GenotypeMatrixBuilder {
+ public:
+  /**
+   * @brief creates a builder for the given encoding
+   *
+   * @param encoding what the values count (non-reference alleles by default)
+   * @param allele the allele counted by the ALLELE_COUNT encoding (0 is the reference, 1 the first alternate, ...). Ignored by DOSAGE.
+   */
+  explicit GenotypeMatrixBuilder(const GenotypeMatrixEncoding encoding = GenotypeMatrixEncoding::DOSAGE, const uint32_t allele = 1);
+
+  /**
+   * @brief decodes the genotypes of all samples of a variant
+   *
+   * @param variant the variant to decode
+   * @param column destination for variant.n_samples() values (any memory, not necessarily a GenotypeMatrix column)
+   */
+  void decode(const Variant& variant, int8_t* column) const;
+
+  /**
+   * @brief decodes the next block of variants into the columns of a matrix
+   *
+   * @param it the iterator to consume variants from. It's left pointing at the first variant that didn't fit.
+   * @param end the end iterator of the same reader
+   * @param matrix the matrix to fill. Its number of rows must match the number of samples of the variants.
+   * @return the number of columns filled (only less than matrix.n_variants() when the iterator is exhausted, 0 if it already was)
+   * @throws std::invalid_argument if a variant doesn't have as many samples as the matrix has rows
+   */
+  template<class ITERATOR>
+  uint32_t fill(ITERATOR& it, const ITERATOR& end, GenotypeMatrix& matrix) const {
+    auto n_columns = 0u;
+    for (; n_columns < matrix.n_variants() && it != end; ++it, ++n_columns) {
+      const auto& variant = *it;
+      if (variant.n_samples() != matrix.n_samples())
+        throw std::invalid_argument{"variant has " + std::to_string(variant.n_samples()) + " samples but the genotype matrix has " + std::to_string(matrix.n_samples()) + " rows"};
+      decode(variant, matrix.column(n_columns));
+    }
+    return n_columns;
+  }
+
+ private:
+  int32_t m_first_key;  ///< smallest encoded allele (BCF GT value >> 1) that is counted
+  int32_t m_last_key;   ///< largest encoded allele (BCF GT value >> 1) that is counted
+};
+
+}
+
+#endif // gamgee__genotype_matrix__guard
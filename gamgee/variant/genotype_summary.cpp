@@ -0,0 +1,100 @@
+#include "genotype_summary.h"
+
+#include "htslib/vcf.h"
+
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace gamgee {
+
+GenotypeSummary::GenotypeSummary(const Variant& variant) {
+  assign(variant);
+}
+
+void GenotypeSummary::assign(const Variant& variant) {
+  m_n_samples = variant.n_samples();
+  m_hom_ref = m_het = m_hom_var = m_missing = m_partially_missing = 0;
+  m_allele_number = m_phased = m_multiploid = 0;
+  m_allele_counts.assign(variant.n_alleles(), 0);
+  const auto format_ptr = variant.raw_individual_field("GT");
+  if (format_ptr == nullptr || format_ptr->n == 0) {
+    m_ploidy_counts.assign(1, m_n_samples);
+    m_missing = m_n_samples;
+    return;
+  }
+  const auto max_ploidy = uint32_t(format_ptr->n);
+  m_ploidy_counts.assign(max_ploidy + 1, 0);
+  switch (format_ptr->type) {
+    case BCF_BT_INT8:
+      summarize(reinterpret_cast<const int8_t*>(format_ptr->p), max_ploidy, int8_t(bcf_int8_vector_end));
+      break;
+    case BCF_BT_INT16:
+      summarize(reinterpret_cast<const int16_t*>(format_ptr->p), max_ploidy, int16_t(bcf_int16_vector_end));
+      break;
+    case BCF_BT_INT32:
+      summarize(reinterpret_cast<const int32_t*>(format_ptr->p), max_ploidy, int32_t(bcf_int32_vector_end));
+      break;
+    default:
+      throw invalid_argument("unknown GT field type: " + to_string(format_ptr->type));
+  }
+}
+
+template<class TYPE>
+void GenotypeSummary::summarize(const TYPE* values, const uint32_t max_ploidy, const TYPE vector_end) {
+  // the constant ploidy lets the compiler unroll the allele loop of the common diploid case
+  if (max_ploidy == 2) {
+    for (auto sample = 0u; sample < m_n_samples; ++sample)
+      add_sample(values + 2 * sample, 2, vector_end);
+  }
+  else {
+    for (auto sample = 0u; sample < m_n_samples; ++sample)
+      add_sample(values + sample * max_ploidy, max_ploidy, vector_end);
+  }
+}
+
+/**
+ * A BCF GT value is (allele + 1) << 1 | phased. Missing alleles are 0 or 1 (or the type's missing value, which
+ * is negative) and samples with a smaller ploidy than the maximum are padded with the type's vector end value.
+ * The phased bit of the first allele is never set, so a sample is phased if all the others have it.
+ */
+template<class TYPE>
+inline void GenotypeSummary::add_sample(const TYPE* values, const uint32_t max_ploidy, const TYPE vector_end) {
+  const auto n_alleles = int32_t(m_allele_counts.size());
+  auto ploidy = 0u;
+  auto called = 0u;
+  auto first_key = -1;
+  auto mixed = false;
+  auto phased = true;
+  for (; ploidy < max_ploidy && values[ploidy] != vector_end; ++ploidy) {
+    const int32_t value = values[ploidy];
+    const auto key = (value >> 1) - 1;
+    phased &= ploidy == 0 || (value & 1) != 0;
+    if (value < 2 || key >= n_alleles)
+      continue;
+    ++m_allele_counts[key];
+    ++called;
+    mixed |= first_key >= 0 && key != first_key;
+    if (first_key < 0)
+      first_key = key;
+  }
+  ++m_ploidy_counts[ploidy];
+  m_allele_number += called;
+  if (ploidy >= 2) {
+    ++m_multiploid;
+    m_phased += phased;
+  }
+  if (called == 0)
+    ++m_missing;
+  else if (called < ploidy)
+    ++m_partially_missing;
+  else if (mixed)
+    ++m_het;
+  else if (first_key == 0)
+    ++m_hom_ref;
+  else
+    ++m_hom_var;
+}
+
+}
@@ -0,0 +1,84 @@
+#ifndef gamgee__genotype_summary__guard
+#define gamgee__genotype_summary__guard
+
+#include "variant.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace gamgee {
+
+/**
+ * @brief genotype class counts, allele counts, ploidies and phasing of all the samples of a site
+ *
+ * Everything is computed in a single pass over the GT bytes of the record, with a loop specialized for each BCF
+ * integer width, instead of going through Genotype objects (whose hom_ref(), hom_var(), ... decode the alleles
+ * of every sample again). The per allele and per ploidy counters are reused by assign(), so summarizing all the
+ * records of a file with one object only allocates when a record has more alleles or a higher ploidy than all the
+ * previous ones:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * auto summary = GenotypeSummary{};
+ * for (const auto& record : SingleVariantReader{filename}) {
+ *   summary.assign(record);
+ *   cout << summary.hom_ref() << " " << summary.het() << " " << summary.hom_var() << " AC=" << summary.allele_count(1) << " AN=" << summary.allele_number() << endl;
+ * }
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * Every sample falls in exactly one of the classes hom_ref, het, hom_var, missing and partially_missing. The
+ * first three follow Genotype::hom_ref(), Genotype::het() and Genotype::hom_var() for fully called samples of
+ * any ploidy (so a triploid 0/0/1 is het). The called alleles of partially missing samples still count towards
+ * AC and AN, as in bcftools. Allele indices past the alleles of the record are treated as missing, as in
+ * Genotype::allele_keys().
+ */
+class GenotypeSummary {
+ public:
+  GenotypeSummary() = default;                       ///< @brief creates an empty summary, see assign()
+  explicit GenotypeSummary(const Variant& variant);  ///< @brief summarizes the genotypes of a variant
+
+  /**
+   * @brief replaces the summary with the one of another variant, reusing the memory
+   * @throws std::invalid_argument if the GT field has an unknown type
+   */
+  void assign(const Variant& variant);
+
+  uint32_t n_samples() const { return m_n_samples; }                   ///< @brief number of samples in the record
+  uint32_t hom_ref() const { return m_hom_ref; }                       ///< @brief number of samples with all alleles the reference
+  uint32_t het() const { return m_het; }                               ///< @brief number of fully called samples with differing alleles
+  uint32_t hom_var() const { return m_hom_var; }                       ///< @brief number of samples with all alleles the same alternate
+  uint32_t missing() const { return m_missing; }                       ///< @brief number of samples without any called allele (including those with no GT value at all)
+  uint32_t partially_missing() const { return m_partially_missing; }   ///< @brief number of samples with both called and missing alleles
+  uint32_t called() const { return m_hom_ref + m_het + m_hom_var; }    ///< @brief number of fully called samples
+
+  uint32_t n_alleles() const { return uint32_t(m_allele_counts.size()); }                                ///< @brief number of alleles in the record, including the reference
+  uint32_t allele_count(const uint32_t allele) const { return m_allele_counts[allele]; }                 ///< @brief number of called copies of an allele (0 is the reference) @warning no bounds checking
+  uint32_t alt_allele_count() const { return m_allele_number - (m_allele_counts.empty() ? 0 : m_allele_counts[0]); } ///< @brief number of called alternate alleles
+  uint32_t allele_number() const { return m_allele_number; }                                             ///< @brief number of called alleles (AN)
+  double allele_frequency(const uint32_t allele) const { return m_allele_number == 0 ? 0.0 : double(m_allele_counts[allele]) / m_allele_number; } ///< @brief allele_count(allele) / allele_number(), or 0 if no allele is called @warning no bounds checking
+
+  uint32_t max_ploidy() const { return uint32_t(m_ploidy_counts.size()) - 1; }                           ///< @brief largest ploidy the GT field can hold (0 if there is no GT field)
+  uint32_t ploidy_count(const uint32_t ploidy) const { return ploidy < m_ploidy_counts.size() ? m_ploidy_counts[ploidy] : 0; } ///< @brief number of samples with a given ploidy (0 for samples with no GT value)
+
+  uint32_t phased() const { return m_phased; }                                                           ///< @brief number of samples with ploidy 2 or more and all their alleles phased
+  double phased_fraction() const { return m_multiploid == 0 ? 0.0 : double(m_phased) / m_multiploid; } ///< @brief phased samples over samples with ploidy 2 or more, or 0 if there are none
+
+ private:
+  uint32_t m_n_samples {0};
+  uint32_t m_hom_ref {0};
+  uint32_t m_het {0};
+  uint32_t m_hom_var {0};
+  uint32_t m_missing {0};
+  uint32_t m_partially_missing {0};
+  uint32_t m_allele_number {0};
+  uint32_t m_phased {0};
+  uint32_t m_multiploid {0};                     ///< number of samples with ploidy 2 or more
+  std::vector<uint32_t> m_allele_counts {};      ///< AC of every allele, including the reference
+  std::vector<uint32_t> m_ploidy_counts {0};     ///< number of samples by ploidy, from 0 to the maximum ploidy
+
+  template<class TYPE> void summarize(const TYPE* values, const uint32_t max_ploidy, const TYPE vector_end);
+  template<class TYPE> void add_sample(const TYPE* values, const uint32_t max_ploidy, const TYPE vector_end);
+};
+
+}
+
+#endif // gamgee__genotype_summary__guard
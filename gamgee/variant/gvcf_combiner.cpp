@@ -0,0 +1,449 @@
+#include "gvcf_combiner.h"
+
+#include "../missing.h"
+#include "../utils/genotype_utils.h"
+#include "../utils/utils.h"
+#include "../utils/variant_field_type.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace gamgee {
+
+namespace {
+
+bool is_non_ref(const char* allele) {
+  return strcmp(allele, "<NON_REF>") == 0 || strcmp(allele, "<*>") == 0;
+}
+
+bool is_symbolic(const char* allele) {
+  return allele[0] == '<' || strcmp(allele, "*") == 0;
+}
+
+// index of the diploid genotype a/b in the VCF order of Number=G fields
+uint32_t genotype_index(const uint32_t a, const uint32_t b) {
+  return a <= b ? b * (b + 1) / 2 + a : a * (a + 1) / 2 + b;
+}
+
+// a Number=G field with one value per allele is haploid (which is ambiguous with a single allele, taken as diploid)
+bool haploid(const uint32_t n_alleles, const uint32_t n_values) {
+  return n_alleles > 1 && n_values == n_alleles;
+}
+
+template<class VALUE> VALUE convert_value(const uint8_t* data_ptr, const int index, const uint8_t bytes, const utils::VariantFieldType type);
+template<> int32_t convert_value<int32_t>(const uint8_t* data_ptr, const int index, const uint8_t bytes, const utils::VariantFieldType type) {
+  return utils::convert_data_to_integer(data_ptr, index, bytes, type);
+}
+template<> float convert_value<float>(const uint8_t* data_ptr, const int index, const uint8_t bytes, const utils::VariantFieldType type) {
+  return utils::convert_data_to_float(data_ptr, index, bytes, type);
+}
+
+template<class VALUE> VALUE missing_value();
+template<> int32_t missing_value<int32_t>() { return bcf_int32_missing; }
+template<> float missing_value<float>() { auto value = 0.0f; bcf_float_set_missing(value); return value; }
+
+}
+
+GVCFCombiner::GVCFCombiner(const InputOrderedVariantHeaderMerger& header_merger, const std::vector<std::shared_ptr<bcf_hdr_t>>& input_headers) :
+  m_header_merger {header_merger},
+  m_builder {header_merger.get_merged_header()},
+  m_n_samples {uint32_t(bcf_hdr_nsamples(header_merger.get_raw_merged_header().get()))},
+  m_genotype_index {-1},
+  m_end_index {-1},
+  m_fields {},
+  m_present_fields {},
+  m_genotypes {m_builder.get_genotype_multi_sample_vector(0, 0)},
+  m_genotype_width {0},
+  m_alleles_lut {std::max(uint32_t(input_headers.size()), 1u)},
+  m_alleles {},
+  m_n_alleles {0},
+  m_alt_alleles {},
+  m_allele {},
+  m_non_ref {-1},
+  m_allele_map {},
+  m_merged_alleles {},
+  m_sample_map {},
+  m_records {},
+  m_input_stamps(input_headers.size(), 0),
+  m_sample_stamps(m_n_samples, 0),
+  m_stamp {0}
+{
+  m_builder.set_enable_validation(false);   // everything set comes from the merged header
+  const auto header = header_merger.get_raw_merged_header().get();
+  m_genotype_index = bcf_hdr_id2int(header, BCF_DT_ID, "GT");
+  m_end_index = bcf_hdr_id2int(header, BCF_DT_ID, "END");
+  if (m_end_index >= 0 && !bcf_hdr_idinfo_exists(header, BCF_HL_INFO, m_end_index))
+    m_end_index = -1;
+  m_fields.reserve(header->n[BCF_DT_ID]);
+  for (auto id = 0; id < header->n[BCF_DT_ID]; ++id) {
+    auto type = -1;
+    auto number = BCF_VL_FIXED;
+    if (id != m_genotype_index && bcf_hdr_idinfo_exists(header, BCF_HL_FMT, id)) {
+      type = bcf_hdr_id2type(header, BCF_HL_FMT, id);
+      number = bcf_hdr_id2length(header, BCF_HL_FMT, id);
+      if (type != BCF_HT_INT && type != BCF_HT_REAL && type != BCF_HT_STR)
+        type = -1;
+    }
+    m_fields.push_back(Field{type, number, 0, m_builder.get_integer_multi_sample_vector(0, 0), m_builder.get_float_multi_sample_vector(0, 0), {}});
+  }
+}
+
+Variant GVCFCombiner::combine(const std::vector<VariantIndexPair>& records) {
+  auto combined = Variant{};
+  combine_into(records, combined);
+  return combined;
+}
+
+void GVCFCombiner::combine_into(const std::vector<VariantIndexPair>& records, Variant& combined) {
+  if (records.empty())
+    throw std::invalid_argument{"there are no records to combine"};
+  reset_alleles_lut();
+  next_stamp();
+  m_builder.clear();
+  select_records(records);
+  merge_alleles();
+  set_site();
+  size_fields();
+  for (const auto& record : m_records) {
+    map_alleles(record);
+    map_samples(record);
+    for (auto i = 0u; i < record.body->n_fmt; ++i) {
+      const auto format_ptr = &record.body->d.fmt[i];
+      if (format_ptr->p == nullptr)
+        continue;
+      const auto merged_index = m_header_merger.get_merged_header_idx_for_input(record.input, format_ptr->id);
+      if (missing(merged_index))
+        continue;
+      if (merged_index == m_genotype_index) {
+        fill_genotypes(record, format_ptr);
+        continue;
+      }
+      auto& field = m_fields[merged_index];
+      if (field.width == 0)
+        continue;
+      switch (field.type) {
+        case BCF_HT_INT:  fill_values(record, format_ptr, field, field.integers); break;
+        case BCF_HT_REAL: fill_values(record, format_ptr, field, field.floats); break;
+        case BCF_HT_STR:  fill_strings(format_ptr, field); break;
+        default: break;
+      }
+    }
+  }
+  set_fields();
+  m_builder.build_into(combined);
+}
+
+/**
+ * @brief moves on to the next position, so every input and merged sample is free to be filled again
+ */
+void GVCFCombiner::next_stamp() {
+  if (++m_stamp == 0) {   // wrapped around: the old stamps could match again
+    std::fill(m_input_stamps.begin(), m_input_stamps.end(), 0u);
+    std::fill(m_sample_stamps.begin(), m_sample_stamps.end(), 0u);
+    m_stamp = 1;
+  }
+}
+
+/**
+ * @brief removes the allele mappings of the previous position (cheaper than resetting the whole LUT for a few inputs)
+ */
+void GVCFCombiner::reset_alleles_lut() {
+  for (const auto& record : m_records) {
+    for (auto allele = 0u; allele < record.n_alleles; ++allele) {
+      const auto merged_allele = m_alleles_lut.get_merged_idx_for_input(record.input, allele);
+      if (missing(merged_allele))
+        continue;
+      m_alleles_lut.reset_input_idx_for_merged(record.input, merged_allele);
+      m_alleles_lut.reset_merged_idx_for_input(record.input, allele);
+    }
+  }
+  m_records.clear();
+}
+
+/**
+ * @brief takes the first record of every input, unpacks it and finds the longest reference allele
+ */
+void GVCFCombiner::select_records(const std::vector<VariantIndexPair>& records) {
+  auto total_alleles = 1u;
+  auto ref_index = 0u;
+  auto ref_length = size_t{0};
+  for (const auto& variant_pair : records) {
+    const auto input = variant_pair.second;
+    if (m_input_stamps[input] == m_stamp)
+      continue;
+    m_input_stamps[input] = m_stamp;
+    const auto body = variant_pair.first.raw_body();
+    const auto length = strlen(body->d.allele[0]);
+    if (length > ref_length) {
+      ref_length = length;
+      ref_index = uint32_t(m_records.size());
+    }
+    total_alleles += body->n_allele;
+    m_records.push_back(Record{body, input, body->n_allele, -1});
+  }
+  m_alleles_lut.resize_luts_if_needed(total_alleles);
+  if (m_alleles.empty())
+    m_alleles.emplace_back();
+  m_alleles[0].assign(m_records[ref_index].body->d.allele[0]);
+}
+
+/**
+ * @brief merges the alt alleles of all the records, keeping <NON_REF> for last
+ */
+void GVCFCombiner::merge_alleles() {
+  const auto& ref = m_alleles[0];
+  m_n_alleles = 1;
+  m_non_ref = -1;
+  auto non_ref_spelling = static_cast<const char*>(nullptr);
+  for (auto& record : m_records) {
+    const auto alleles = record.body->d.allele;
+    const auto ref_length = strlen(alleles[0]);
+    m_alleles_lut.add_input_merged_idx_pair(record.input, 0, 0);
+    for (auto allele = 1u; allele < record.n_alleles; ++allele) {
+      if (is_non_ref(alleles[allele])) {
+        record.non_ref = int32_t(allele);
+        if (non_ref_spelling == nullptr)
+          non_ref_spelling = alleles[allele];
+        continue;
+      }
+      m_allele.assign(alleles[allele]);
+      if (!is_symbolic(alleles[allele]) && ref_length < ref.size())
+        m_allele.append(ref, ref_length, std::string::npos);
+      auto merged_allele = 1u;
+      while (merged_allele < m_n_alleles && m_alleles[merged_allele] != m_allele)
+        ++merged_allele;
+      if (merged_allele == m_n_alleles) {
+        if (m_n_alleles == m_alleles.size())
+          m_alleles.push_back(m_allele);
+        else
+          m_alleles[m_n_alleles].assign(m_allele);
+        ++m_n_alleles;
+      }
+      m_alleles_lut.add_input_merged_idx_pair(record.input, int(allele), int(merged_allele));
+    }
+  }
+  if (non_ref_spelling != nullptr) {
+    m_non_ref = int32_t(m_n_alleles);
+    if (m_n_alleles == m_alleles.size())
+      m_alleles.emplace_back(non_ref_spelling);
+    else
+      m_alleles[m_n_alleles].assign(non_ref_spelling);
+    ++m_n_alleles;
+    for (const auto& record : m_records) {
+      if (record.non_ref >= 0)
+        m_alleles_lut.add_input_merged_idx_pair(record.input, record.non_ref, m_non_ref);
+    }
+  }
+}
+
+/**
+ * @brief sets the location and alleles of the combined record (and its END if it's a reference block)
+ */
+void GVCFCombiner::set_site() {
+  const auto first = m_records.front().body;
+  m_builder.set_chromosome(uint32_t(first->rid));
+  m_builder.set_alignment_start(uint32_t(first->pos + 1));
+  m_builder.set_ref_allele(m_alleles[0]);
+  if (m_n_alleles > 1) {
+    m_alt_alleles.resize(m_n_alleles - 1);
+    for (auto allele = 1u; allele < m_n_alleles; ++allele)
+      m_alt_alleles[allele - 1].assign(m_alleles[allele]);
+    m_builder.set_alt_alleles(m_alt_alleles);
+  }
+  const auto reference_block = m_n_alleles == 1 || (m_n_alleles == 2 && m_non_ref == 1);
+  if (!reference_block)
+    return;
+  auto stop = UINT32_MAX;
+  for (const auto& record : m_records)
+    stop = std::min(stop, uint32_t(record.body->pos + record.body->rlen));
+  if (stop <= uint32_t(first->pos) + m_alleles[0].size())   // not longer than the reference allele
+    return;
+  m_builder.set_alignment_stop(stop);
+  if (m_end_index >= 0)
+    m_builder.set_integer_shared_field(uint32_t(m_end_index), int32_t(stop));
+}
+
+/**
+ * @brief finds how many values per sample every FORMAT field takes at this position and resets their sample vectors
+ */
+void GVCFCombiner::size_fields() {
+  for (const auto index : m_present_fields)
+    m_fields[index].width = 0;
+  m_present_fields.clear();
+  m_genotype_width = 0;
+  for (const auto& record : m_records) {
+    for (auto i = 0u; i < record.body->n_fmt; ++i) {
+      const auto format_ptr = &record.body->d.fmt[i];
+      if (format_ptr->p == nullptr)
+        continue;
+      const auto merged_index = m_header_merger.get_merged_header_idx_for_input(record.input, format_ptr->id);
+      if (missing(merged_index))
+        continue;
+      if (merged_index == m_genotype_index) {
+        m_genotype_width = std::max(m_genotype_width, uint32_t(format_ptr->n));
+        continue;
+      }
+      auto& field = m_fields[merged_index];
+      if (field.type < 0)
+        continue;
+      auto width = uint32_t(format_ptr->n);
+      switch (field.number) {
+        case BCF_VL_A: width = m_n_alleles - 1; break;
+        case BCF_VL_R: width = m_n_alleles; break;
+        case BCF_VL_G: width = haploid(record.n_alleles, width) ? m_n_alleles : genotype_index(m_n_alleles - 1, m_n_alleles - 1) + 1; break;
+        default: break;
+      }
+      if (field.width == 0 && width > 0)
+        m_present_fields.push_back(uint32_t(merged_index));
+      field.width = std::max(field.width, width);
+    }
+  }
+  if (m_genotype_width > 0)
+    m_genotypes.reset(m_n_samples, m_genotype_width);
+  for (const auto index : m_present_fields) {
+    auto& field = m_fields[index];
+    switch (field.type) {
+      case BCF_HT_INT:  field.integers.reset(m_n_samples, field.width); break;
+      case BCF_HT_REAL: field.floats.reset(m_n_samples, field.width); break;
+      case BCF_HT_STR:
+        field.strings.resize(m_n_samples);
+        for (auto& value : field.strings)
+          value.assign(".");
+        break;
+      default: break;
+    }
+  }
+}
+
+/**
+ * @brief finds the allele of the record for every merged allele: the same allele, or else the record's <NON_REF>
+ */
+void GVCFCombiner::map_alleles(const Record& record) {
+  m_allele_map.resize(m_n_alleles);
+  m_alleles_lut.get_input_idxs_for_merged(record.input, m_n_alleles, m_allele_map.data());
+  for (auto& allele : m_allele_map)
+    allele = missing(allele) ? record.non_ref : allele;
+  m_merged_alleles.resize(record.n_alleles);
+  m_alleles_lut.get_merged_idxs_for_input(record.input, record.n_alleles, m_merged_alleles.data());
+}
+
+/**
+ * @brief places the samples of the record, skipping the ones an earlier input already filled at this position
+ */
+void GVCFCombiner::map_samples(const Record& record) {
+  m_sample_map.resize(record.body->n_sample);
+  m_header_merger.get_merged_sample_idxs_for_input(record.input, record.body->n_sample, m_sample_map.data());
+  for (auto& merged_sample : m_sample_map) {
+    if (missing(merged_sample) || m_sample_stamps[merged_sample] == m_stamp) {
+      merged_sample = -1;
+      continue;
+    }
+    m_sample_stamps[merged_sample] = m_stamp;
+  }
+}
+
+void GVCFCombiner::fill_genotypes(const Record& record, const bcf_fmt_t* format_ptr) {
+  for (auto sample = 0u; sample < m_sample_map.size(); ++sample) {
+    const auto merged_sample = m_sample_map[sample];
+    if (merged_sample < 0)
+      continue;
+    const auto data_ptr = format_ptr->p + sample * format_ptr->size;
+    for (auto i = 0u; i < uint32_t(format_ptr->n); ++i) {
+      const auto allele = utils::allele_key(format_ptr, data_ptr, i);
+      if (allele == bcf_int32_vector_end)
+        break;
+      auto merged_allele = -1;
+      if (!missing(allele) && allele >= 0 && uint32_t(allele) < record.n_alleles && !missing(m_merged_alleles[allele]))
+        merged_allele = m_merged_alleles[allele];
+      m_genotypes.set_sample_value(uint32_t(merged_sample), i, merged_allele);
+    }
+  }
+}
+
+template<class VALUE>
+void GVCFCombiner::fill_values(const Record& record, const bcf_fmt_t* format_ptr, const Field& field, VariantBuilderMultiSampleVector<VALUE>& values) {
+  const auto type = static_cast<utils::VariantFieldType>(format_ptr->type);
+  if (type == utils::VariantFieldType::STRING)
+    return;
+  const auto bytes = utils::size_for_type(type, format_ptr);
+  const auto n_values = uint32_t(format_ptr->n);
+  const auto missing_val = missing_value<VALUE>();
+  // the value of the record at an index, missing past its end
+  const auto value_at = [&](const uint8_t* data_ptr, const int32_t index, const uint32_t n_sample_values) {
+    if (index < 0 || uint32_t(index) >= n_sample_values)
+      return missing_val;
+    return convert_value<VALUE>(data_ptr, index, bytes, type);
+  };
+  for (auto sample = 0u; sample < m_sample_map.size(); ++sample) {
+    const auto merged_sample = m_sample_map[sample];
+    if (merged_sample < 0)
+      continue;
+    const auto data_ptr = format_ptr->p + sample * format_ptr->size;
+    auto n_sample_values = 0u;   // the values before the vector end
+    while (n_sample_values < n_values && !utils::bcf_is_vector_end_value(convert_value<VALUE>(data_ptr, int(n_sample_values), bytes, type)))
+      ++n_sample_values;
+    switch (field.number) {
+      case BCF_VL_A:
+        for (auto merged_allele = 1u; merged_allele < m_n_alleles; ++merged_allele) {
+          const auto allele = m_allele_map[merged_allele];
+          values.set_sample_value(uint32_t(merged_sample), merged_allele - 1, value_at(data_ptr, allele - 1, n_sample_values));
+        }
+        break;
+      case BCF_VL_R:
+        for (auto merged_allele = 0u; merged_allele < m_n_alleles; ++merged_allele)
+          values.set_sample_value(uint32_t(merged_sample), merged_allele, value_at(data_ptr, m_allele_map[merged_allele], n_sample_values));
+        break;
+      case BCF_VL_G:
+        if (haploid(record.n_alleles, n_sample_values)) {
+          for (auto merged_allele = 0u; merged_allele < m_n_alleles; ++merged_allele)
+            values.set_sample_value(uint32_t(merged_sample), merged_allele, value_at(data_ptr, m_allele_map[merged_allele], n_sample_values));
+        }
+        else if (n_sample_values == genotype_index(record.n_alleles - 1, record.n_alleles - 1) + 1) {
+          for (auto b = 0u; b < m_n_alleles; ++b) {
+            for (auto a = 0u; a <= b; ++a) {
+              const auto allele_a = m_allele_map[a];
+              const auto allele_b = m_allele_map[b];
+              const auto index = allele_a < 0 || allele_b < 0 ? -1 : int32_t(genotype_index(uint32_t(allele_a), uint32_t(allele_b)));
+              values.set_sample_value(uint32_t(merged_sample), genotype_index(a, b), value_at(data_ptr, index, n_sample_values));
+            }
+          }
+        }
+        break;   // any other ploidy is left missing
+      default:
+        for (auto i = 0u; i < std::min(n_sample_values, field.width); ++i)
+          values.set_sample_value(uint32_t(merged_sample), i, convert_value<VALUE>(data_ptr, int(i), bytes, type));
+        break;
+    }
+  }
+}
+
+void GVCFCombiner::fill_strings(const bcf_fmt_t* format_ptr, Field& field) {
+  if (static_cast<utils::VariantFieldType>(format_ptr->type) != utils::VariantFieldType::STRING)
+    return;
+  for (auto sample = 0u; sample < m_sample_map.size(); ++sample) {
+    const auto merged_sample = m_sample_map[sample];
+    if (merged_sample < 0)
+      continue;
+    const auto data_ptr = reinterpret_cast<const char*>(format_ptr->p + sample * format_ptr->size);
+    const auto length = strnlen(data_ptr, format_ptr->n);
+    if (length > 0)
+      field.strings[merged_sample].assign(data_ptr, length);
+  }
+}
+
+void GVCFCombiner::set_fields() {
+  if (m_genotype_width > 0)
+    m_builder.set_genotypes(m_genotypes);
+  for (const auto index : m_present_fields) {
+    const auto& field = m_fields[index];
+    switch (field.type) {
+      case BCF_HT_INT:  m_builder.set_integer_individual_field(index, field.integers); break;
+      case BCF_HT_REAL: m_builder.set_float_individual_field(index, field.floats); break;
+      case BCF_HT_STR:  m_builder.set_string_individual_field(index, field.strings); break;
+      default: break;
+    }
+  }
+}
+
+}
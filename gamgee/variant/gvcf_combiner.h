@@ -0,0 +1,149 @@
+#ifndef gamgee__gvcf_combiner__guard
+#define gamgee__gvcf_combiner__guard
+
+#include "variant.h"
+#include "variant_builder.h"
+#include "variant_header.h"
+#include "variant_header_merger.h"
+#include "multiple_variant_iterator.h"
+
+#include "../utils/merged_vcf_lut.h"
+
+#include "htslib/vcf.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gamgee {
+
+/**
+ * @brief combines the records of many gVCF files at one position into a single multi-sample record
+ *
+ * Meant to consume the vectors of a ReferenceBlockSplittingVariantIterator, where all the records start at the
+ * same position and the reference blocks are split to line up:
+ *
+ *   auto reader = MultipleVariantReader<ReferenceBlockSplittingVariantIterator>{filenames};
+ *   auto combiner = GVCFCombiner{reader.get_variant_header_merger(), reader.get_input_vcf_headers()};
+ *   for (const auto& records : reader)
+ *     writer.add_record(combiner.combine(records));
+ *
+ * The combined record has the longest reference allele of the inputs, and the alt alleles of all the inputs
+ * (extended with the rest of that reference allele where their own is shorter) in the order they first appear,
+ * followed by a single <NON_REF> if any input has one. The allele indices of every input are kept in a
+ * CombineAllelesLUT.
+ *
+ * The samples are placed where the sample LUT of the header merger puts them. Their FORMAT fields are remapped by
+ * the Number of the field in the merged header: per allele (R), per alt allele (A) and per genotype (G, haploid or
+ * diploid) fields take the value of the same allele in the input, or the value of the input's <NON_REF> for the
+ * alleles the input doesn't have (missing if it has no <NON_REF>). Other fields (e.g. a Number=4 SB) are copied.
+ * GT alleles are remapped to the merged alleles. Samples without a record at the position are missing.
+ *
+ * Records with only a <NON_REF> alt allele are reference blocks, and so is the combined record when all of them
+ * are: it ends where the first of them ends (with an END tag if the merged header has one). The site level INFO
+ * annotations of the inputs are not combined.
+ *
+ * All the buffers (alleles, LUTs, per field sample vectors) are reused across positions, so once they have grown
+ * to the widest position the only allocation per position is the combined record itself.
+ *
+ * @note the records must be fully unpacked (read with VariantUnpackLevel::ALL)
+ * @note all the inputs must have the same chromosomes as the merged header (as the MultipleVariantReader checks)
+ * @note if an input has several records at a position, only the first is combined. If several inputs have a
+ * sample of the same name, the sample takes the values of the first of them with a record at the position.
+ * @note phasing is lost (VariantBuilder doesn't support phased genotypes)
+ */
+class GVCFCombiner {
+ public:
+  /**
+   * @brief prepares the combination of the records of the inputs of a header merger
+   *
+   * @param header_merger the merger of the headers of the inputs (must outlive the combiner)
+   * @param input_headers the headers of the inputs, in the order they were added to the merger
+   */
+  GVCFCombiner(const InputOrderedVariantHeaderMerger& header_merger, const std::vector<std::shared_ptr<bcf_hdr_t>>& input_headers);
+
+  GVCFCombiner(const GVCFCombiner&) = delete;
+  GVCFCombiner& operator=(const GVCFCombiner&) = delete;
+  GVCFCombiner(GVCFCombiner&&) = default;
+  GVCFCombiner& operator=(GVCFCombiner&&) = delete;
+
+  /**
+   * @brief combines the records of one position
+   *
+   * @param records the records of the position, paired with the index of their input
+   * @return a record of the merged header with all the samples
+   * @throws std::invalid_argument if there are no records
+   */
+  Variant combine(const std::vector<VariantIndexPair>& records);
+
+  /**
+   * @brief combines the records of one position into an existing record, reusing its memory
+   *
+   * @param records the records of the position, paired with the index of their input
+   * @param combined the record to overwrite (see VariantBuilder::build_into()), so combining a whole file into the
+   *        same record stops allocating once it has grown to the widest position
+   * @throws std::invalid_argument if there are no records
+   */
+  void combine_into(const std::vector<VariantIndexPair>& records, Variant& combined);
+
+  VariantHeader header() const { return m_builder.header(); } ///< @brief the merged header of the combined records
+
+ private:
+  struct Record {
+    const bcf1_t* body;
+    uint32_t input;
+    uint32_t n_alleles;
+    int32_t non_ref;                                   ///< index of the <NON_REF> allele of the record (-1 if it has none)
+  };
+
+  struct Field {
+    int32_t type;                                      ///< BCF_HT_INT, BCF_HT_REAL or BCF_HT_STR (-1 if the header id is not a FORMAT field that is combined)
+    int32_t number;                                    ///< BCF_VL_FIXED, BCF_VL_VAR, BCF_VL_A, BCF_VL_R or BCF_VL_G
+    uint32_t width;                                    ///< values per sample at the current position (0 if no record has the field)
+    VariantBuilderMultiSampleVector<int32_t> integers;
+    VariantBuilderMultiSampleVector<float> floats;
+    std::vector<std::string> strings;
+  };
+
+  const InputOrderedVariantHeaderMerger& m_header_merger;
+  VariantBuilder m_builder;
+  uint32_t m_n_samples;
+  int32_t m_genotype_index;                            ///< index of GT in the merged header (-1 if it has none)
+  int32_t m_end_index;                                 ///< index of END in the merged header (-1 if it has none)
+  std::vector<Field> m_fields;                         ///< indexed by merged header id
+  std::vector<uint32_t> m_present_fields;              ///< the fields that some record has at the current position
+  VariantBuilderMultiSampleVector<int32_t> m_genotypes;
+  uint32_t m_genotype_width;
+  utils::CombineAllelesLUT m_alleles_lut;              ///< input allele index <-> merged allele index, for every input
+  std::vector<std::string> m_alleles;                  ///< the merged alleles (the first m_n_alleles are current)
+  uint32_t m_n_alleles;
+  std::vector<std::string> m_alt_alleles;
+  std::string m_allele;                                ///< scratch space for an extended allele
+  int32_t m_non_ref;                                   ///< index of the merged <NON_REF> allele (-1 if no record has one)
+  std::vector<int32_t> m_allele_map;                   ///< merged allele index -> allele index of the current record
+  std::vector<int32_t> m_merged_alleles;               ///< allele index of the current record -> merged allele index
+  std::vector<int32_t> m_sample_map;                   ///< sample index of the current record -> merged sample index (-1 to skip it)
+  std::vector<Record> m_records;                       ///< the records combined at the current position
+  std::vector<uint32_t> m_input_stamps;                ///< last position an input was combined at
+  std::vector<uint32_t> m_sample_stamps;               ///< last position a merged sample was filled at
+  uint32_t m_stamp;                                    ///< the current position (counts combine() calls)
+
+  void next_stamp();
+  void reset_alleles_lut();
+  void select_records(const std::vector<VariantIndexPair>& records);
+  void merge_alleles();
+  void set_site();
+  void size_fields();
+  void map_alleles(const Record& record);
+  void map_samples(const Record& record);
+  void fill_genotypes(const Record& record, const bcf_fmt_t* format_ptr);
+  template<class VALUE>
+  void fill_values(const Record& record, const bcf_fmt_t* format_ptr, const Field& field, VariantBuilderMultiSampleVector<VALUE>& values);
+  void fill_strings(const bcf_fmt_t* format_ptr, Field& field);
+  void set_fields();
+};
+
+}
+
+#endif // gamgee__gvcf_combiner__guard
@@ -15,24 +15,38 @@ const std::vector<std::string> IndexedVariantIterator::all_intervals = {"."};
 IndexedVariantIterator::IndexedVariantIterator() :
   VariantIterator {},
   m_variant_index_ptr {},
+  m_tabix_ptr {},
   m_interval_list {},
   m_interval_iter {},
-  m_index_iter_ptr {}
+  m_index_iter_ptr {},
+  m_line {}
   {}
 
 IndexedVariantIterator::IndexedVariantIterator(const std::shared_ptr<htsFile>& file_ptr,
                                                const std::shared_ptr<hts_idx_t>& index_ptr,
                                                const std::shared_ptr<bcf_hdr_t>& header_ptr,
-                                               const std::vector<std::string>& interval_list) :
-  VariantIterator { file_ptr, header_ptr },
-  m_variant_index_ptr { index_ptr },
-  m_interval_list { interval_list.empty() ? all_intervals : interval_list },
-  m_interval_iter { m_interval_list.begin() },
-  m_index_iter_ptr { utils::make_unique_hts_itr(bcf_itr_querys(m_variant_index_ptr.get(), m_variant_header_ptr.get(), m_interval_iter->c_str())) }
+                                               const std::vector<std::string>& interval_list,
+                                               const VariantUnpackLevel unpack_level) :
+  IndexedVariantIterator { file_ptr, index_ptr, nullptr, header_ptr, interval_list, unpack_level }
 {
   fetch_next_record();
 }
 
+IndexedVariantIterator::IndexedVariantIterator(const std::shared_ptr<htsFile>& file_ptr,
+                                               const std::shared_ptr<hts_idx_t>& index_ptr,
+                                               const std::shared_ptr<tbx_t>& tabix_ptr,
+                                               const std::shared_ptr<bcf_hdr_t>& header_ptr,
+                                               const std::vector<std::string>& interval_list,
+                                               const VariantUnpackLevel unpack_level) :
+  VariantIterator { file_ptr, header_ptr, unpack_level, false },   // the index queries seek, a sequential read would be thrown away
+  m_variant_index_ptr { index_ptr },
+  m_tabix_ptr { tabix_ptr },
+  m_interval_list { interval_list.empty() ? all_intervals : interval_list },
+  m_interval_iter { m_interval_list.begin() },
+  m_index_iter_ptr { utils::make_unique_hts_itr(query_interval()) },
+  m_line { utils::make_unique_kstring() }
+{}
+
 bool IndexedVariantIterator::operator!=(const IndexedVariantIterator& rhs) {
   return m_variant_file_ptr != rhs.m_variant_file_ptr &&
     m_index_iter_ptr != rhs.m_index_iter_ptr;
@@ -43,16 +57,32 @@ bool IndexedVariantIterator::operator!=(const IndexedVariantIterator& rhs) {
  * @warning we're reusing the existing htslib memory, so users should be aware that all objects from the previous iteration are now stale unless a deep copy has been performed
  */
 void IndexedVariantIterator::fetch_next_record() {
-  while (bcf_itr_next(m_variant_file_ptr, m_index_iter_ptr.get(), m_variant_record_ptr.get()) < 0) {
+  while (read_indexed_record() < 0) {
     ++m_interval_iter;
     if (m_interval_list.end() == m_interval_iter) {
       m_variant_file_ptr.reset();
       m_variant_record = Variant{};
       return;
     }
-    m_index_iter_ptr.reset(bcf_itr_querys(m_variant_index_ptr.get(), m_variant_header_ptr.get(), m_interval_iter->c_str()));
+    m_index_iter_ptr.reset(query_interval());
   }
+  unpack_variant_record(m_variant_record_ptr.get(), m_variant_header_ptr.get(), m_unpack_level);
+  m_variant_record.invalidate_field_slots();
 }
 
+hts_itr_t* IndexedVariantIterator::query_interval() const {
+  if (m_tabix_ptr)
+    return tbx_itr_querys(m_tabix_ptr.get(), m_interval_iter->c_str());
+  return bcf_itr_querys(m_variant_index_ptr.get(), m_variant_header_ptr.get(), m_interval_iter->c_str());
 }
 
+int IndexedVariantIterator::read_indexed_record() {
+  if (!m_index_iter_ptr)
+    return -1;
+  if (!m_tabix_ptr)
+    return bcf_itr_next(m_variant_file_ptr, m_index_iter_ptr.get(), m_variant_record_ptr.get());
+  const auto status = tbx_itr_next(m_variant_file_ptr.get(), m_tabix_ptr.get(), m_index_iter_ptr.get(), m_line.get());
+  return status < 0 ? status : vcf_parse(m_line.get(), m_variant_header_ptr.get(), m_variant_record_ptr.get());
+}
+
+}
@@ -5,6 +5,7 @@
 
 #include "../utils/hts_memory.h"
 
+#include "htslib/tbx.h"
 #include "htslib/vcf.h"
 
 #include <memory>
@@ -30,11 +31,13 @@ class IndexedVariantIterator : public VariantIterator {
    * @param index_ptr           shared pointer to a BCF file index (CSI) created with the bcf_index_load() macro from htslib
    * @param header_ptr          shared pointer to a BCF file header created with the bcf_hdr_read() macro from htslib
    * @param interval_list       vector of intervals represented by strings
+   * @param unpack_level        how much of each record to decode (see VariantUnpackLevel)
    */
   IndexedVariantIterator(const std::shared_ptr<htsFile>& file_ptr,
                          const std::shared_ptr<hts_idx_t>& index_ptr,
                          const std::shared_ptr<bcf_hdr_t>& header_ptr,
-                         const std::vector<std::string>& interval_list = all_intervals);
+                         const std::vector<std::string>& interval_list = all_intervals,
+                         const VariantUnpackLevel unpack_level = VariantUnpackLevel::ALL);
 
   /**
    * @brief an IndexedVariantIterator cannot be copied safely, as it is iterating over a stream.
@@ -61,13 +64,34 @@ class IndexedVariantIterator : public VariantIterator {
   bool operator!=(const IndexedVariantIterator& rhs);
 
  protected:
+  /**
+   * @brief initializes a new iterator without reading its first record (see the public constructor)
+   *
+   * The file is read through its tabix (or CSI) index as VCF text if tabix_ptr is given, and through index_ptr as BCF
+   * otherwise. Nothing is read from the file until fetch_next_record(), so it doesn't need to be at any particular
+   * position (every interval query seeks).
+   *
+   * @param tabix_ptr           shared pointer to the index of a bgzipped VCF file loaded with tbx_index_load() from htslib (null for BCF)
+   */
+  IndexedVariantIterator(const std::shared_ptr<htsFile>& file_ptr,
+                         const std::shared_ptr<hts_idx_t>& index_ptr,
+                         const std::shared_ptr<tbx_t>& tabix_ptr,
+                         const std::shared_ptr<bcf_hdr_t>& header_ptr,
+                         const std::vector<std::string>& interval_list,
+                         const VariantUnpackLevel unpack_level);
+
   void fetch_next_record() override;                                       ///< fetches next Variant record into existing htslib memory without making a copy
 
  private:
   std::shared_ptr<hts_idx_t> m_variant_index_ptr;                          ///< pointer to the internal structure of the index file
+  std::shared_ptr<tbx_t> m_tabix_ptr;                                      ///< index of a VCF file (null when reading BCF through m_variant_index_ptr)
   std::vector<std::string> m_interval_list;                                ///< vector of intervals represented by strings
   std::vector<std::string>::const_iterator m_interval_iter;                ///< iterator for the interval list
   std::unique_ptr<hts_itr_t, utils::HtsIteratorDeleter> m_index_iter_ptr;  ///< pointer to the htslib BCF index iterator
+  std::unique_ptr<kstring_t, utils::KStringDeleter> m_line;                ///< the last VCF line read through the tabix index
+
+  hts_itr_t* query_interval() const;                                       ///< a new index iterator over the current interval (null if its contig is not in the index)
+  int read_indexed_record();                                               ///< reads the next record of the current interval (negative at its end)
 };
 
 }
@@ -5,6 +5,7 @@
 
 #include "../exceptions.h"
 #include "../utils/hts_memory.h"
+#include "../utils/variant_utils.h"
 
 #include "htslib/vcf.h"
 
@@ -37,13 +38,16 @@ class IndexedVariantReader {
    *
    * @param filename the name of the variant file
    * @param interval_list a vector of intervals represented by strings.  Empty vector for all intervals.
+   * @param options decompression threads and unpack level (see VariantReaderOptions)
    *
    */
-  IndexedVariantReader(const std::string& filename, const std::vector<std::string>& interval_list) :
+  IndexedVariantReader(const std::string& filename, const std::vector<std::string>& interval_list,
+                       const VariantReaderOptions& options = VariantReaderOptions{}) :
     m_variant_file_ptr {},
     m_variant_index_ptr {},
     m_variant_header_ptr {},
-    m_interval_list { interval_list }
+    m_interval_list { interval_list },
+    m_options { options }
   {
     init_reader(filename);
   }
@@ -63,7 +67,7 @@ class IndexedVariantReader {
   IndexedVariantReader& operator=(IndexedVariantReader&& other) = default;
 
   ITERATOR begin() const {
-    return ITERATOR{ m_variant_file_ptr, m_variant_index_ptr, m_variant_header_ptr, m_interval_list };
+    return ITERATOR{ m_variant_file_ptr, m_variant_index_ptr, m_variant_header_ptr, m_interval_list, m_options.unpack_level };
   }
 
   ITERATOR end() const {
@@ -80,6 +84,7 @@ class IndexedVariantReader {
   std::shared_ptr<hts_idx_t> m_variant_index_ptr;     ///< pointer to the internal structure of the index file
   std::shared_ptr<bcf_hdr_t> m_variant_header_ptr;    ///< pointer to the internal structure of the header file
   std::vector<std::string> m_interval_list;           ///< vector of intervals represented by strings
+  VariantReaderOptions m_options;                     ///< decompression threads and unpack level
 
   void init_reader(const std::string& filename) {
     // Need to check raw pointers for null before wrapping them in a shared_ptr to avoid a segfault
@@ -90,6 +95,7 @@ class IndexedVariantReader {
       throw FileOpenException{filename};
     }
     m_variant_file_ptr = utils::make_shared_hts_file(variant_file_ptr);
+    set_variant_decompression_threads(variant_file_ptr, m_options.decompression_threads);
 
     auto* index_file_ptr = bcf_index_load(filename.c_str());
     if ( index_file_ptr == nullptr ) {
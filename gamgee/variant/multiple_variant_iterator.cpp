@@ -1,15 +1,43 @@
 #include "multiple_variant_iterator.h"
 
+#include "../utils/hts_memory.h"
+
 namespace gamgee {
 
-MultipleVariantIterator::MultipleVariantIterator(const std::vector<std::shared_ptr<htsFile>>& variant_files, const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers) :
-  m_queue {},
+MultipleVariantIterator::MultipleVariantIterator(const std::vector<std::shared_ptr<htsFile>>& variant_files, const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers,
+                                                 const VariantUnpackLevel unpack_level, const uint32_t decoding_threads) :
+  m_inputs {},
+  m_tree {},
+  m_unpack_level {unpack_level},
+  m_decoding_pool {decoding_threads > 0 && !variant_files.empty() ? std::make_unique<VariantDecodingPool>(variant_files, variant_headers, unpack_level, decoding_threads) : nullptr},
+  m_budgeted_inputs {},
+  m_variant_vector {}
+{
+  init(variant_files, variant_headers);
+}
+
+MultipleVariantIterator::MultipleVariantIterator(std::unique_ptr<BudgetedVariantInputs> inputs, const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers,
+                                                 const VariantUnpackLevel unpack_level) :
+  m_inputs {},
+  m_tree {},
+  m_unpack_level {unpack_level},
+  m_decoding_pool {},
+  m_budgeted_inputs {std::move(inputs)},
   m_variant_vector {}
 {
+  init(std::vector<std::shared_ptr<htsFile>>(variant_headers.size()), variant_headers);
+}
+
+void MultipleVariantIterator::init(const std::vector<std::shared_ptr<htsFile>>& variant_files, const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers) {
+  m_inputs.reserve(variant_files.size());
   m_variant_vector.reserve(variant_files.size());
+  auto keys = std::vector<uint64_t>{};
+  keys.reserve(variant_files.size());
   for (auto i = 0u; i < variant_files.size(); i++) {
-    m_queue.push(VariantIteratorIndexPair{std::make_shared<VariantIterator>(variant_files[i], variant_headers[i]), i});
+    m_inputs.push_back(Input{variant_files[i], variant_headers[i], new_record(), Variant{}, i});
+    keys.push_back(read_next_record(m_inputs.back()));
   }
+  m_tree = utils::LoserTree{std::move(keys)};
   fetch_next_vector();
 }
 
@@ -28,47 +56,64 @@ bool MultipleVariantIterator::operator!=(const MultipleVariantIterator& rhs) {
   return !(m_variant_vector.empty() && rhs.m_variant_vector.empty());
 }
 
-bool MultipleVariantIterator::Comparator::operator()(const VariantIteratorIndexPair& left, const VariantIteratorIndexPair& right) {
-  if ((**(left.first)).chromosome() > (**(right.first)).chromosome())
-    return true;
+std::shared_ptr<bcf1_t> MultipleVariantIterator::new_record() const {
+  auto record = utils::make_shared_variant(bcf_init1());
+  if (m_unpack_level != VariantUnpackLevel::ALL)
+    record->max_unpack = BCF_UN_SHR;   // stops the VCF parser before the per sample columns (the BCF reader ignores it)
+  return record;
+}
 
-  if ((**(left.first)).chromosome() < (**(right.first)).chromosome())
-    return false;
+uint64_t MultipleVariantIterator::read_next_record(Input& input) {
+  if (m_decoding_pool) {
+    if (!m_decoding_pool->next(input.index, input.next_record))
+      return utils::LoserTree::exhausted;
+  }
+  else if (m_budgeted_inputs) {
+    if (!m_budgeted_inputs->next(input.index, input.next_record))
+      return utils::LoserTree::exhausted;
+  }
+  else {
+    if (bcf_read1(input.file.get(), input.header.get(), input.next_record.get()) < 0)
+      return utils::LoserTree::exhausted;
+    unpack_variant_record(input.next_record.get(), input.header.get(), m_unpack_level);
+  }
+  return utils::LoserTree::location_key(input.next_record->rid, input.next_record->pos);
+}
 
-  return (**(left.first)).alignment_start() > (**(right.first)).alignment_start();
+/**
+ * @brief moves the records of the last vector back to their inputs
+ * @note a record the user still refers to (through a moved Variant or one of its fields) isn't given back: its
+ * input will serve a new record next time instead
+ */
+void MultipleVariantIterator::recycle_variant_vector() {
+  for (auto& variant_pair : m_variant_vector) {
+    auto& variant = variant_pair.first;
+    if (variant.m_body && variant.m_body.use_count() == 1)
+      m_inputs[variant_pair.second].served = std::move(variant);
+  }
+  m_variant_vector.clear();
 }
 
 void MultipleVariantIterator::fetch_next_vector() {
-  m_variant_vector.clear();
-  auto current_chrom = 0u;
-  auto current_start = 0u;
-
-  while (!m_queue.empty()) {
-    const auto top_queue_elem = m_queue.top();
-    const auto top_iterator = top_queue_elem.first;
-    const auto& variant = **top_iterator;
-
-    //top VariantIterator returns 'empty' Variant - no more variants in this VCF
-    if(variant.missing())
-    {
-      m_queue.pop();
-      continue;
-    }
-
-    if (!m_variant_vector.empty() && !(variant.chromosome() == current_chrom && variant.alignment_start() == current_start))
-      break;
-    else {
-      current_chrom = variant.chromosome();
-      current_start = variant.alignment_start();
-      m_variant_vector.push_back(VariantIndexPair{variant, top_queue_elem.second});
-
-      m_queue.pop();
-      top_iterator->operator++();
-      if (! top_iterator->empty())
-        m_queue.push(std::move(top_queue_elem));
-    }
+  recycle_variant_vector();
+  if (m_tree.empty())
+    return;
+
+  const auto current_location = m_tree.top_key();
+  while (!m_tree.empty() && m_tree.top_key() == current_location) {
+    auto& input = m_inputs[m_tree.top()];
+
+    // serve the read ahead record and read the next one into the record served last time (or a new one if it wasn't given back)
+    auto& served = input.served;
+    if (served.missing())
+      served = Variant{input.header, new_record()};
+    std::swap(served.m_body, input.next_record);
+    served.invalidate_field_slots();
+    m_variant_vector.push_back(VariantIndexPair{std::move(served), input.index});
+    input.served = Variant{};
+
+    m_tree.replace_top(read_next_record(input));
   }
 }
 
 }
-
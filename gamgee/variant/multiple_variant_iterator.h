@@ -5,9 +5,13 @@
 
 #include "variant.h"
 #include "variant_iterator.h"
+#include "budgeted_variant_inputs.h"
+#include "variant_decoding_pool.h"
+
+#include "../utils/loser_tree.h"
 
 #include <memory>
-#include <queue>
+#include <vector>
 
 namespace gamgee {
 
@@ -16,6 +20,20 @@ using VariantIndexPair = std::pair<Variant, uint32_t>;
 
 /**
  * @brief Utility class to enable for-each style iteration in the MultipleVariantReader class
+ *
+ * Every input reads ahead into one record and serves the previous one, and the records of a position are moved
+ * into the vector instead of copied. When the iterator advances, the records of the previous vector go back to
+ * their inputs to be read into again, so merging doesn't allocate or deep copy records in the common case.
+ *
+ * The inputs are merged with a loser tree over the packed (chromosome, position) keys of their read ahead records,
+ * so advancing an input costs one leaf to root replay. The records of a position come in input order.
+ *
+ * With decoding threads, the inputs are read and decoded by a VariantDecodingPool and the merge only consumes
+ * records that are ready, so the throughput of the merge scales with the threads (up to the I/O limit).
+ *
+ * @note a record is only recycled if nothing else refers to it, so keeping a Variant of the vector (or any of its
+ * fields) past the next step is safe: the input simply reads into a new record instead. Copying a Variant still
+ * makes a deep copy, which is the way to keep a record that will be modified independently.
  */
 class MultipleVariantIterator {
  public:
@@ -30,8 +48,21 @@ class MultipleVariantIterator {
    *
    * @param variant_files   vector of vcf/bcf files opened via the bcf_open() macro from htslib
    * @param variant_headers vector of headers corresponding to the files
+   * @param unpack_level    how much of each record to decode (see VariantUnpackLevel)
+   * @param decoding_threads worker threads reading and decoding the files ahead of the merge (0 = read them in the calling thread)
    */
-  MultipleVariantIterator(const std::vector<std::shared_ptr<htsFile>>& variant_files, const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers);
+  MultipleVariantIterator(const std::vector<std::shared_ptr<htsFile>>& variant_files, const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers,
+                          const VariantUnpackLevel unpack_level = VariantUnpackLevel::ALL, const uint32_t decoding_threads = 0);
+
+  /**
+   * @brief initializes a new iterator based on files that are not all kept open (see BudgetedVariantInputs)
+   *
+   * @param inputs          the files to read
+   * @param variant_headers vector of headers corresponding to the files
+   * @param unpack_level    how much of each record to decode (see VariantUnpackLevel)
+   */
+  MultipleVariantIterator(std::unique_ptr<BudgetedVariantInputs> inputs, const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers,
+                          const VariantUnpackLevel unpack_level = VariantUnpackLevel::ALL);
 
   /**
    * @brief a MultipleVariantIterator move constructor guarantees all objects will have the same state.
@@ -75,14 +106,41 @@ class MultipleVariantIterator {
   // fetches the next Variant vector
   void fetch_next_vector();
 
-  // comparison class for genomic locations in the priority queue
-  class Comparator {
-   public:
-    bool operator()(const VariantIteratorIndexPair& left, const VariantIteratorIndexPair& right);
+  // reads the first record of every input and fetches the first vector
+  void init(const std::vector<std::shared_ptr<htsFile>>& variant_files, const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers);
+
+  // an input file with its read ahead record and the record it last served
+  struct Input {
+    std::shared_ptr<htsFile> file;
+    std::shared_ptr<bcf_hdr_t> header;
+    std::shared_ptr<bcf1_t> next_record;   // the read ahead record, which decides the order of the inputs
+    Variant served;                        // the record handed out last, recycled when it comes back
+    uint32_t index;
   };
 
-  // the individual file iterators
-  std::priority_queue<VariantIteratorIndexPair, std::vector<VariantIteratorIndexPair>, Comparator> m_queue;
+  // reads the next record of an input into its read ahead record, returns its key in the merge (LoserTree::exhausted at the end of the file)
+  uint64_t read_next_record(Input& input);
+
+  // gives back the records of the last vector to their inputs
+  void recycle_variant_vector();
+
+  // a new record to read into, decoded only up to the unpack level
+  std::shared_ptr<bcf1_t> new_record() const;
+
+  // the inputs, in the order of their files
+  std::vector<Input> m_inputs;
+
+  // the inputs ordered by the locations of their read ahead records (exhausted inputs have the key LoserTree::exhausted)
+  utils::LoserTree m_tree;
+
+  // how much of each record to decode
+  VariantUnpackLevel m_unpack_level {VariantUnpackLevel::ALL};
+
+  // reads and decodes the inputs ahead of the merge (nullptr to read them in this thread)
+  std::unique_ptr<VariantDecodingPool> m_decoding_pool;
+
+  // reads the inputs that are not all kept open (nullptr if they are)
+  std::unique_ptr<BudgetedVariantInputs> m_budgeted_inputs;
 
   // caches next Variant vector
   std::vector<VariantIndexPair> m_variant_vector;
@@ -3,6 +3,7 @@
 
 #include "htslib/vcf.h"
 
+#include "budgeted_variant_inputs.h"
 #include "variant_header.h"
 #include "variant_header_merger.h"
 
@@ -10,6 +11,9 @@
 #include "../utils/hts_memory.h"
 #include "../utils/variant_utils.h"
 
+#include <algorithm>
+#include <cstdint>
+
 namespace gamgee {
 
 /**
@@ -34,6 +38,26 @@ namespace gamgee {
  * for (auto& vector : MultipleVariantReader<MultipleVariantIterator>{filename1, stream2})
  *   do_something_with_vector(vector);
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * Merging many files is usually bound by reading and decoding them. To do that on a pool of worker threads:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * auto options = VariantReaderOptions{};
+ * options.decoding_threads = 8;
+ * for (auto& vector : MultipleVariantReader<MultipleVariantIterator>{filenames, false, options})
+ *   do_something_with_vector(vector);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * Tens of thousands of files can't all be kept open. With VariantReaderOptions::max_open_files, a reader of more
+ * files than that only reads their headers when it's created and closes them again. The iterators then read the
+ * files in batches through BudgetedVariantInputs, reopening them as needed, with the same output as if all the
+ * files were open (decoding threads are not used in this mode).
+ *
+ * Opening that many files is also slowed down by merging their headers. The headers of a cohort are usually all
+ * alike and each distinct one is merged once (see VariantHeaderMerger), their fields and samples can be mapped on
+ * VariantReaderOptions::header_merging_threads, and VariantReaderOptions::header_merger_cache names a file that keeps
+ * the merged header from one run to the next (it's written on the first run and read on the next ones, as long as
+ * the headers don't change).
  */
 template<class ITERATOR>
 class MultipleVariantReader {
@@ -44,10 +68,13 @@ class MultipleVariantReader {
    *
    * @param filenames the names of the variant files
    * @param validate_headers should we validate that the header files have identical chromosomes?  default = true
+   * @param options decompression threads (for each file), unpack level and decoding threads (see VariantReaderOptions)
    */
-  explicit MultipleVariantReader(const std::vector<std::string>& filenames, const bool validate_headers = true) :
+  explicit MultipleVariantReader(const std::vector<std::string>& filenames, const bool validate_headers = true,
+                                 const VariantReaderOptions& options = VariantReaderOptions{}) :
     m_variant_files { },
-    m_variant_headers { }
+    m_variant_headers { },
+    m_options { options }
   {
     init_reader(filenames, validate_headers);
   }
@@ -59,11 +86,14 @@ class MultipleVariantReader {
    * @param validate_headers should we validate that the header files have identical chromosomes?  (must specify if using this constructor)
    * @param samples the list of samples you want included/excluded from your iteration
    * @param include whether you want these samples to be included or excluded from your iteration.  default = true (include)
+   * @param options decompression threads (for each file), unpack level and decoding threads (see VariantReaderOptions)
    */
   MultipleVariantReader(const std::vector<std::string>& filenames, const bool validate_headers,
-                        const std::vector<std::string>& samples, const bool include = true) :
+                        const std::vector<std::string>& samples, const bool include = true,
+                        const VariantReaderOptions& options = VariantReaderOptions{}) :
     m_variant_files { },
-    m_variant_headers { }
+    m_variant_headers { },
+    m_options { options }
   {
     init_reader(filenames, validate_headers);
     subset_variant_samples(m_variant_header_merger.get_raw_merged_header().get(), samples, include);
@@ -78,6 +108,8 @@ class MultipleVariantReader {
   void init_reader(const std::vector<std::string>& filenames, const bool validate_headers) {
     m_variant_files.reserve(filenames.size());
     m_variant_headers.reserve(filenames.size());
+    auto chromosomes_fingerprint = uint64_t{0};
+    const auto budgeted = m_options.max_open_files > 0 && filenames.size() > m_options.max_open_files;
 
     for (const auto& filename : filenames) {
       // TODO? check for maximum one stream
@@ -86,6 +118,8 @@ class MultipleVariantReader {
         throw FileOpenException{filename};
       }
       m_variant_files.push_back(std::move(utils::make_shared_hts_file(file_ptr)));
+      if (!budgeted)   // otherwise the files get their threads when they are reopened
+        set_variant_decompression_threads(file_ptr, m_options.decompression_threads);
 
       auto* header_raw_ptr = bcf_hdr_read(file_ptr);
       if ( header_raw_ptr == nullptr ) {
@@ -93,10 +127,27 @@ class MultipleVariantReader {
       }
       const auto& header_ptr = utils::make_shared_variant_header(header_raw_ptr);
       m_variant_headers.push_back(header_ptr);
- 
-      if (validate_headers && m_variant_header_merger.get_raw_merged_header().get() != nullptr)
-	validate_header(header_ptr);  
-      m_variant_header_merger.add_header(header_ptr); 
+
+      // keeps the file closed until the iterators read it (if it can be reopened where its records start)
+      if (budgeted) {
+        m_filenames.push_back(filename);
+        const auto resumable = BudgetedVariantInputs::resumable(filename, file_ptr);
+        m_data_offsets.push_back(resumable ? BudgetedVariantInputs::tell(file_ptr) : -1);
+        if (resumable)
+          m_variant_files.back().reset();
+      }
+
+      // all the headers must have the chromosomes of the first one (and so of the merged header)
+      if (m_variant_headers.size() == 1)
+        chromosomes_fingerprint = variant_header_chromosomes_fingerprint(header_ptr.get());
+      else if (validate_headers)
+        validate_header(header_ptr, chromosomes_fingerprint);
+    }
+    const auto& cache = m_options.header_merger_cache;
+    if (cache.empty() || !m_variant_header_merger.read_cache(cache, m_variant_headers)) {
+      m_variant_header_merger.add_headers(m_variant_headers, std::max(m_options.header_merging_threads, 1u));
+      if (!cache.empty())
+        m_variant_header_merger.write_cache(cache);
     }
   }
 
@@ -119,7 +170,9 @@ class MultipleVariantReader {
    * @return an ITERATOR ready to start parsing the files
    */
   ITERATOR begin() const {
-    return ITERATOR{m_variant_files, m_variant_headers};
+    if (!m_data_offsets.empty())
+      return ITERATOR{std::make_unique<BudgetedVariantInputs>(m_filenames, m_variant_files, m_variant_headers, m_data_offsets, m_options), m_variant_headers, m_options.unpack_level};
+    return ITERATOR{m_variant_files, m_variant_headers, m_options.unpack_level, m_options.decoding_threads};
   }
 
   /**
@@ -150,16 +203,18 @@ class MultipleVariantReader {
   const std::vector<std::shared_ptr<bcf_hdr_t>>& get_input_vcf_headers() const { return m_variant_headers; }
   
  private:
-  ///< confirms that the chromosomes in the headers of all of the input files are identical
+  ///< confirms that the chromosomes in the headers of all of the input files are identical (by the hash of their names)
   // TODO? only handles chromosome names, not lengths
-  void validate_header(const std::shared_ptr<bcf_hdr_t>& other_header_ptr) {
-    const auto& other_header = VariantHeader{other_header_ptr};
-    if (combined_header().chromosomes() != other_header.chromosomes())
+  void validate_header(const std::shared_ptr<bcf_hdr_t>& other_header_ptr, const uint64_t chromosomes_fingerprint) {
+    if (variant_header_chromosomes_fingerprint(other_header_ptr.get()) != chromosomes_fingerprint)
       throw HeaderCompatibilityException{"chromosomes in header files are inconsistent"};
   }
 
   std::vector<std::shared_ptr<htsFile>> m_variant_files;        ///< vector of the internal file structures of the variant files
   std::vector<std::shared_ptr<bcf_hdr_t>> m_variant_headers;    ///< vector of the internal header structures of the variant files
+  VariantReaderOptions m_options;                               ///< decompression threads (for each file) and unpack level
+  std::vector<std::string> m_filenames;                         ///< names of the files, when they're not all kept open (see VariantReaderOptions::max_open_files)
+  std::vector<int64_t> m_data_offsets;                          ///< virtual offsets of the first records of the files that are not kept open (-1 for the others)
   InputOrderedVariantHeaderMerger m_variant_header_merger;			///< merge headers and create LUTs for fields, samples,
 
 };
@@ -0,0 +1,124 @@
+#include "packed_genotypes.h"
+
+#include "../utils/genotype_utils.h"
+
+#include "htslib/vcf.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace gamgee {
+
+constexpr uint32_t PackedGenotypes::samples_per_word;
+
+namespace {
+
+constexpr auto low_bits = uint64_t{0x5555555555555555};  ///< the low bit of every 2 bit code
+constexpr auto missing_code = uint64_t(PackedGenotype::MISSING);
+
+inline uint32_t popcount(const uint64_t word) {
+  return uint32_t(__builtin_popcountll(word));
+}
+
+/**
+ * @brief one bit per sample (in the low bit of its code) for each of the four codes, with the unused bits cleared
+ */
+inline array<uint64_t, 4> code_masks(const uint64_t word) {
+  const auto low = word & low_bits;
+  const auto high = (word >> 1) & low_bits;
+  return {{~low & ~high & low_bits, low & ~high, high & ~low, low & high}};
+}
+
+}
+
+PackedGenotypes::PackedGenotypes(const Variant& variant) {
+  assign(variant);
+}
+
+void PackedGenotypes::assign(const Variant& variant) {
+  m_n_samples = variant.n_samples();
+  const auto n_words = (m_n_samples + samples_per_word - 1) / samples_per_word;
+  m_words.resize(n_words);
+  const auto format_ptr = variant.raw_individual_field("GT");
+  if (format_ptr == nullptr || format_ptr->n == 0) {
+    // every code set to MISSING, leaving the bits past the last sample cleared
+    fill(m_words.begin(), m_words.end(), ~uint64_t{0});
+    if (m_n_samples % samples_per_word != 0)
+      m_words.back() >>= 2 * (samples_per_word - m_n_samples % samples_per_word);
+    return;
+  }
+  // hom ref (no alternate allele), het (different alleles) or hom var, one 2 bit code per sample; a haploid sample is
+  // classified by its only allele, and a sample without any allele is missing
+  auto* words = m_words.data();
+  auto word = uint64_t{0};
+  const auto n_samples = m_n_samples;
+  utils::decode_genotypes(format_ptr, n_samples, [&words, &word, n_samples](const uint32_t sample, const bool is_missing, const int32_t* keys, const uint32_t n_keys) {
+    auto het = false;
+    for (auto allele = 1u; allele < n_keys; ++allele)
+      het |= keys[allele] != keys[0];
+    const auto hom_var = !het & (keys[0] != 1);
+    const auto code = (is_missing || n_keys == 0) ? missing_code : uint64_t(het) | uint64_t(hom_var) << 1;
+    const auto slot = sample % samples_per_word;
+    word |= code << (2 * slot);
+    if (slot == samples_per_word - 1 || sample + 1 == n_samples) {
+      *words++ = word;
+      word = 0;
+    }
+  });
+}
+
+PackedGenotypeCounts PackedGenotypes::counts() const {
+  auto het = 0u;
+  auto hom_var = 0u;
+  auto missing = 0u;
+  for (const auto word : m_words) {
+    const auto low = word & low_bits;
+    const auto high = (word >> 1) & low_bits;
+    het += popcount(low & ~high);
+    hom_var += popcount(high & ~low);
+    missing += popcount(low & high);
+  }
+  return PackedGenotypeCounts{m_n_samples - het - hom_var - missing, het, hom_var, missing};
+}
+
+uint32_t PackedGenotypes::allele_count() const {
+  const auto site_counts = counts();
+  return site_counts.het + 2 * site_counts.hom_var;
+}
+
+uint32_t PackedGenotypes::allele_number() const {
+  return 2 * (m_n_samples - counts().missing);
+}
+
+double PackedGenotypes::call_rate() const {
+  return m_n_samples == 0 ? 0.0 : double(m_n_samples - counts().missing) / m_n_samples;
+}
+
+double PackedGenotypes::heterozygosity() const {
+  const auto site_counts = counts();
+  const auto called = m_n_samples - site_counts.missing;
+  return called == 0 ? 0.0 : double(site_counts.het) / called;
+}
+
+PackedGenotypeTable genotype_count_table(const PackedGenotypes& first, const PackedGenotypes& second) {
+  if (first.n_samples() != second.n_samples())
+    throw invalid_argument{"cannot cross-tabulate sites with " + to_string(first.n_samples()) + " and " + to_string(second.n_samples()) + " samples"};
+  auto table = PackedGenotypeTable{};
+  const auto& first_words = first.words();
+  const auto& second_words = second.words();
+  for (auto w = 0u; w < first_words.size(); ++w) {
+    const auto first_masks = code_masks(first_words[w]);
+    const auto second_masks = code_masks(second_words[w]);
+    for (auto i = 0u; i < 4; ++i)
+      for (auto j = 0u; j < 4; ++j)
+        table[i][j] += popcount(first_masks[i] & second_masks[j]);
+  }
+  // the unused bits of the last word read as HOM_REF at both sites
+  table[0][0] -= uint32_t(first_words.size()) * PackedGenotypes::samples_per_word - first.n_samples();
+  return table;
+}
+
+}
@@ -4,11 +4,25 @@
 
 namespace gamgee {
 
-ReferenceBlockSplittingVariantIterator::ReferenceBlockSplittingVariantIterator(const std::vector<std::shared_ptr<htsFile>>& variant_files, const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers) :
-  MultipleVariantIterator {variant_files, variant_headers},
+ReferenceBlockSplittingVariantIterator::ReferenceBlockSplittingVariantIterator(const std::vector<std::shared_ptr<htsFile>>& variant_files, const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers,
+                                                                               const VariantUnpackLevel unpack_level, const uint32_t decoding_threads) :
+  MultipleVariantIterator {variant_files, variant_headers, unpack_level, decoding_threads},
   m_pending_variants {},
   m_split_variants {}
 {
+  init(variant_headers);
+}
+
+ReferenceBlockSplittingVariantIterator::ReferenceBlockSplittingVariantIterator(std::unique_ptr<BudgetedVariantInputs> inputs, const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers,
+                                                                               const VariantUnpackLevel unpack_level) :
+  MultipleVariantIterator {std::move(inputs), variant_headers, unpack_level},
+  m_pending_variants {},
+  m_split_variants {}
+{
+  init(variant_headers);
+}
+
+void ReferenceBlockSplittingVariantIterator::init(const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers) {
   // will over-count for duplicate samples because we don't have access to the combined header
   // but that is not a big deal
   auto sample_count = 0u;
@@ -37,7 +51,8 @@ bool ReferenceBlockSplittingVariantIterator::operator!=(const ReferenceBlockSpli
 }
 
 void ReferenceBlockSplittingVariantIterator::populate_pending () {
-  for (const auto& variant_pair : MultipleVariantIterator::operator*()) {
+  // the pending variants take over the incoming records (which the MultipleVariantIterator then won't recycle)
+  for (auto& variant_pair : MultipleVariantIterator::operator*()) {
     const auto& variant = variant_pair.first;
     m_pending_min_end = std::min(m_pending_min_end, variant.alignment_stop());
     m_pending_variants.push_back(std::move(variant_pair));
@@ -26,8 +26,21 @@ class ReferenceBlockSplittingVariantIterator : public MultipleVariantIterator {
    *
    * @param variant_files   vector of vcf/bcf files opened via the bcf_open() macro from htslib
    * @param variant_headers vector of variant headers corresponding to these files
+   * @param unpack_level    how much of each record to decode (see VariantUnpackLevel)
+   * @param decoding_threads worker threads reading and decoding the files ahead of the merge (0 = read them in the calling thread)
    */
-  ReferenceBlockSplittingVariantIterator(const std::vector<std::shared_ptr<htsFile>>& variant_files, const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers);
+  ReferenceBlockSplittingVariantIterator(const std::vector<std::shared_ptr<htsFile>>& variant_files, const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers,
+                                         const VariantUnpackLevel unpack_level = VariantUnpackLevel::ALL, const uint32_t decoding_threads = 0);
+
+  /**
+   * @brief initializes a new iterator based on files that are not all kept open (see BudgetedVariantInputs)
+   *
+   * @param inputs          the files to read
+   * @param variant_headers vector of variant headers corresponding to these files
+   * @param unpack_level    how much of each record to decode (see VariantUnpackLevel)
+   */
+  ReferenceBlockSplittingVariantIterator(std::unique_ptr<BudgetedVariantInputs> inputs, const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers,
+                                         const VariantUnpackLevel unpack_level = VariantUnpackLevel::ALL);
 
   /**
    * @brief a ReferenceBlockSplittingVariantIterator move constructor guarantees all objects will have the same state.
@@ -68,6 +81,9 @@ class ReferenceBlockSplittingVariantIterator : public MultipleVariantIterator {
   std::vector<VariantIndexPair>& operator++();
 
  private:
+  // reserves the vectors and fetches the first split vector
+  void init(const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers);
+
   // fetches the next reference-block-split Variant vector
   // calls populate_pending() and populate_split_variants() as needed
   void fetch_next_split_vector();
@@ -0,0 +1,101 @@
+#ifndef gamgee__sample_mask__guard
+#define gamgee__sample_mask__guard
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace gamgee {
+
+/**
+ * @brief one bit per sample, stored in 64 bit words
+ *
+ * Produced by the built-in predicates in SamplePredicate. Sample i is bit i % 64 of word i / 64 and the bits
+ * past the last sample are always zero, so the set operations below are plain loops over whole words that the
+ * compiler vectorises, and count() is a popcount per word.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * const auto pass = SamplePredicate::greater_equal(20).select(record, "GQ") & SamplePredicate::in_range(10, 200).select(record, "DP");
+ * cout << pass.count() << " samples pass" << endl;
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class SampleMask {
+ public:
+  static constexpr uint32_t bits_per_word = 64;  ///< number of samples in a word
+
+  SampleMask() = default;                                             ///< @brief creates an empty mask (no samples)
+  explicit SampleMask(const uint32_t n_samples, const bool value = false) :
+    m_n_samples {n_samples},
+    m_words ((n_samples + bits_per_word - 1) / bits_per_word, value ? ~uint64_t{0} : uint64_t{0})
+  {
+    clear_unused_bits();
+  }
+
+  uint32_t size() const { return m_n_samples; }                                                                   ///< @brief number of samples
+  bool test(const uint32_t sample) const { return (m_words[sample / bits_per_word] >> (sample % bits_per_word)) & 1; } ///< @brief whether a sample is selected @warning no bounds checking
+  bool operator[](const uint32_t sample) const { return test(sample); }                                           ///< @brief whether a sample is selected @warning no bounds checking
+  void set(const uint32_t sample) { m_words[sample / bits_per_word] |= uint64_t{1} << (sample % bits_per_word); }      ///< @brief selects a sample @warning no bounds checking
+  void reset(const uint32_t sample) { m_words[sample / bits_per_word] &= ~(uint64_t{1} << (sample % bits_per_word)); } ///< @brief deselects a sample @warning no bounds checking
+  const std::vector<uint64_t>& words() const { return m_words; }                                                  ///< @brief the underlying words
+  std::vector<uint64_t>& words() { return m_words; }                                                              ///< @brief the underlying words @warning the bits past the last sample must be kept at zero
+
+  uint32_t count() const {                                                                                        ///< @brief number of selected samples
+    auto total = 0u;
+    for (const auto word : m_words)
+      total += uint32_t(__builtin_popcountll(word));
+    return total;
+  }
+  bool any() const {                                                                                              ///< @brief whether any sample is selected
+    for (const auto word : m_words)
+      if (word != 0)
+        return true;
+    return false;
+  }
+  bool none() const { return !any(); }                                                                            ///< @brief whether no sample is selected
+
+  SampleMask& operator&=(const SampleMask& other) { check_size(other); for (auto i = 0u; i < m_words.size(); ++i) m_words[i] &= other.m_words[i]; return *this; } ///< @brief intersection @throws std::invalid_argument if the sizes differ
+  SampleMask& operator|=(const SampleMask& other) { check_size(other); for (auto i = 0u; i < m_words.size(); ++i) m_words[i] |= other.m_words[i]; return *this; } ///< @brief union @throws std::invalid_argument if the sizes differ
+  SampleMask& operator^=(const SampleMask& other) { check_size(other); for (auto i = 0u; i < m_words.size(); ++i) m_words[i] ^= other.m_words[i]; return *this; } ///< @brief symmetric difference @throws std::invalid_argument if the sizes differ
+  SampleMask& and_not(const SampleMask& other) { check_size(other); for (auto i = 0u; i < m_words.size(); ++i) m_words[i] &= ~other.m_words[i]; return *this; } ///< @brief removes the samples selected in other @throws std::invalid_argument if the sizes differ
+  SampleMask& flip() { for (auto& word : m_words) word = ~word; clear_unused_bits(); return *this; }             ///< @brief complement
+
+  SampleMask operator~() const { auto result = *this; return result.flip(); }                                     ///< @brief complement
+  bool operator==(const SampleMask& other) const { return m_n_samples == other.m_n_samples && m_words == other.m_words; }
+  bool operator!=(const SampleMask& other) const { return !(*this == other); }
+
+  /**
+   * @brief converts to the bitset type returned by Variant::select_if
+   */
+  boost::dynamic_bitset<> to_dynamic_bitset() const {
+    auto result = boost::dynamic_bitset<>(m_n_samples);
+    for (auto sample = 0u; sample < m_n_samples; ++sample)
+      if (test(sample))
+        result.set(sample);
+    return result;
+  }
+
+ private:
+  uint32_t m_n_samples {0};
+  std::vector<uint64_t> m_words {};
+
+  void clear_unused_bits() {
+    if (m_n_samples % bits_per_word != 0)
+      m_words.back() &= (uint64_t{1} << (m_n_samples % bits_per_word)) - 1;
+  }
+
+  void check_size(const SampleMask& other) const {
+    if (other.m_n_samples != m_n_samples)
+      throw std::invalid_argument{"cannot combine sample masks of sizes " + std::to_string(m_n_samples) + " and " + std::to_string(other.m_n_samples)};
+  }
+};
+
+inline SampleMask operator&(SampleMask lhs, const SampleMask& rhs) { return lhs &= rhs; } ///< @brief intersection @throws std::invalid_argument if the sizes differ
+inline SampleMask operator|(SampleMask lhs, const SampleMask& rhs) { return lhs |= rhs; } ///< @brief union @throws std::invalid_argument if the sizes differ
+inline SampleMask operator^(SampleMask lhs, const SampleMask& rhs) { return lhs ^= rhs; } ///< @brief symmetric difference @throws std::invalid_argument if the sizes differ
+
+}
+
+#endif // gamgee__sample_mask__guard
@@ -0,0 +1,103 @@
+#include "sample_predicate.h"
+
+#include "htslib/vcf.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+
+namespace gamgee {
+
+namespace {
+
+constexpr auto infinity = numeric_limits<double>::infinity();
+
+/**
+ * @brief the comparison loop, one instantiation per BCF type
+ *
+ * RAW is the integer type used to recognize the missing and vector end values (the float values are NaNs with
+ * specific bit patterns, so they're compared as uint32) and TYPE is the type the value is compared as. There are
+ * no branches in the inner loop: the predicate flags are loop invariant and the comparisons are combined with
+ * bitwise operators.
+ */
+template<class TYPE, class RAW>
+void select_kernel(const bcf_fmt_t* format_ptr, const uint32_t n_samples, const uint32_t value_index, const RAW missing, const RAW vector_end,
+                   const double lower, const double upper, const bool outside, const bool select_missing, uint64_t* words) {
+  static_assert(sizeof(TYPE) == sizeof(RAW), "the raw type must have the size of the value type");
+  const auto values = format_ptr->p + value_index * sizeof(TYPE);
+  const auto stride = uint32_t(format_ptr->size);
+  for (auto first_sample = 0u; first_sample < n_samples; first_sample += SampleMask::bits_per_word) {
+    const auto n_word_samples = min(n_samples - first_sample, uint32_t{SampleMask::bits_per_word});
+    const auto word_values = values + size_t{first_sample} * stride;
+    auto word = uint64_t{0};
+    for (auto bit = 0u; bit < n_word_samples; ++bit) {
+      auto raw = RAW{};
+      memcpy(&raw, word_values + bit * stride, sizeof(RAW));
+      auto value = TYPE{};
+      memcpy(&value, &raw, sizeof(TYPE));
+      const auto is_missing = (raw == missing) | (raw == vector_end);
+      const auto inside = (double(value) >= lower) & (double(value) <= upper);
+      const auto pass = select_missing ? is_missing : !is_missing & (inside != outside);
+      word |= uint64_t(pass) << bit;
+    }
+    *words++ = word;
+  }
+}
+
+}
+
+SamplePredicate::SamplePredicate(const double lower, const double upper, const bool outside, const bool missing) :
+  m_lower {lower},
+  m_upper {upper},
+  m_outside {outside},
+  m_missing {missing}
+{}
+
+SamplePredicate SamplePredicate::less(const double threshold)                      { return SamplePredicate{-infinity, nextafter(threshold, -infinity), false, false}; }
+SamplePredicate SamplePredicate::less_equal(const double threshold)                { return SamplePredicate{-infinity, threshold, false, false}; }
+SamplePredicate SamplePredicate::greater(const double threshold)                   { return SamplePredicate{nextafter(threshold, infinity), infinity, false, false}; }
+SamplePredicate SamplePredicate::greater_equal(const double threshold)             { return SamplePredicate{threshold, infinity, false, false}; }
+SamplePredicate SamplePredicate::equal(const double value)                         { return SamplePredicate{value, value, false, false}; }
+SamplePredicate SamplePredicate::not_equal(const double value)                     { return SamplePredicate{value, value, true, false}; }
+SamplePredicate SamplePredicate::in_range(const double lower, const double upper)     { return SamplePredicate{lower, upper, false, false}; }
+SamplePredicate SamplePredicate::out_of_range(const double lower, const double upper) { return SamplePredicate{lower, upper, true, false}; }
+SamplePredicate SamplePredicate::missing()                                         { return SamplePredicate{0.0, 0.0, false, true}; }
+
+SampleMask SamplePredicate::select(const Variant& variant, const std::string& tag, const uint32_t value_index) const {
+  return select_values(variant.raw_individual_field(tag), variant.n_samples(), value_index);
+}
+
+SampleMask SamplePredicate::select(const Variant& variant, const uint32_t field_index, const uint32_t value_index) const {
+  return select_values(variant.raw_individual_field(field_index), variant.n_samples(), value_index);
+}
+
+SampleMask SamplePredicate::select_values(const bcf_fmt_t* format_ptr, const uint32_t n_samples, const uint32_t value_index) const {
+  // no field, or no value at this index for any sample: everything is missing
+  if (format_ptr == nullptr || value_index >= uint32_t(format_ptr->n))
+    return SampleMask{n_samples, m_missing};
+  auto mask = SampleMask{n_samples};
+  const auto words = mask.words().data();
+  switch (format_ptr->type) {
+    case BCF_BT_INT8:
+      select_kernel<int8_t, int8_t>(format_ptr, n_samples, value_index, bcf_int8_missing, bcf_int8_vector_end, m_lower, m_upper, m_outside, m_missing, words);
+      break;
+    case BCF_BT_INT16:
+      select_kernel<int16_t, int16_t>(format_ptr, n_samples, value_index, bcf_int16_missing, bcf_int16_vector_end, m_lower, m_upper, m_outside, m_missing, words);
+      break;
+    case BCF_BT_INT32:
+      select_kernel<int32_t, int32_t>(format_ptr, n_samples, value_index, bcf_int32_missing, bcf_int32_vector_end, m_lower, m_upper, m_outside, m_missing, words);
+      break;
+    case BCF_BT_FLOAT:
+      select_kernel<float, uint32_t>(format_ptr, n_samples, value_index, bcf_float_missing, bcf_float_vector_end, m_lower, m_upper, m_outside, m_missing, words);
+      break;
+    default:
+      throw invalid_argument("sample predicates only apply to numeric individual fields, found type " + to_string(format_ptr->type));
+  }
+  return mask;
+}
+
+}
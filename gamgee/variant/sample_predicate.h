@@ -0,0 +1,72 @@
+#ifndef gamgee__sample_predicate__guard
+#define gamgee__sample_predicate__guard
+
+#include "sample_mask.h"
+#include "variant.h"
+
+#include <cstdint>
+#include <string>
+
+namespace gamgee {
+
+/**
+ * @brief a built-in comparison evaluated for every sample of a numeric individual field straight from the htslib record
+ *
+ * This is the fast path for the usual per-sample filters (GQ >= 20, DP in a range, missing PLs...). Unlike
+ * Variant::select_if, which calls the predicate on an IndividualFieldValue per sample, select() runs a tight
+ * loop over the raw values with one specialization per BCF type (int8, int16, int32 and float) that the compiler
+ * vectorises, and writes a SampleMask a word at a time.
+ *
+ * A sample's value is the one at value_index in its vector (e.g. 1 for the first alternate AD). Missing values,
+ * and indices past the end of a sample's vector (vector end values), fail every comparison and are only selected
+ * by SamplePredicate::missing(). The same goes for every sample if the record doesn't have the field.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * const auto high_gq = SamplePredicate::greater_equal(20);   // build once, reuse for every record
+ * const auto good_dp = SamplePredicate::in_range(10, 200);
+ * for (const auto& record : SingleVariantReader{filename}) {
+ *   const auto pass = high_gq.select(record, "GQ") & good_dp.select(record, "DP");
+ *   ...
+ * }
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class SamplePredicate {
+ public:
+  static SamplePredicate less(const double threshold);                         ///< @brief selects values < threshold
+  static SamplePredicate less_equal(const double threshold);                   ///< @brief selects values <= threshold
+  static SamplePredicate greater(const double threshold);                      ///< @brief selects values > threshold
+  static SamplePredicate greater_equal(const double threshold);                ///< @brief selects values >= threshold
+  static SamplePredicate equal(const double value);                            ///< @brief selects values == value
+  static SamplePredicate not_equal(const double value);                        ///< @brief selects non-missing values != value
+  static SamplePredicate in_range(const double lower, const double upper);     ///< @brief selects values in [lower, upper]
+  static SamplePredicate out_of_range(const double lower, const double upper); ///< @brief selects non-missing values outside [lower, upper]
+  static SamplePredicate missing();                                            ///< @brief selects missing values (including indices past the end of a sample's vector)
+
+  /**
+   * @brief evaluates the predicate for all samples of a variant
+   * @param variant the record
+   * @param tag the individual field (e.g. "GQ")
+   * @param value_index which value of each sample's vector to test
+   * @return a mask with variant.n_samples() bits
+   * @throws std::invalid_argument if the field is a string
+   */
+  SampleMask select(const Variant& variant, const std::string& tag, const uint32_t value_index = 0) const;
+
+  /**
+   * @brief same as select(variant, tag, value_index) but with the field index in the header, skipping the tag lookup
+   */
+  SampleMask select(const Variant& variant, const uint32_t field_index, const uint32_t value_index = 0) const;
+
+ private:
+  double m_lower;        ///< smallest selected value (inclusive, exclusive bounds are moved to the next double)
+  double m_upper;        ///< largest selected value (inclusive, exclusive bounds are moved to the previous double)
+  bool m_outside;        ///< select the non-missing values outside of [m_lower, m_upper] instead of inside
+  bool m_missing;        ///< select the missing values instead of comparing
+
+  SamplePredicate(const double lower, const double upper, const bool outside, const bool missing);
+  SampleMask select_values(const bcf_fmt_t* format_ptr, const uint32_t n_samples, const uint32_t value_index) const;
+};
+
+}
+
+#endif // gamgee__sample_predicate__guard
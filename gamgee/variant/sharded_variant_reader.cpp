@@ -0,0 +1,130 @@
+#include "sharded_variant_reader.h"
+
+#include "../exceptions.h"
+#include "../utils/hts_memory.h"
+
+#include <cstdlib>
+#include <strings.h>
+
+using namespace std;
+
+namespace gamgee {
+
+ShardedVariantIterator::ShardedVariantIterator() :
+  IndexedVariantIterator {},
+  m_start {0}
+{}
+
+ShardedVariantIterator::ShardedVariantIterator(const shared_ptr<htsFile>& file_ptr, const shared_ptr<hts_idx_t>& index_ptr,
+                                               const shared_ptr<tbx_t>& tabix_ptr, const shared_ptr<bcf_hdr_t>& header_ptr,
+                                               const string& interval, const VariantUnpackLevel unpack_level) :
+  IndexedVariantIterator {file_ptr, index_ptr, tabix_ptr, header_ptr, {interval}, unpack_level},  // doesn't read anything
+  m_start {interval_start(interval)}
+{
+  fetch_next_record();
+}
+
+uint32_t ShardedVariantIterator::interval_start(const string& interval) {
+  const auto colon = interval.rfind(':');
+  if (colon == string::npos)
+    return 0;
+  auto digits = string{};
+  for (auto i = colon + 1; i < interval.size() && interval[i] != '-'; ++i)
+    if (interval[i] != ',')
+      digits += interval[i];
+  return digits.empty() ? 0 : uint32_t(stoul(digits));
+}
+
+void ShardedVariantIterator::fetch_next_record() {
+  IndexedVariantIterator::fetch_next_record();
+  skip_previous_records();
+}
+
+void ShardedVariantIterator::skip_previous_records() {
+  while (m_variant_file_ptr && m_variant_record.alignment_start() < m_start)   // belongs to the previous interval
+    IndexedVariantIterator::fetch_next_record();
+}
+
+ShardedVariantReader::ShardedVariantReader(const string& filename, const vector<string>& intervals, const uint32_t n_threads,
+                                           const VariantReaderOptions& options) :
+  m_filename {filename},
+  m_index_ptr {},
+  m_tabix_ptr {},
+  m_header_ptr {},
+  m_shards {intervals.empty() ? IndexedVariantIterator::all_intervals : intervals},
+  m_n_threads {max(n_threads, 1u)},
+  m_options {options}
+{
+  init_reader();
+}
+
+ShardedVariantReader::ShardedVariantReader(const string& filename, const uint32_t window_size, const uint32_t n_threads,
+                                           const VariantReaderOptions& options) :
+  m_filename {filename},
+  m_index_ptr {},
+  m_tabix_ptr {},
+  m_header_ptr {},
+  m_shards {},
+  m_n_threads {max(n_threads, 1u)},
+  m_options {options}
+{
+  init_reader();
+  m_shards = genome_windows(m_header_ptr.get(), window_size);
+}
+
+vector<string> ShardedVariantReader::genome_windows(const bcf_hdr_t* header_ptr, const uint32_t window_size) {
+  auto windows = vector<string>{};
+  for (auto contig = 0; contig < header_ptr->n[BCF_DT_CTG]; ++contig) {
+    const auto name = string{header_ptr->id[BCF_DT_CTG][contig].key};
+    // the length of the contig line (htslib only recognizes the lower case key)
+    auto length = uint64_t{0};
+    const auto* hrec = bcf_hdr_id2hrec(header_ptr, BCF_DT_CTG, 0, contig);
+    for (auto key = 0; hrec != nullptr && key < hrec->nkeys; ++key)
+      if (strcasecmp(hrec->keys[key], "length") == 0)
+        length = strtoull(hrec->vals[key], nullptr, 10);
+    if (length == 0 || window_size == 0) {
+      windows.push_back(name);
+      continue;
+    }
+    for (auto start = uint64_t{1}; start <= length; start += window_size)
+      windows.push_back(name + ":" + to_string(start) + "-" + to_string(min(start + window_size - 1, length)));
+  }
+  return windows;
+}
+
+void ShardedVariantReader::init_reader() {
+  const auto file_ptr = open_file(m_header_ptr);   // checks that the file can be opened before loading its index
+  if (file_ptr->is_bin) {
+    auto* index_ptr = bcf_index_load(m_filename.c_str());
+    if (index_ptr == nullptr)
+      throw IndexLoadException{m_filename};
+    m_index_ptr = utils::make_shared_hts_index(index_ptr);
+  }
+  else {   // bgzipped VCF, read through its tabix (or CSI) index
+    auto* tabix_ptr = tbx_index_load(m_filename.c_str());
+    if (tabix_ptr == nullptr)
+      throw IndexLoadException{m_filename};
+    m_tabix_ptr = utils::make_shared_tabix_index(tabix_ptr);
+  }
+}
+
+shared_ptr<htsFile> ShardedVariantReader::open_file() const {
+  auto header_ptr = shared_ptr<bcf_hdr_t>{};   // the workers share the header of the reader
+  return open_file(header_ptr);
+}
+
+shared_ptr<htsFile> ShardedVariantReader::open_file(shared_ptr<bcf_hdr_t>& header_ptr) const {
+  auto* file_ptr = bcf_open(m_filename.c_str(), "r");
+  if (file_ptr == nullptr)
+    throw FileOpenException{m_filename};
+  auto file = utils::make_shared_hts_file(file_ptr);
+  set_variant_decompression_threads(file_ptr, m_options.decompression_threads);
+  // the index queries seek before reading, but the header is still read so the handle is in the state htslib expects
+  auto* hdr_ptr = bcf_hdr_read(file_ptr);
+  if (hdr_ptr == nullptr)
+    throw HeaderReadException{m_filename};
+  header_ptr = utils::make_shared_variant_header(hdr_ptr);
+  return file;
+}
+
+}
@@ -0,0 +1,316 @@
+#ifndef gamgee__sharded_variant_reader__guard
+#define gamgee__sharded_variant_reader__guard
+
+#include "indexed_variant_iterator.h"
+#include "variant.h"
+#include "variant_header.h"
+
+#include "../utils/variant_utils.h"
+
+#include "htslib/tbx.h"
+#include "htslib/vcf.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace gamgee {
+
+/**
+ * @brief an IndexedVariantIterator over a single interval that skips the records starting before the interval
+ *
+ * Records overlapping the boundary of two adjacent intervals are returned by the index queries of both, this iterator
+ * only keeps them in the interval that contains their start, so every record of a file belongs to exactly one shard.
+ */
+class ShardedVariantIterator : public IndexedVariantIterator {
+ public:
+  ShardedVariantIterator();  ///< @brief creates an empty iterator (used for the end() method)
+
+  /**
+   * @brief initializes a new iterator over the records starting in an interval
+   *
+   * @param file_ptr     shared pointer to a BCF or bgzipped VCF file opened via the bcf_open() macro from htslib
+   * @param index_ptr    shared pointer to the index of a BCF file (unused for VCF)
+   * @param tabix_ptr    shared pointer to the tabix (or CSI) index of a VCF file (null for BCF)
+   * @param header_ptr   shared pointer to the header of the file
+   * @param interval     the interval (chr, or chr:start-stop)
+   * @param unpack_level how much of each record to decode (see VariantUnpackLevel)
+   */
+  ShardedVariantIterator(const std::shared_ptr<htsFile>& file_ptr, const std::shared_ptr<hts_idx_t>& index_ptr,
+                         const std::shared_ptr<tbx_t>& tabix_ptr, const std::shared_ptr<bcf_hdr_t>& header_ptr, const std::string& interval,
+                         const VariantUnpackLevel unpack_level = VariantUnpackLevel::ALL);
+
+  ShardedVariantIterator(ShardedVariantIterator&& other) = default;
+  ShardedVariantIterator& operator=(ShardedVariantIterator&& other) = default;
+
+  /**
+   * @brief the first position of an interval string (chr:start-stop), or 0 if it covers a whole contig
+   */
+  static uint32_t interval_start(const std::string& interval);
+
+ protected:
+  void fetch_next_record() override;
+
+ private:
+  uint32_t m_start;                                     ///< records starting before this position belong to the previous interval
+
+  void skip_previous_records();
+};
+
+/**
+ * @brief one shard of a ShardedVariantReader: an interval read through the file handle of a worker thread
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * for (const auto& record : shard)
+ *   do_something_with_record(record);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * @warning the record is reused from one iteration to the next, make a deep copy to keep it
+ */
+class VariantShard {
+ public:
+  VariantShard(const uint32_t index, const std::string& interval, const std::shared_ptr<htsFile>& file_ptr,
+               const std::shared_ptr<hts_idx_t>& index_ptr, const std::shared_ptr<tbx_t>& tabix_ptr,
+               const std::shared_ptr<bcf_hdr_t>& header_ptr, const VariantUnpackLevel unpack_level) :
+    m_index {index}, m_interval {interval}, m_file_ptr {file_ptr}, m_index_ptr {index_ptr}, m_tabix_ptr {tabix_ptr}, m_header_ptr {header_ptr}, m_unpack_level {unpack_level}
+  {}
+
+  uint32_t index() const { return m_index; }                       ///< @brief position of the shard in the shards of the reader
+  const std::string& interval() const { return m_interval; }       ///< @brief the interval of the shard
+  VariantHeader header() const { return VariantHeader{m_header_ptr}; } ///< @brief the header of the file
+
+  ShardedVariantIterator begin() const { return ShardedVariantIterator{m_file_ptr, m_index_ptr, m_tabix_ptr, m_header_ptr, m_interval, m_unpack_level}; }
+  ShardedVariantIterator end() const { return ShardedVariantIterator{}; }
+
+ private:
+  uint32_t m_index;
+  std::string m_interval;
+  std::shared_ptr<htsFile> m_file_ptr;
+  std::shared_ptr<hts_idx_t> m_index_ptr;
+  std::shared_ptr<tbx_t> m_tabix_ptr;
+  std::shared_ptr<bcf_hdr_t> m_header_ptr;
+  VariantUnpackLevel m_unpack_level;
+};
+
+/**
+ * @brief reads an indexed BCF or bgzipped VCF file one shard (interval) at a time on a pool of threads
+ *
+ * The index and the header are loaded once and shared by all the threads, every thread reads through its own file
+ * handle. The shards are either a list of intervals, or windows of a fixed size over the contigs of the header. Every
+ * record is read by the shard containing its start (see ShardedVariantIterator), so as long as the shards don't
+ * overlap every record is read once.
+ *
+ * A function runs on every shard and its results come back in shard order (genomic order for windows, or intervals
+ * listed in genomic order), either all at once, reduced into one, or streamed to a consumer on the calling thread as
+ * soon as the shards before them are done, to write them out in order:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * const auto reader = ShardedVariantReader{"cohort.bcf", 10000000, 8};  // 10Mb windows on 8 threads
+ * const auto n_records = reader.reduce(0u, [](auto& count, const auto&) { ++count; }, [](auto& total, auto&& count) { total += count; });
+ * reader.ordered([](const VariantShard& shard) {
+ *     auto records = std::vector<Variant>{};
+ *     for (const auto& record : shard)
+ *       if (keep(record))
+ *         records.push_back(record);   // a deep copy, the record is reused
+ *     return records;
+ *   },
+ *   [&writer](std::vector<Variant>&& records) { for (const auto& record : records) writer.add_record(record); });
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * @note the shard functions run on the worker threads (one shard at a time each), the consumers and mergers on the
+ * calling thread. With a single thread everything runs on the calling thread.
+ */
+class ShardedVariantReader {
+ public:
+  /**
+   * @brief prepares the reading of a file by intervals
+   *
+   * @param filename a BCF file with a CSI index, or a bgzipped VCF file with a tabix or CSI index
+   * @param intervals the shards. An empty vector reads the whole file in a single shard.
+   * @param n_threads number of shards read at the same time
+   * @param options decompression threads (for each worker) and unpack level (see VariantReaderOptions)
+   * @throws FileOpenException, IndexLoadException or HeaderReadException if the file can't be read
+   */
+  ShardedVariantReader(const std::string& filename, const std::vector<std::string>& intervals, const uint32_t n_threads = 1,
+                       const VariantReaderOptions& options = VariantReaderOptions{});
+
+  /**
+   * @brief prepares the reading of a file by windows of a fixed size over the contigs of its header
+   *
+   * @param window_size length of the windows. Contigs without a length in the header are a single shard.
+   * @copydetails ShardedVariantReader(const std::string&, const std::vector<std::string>&, const uint32_t, const VariantReaderOptions&)
+   */
+  ShardedVariantReader(const std::string& filename, const uint32_t window_size, const uint32_t n_threads = 1,
+                       const VariantReaderOptions& options = VariantReaderOptions{});
+
+  ShardedVariantReader(const ShardedVariantReader&) = delete;
+  ShardedVariantReader& operator=(const ShardedVariantReader&) = delete;
+  ShardedVariantReader(ShardedVariantReader&&) = default;
+  ShardedVariantReader& operator=(ShardedVariantReader&&) = default;
+
+  const std::vector<std::string>& shards() const { return m_shards; } ///< @brief the intervals of the shards, in order
+  VariantHeader header() const { return VariantHeader{m_header_ptr}; } ///< @brief the header of the file
+
+  /**
+   * @brief windows of a fixed size over the contigs of a header, in the order of the header
+   */
+  static std::vector<std::string> genome_windows(const bcf_hdr_t* header_ptr, const uint32_t window_size);
+
+  /**
+   * @brief runs a function on every shard and hands the results to a consumer in shard order
+   *
+   * The consumer runs on the calling thread as soon as the result of a shard and those of all the shards before it are
+   * ready. The workers don't get more than two shards per thread ahead of the consumer, which bounds the memory used by
+   * the results waiting for their turn.
+   *
+   * @param shard_function called as shard_function(const VariantShard&) on a worker thread, returns the result of the shard
+   * @param consumer called with each result (as an rvalue) on the calling thread, in shard order
+   * @throws the exception of the first shard (in shard order) whose function threw, or of the consumer
+   */
+  template<class SHARD_FUNCTION, class CONSUMER>
+  void ordered(const SHARD_FUNCTION& shard_function, const CONSUMER& consumer) const;
+
+  /**
+   * @brief runs a function on every shard
+   * @return the results of the shards, in shard order
+   */
+  template<class SHARD_FUNCTION>
+  auto map_shards(const SHARD_FUNCTION& shard_function) const -> std::vector<decltype(shard_function(std::declval<const VariantShard&>()))> {
+    auto results = std::vector<decltype(shard_function(std::declval<const VariantShard&>()))>{};
+    results.reserve(m_shards.size());
+    ordered(shard_function, [&results](auto&& result) { results.push_back(std::move(result)); });
+    return results;
+  }
+
+  /**
+   * @brief accumulates the records of every shard into a result of its own, then merges them in shard order
+   *
+   * @param init the empty result: every shard starts from a copy of it, and the results of the shards are merged into another
+   * @param accumulate called as accumulate(RESULT&, const Variant&) for every record of a shard, on a worker thread
+   * @param merge called as merge(RESULT& total, RESULT&& shard_result) on the calling thread, in shard order
+   */
+  template<class RESULT, class ACCUMULATE, class MERGE>
+  RESULT reduce(RESULT init, const ACCUMULATE& accumulate, const MERGE& merge) const {
+    const auto empty = init;   // read by the workers while the calling thread merges into total
+    auto total = std::move(init);
+    ordered([&empty, &accumulate](const VariantShard& shard) {
+        auto result = RESULT{empty};
+        for (const auto& record : shard)
+          accumulate(result, record);
+        return result;
+      },
+      [&total, &merge](RESULT&& result) { merge(total, std::move(result)); });
+    return total;
+  }
+
+ private:
+  std::string m_filename;
+  std::shared_ptr<hts_idx_t> m_index_ptr;           ///< index of a BCF file, shared by all the workers
+  std::shared_ptr<tbx_t> m_tabix_ptr;               ///< index of a VCF file, shared by all the workers
+  std::shared_ptr<bcf_hdr_t> m_header_ptr;          ///< shared by all the workers
+  std::vector<std::string> m_shards;
+  uint32_t m_n_threads;
+  VariantReaderOptions m_options;
+
+  void init_reader();
+  std::shared_ptr<htsFile> open_file() const;       ///< a file handle of a worker
+  std::shared_ptr<htsFile> open_file(std::shared_ptr<bcf_hdr_t>& header_ptr) const;
+  VariantShard shard(const uint32_t index, const std::shared_ptr<htsFile>& file_ptr) const {
+    return VariantShard{index, m_shards[index], file_ptr, m_index_ptr, m_tabix_ptr, m_header_ptr, m_options.unpack_level};
+  }
+};
+
+template<class SHARD_FUNCTION, class CONSUMER>
+void ShardedVariantReader::ordered(const SHARD_FUNCTION& shard_function, const CONSUMER& consumer) const {
+  using Result = decltype(shard_function(std::declval<const VariantShard&>()));
+  const auto n_shards = uint32_t(m_shards.size());
+  const auto n_workers = std::min(m_n_threads, n_shards);
+  if (n_workers <= 1) {
+    const auto file_ptr = open_file();
+    for (auto index = 0u; index < n_shards; ++index)
+      consumer(shard_function(shard(index, file_ptr)));
+    return;
+  }
+
+  auto results = std::vector<std::unique_ptr<Result>>(n_shards);
+  auto errors = std::vector<std::exception_ptr>(n_shards);
+  std::mutex mutex;
+  std::condition_variable done;               // a shard is done
+  std::condition_variable consumed;           // a result was consumed (or the consumer gave up)
+  auto next_shard = 0u;
+  auto next_result = 0u;
+  auto stopped = false;
+  const auto window = 2 * n_workers;
+  const auto worker = [&]() {
+    auto file_ptr = std::shared_ptr<htsFile>{};
+    while (true) {
+      auto index = 0u;
+      {
+        auto lock = std::unique_lock<std::mutex>{mutex};
+        consumed.wait(lock, [&]() { return stopped || next_shard == n_shards || next_shard < next_result + window; });
+        if (stopped || next_shard == n_shards)
+          return;
+        index = next_shard++;
+      }
+      auto result = std::unique_ptr<Result>{};
+      auto error = std::exception_ptr{};
+      try {
+        if (!file_ptr)
+          file_ptr = open_file();
+        result = std::make_unique<Result>(shard_function(shard(index, file_ptr)));
+      }
+      catch (...) {
+        error = std::current_exception();
+      }
+      {
+        auto lock = std::unique_lock<std::mutex>{mutex};
+        results[index] = std::move(result);
+        errors[index] = error;
+      }
+      done.notify_all();
+    }
+  };
+  auto threads = std::vector<std::thread>{};
+  const auto stop = [&]() {
+    {
+      auto lock = std::unique_lock<std::mutex>{mutex};
+      stopped = true;
+    }
+    consumed.notify_all();
+    for (auto& thread : threads)
+      thread.join();
+  };
+  try {
+    for (auto i = 0u; i < n_workers; ++i)
+      threads.emplace_back(worker);
+    for (; next_result < n_shards; ) {
+      auto result = std::unique_ptr<Result>{};
+      {
+        auto lock = std::unique_lock<std::mutex>{mutex};
+        done.wait(lock, [&]() { return results[next_result] || errors[next_result]; });
+        if (errors[next_result])
+          std::rethrow_exception(errors[next_result]);
+        result = std::move(results[next_result]);
+        ++next_result;
+      }
+      consumed.notify_all();
+      consumer(std::move(*result));
+    }
+  }
+  catch (...) {
+    stop();
+    throw;
+  }
+  stop();
+}
+
+}
+
+#endif // gamgee__sharded_variant_reader__guard
@@ -0,0 +1,294 @@
+#include "site_statistics.h"
+#include "indexed_variant_reader.h"
+#include "indexed_variant_iterator.h"
+#include "sharded_variant_reader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+using namespace std;
+
+namespace gamgee {
+
+namespace {
+
+constexpr auto not_applicable = numeric_limits<double>::quiet_NaN();
+
+inline bool transition(const char ref, const char alt) {
+  const auto r = toupper(ref);
+  const auto a = toupper(alt);
+  return (r == 'A' && a == 'G') || (r == 'G' && a == 'A') || (r == 'C' && a == 'T') || (r == 'T' && a == 'C');
+}
+
+inline bool base(const char c) {
+  const auto upper = toupper(c);
+  return upper == 'A' || upper == 'C' || upper == 'G' || upper == 'T';
+}
+
+inline bool symbolic(const string& allele) {
+  return allele.empty() || allele[0] == '<' || allele == "*" || allele.find_first_of("[]") != string::npos;
+}
+
+inline void add_titv(TiTvCounts& counts, const SiteStatistics& site) {
+  counts.transitions += site.transitions;
+  counts.transversions += site.transversions;
+}
+
+SiteStatisticsTable compute_shard(const VariantShard& shard) {
+  auto table = SiteStatisticsTable{};
+  auto calculator = SiteStatisticsCalculator{};
+  for (const auto& record : shard)   // only the records starting in the shard
+    table.add(calculator.compute(record), record.n_samples());
+  return table;
+}
+
+}
+
+void SiteStatisticsAccumulator::add(const SiteStatistics& site, const uint32_t n_samples) {
+  ++m_n_sites;
+  m_n_snps += site.is_snp;
+  m_n_indels += site.is_indel;
+  m_n_multiallelic += site.is_multiallelic;
+  m_n_pass += site.is_pass;
+  m_n_known += site.is_known;
+  m_n_called += site.called;
+  m_n_genotypes += n_samples;
+  add_titv(m_titv, site);
+  add_titv(site.is_pass ? m_titv_pass : m_titv_filtered, site);
+  add_titv(site.is_known ? m_titv_known : m_titv_novel, site);
+}
+
+SiteStatisticsAccumulator& SiteStatisticsAccumulator::merge(const SiteStatisticsAccumulator& other) {
+  m_n_sites += other.m_n_sites;
+  m_n_snps += other.m_n_snps;
+  m_n_indels += other.m_n_indels;
+  m_n_multiallelic += other.m_n_multiallelic;
+  m_n_pass += other.m_n_pass;
+  m_n_known += other.m_n_known;
+  m_n_called += other.m_n_called;
+  m_n_genotypes += other.m_n_genotypes;
+  m_titv += other.m_titv;
+  m_titv_pass += other.m_titv_pass;
+  m_titv_filtered += other.m_titv_filtered;
+  m_titv_known += other.m_titv_known;
+  m_titv_novel += other.m_titv_novel;
+  return *this;
+}
+
+void SiteStatisticsTable::add(const SiteStatistics& site, const uint32_t n_samples) {
+  chromosome.push_back(site.chromosome);
+  alignment_start.push_back(site.alignment_start);
+  allele_count.push_back(site.allele_count);
+  allele_number.push_back(site.allele_number);
+  allele_frequency.push_back(site.allele_frequency);
+  hwe_p_value.push_back(site.hwe_p_value);
+  excess_het_p_value.push_back(site.excess_het_p_value);
+  call_rate.push_back(site.call_rate);
+  mean_depth.push_back(site.mean_depth);
+  het_allele_balance.push_back(site.het_allele_balance);
+  totals.add(site, n_samples);
+}
+
+void SiteStatisticsTable::append(const SiteStatisticsTable& other) {
+  chromosome.insert(chromosome.end(), other.chromosome.begin(), other.chromosome.end());
+  alignment_start.insert(alignment_start.end(), other.alignment_start.begin(), other.alignment_start.end());
+  allele_count.insert(allele_count.end(), other.allele_count.begin(), other.allele_count.end());
+  allele_number.insert(allele_number.end(), other.allele_number.begin(), other.allele_number.end());
+  allele_frequency.insert(allele_frequency.end(), other.allele_frequency.begin(), other.allele_frequency.end());
+  hwe_p_value.insert(hwe_p_value.end(), other.hwe_p_value.begin(), other.hwe_p_value.end());
+  excess_het_p_value.insert(excess_het_p_value.end(), other.excess_het_p_value.begin(), other.excess_het_p_value.end());
+  call_rate.insert(call_rate.end(), other.call_rate.begin(), other.call_rate.end());
+  mean_depth.insert(mean_depth.end(), other.mean_depth.begin(), other.mean_depth.end());
+  het_allele_balance.insert(het_allele_balance.end(), other.het_allele_balance.begin(), other.het_allele_balance.end());
+  totals.merge(other.totals);
+}
+
+const SiteStatistics& SiteStatisticsCalculator::compute(const Variant& variant) {
+  m_summary.assign(variant);
+  m_packed.assign(variant);
+  m_site.chromosome = variant.chromosome();
+  m_site.alignment_start = variant.alignment_start();
+  m_site.allele_count = m_summary.alt_allele_count();
+  m_site.allele_number = m_summary.allele_number();
+  m_site.allele_frequency = m_site.allele_number == 0 ? not_applicable : double(m_site.allele_count) / m_site.allele_number;
+  m_site.called = m_summary.called();
+  m_site.call_rate = variant.n_samples() == 0 ? not_applicable : double(m_summary.called()) / variant.n_samples();
+  // the exact tests need bi-allelic diploid calls
+  if (variant.n_alleles() == 2 && m_summary.max_ploidy() == 2 && m_summary.ploidy_count(1) == 0) {
+    const auto counts = m_packed.counts();
+    const auto p_values = hardy_weinberg(counts.hom_ref, counts.het, counts.hom_var, m_probabilities);
+    m_site.hwe_p_value = p_values.first;
+    m_site.excess_het_p_value = p_values.second;
+  }
+  else {
+    m_site.hwe_p_value = not_applicable;
+    m_site.excess_het_p_value = not_applicable;
+  }
+  compute_depths(variant);
+  compute_allele_types(variant);
+  m_site.is_pass = variant.filters().size() == 0 || (variant.filters().size() == 1 && variant.has_filter("PASS"));
+  const auto id = variant.id();
+  m_site.is_known = !id.empty() && id != ".";
+  return m_site;
+}
+
+void SiteStatisticsCalculator::compute_depths(const Variant& variant) {
+  const auto depths = variant.visit_individual_field("DP", [](const auto& dp) {
+    using traits = typename decay_t<decltype(dp)>::traits;
+    auto sum = 0.0;
+    auto n = 0u;
+    for (auto sample = 0u; sample < dp.n_samples(); ++sample) {
+      const auto depth = dp.value(sample, 0);
+      if (traits::is_value(depth)) {
+        sum += depth;
+        ++n;
+      }
+    }
+    return make_pair(sum, n);
+  });
+  m_site.mean_depth = depths.second == 0 ? not_applicable : depths.first / depths.second;
+
+  const auto allele_depths = variant.visit_individual_field("AD", [this](const auto& ad) {
+    using traits = typename decay_t<decltype(ad)>::traits;
+    auto alt_depth = 0.0;
+    auto total_depth = 0.0;
+    for (auto sample = 0u; sample < ad.n_samples(); ++sample) {
+      if (m_packed[sample] != PackedGenotype::HET)
+        continue;
+      for (auto allele = 0u; allele < ad.values_per_sample(); ++allele) {
+        const auto depth = ad.value(sample, allele);
+        if (!traits::is_value(depth))
+          continue;
+        total_depth += depth;
+        alt_depth += allele == 0 ? 0 : depth;
+      }
+    }
+    return make_pair(alt_depth, total_depth);
+  });
+  m_site.het_allele_balance = allele_depths.second == 0 ? not_applicable : allele_depths.first / allele_depths.second;
+}
+
+void SiteStatisticsCalculator::compute_allele_types(const Variant& variant) {
+  const auto ref = variant.ref();
+  const auto alts = variant.alt();
+  m_site.transitions = 0;
+  m_site.transversions = 0;
+  m_site.is_multiallelic = alts.size() > 1;
+  m_site.is_indel = false;
+  auto all_snps = !alts.empty() && ref.size() == 1 && base(ref[0]);
+  for (const auto& alt : alts) {
+    if (symbolic(alt)) {
+      all_snps = false;
+      continue;
+    }
+    m_site.is_indel |= alt.size() != ref.size();
+    if (ref.size() == 1 && alt.size() == 1 && base(ref[0]) && base(alt[0])) {
+      if (transition(ref[0], alt[0]))
+        ++m_site.transitions;
+      else
+        ++m_site.transversions;
+    }
+    else
+      all_snps = false;
+  }
+  m_site.is_snp = all_snps;
+}
+
+void SiteStatisticsCalculator::annotate(VariantBuilder& builder) const {
+  const auto n_alts = m_summary.n_alleles() == 0 ? 0 : m_summary.n_alleles() - 1;
+  auto allele_counts = vector<int32_t>(n_alts);
+  auto allele_frequencies = vector<float>(n_alts);
+  for (auto alt = 0u; alt < n_alts; ++alt) {
+    allele_counts[alt] = int32_t(m_summary.allele_count(alt + 1));
+    allele_frequencies[alt] = float(m_summary.allele_frequency(alt + 1));
+  }
+  builder.set_integer_shared_field("AC", allele_counts);
+  builder.set_integer_shared_field("AN", int32_t(m_site.allele_number));
+  if (m_site.allele_number > 0)
+    builder.set_float_shared_field("AF", allele_frequencies);
+  if (!std::isnan(m_site.hwe_p_value)) {
+    builder.set_float_shared_field("HWE", float(m_site.hwe_p_value));
+    builder.set_float_shared_field("ExcHet", float(m_site.excess_het_p_value));
+  }
+  if (!std::isnan(m_site.call_rate))
+    builder.set_float_shared_field("CallRate", float(m_site.call_rate));
+  if (!std::isnan(m_site.mean_depth))
+    builder.set_float_shared_field("MeanDP", float(m_site.mean_depth));
+  if (!std::isnan(m_site.het_allele_balance))
+    builder.set_float_shared_field("HetAB", float(m_site.het_allele_balance));
+}
+
+void SiteStatisticsCalculator::add_info_fields(VariantHeaderBuilder& builder) {
+  builder.add_shared_field("AC", "A", "Integer", "Allele count in genotypes, for each ALT allele")
+         .add_shared_field("AN", "1", "Integer", "Total number of alleles in called genotypes")
+         .add_shared_field("AF", "A", "Float", "Allele frequency in called genotypes, for each ALT allele")
+         .add_shared_field("HWE", "1", "Float", "Exact Hardy-Weinberg equilibrium p-value")
+         .add_shared_field("ExcHet", "1", "Float", "Exact test p-value for excess heterozygosity")
+         .add_shared_field("CallRate", "1", "Float", "Fraction of samples with a fully called genotype")
+         .add_shared_field("MeanDP", "1", "Float", "Mean sample depth")
+         .add_shared_field("HetAB", "1", "Float", "Alternate allele depth over total depth in heterozygous samples");
+}
+
+pair<double, double> SiteStatisticsCalculator::hardy_weinberg(const uint32_t n_hom_ref, const uint32_t n_het, const uint32_t n_hom_var, vector<double>& probabilities) {
+  const auto n_genotypes = n_hom_ref + n_het + n_hom_var;
+  if (n_genotypes == 0)
+    return make_pair(not_applicable, not_applicable);
+  const auto n_hom_rare = min(n_hom_ref, n_hom_var);
+  const auto rare_copies = 2 * n_hom_rare + n_het;
+  probabilities.assign(rare_copies + 1, 0.0);
+
+  // start at the most likely number of hets and walk down and up with the recurrence between consecutive counts
+  auto mid = uint32_t(uint64_t(rare_copies) * (2 * uint64_t(n_genotypes) - rare_copies) / (2 * uint64_t(n_genotypes)));
+  if (mid % 2 != rare_copies % 2)
+    ++mid;
+  probabilities[mid] = 1.0;
+  auto sum = 1.0;
+  auto hom_rare = double((rare_copies - mid) / 2);
+  auto hom_common = double(n_genotypes - mid) - hom_rare;
+  for (auto hets = mid; hets > 1; hets -= 2) {
+    probabilities[hets - 2] = probabilities[hets] * hets * (hets - 1.0) / (4.0 * (hom_rare + 1.0) * (hom_common + 1.0));
+    sum += probabilities[hets - 2];
+    hom_rare += 1.0;
+    hom_common += 1.0;
+  }
+  hom_rare = double((rare_copies - mid) / 2);
+  hom_common = double(n_genotypes - mid) - hom_rare;
+  for (auto hets = mid; hets + 2 <= rare_copies; hets += 2) {
+    probabilities[hets + 2] = probabilities[hets] * 4.0 * hom_rare * hom_common / ((hets + 2.0) * (hets + 1.0));
+    sum += probabilities[hets + 2];
+    hom_rare -= 1.0;
+    hom_common -= 1.0;
+  }
+
+  const auto observed = probabilities[n_het];
+  auto p_hwe = 0.0;
+  auto p_excess_het = 0.0;
+  for (auto hets = rare_copies % 2; hets <= rare_copies; hets += 2) {
+    if (probabilities[hets] <= observed)
+      p_hwe += probabilities[hets];
+    if (hets >= n_het)
+      p_excess_het += probabilities[hets];
+  }
+  return make_pair(min(1.0, p_hwe / sum), min(1.0, p_excess_het / sum));
+}
+
+SiteStatisticsEngine::SiteStatisticsEngine(const uint32_t n_threads) :
+  m_n_threads {max(n_threads, 1u)}
+{}
+
+SiteStatisticsTable SiteStatisticsEngine::run(const std::string& filename, const std::vector<std::string>& intervals) const {
+  if (intervals.empty()) {
+    auto reader = IndexedVariantReader<IndexedVariantIterator>{filename, intervals};
+    return stream(reader);
+  }
+  auto table = SiteStatisticsTable{};
+  const auto reader = ShardedVariantReader{filename, intervals, m_n_threads};
+  reader.ordered(compute_shard, [&table](SiteStatisticsTable&& shard_table) { table.append(shard_table); });
+  return table;
+}
+
+}
@@ -0,0 +1,222 @@
+#ifndef gamgee__site_statistics__guard
+#define gamgee__site_statistics__guard
+
+#include "genotype_summary.h"
+#include "packed_genotypes.h"
+#include "variant.h"
+#include "variant_builder.h"
+#include "variant_header_builder.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gamgee {
+
+/**
+ * @brief the QC metrics of one site, see SiteStatisticsCalculator
+ *
+ * Metrics that don't apply to a site are NaN (e.g. the Hardy-Weinberg p-values of multi-allelic sites or the mean
+ * depth of records without DP).
+ */
+struct SiteStatistics {
+  uint32_t chromosome;         ///< contig index in the header
+  uint32_t alignment_start;    ///< 1-based position
+  uint32_t allele_count;       ///< number of called alternate alleles (all alternates together)
+  uint32_t allele_number;      ///< number of called alleles (AN)
+  double allele_frequency;     ///< allele_count / allele_number (NaN if no allele is called)
+  double hwe_p_value;          ///< exact Hardy-Weinberg equilibrium test (Wigginton et al. 2005), bi-allelic sites with diploid calls only
+  double excess_het_p_value;   ///< one-sided exact test for excess heterozygosity: probability of at least as many hets under HWE
+  uint32_t called;             ///< number of fully called samples
+  double call_rate;            ///< fully called samples over all samples
+  double mean_depth;           ///< mean DP of the samples with a DP value
+  double het_allele_balance;   ///< alternate AD over total AD summed over the het samples
+  uint32_t transitions;        ///< number of alternate alleles that are transitions of a single base reference
+  uint32_t transversions;      ///< number of alternate alleles that are transversions of a single base reference
+  bool is_snp;                 ///< single base reference and alternates
+  bool is_indel;               ///< at least one non-symbolic alternate allele of a different length than the reference
+  bool is_multiallelic;        ///< more than one alternate allele
+  bool is_pass;                ///< no filters or only PASS
+  bool is_known;               ///< has an ID
+};
+
+/**
+ * @brief transition and transversion counts
+ */
+struct TiTvCounts {
+  uint64_t transitions {0};
+  uint64_t transversions {0};
+
+  double ratio() const { return transversions == 0 ? 0.0 : double(transitions) / transversions; } ///< @brief Ti/Tv ratio (0 without transversions)
+  TiTvCounts& operator+=(const TiTvCounts& other) { transitions += other.transitions; transversions += other.transversions; return *this; }
+};
+
+/**
+ * @brief cohort totals over many sites, mergeable across shards
+ */
+class SiteStatisticsAccumulator {
+ public:
+  void add(const SiteStatistics& site, const uint32_t n_samples);   ///< @brief adds a site with n_samples samples
+  SiteStatisticsAccumulator& merge(const SiteStatisticsAccumulator& other); ///< @brief adds the totals of another accumulator (e.g. of another shard)
+
+  uint64_t n_sites() const { return m_n_sites; }                   ///< @brief number of sites
+  uint64_t n_snps() const { return m_n_snps; }                     ///< @brief number of SNP sites
+  uint64_t n_indels() const { return m_n_indels; }                 ///< @brief number of indel sites
+  uint64_t n_multiallelic() const { return m_n_multiallelic; }     ///< @brief number of multi-allelic sites
+  uint64_t n_pass() const { return m_n_pass; }                     ///< @brief number of sites with no filters or only PASS
+  uint64_t n_known() const { return m_n_known; }                   ///< @brief number of sites with an ID
+  double call_rate() const { return m_n_genotypes == 0 ? 0.0 : double(m_n_called) / m_n_genotypes; } ///< @brief fully called genotypes over all genotypes of all sites
+
+  const TiTvCounts& titv() const { return m_titv; }                ///< @brief all sites
+  const TiTvCounts& titv_pass() const { return m_titv_pass; }      ///< @brief sites with no filters or only PASS
+  const TiTvCounts& titv_filtered() const { return m_titv_filtered; } ///< @brief filtered sites
+  const TiTvCounts& titv_known() const { return m_titv_known; }    ///< @brief sites with an ID
+  const TiTvCounts& titv_novel() const { return m_titv_novel; }    ///< @brief sites without an ID
+
+ private:
+  uint64_t m_n_sites {0};
+  uint64_t m_n_snps {0};
+  uint64_t m_n_indels {0};
+  uint64_t m_n_multiallelic {0};
+  uint64_t m_n_pass {0};
+  uint64_t m_n_known {0};
+  uint64_t m_n_called {0};
+  uint64_t m_n_genotypes {0};
+  TiTvCounts m_titv {};
+  TiTvCounts m_titv_pass {};
+  TiTvCounts m_titv_filtered {};
+  TiTvCounts m_titv_known {};
+  TiTvCounts m_titv_novel {};
+};
+
+/**
+ * @brief columnar table of site statistics (one entry per site in every column) and their totals
+ */
+struct SiteStatisticsTable {
+  std::vector<uint32_t> chromosome;
+  std::vector<uint32_t> alignment_start;
+  std::vector<uint32_t> allele_count;
+  std::vector<uint32_t> allele_number;
+  std::vector<double> allele_frequency;
+  std::vector<double> hwe_p_value;
+  std::vector<double> excess_het_p_value;
+  std::vector<double> call_rate;
+  std::vector<double> mean_depth;
+  std::vector<double> het_allele_balance;
+  SiteStatisticsAccumulator totals;
+
+  uint32_t size() const { return uint32_t(chromosome.size()); }   ///< @brief number of sites
+  void add(const SiteStatistics& site, const uint32_t n_samples); ///< @brief appends a site
+  void append(const SiteStatisticsTable& other);                   ///< @brief appends all sites of another table (e.g. the next shard) and merges its totals
+};
+
+/**
+ * @brief computes the SiteStatistics of records from their GT, AD and DP fields
+ *
+ * The genotypes go through a GenotypeSummary and PackedGenotypes and the AD and DP values are read in place, so
+ * there are no per-sample allocations, and the buffers are reused from one record to the next. A calculator is not
+ * thread safe: use one per thread.
+ *
+ * The metrics can be written back as INFO fields of a rebuilt record:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * auto header_builder = VariantHeaderBuilder{reader.header()};
+ * SiteStatisticsCalculator::add_info_fields(header_builder);
+ * const auto header = header_builder.build();
+ * auto builder = VariantBuilder{header};
+ * auto calculator = SiteStatisticsCalculator{};
+ * for (const auto& record : reader) {
+ *   calculator.compute(record);
+ *   ... set the site and sample fields of builder ...
+ *   calculator.annotate(builder);
+ *   writer.add_record(builder.build());
+ * }
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class SiteStatisticsCalculator {
+ public:
+  /**
+   * @brief computes the metrics of a record
+   * @return the metrics, also available with last() until the next call
+   */
+  const SiteStatistics& compute(const Variant& variant);
+
+  const SiteStatistics& last() const { return m_site; }            ///< @brief metrics of the last record passed to compute()
+  const GenotypeSummary& last_summary() const { return m_summary; } ///< @brief genotype summary of the last record passed to compute()
+
+  /**
+   * @brief sets the INFO fields added by add_info_fields() to the metrics of the last record passed to compute()
+   *
+   * AC and AF have one value per alternate allele. Metrics that don't apply to the site (NaN) are not set.
+   */
+  void annotate(VariantBuilder& builder) const;
+
+  /**
+   * @brief declares the INFO fields set by annotate(): AC, AN, AF, HWE, ExcHet, CallRate, MeanDP and HetAB
+   */
+  static void add_info_fields(VariantHeaderBuilder& builder);
+
+  /**
+   * @brief exact Hardy-Weinberg tests of bi-allelic diploid genotype counts (Wigginton, Cutler and Abecasis 2005)
+   * @param probabilities buffer reused across calls to avoid allocating
+   * @return {two-sided HWE p-value, probability of at least n_het hets}, NaN if there are no genotypes
+   */
+  static std::pair<double, double> hardy_weinberg(const uint32_t n_hom_ref, const uint32_t n_het, const uint32_t n_hom_var, std::vector<double>& probabilities);
+
+ private:
+  SiteStatistics m_site {};
+  GenotypeSummary m_summary {};
+  PackedGenotypes m_packed {};
+  std::vector<double> m_probabilities {};
+
+  void compute_depths(const Variant& variant);
+  void compute_allele_types(const Variant& variant);
+};
+
+/**
+ * @brief computes the site statistics of whole files, sharding genomic intervals across threads
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * const auto engine = SiteStatisticsEngine{8};
+ * const auto table = engine.run("cohort.bcf", SingleVariantReader{"cohort.bcf"}.header().chromosomes()); // one shard per contig
+ * cout << table.size() << " sites, Ti/Tv " << table.totals.titv().ratio() << endl;
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class SiteStatisticsEngine {
+ public:
+  explicit SiteStatisticsEngine(const uint32_t n_threads = 1); ///< @param n_threads number of shards processed at the same time
+
+  /**
+   * @brief computes the statistics of all the records of any variant reader, on the calling thread
+   */
+  template<class READER>
+  static SiteStatisticsTable stream(READER& reader) {
+    auto table = SiteStatisticsTable{};
+    auto calculator = SiteStatisticsCalculator{};
+    for (const auto& record : reader)
+      table.add(calculator.compute(record), record.n_samples());
+    return table;
+  }
+
+  /**
+   * @brief computes the statistics of an indexed file, one interval at a time on a pool of threads
+   *
+   * The intervals are the shards of a ShardedVariantReader. A record is only counted in the interval that contains
+   * its start, so records overlapping the boundary of adjacent intervals are not counted twice. The table has the
+   * sites in interval order and the totals of all intervals.
+   *
+   * @param filename an indexed variant file (see IndexedVariantReader)
+   * @param intervals the shards (e.g. the chromosomes of the header, or fixed size windows). An empty vector reads
+   * the whole file on the calling thread, as in IndexedVariantReader.
+   * @throws the first exception thrown while reading a shard
+   */
+  SiteStatisticsTable run(const std::string& filename, const std::vector<std::string>& intervals) const;
+
+ private:
+  uint32_t m_n_threads;
+};
+
+}
+
+#endif // gamgee__site_statistics__guard
@@ -10,12 +10,14 @@ namespace gamgee {
 
 SyncedVariantIterator::SyncedVariantIterator() :
   m_synced_readers {},
-  m_variant_vector {}
+  m_variant_vector {},
+  m_spare_records {}
 {}
 
 SyncedVariantIterator::SyncedVariantIterator(const std::shared_ptr<bcf_srs_t>& synced_readers) :
   m_synced_readers {synced_readers},
-  m_variant_vector {}
+  m_variant_vector {},
+  m_spare_records (synced_readers->nreaders)
 {
   m_variant_vector.reserve(m_synced_readers->nreaders);
   fetch_next_record();
@@ -25,6 +27,12 @@ std::vector<Variant>& SyncedVariantIterator::operator*() {
   return m_variant_vector;
 }
 
+std::vector<Variant> SyncedVariantIterator::detach() {
+  auto detached = std::move(m_variant_vector);
+  m_variant_vector = std::vector<Variant>(detached.size());   // keeps the iterator away from its end state
+  return detached;
+}
+
 std::vector<Variant>& SyncedVariantIterator::operator++() {
   fetch_next_record();
   return m_variant_vector;
@@ -47,28 +55,44 @@ void SyncedVariantIterator::init_headers_vector() {
   }
 }
 
+/**
+ * @brief moves the records of the last vector back to their readers
+ * @note a record the user still refers to (through a moved Variant or one of its fields) isn't given back: its
+ * reader will copy into a new record next time instead
+ */
+void SyncedVariantIterator::recycle_variant_vector() {
+  for (auto idx = 0u; idx < m_variant_vector.size(); idx++) {
+    auto& variant = m_variant_vector[idx];
+    if (variant.m_body && variant.m_body.use_count() == 1)
+      m_spare_records[idx] = std::move(variant);
+  }
+  m_variant_vector.clear();
+}
+
 /**
  * @brief pre-fetches the next variant record
  */
 void SyncedVariantIterator::fetch_next_record() {
-  if (!bcf_sr_next_line(m_synced_readers.get())) {
-    m_variant_vector.clear();
+  recycle_variant_vector();
+  if (!bcf_sr_next_line(m_synced_readers.get()))
     return;
-  }
-  else {
-    m_variant_vector.clear();
-    m_variant_vector.resize(m_synced_readers->nreaders);
-  }
-    
+  m_variant_vector.resize(m_synced_readers->nreaders);
+
   // can't initialize until a line has been read
   if (m_headers_vector.empty())
     init_headers_vector();
 
   for (int idx = 0; idx < m_synced_readers->nreaders; idx++) {
     if (bcf_sr_has_line(m_synced_readers.get(), idx)) {
-      // can't cache variant bodies because they may change location in the synced reader
-      auto* body_ptr = utils::variant_deep_copy(bcf_sr_get_line(m_synced_readers.get(), idx));
-      m_variant_vector[idx] = Variant{m_headers_vector[idx], utils::make_shared_variant(body_ptr)};
+      // can't keep the synced reader's bodies because they may change location, so the line is copied into the
+      // reader's own record (reusing its memory)
+      auto& record = m_spare_records[idx];
+      if (record.missing())
+        record = Variant{m_headers_vector[idx], utils::make_shared_variant(bcf_init1())};
+      utils::variant_deep_copy_into(bcf_sr_get_line(m_synced_readers.get(), idx), record.m_body.get());
+      record.invalidate_field_slots();
+      m_variant_vector[idx] = std::move(record);
+      record = Variant{};
     }
   }
 }
@@ -12,6 +12,13 @@ namespace gamgee {
 
 /**
  * @brief Utility class to enable for-each style iteration in the SyncedVariantReader class
+ *
+ * Every reader has a record of its own that the lines of the synced readers are copied into, reusing the memory
+ * of the previous line, so advancing the iterator doesn't allocate once the records have grown to the widest line.
+ *
+ * @note a record is only reused if nothing else refers to it, so keeping a Variant of the vector (by moving it out
+ * or holding one of its fields) past the next step is safe: the reader simply copies into a new record instead.
+ * detach() hands over the whole vector that way. Copying a Variant still makes a deep copy.
  */
 class SyncedVariantIterator {
  public:
@@ -55,10 +62,19 @@ class SyncedVariantIterator {
   /**
    * @brief dereference operator (needed by for-each loop)
    *
-   * @return a persistent Variant vector independent from the iterator (a copy of the iterator's vector)
+   * @return a reference to the iterator's Variant vector, whose records are reused by the next step unless
+   * something else refers to them
    */
   std::vector<Variant>& operator*();
 
+  /**
+   * @brief hands over the records of the current vector, so they are never reused by the iterator
+   *
+   * @return the current Variant vector, independent from the iterator. The iterator's vector is left with missing
+   * records until the next step.
+   */
+  std::vector<Variant> detach();
+
   /**
    * @brief pre-fetches the next vector and tests for end of file
    *
@@ -70,8 +86,10 @@ class SyncedVariantIterator {
   std::shared_ptr<bcf_srs_t> m_synced_readers;                  ///< pointer to the synced readers of the variant files
   std::vector<Variant> m_variant_vector;                        ///< caches next Variant vector
   std::vector<std::shared_ptr<bcf_hdr_t>> m_headers_vector;     ///< caches each reader's htslib header
+  std::vector<Variant> m_spare_records;                         ///< each reader's record to copy its next line into (missing if it was kept by the user)
 
   void init_headers_vector();                                   ///< initializes m_variant_headers
+  void recycle_variant_vector();                                ///< gives the records of the last vector back to their readers
   void fetch_next_record();                                     ///< fetches next Variant vector
 };
 
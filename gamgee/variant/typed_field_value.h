@@ -0,0 +1,116 @@
+#ifndef gamgee__typed_field_value__guard
+#define gamgee__typed_field_value__guard
+
+#include "htslib/vcf.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace gamgee {
+
+/**
+ * @brief the BCF type code and the missing and vector end markers of one of the BCF value types
+ *
+ * Specialized for the four numeric widths htslib stores values with (int8_t, int16_t, int32_t and float), so the
+ * marker checks compile to a single comparison of the right width instead of a switch on the type of the field.
+ * The integer checks rely on the markers being the two smallest values of each width: every value greater than the
+ * vector end marker is a real value.
+ */
+template<class TYPE> struct BcfValueTraits;
+
+/**
+ * @brief the common part of the integer specializations of BcfValueTraits
+ */
+template<class TYPE, int32_t BCF_TYPE, int32_t MISSING, int32_t VECTOR_END>
+struct BcfIntegerValueTraits {
+  static constexpr int32_t bcf_type = BCF_TYPE;                                                     ///< @brief the BCF_BT_* code of this width
+  static bool is_missing(const TYPE value) { return value == TYPE(MISSING); }                       ///< @brief whether the value is the missing marker
+  static bool is_vector_end(const TYPE value) { return value == TYPE(VECTOR_END); }                 ///< @brief whether the value is the vector end marker
+  static bool is_value(const TYPE value) { return value > TYPE(VECTOR_END); }                       ///< @brief whether the value is neither missing nor vector end
+
+  /**
+   * @brief widens a value to int32_t, mapping the markers to the int32_t markers (as IndividualFieldValue<int32_t> does)
+   */
+  static int32_t to_integer(const TYPE value) { return is_value(value) ? int32_t(value) : bcf_int32_vector_end - (VECTOR_END - int32_t(value)); }
+
+  /**
+   * @brief converts a value to float, mapping the markers to the float markers (as IndividualFieldValue<float> does)
+   */
+  static float to_float(const TYPE value) {
+    if (is_value(value))
+      return float(value);
+    auto marker = 0.0f;
+    bcf_float_set(&marker, is_missing(value) ? bcf_float_missing : bcf_float_vector_end);
+    return marker;
+  }
+};
+
+template<> struct BcfValueTraits<int8_t>  : BcfIntegerValueTraits<int8_t,  BCF_BT_INT8,  bcf_int8_missing,  bcf_int8_vector_end>  {};
+template<> struct BcfValueTraits<int16_t> : BcfIntegerValueTraits<int16_t, BCF_BT_INT16, bcf_int16_missing, bcf_int16_vector_end> {};
+template<> struct BcfValueTraits<int32_t> : BcfIntegerValueTraits<int32_t, BCF_BT_INT32, bcf_int32_missing, bcf_int32_vector_end> {};
+
+/**
+ * @brief float specialization of BcfValueTraits: the markers are NaNs with specific bit patterns, so they are compared as uint32_t
+ */
+template<> struct BcfValueTraits<float> {
+  static constexpr int32_t bcf_type = BCF_BT_FLOAT;
+  static bool is_missing(const float value) { return bits(value) == bcf_float_missing; }
+  static bool is_vector_end(const float value) { return bits(value) == bcf_float_vector_end; }
+  static bool is_value(const float value) { const auto b = bits(value); return b != bcf_float_missing && b != bcf_float_vector_end; }
+  static int32_t to_integer(const float value) { return is_value(value) ? int32_t(value) : (is_missing(value) ? bcf_int32_missing : bcf_int32_vector_end); }
+  static float to_float(const float value) { return value; }
+
+ private:
+  static uint32_t bits(const float value) { auto result = uint32_t{}; memcpy(&result, &value, sizeof(result)); return result; }
+};
+
+/**
+ * @brief the values of one sample of a TypedIndividualField (or of a TypedSharedField), in their on-disk width
+ *
+ * This is just a pointer and a size: there is no conversion, no bounds checking and no reference counting, so loops
+ * over the values compile to plain typed loads. All the values are visible, including the vector end markers that
+ * pad samples with fewer values than the others (see n_values()) and missing values (see BcfValueTraits).
+ *
+ * @warning only valid while the field it came from (and its Variant) is alive
+ * @tparam TYPE one of int8_t, int16_t, int32_t or float
+ */
+template<class TYPE>
+class TypedFieldValue {
+ public:
+  using traits = BcfValueTraits<TYPE>;
+
+  TypedFieldValue(const TYPE* const data, const uint32_t size) : m_data {data}, m_size {size} {} ///< @brief creates a view of size values starting at data
+
+  TYPE operator[](const uint32_t index) const { return m_data[index]; } ///< @brief the raw value at index (possibly a marker) @warning no bounds checking
+  uint32_t size() const { return m_size; }                              ///< @brief the number of values, including the vector end padding
+  const TYPE* begin() const { return m_data; }                          ///< @brief pointer to the first value
+  const TYPE* end() const { return m_data + m_size; }                   ///< @brief pointer past the last value, including the vector end padding
+
+  /**
+   * @brief the number of values before the vector end padding
+   */
+  uint32_t n_values() const {
+    auto n = 0u;
+    while (n < m_size && !traits::is_vector_end(m_data[n]))
+      ++n;
+    return n;
+  }
+
+  /**
+   * @brief whether all the values (ignoring the vector end padding) are missing
+   */
+  bool missing() const {
+    for (auto i = 0u; i < m_size; ++i)
+      if (traits::is_value(m_data[i]))
+        return false;
+    return true;
+  }
+
+ private:
+  const TYPE* m_data;
+  uint32_t m_size;
+};
+
+}
+
+#endif // gamgee__typed_field_value__guard
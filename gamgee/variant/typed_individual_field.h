@@ -0,0 +1,107 @@
+#ifndef gamgee__typed_individual_field__guard
+#define gamgee__typed_individual_field__guard
+
+#include "typed_field_value.h"
+
+#include "../utils/utils.h"
+
+#include "htslib/vcf.h"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace gamgee {
+
+/**
+ * @brief the values of an individual field of a Variant for all samples, in the width they are stored with
+ *
+ * IndividualField<IndividualFieldValue<int32_t>> converts every value it returns from the width of the field in
+ * this particular record (int8_t, int16_t, int32_t or float) and checks for the vector end markers element by
+ * element. A TypedIndividualField is instead typed on the stored width, which is checked once when it is created,
+ * so the values are plain arrays:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * const auto total_depth = record.visit_individual_field("DP", [](const auto& dp) {
+ *   using traits = typename std::decay_t<decltype(dp)>::traits;
+ *   auto total = 0ll;
+ *   for (auto sample = 0u; sample < dp.n_samples(); ++sample) {
+ *     const auto value = dp.value(sample, 0);
+ *     total += traits::is_value(value) ? value : 0;
+ *   }
+ *   return total;
+ * });
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The visitor (a generic lambda or any function object with an overload for each width) is instantiated once per
+ * width, so the loop is specialized for the type of the field and can be vectorized by the compiler.
+ *
+ * @note like IndividualField, a TypedIndividualField holds a shared pointer to the record so it can outlive the Variant it came from
+ * @tparam TYPE one of int8_t, int16_t, int32_t or float
+ */
+template<class TYPE>
+class TypedIndividualField {
+ public:
+  using traits = BcfValueTraits<TYPE>;
+  using value_type = TYPE;
+
+  /**
+   * @brief default constructor of an empty TypedIndividualField
+   * @note empty fields are created when the field requested is missing in the Variant record
+   */
+  TypedIndividualField() : m_body {nullptr}, m_data {nullptr}, m_n_samples {0}, m_values_per_sample {0} {}
+
+  /**
+   * @brief creates a new typed view of a format field inside the Variant object
+   * @param body the full Variant object where all the values of the field are stored (shared ownership)
+   * @param format_ptr the format field inside the body
+   * @throws std::invalid_argument if the values of the field are not stored as TYPE
+   */
+  explicit TypedIndividualField(const std::shared_ptr<bcf1_t>& body, const bcf_fmt_t* const format_ptr) :
+    m_body {body},
+    m_data {reinterpret_cast<const TYPE*>(format_ptr->p)},
+    m_n_samples {uint32_t(body->n_sample)},
+    m_values_per_sample {uint32_t(format_ptr->n)}
+  {
+    if (format_ptr->type != traits::bcf_type)
+      throw std::invalid_argument{"individual field values are stored with BCF type " + std::to_string(format_ptr->type) + ", not " + std::to_string(traits::bcf_type)};
+  }
+
+  TypedIndividualField(const TypedIndividualField& other) = delete;            ///< @brief copying of the TypedIndividualField object is not allowed. Use move constructor instead.
+  TypedIndividualField& operator=(const TypedIndividualField& other) = delete; ///< @copydoc TypedIndividualField::TypedIndividualField(const TypedIndividualField&)
+  TypedIndividualField(TypedIndividualField&& other) = default;                ///< @brief safely moves the data from one TypedIndividualField to a new one without making any copies
+  TypedIndividualField& operator=(TypedIndividualField&& other) = default;     ///< @brief safely moves the data from one TypedIndividualField to the other without making any copies
+
+  /**
+   * @brief the values of a sample
+   * @exception std::out_of_range if sample is out of range or the field is missing
+   */
+  TypedFieldValue<TYPE> operator[](const uint32_t sample) const {
+    if (empty())
+      throw std::out_of_range("Tried to index an individual field that is missing with operator[]");
+    utils::check_max_boundary(sample, m_n_samples);
+    return TypedFieldValue<TYPE>{m_data + size_t{sample} * m_values_per_sample, m_values_per_sample};
+  }
+
+  /**
+   * @brief the raw value (possibly a marker) at index of sample
+   * @warning no bounds checking, for inner loops
+   */
+  TYPE value(const uint32_t sample, const uint32_t index) const { return m_data[size_t{sample} * m_values_per_sample + index]; }
+
+  const TYPE* data() const { return m_data; }                            ///< @brief the values of all samples, sample after sample, values_per_sample() each (nullptr if empty)
+  uint32_t values_per_sample() const { return m_values_per_sample; }     ///< @brief the number of values of every sample, including the vector end padding (the stride of data())
+  uint32_t size() const { return m_n_samples; }                          ///< @brief the number of samples (0 if the field is missing)
+  uint32_t n_samples() const { return size(); }                          ///< @brief just an alias to size() to simplify interfaces
+  bool empty() const { return m_body == nullptr; }                       ///< @brief checks if the object is empty. @note empty objects are returned when the requested field is missing
+
+ private:
+  std::shared_ptr<bcf1_t> m_body; ///< shared ownership of the Variant record memory so it stays alive while this object is in scope
+  const TYPE* m_data;             ///< the values of the first sample
+  uint32_t m_n_samples;
+  uint32_t m_values_per_sample;
+};
+
+}
+
+#endif // gamgee__typed_individual_field__guard
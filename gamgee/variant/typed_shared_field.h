@@ -0,0 +1,88 @@
+#ifndef gamgee__typed_shared_field__guard
+#define gamgee__typed_shared_field__guard
+
+#include "typed_field_value.h"
+
+#include "../utils/utils.h"
+
+#include "htslib/vcf.h"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace gamgee {
+
+/**
+ * @brief the values of a shared field of a Variant, in the width they are stored with
+ *
+ * The shared field counterpart of TypedIndividualField, see Variant::visit_shared_field():
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * const auto max_allele_count = record.visit_shared_field("AC", [](const auto& ac) {
+ *   using traits = typename std::decay_t<decltype(ac)>::traits;
+ *   auto result = 0;
+ *   for (const auto value : ac)
+ *     result = std::max(result, traits::is_value(value) ? int(value) : 0);
+ *   return result;
+ * });
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * @tparam TYPE one of int8_t, int16_t, int32_t or float
+ */
+template<class TYPE>
+class TypedSharedField {
+ public:
+  using traits = BcfValueTraits<TYPE>;
+  using value_type = TYPE;
+
+  /**
+   * @brief default constructor of an empty TypedSharedField
+   * @note empty fields are created when the field requested is missing in the Variant record (or is a flag)
+   */
+  TypedSharedField() : m_body {nullptr}, m_data {nullptr}, m_size {0} {}
+
+  /**
+   * @brief creates a new typed view of an info field inside the Variant object
+   * @param body the full Variant object where all the values of the field are stored (shared ownership)
+   * @param info_ptr the info field inside the body
+   * @throws std::invalid_argument if the values of the field are not stored as TYPE
+   */
+  explicit TypedSharedField(const std::shared_ptr<bcf1_t>& body, const bcf_info_t* const info_ptr) :
+    m_body {body},
+    m_data {reinterpret_cast<const TYPE*>(info_ptr->vptr)},
+    m_size {uint32_t(info_ptr->len)}
+  {
+    if (info_ptr->type != traits::bcf_type)
+      throw std::invalid_argument{"shared field values are stored with BCF type " + std::to_string(info_ptr->type) + ", not " + std::to_string(traits::bcf_type)};
+  }
+
+  TypedSharedField(const TypedSharedField& other) = delete;            ///< @brief copying of the TypedSharedField object is not allowed. Use move constructor instead.
+  TypedSharedField& operator=(const TypedSharedField& other) = delete; ///< @copydoc TypedSharedField::TypedSharedField(const TypedSharedField&)
+  TypedSharedField(TypedSharedField&& other) = default;                ///< @brief safely moves the data from one TypedSharedField to a new one without making any copies
+  TypedSharedField& operator=(TypedSharedField&& other) = default;     ///< @brief safely moves the data from one TypedSharedField to the other without making any copies
+
+  /**
+   * @brief the raw value (possibly a marker) at index
+   * @exception std::out_of_range if index is out of range
+   */
+  TYPE operator[](const uint32_t index) const {
+    utils::check_max_boundary(index, m_size);
+    return m_data[index];
+  }
+
+  TypedFieldValue<TYPE> values() const { return TypedFieldValue<TYPE>{m_data, m_size}; } ///< @brief all the values, without bounds checking
+  const TYPE* begin() const { return m_data; }                 ///< @brief pointer to the first value
+  const TYPE* end() const { return m_data + m_size; }          ///< @brief pointer past the last value
+  uint32_t size() const { return m_size; }                     ///< @brief the number of values (0 if the field is missing)
+  bool empty() const { return m_body == nullptr; }             ///< @brief checks if the object is empty. @note empty objects are returned when the requested field is missing
+
+ private:
+  std::shared_ptr<bcf1_t> m_body; ///< shared ownership of the Variant record memory so it stays alive while this object is in scope
+  const TYPE* m_data;
+  uint32_t m_size;
+};
+
+}
+
+#endif // gamgee__typed_shared_field__guard
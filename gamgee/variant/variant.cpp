@@ -81,7 +81,11 @@ Variant& Variant::operator=(const Variant& other) {
   if ( &other == this )  
     return *this;
   m_header = VariantHeader{other.m_header.m_header};    // Avoid a deep copy here by constructing using other's internal shared header pointer
-  m_body = utils::make_shared_variant(utils::variant_deep_copy(other.m_body.get()));  ///< shared_ptr assignment will take care of deallocating old record if necessary
+  if (m_body && other.m_body && m_body.use_count() == 1)  ///< nothing else refers to our record, so its memory can be reused
+    utils::variant_deep_copy_into(other.m_body.get(), m_body.get());
+  else
+    m_body = utils::make_shared_variant(utils::variant_deep_copy(other.m_body.get()));  ///< shared_ptr assignment will take care of deallocating old record if necessary
+  invalidate_field_slots();
   return *this;
 }
 
@@ -250,8 +254,8 @@ SharedField<string> Variant::shared_field_as_string(const int32_t index) const {
 }
 
 IndividualField<Genotype> Variant::genotypes() const {
-  // bcf_get_fmt() will unpack the record if necessary
-  const auto fmt = bcf_get_fmt(m_header.m_header.get(), m_body.get(), "GT");
+  // find_individual_field() will unpack the record if necessary
+  const auto fmt = find_individual_field("GT");
   if (fmt == nullptr) ///< if the variant is missing or the GT tag is missing, return an empty IndividualField
     return IndividualField<Genotype>{};
   return IndividualField<Genotype>{m_body, fmt};
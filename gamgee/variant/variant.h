@@ -2,9 +2,13 @@
 #define gamgee__variant__guard
 
 #include "variant_header.h"
+#include "field_handle.h"
+#include "field_slot_table.h"
 #include "individual_field.h"
 #include "individual_field_value.h"
 #include "shared_field.h"
+#include "typed_individual_field.h"
+#include "typed_shared_field.h"
 #include "variant_filters.h"
 #include "genotype.h"
 
@@ -15,6 +19,8 @@
 
 #include <string>
 #include <memory>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 namespace gamgee {
@@ -31,7 +37,7 @@ class Variant {
   Variant() = default;                                                                                        ///< initializes a null Variant @note this is only used internally by the iterators @warning if you need to create a Variant from scratch, use the builder instead
   explicit Variant(const std::shared_ptr<bcf_hdr_t>& header, const std::shared_ptr<bcf1_t>& body) noexcept;   ///< creates a Variant given htslib objects. @note used by all iterators
   Variant(const Variant& other);                                                                              ///< makes a deep copy of a Variant and it's header. Shared pointers maintain state to all other associated objects correctly.
-  Variant& operator=(const Variant& other);                                                                   ///< deep copy assignment of a Variant and it's header. Shared pointers maintain state to all other associated objects correctly.
+  Variant& operator=(const Variant& other);                                                                   ///< deep copy assignment of a Variant and it's header. Shared pointers maintain state to all other associated objects correctly. @note the memory of this record is overwritten in place (and reused) if nothing else refers to it, otherwise a new record is allocated, so the field objects (genotypes(), integer_individual_field(), ...) taken from it before keep their values. @warning the raw_* pointers are not references: they are left dangling or see the new values
   Variant(Variant&& other) = default;                                                                         ///< moves Variant and it's header accordingly. Shared pointers maintain state to all other associated objects correctly.
   Variant& operator=(Variant&& other) = default;                                                              ///< move assignment of a Variant and it's header. Shared pointers maintain state to all other associated objects correctly.
 
@@ -94,6 +100,85 @@ class Variant {
   SharedField<float> shared_field_as_float(const int32_t index) const;           ///< same as float_shared_field but will attempt to convert underlying data to float if possible. @warning creates a new object but makes no copies of the underlying values.
   SharedField<std::string> shared_field_as_string(const int32_t index) const;    ///< same as string_shared_field but will attempt to convert underlying data to string if possible. @warning creates a new object but makes no copies of the underlying values.
 
+  /**
+   * @brief returns the values of an individual field resolved in advance, see FieldHandle
+   * @return an empty IndividualField if the header doesn't declare the field or this record doesn't have it
+   * @throws std::invalid_argument if the handle is for a shared field
+   * @note the first lookup of a record builds a table of its fields, every following lookup (with a handle or an index) is O(1). This is why
+   * even the const accessors of a Variant should not be called from several threads at the same time.
+   */
+  template<class TYPE>
+  IndividualField<IndividualFieldValue<TYPE>> individual_field(const FieldHandle<TYPE>& handle) const {
+    if (!handle.is_individual())
+      throw std::invalid_argument{"the handle is not for an individual field"};
+    const auto field_ptr = handle.present() ? find_individual_field(uint32_t(handle.index())) : nullptr;
+    return field_ptr == nullptr ? IndividualField<IndividualFieldValue<TYPE>>{} : IndividualField<IndividualFieldValue<TYPE>>{m_body, field_ptr};
+  }
+
+  /**
+   * @brief returns the values of a shared field resolved in advance, see FieldHandle
+   * @return an empty SharedField if the header doesn't declare the field or this record doesn't have it
+   * @throws std::invalid_argument if the handle is for an individual field
+   * @copydetails individual_field(const FieldHandle<TYPE>&) const
+   */
+  template<class TYPE>
+  SharedField<TYPE> shared_field(const FieldHandle<TYPE>& handle) const {
+    if (!handle.is_shared())
+      throw std::invalid_argument{"the handle is not for a shared field"};
+    const auto field_ptr = handle.present() ? find_shared_field(uint32_t(handle.index())) : nullptr;
+    return field_ptr == nullptr ? SharedField<TYPE>{} : SharedField<TYPE>{m_body, field_ptr};
+  }
+
+  /**
+   * @brief the raw htslib storage of an individual field, for the kernels that decode the BCF bytes themselves
+   * (genotype matrices, summaries and packing, sample predicates)
+   * @return nullptr if the header doesn't declare the field or this record doesn't have it
+   * @warning low level: the pointer refers to the body of this record and is only valid until the record is modified or replaced.
+   * Prefer the typed accessors (e.g. visit_individual_field()) everywhere else.
+   */
+  const bcf_fmt_t* raw_individual_field(const std::string& tag) const { return find_individual_field(tag); }
+  const bcf_fmt_t* raw_individual_field(const uint32_t index) const { return find_individual_field(index); }  ///< @copydoc raw_individual_field(const std::string&) const
+  /// @copydoc raw_individual_field(const std::string&) const
+  template<class TYPE>
+  const bcf_fmt_t* raw_individual_field(const FieldHandle<TYPE>& handle) const {
+    return handle.present() && handle.is_individual() ? find_individual_field(uint32_t(handle.index())) : nullptr;
+  }
+
+  /**
+   * @brief the raw htslib record, unpacked up to the given level, for the kernels that work on whole records (e.g. GVCFCombiner)
+   * @copydetails raw_individual_field(const std::string&) const
+   */
+  const bcf1_t* raw_body(const int unpack_level = BCF_UN_ALL) const {
+    if ((m_body->unpacked & unpack_level) != unpack_level)
+      bcf_unpack(m_body.get(), unpack_level);
+    return m_body.get();
+  }
+
+  /**
+   * @brief calls visitor with a TypedIndividualField of the width the values of an individual field are stored with in this record
+   *
+   * BCF stores the numeric values of a field in the smallest width that fits the values of each record, so the
+   * width is only known at run time. The visitor is called with a TypedIndividualField<int8_t>,
+   * TypedIndividualField<int16_t>, TypedIndividualField<int32_t> or TypedIndividualField<float>, so it must accept
+   * all four (typically a generic lambda taking a const auto&). This is the only place the type is checked: the
+   * loops inside the visitor are specialized for the width. Missing fields are visited as an empty
+   * TypedIndividualField<int32_t>.
+   *
+   * @param visitor any callable accepting every TypedIndividualField, with the same return type for all of them
+   * @return what visitor returns
+   * @throws std::invalid_argument for string fields
+   */
+  template<class VISITOR> decltype(auto) visit_individual_field(const std::string& tag, VISITOR&& visitor) const { return visit_typed_field<TypedIndividualField>(find_individual_field(tag), std::forward<VISITOR>(visitor)); }
+  template<class VISITOR> decltype(auto) visit_individual_field(const int32_t index, VISITOR&& visitor) const { return visit_typed_field<TypedIndividualField>(find_individual_field(uint32_t(index)), std::forward<VISITOR>(visitor)); } ///< @copydoc visit_individual_field(const std::string&, VISITOR&&) const
+
+  /**
+   * @brief calls visitor with a TypedSharedField of the width the values of a shared field are stored with in this record
+   * @copydetails visit_individual_field(const std::string&, VISITOR&&) const
+   * @note flags have no values and are visited as an empty TypedSharedField<int32_t>, like missing fields
+   */
+  template<class VISITOR> decltype(auto) visit_shared_field(const std::string& tag, VISITOR&& visitor) const { return visit_typed_field<TypedSharedField>(find_shared_field(tag), std::forward<VISITOR>(visitor)); }
+  template<class VISITOR> decltype(auto) visit_shared_field(const int32_t index, VISITOR&& visitor) const { return visit_typed_field<TypedSharedField>(find_shared_field(uint32_t(index)), std::forward<VISITOR>(visitor)); } ///< @copydoc visit_shared_field(const std::string&, VISITOR&&) const
+
   /**
    * @brief functional-style set logic operations for variant field vectors
    *
@@ -135,26 +220,29 @@ class Variant {
    * auto everywhere and unaware of the iterator and value types underlying the
    * data structures.
    *
-   * @note pred can either be a function pointer, a function object or a lambda function. 
+   * @note pred can either be a function pointer, a function object or a lambda function. It is called directly (it is not wrapped in a std::function), so it can be inlined.
    * @note This function can be called directly (ignoring the template parameters) as all the template parameters can be deduced from the function parameters. 
+   * @note for the common numeric comparisons (thresholds, ranges, missing values) SamplePredicate is much faster as it works on the raw values.
    * @tparam ITER any iterator that has operator- defined to return the difference in number of elements between two ITER iterators
    * @tparam VALUE the class of the objects ITER is iterating over. (e.g. in IndividualFieldIterator<Genotype> Genotype is the VALUE, IndividualFieldIterator is the ITER
    * @param first iterator to the initial position in a sequence. The range includes the element pointed by first.
    * @param last iterator to the last position in a sequence. The range does not include the element pointed by last.
+   * @tparam PRED any callable taking a const VALUE& and returning a value convertible to bool
    * @param pred unary predicate (lambda) function that accepts an element in range [first, last) as argument and returns a value convertible to bool. The value returned indicates whether the element is considered a match in the context of this function. 
    * @return a bitset indicating the samples for which the unary predicate is true
    */
-  template <class VALUE, template<class> class ITER>                                                                                         
-  static boost::dynamic_bitset<> select_if(                                                                   
-      const ITER<VALUE>& first,         
-      const ITER<VALUE>& last,          
-      const std::function<bool (const decltype(*first)& value)> pred)  // decltype(*first) will always yield an l-value reference to VALUE (VALUE&). I just added the & here to be explicit about my intention of capturing the parameter by reference.
+  template <class VALUE, template<class> class ITER, class PRED>
+  static boost::dynamic_bitset<> select_if(
+      const ITER<VALUE>& first,
+      const ITER<VALUE>& last,
+      const PRED& pred)
   {
     const auto n_samples = last - first; 
     auto selected_samples = boost::dynamic_bitset<>(n_samples);
     auto it = first;
     for (auto i = 0; i < n_samples; i++) {
-      selected_samples[i] = pred(*it++);
+      if (pred(*it++))
+        selected_samples.set(i);
     }
     return selected_samples;
   }
@@ -174,18 +262,47 @@ class Variant {
  private:
   VariantHeader m_header;                                                                        ///< variant header
   std::shared_ptr<bcf1_t> m_body;                                                                ///< htslib variant body pointer
+  mutable FieldSlotTable m_individual_slots {};                                                  ///< positions of the FORMAT fields of the record, built on the first lookup
+  mutable FieldSlotTable m_shared_slots {};                                                      ///< positions of the INFO fields of the record, built on the first lookup
 
-  bcf_fmt_t*  find_individual_field(const std::string& tag) const { return bcf_get_fmt(m_header.m_header.get(), m_body.get(), tag.c_str());  }
-  bcf_info_t* find_shared_field(const std::string& tag)     const { return bcf_get_info(m_header.m_header.get(), m_body.get(), tag.c_str()); }
-  bcf_fmt_t*  find_individual_field(const uint32_t index) const { return bcf_get_fmt_id(m_body.get(), index); }
-  bcf_info_t* find_shared_field(const uint32_t index)     const { return bcf_get_info_id(m_body.get(), index); }
+  bcf_fmt_t*  find_individual_field(const std::string& tag) const { return find_individual_field(uint32_t(m_header.field_index(tag))); }
+  bcf_info_t* find_shared_field(const std::string& tag)     const { return find_shared_field(uint32_t(m_header.field_index(tag))); }
+  bcf_fmt_t*  find_individual_field(const uint32_t index) const {
+    if (!(m_body->unpacked & BCF_UN_FMT))
+      bcf_unpack(m_body.get(), BCF_UN_FMT);
+    return m_individual_slots.find(m_body->d.fmt, m_body->n_fmt, int32_t(index));
+  }
+  bcf_info_t* find_shared_field(const uint32_t index) const {
+    if (!(m_body->unpacked & BCF_UN_INFO))
+      bcf_unpack(m_body.get(), BCF_UN_INFO);
+    return m_shared_slots.find(m_body->d.info, m_body->n_info, int32_t(index));
+  }
+  void invalidate_field_slots() const { m_individual_slots.invalidate(); m_shared_slots.invalidate(); } ///< must be called whenever the record in m_body is replaced in place
   bool check_field(const int32_t type_field, const int32_t type_value, const int32_t index) const;
   inline AlleleType allele_type_from_difference(const int diff) const;
 
   template<class FIELD_TYPE, class INDEX_OR_TAG> SharedField<FIELD_TYPE> shared_field_as(const INDEX_OR_TAG& p) const;
   template<class FIELD_TYPE, class INDEX_OR_TAG> IndividualField<IndividualFieldValue<FIELD_TYPE>> individual_field_as(const INDEX_OR_TAG& p) const;
 
+  template<template<class> class TYPED_FIELD, class FIELD, class VISITOR>
+  decltype(auto) visit_typed_field(const FIELD* const field_ptr, VISITOR&& visitor) const {
+    if (field_ptr == nullptr)
+      return visitor(TYPED_FIELD<int32_t>{});
+    switch (field_ptr->type) {
+      case BCF_BT_INT8:  return visitor(TYPED_FIELD<int8_t>{m_body, field_ptr});
+      case BCF_BT_INT16: return visitor(TYPED_FIELD<int16_t>{m_body, field_ptr});
+      case BCF_BT_INT32: return visitor(TYPED_FIELD<int32_t>{m_body, field_ptr});
+      case BCF_BT_FLOAT: return visitor(TYPED_FIELD<float>{m_body, field_ptr});
+      case BCF_BT_NULL:  return visitor(TYPED_FIELD<int32_t>{});
+      default: throw std::invalid_argument{"typed fields only apply to numeric fields, found BCF type " + std::to_string(field_ptr->type)};
+    }
+  }
+
   friend class VariantWriter;
+  friend class VariantIterator;        ///< reads every record into the same body
+  friend class IndexedVariantIterator; ///< reads every record into the same body
+  friend class MultipleVariantIterator; ///< recycles the bodies of the records it served
+  friend class SyncedVariantIterator; ///< copies every line into the bodies it recycles
   friend class VariantBuilder; ///< builder needs access to the internals in order to build efficiently
 
   // TODO: remove this friendship and these mutators after Issue #320 is resolved
@@ -9,6 +9,8 @@ using namespace std;
 
 namespace gamgee {
 
+constexpr uint32_t VariantBuilder::default_min_parallel_encoding_size;
+
 VariantBuilder::VariantBuilder(const VariantHeader& header) :
   m_header { header.m_header },  // Important: take shared ownership of header rather than make a deep copy
   m_contig {},
@@ -27,6 +29,11 @@ VariantBuilder& VariantBuilder::set_enable_validation(const bool enable_validati
   return *this;
 }
 
+VariantBuilder& VariantBuilder::set_encoding_threads(const uint32_t n_threads, const uint32_t min_encoded_size) {
+  m_individual_region.set_encoding_threads(n_threads, min_encoded_size);
+  return *this;
+}
+
 /******************************************************************************
  *
  * Functions for setting core site-level fields
@@ -363,6 +370,48 @@ VariantBuilder& VariantBuilder::set_string_individual_field(const uint32_t field
   return *this;
 }
 
+/******************************************************************************
+ *
+ * Functions for setting individual/FORMAT fields in bulk from caller owned columns
+ *
+ ******************************************************************************/
+
+VariantBuilder& VariantBuilder::set_genotypes(const VariantBuilderColumn<int32_t>& genotypes_for_all_samples) {
+  // The raw allele indices are kept: the field encodes them as it writes the column at build time
+  m_individual_region.bulk_set_genotype_field(m_individual_region.gt_index(), genotypes_for_all_samples);
+  return *this;
+}
+
+VariantBuilder& VariantBuilder::set_integer_individual_field(const std::string& tag, const VariantBuilderColumn<int32_t>& values_for_all_samples) {
+  m_individual_region.bulk_set_integer_field(tag, values_for_all_samples);
+  return *this;
+}
+
+VariantBuilder& VariantBuilder::set_integer_individual_field(const uint32_t field_index, const VariantBuilderColumn<int32_t>& values_for_all_samples) {
+  m_individual_region.bulk_set_integer_field(field_index, values_for_all_samples);
+  return *this;
+}
+
+VariantBuilder& VariantBuilder::set_float_individual_field(const std::string& tag, const VariantBuilderColumn<float>& values_for_all_samples) {
+  m_individual_region.bulk_set_float_field(tag, values_for_all_samples);
+  return *this;
+}
+
+VariantBuilder& VariantBuilder::set_float_individual_field(const uint32_t field_index, const VariantBuilderColumn<float>& values_for_all_samples) {
+  m_individual_region.bulk_set_float_field(field_index, values_for_all_samples);
+  return *this;
+}
+
+VariantBuilder& VariantBuilder::set_string_individual_field(const std::string& tag, const VariantBuilderStringColumn& values_for_all_samples) {
+  m_individual_region.bulk_set_string_field(tag, values_for_all_samples);
+  return *this;
+}
+
+VariantBuilder& VariantBuilder::set_string_individual_field(const uint32_t field_index, const VariantBuilderStringColumn& values_for_all_samples) {
+  m_individual_region.bulk_set_string_field(field_index, values_for_all_samples);
+  return *this;
+}
+
 /******************************************************************************
  *
  * Functions for setting individual/FORMAT fields by sample
@@ -503,7 +552,7 @@ VariantBuilderMultiSampleVector<float> VariantBuilder::get_float_multi_sample_ve
 
 /******************************************************************************
  *
- * Builder operations: build() and clear()
+ * Builder operations: build(), build_into() and clear()
  *
  ******************************************************************************/
 
@@ -520,6 +569,24 @@ Variant VariantBuilder::build() const {
   return Variant{m_header.m_header, new_variant_body};
 }
 
+void VariantBuilder::build_into(Variant& variant) const {
+  // a body that something else still refers to (a copy of the Variant's pointer or one of its fields) is left alone
+  if ( variant.m_body.use_count() != 1 ) {
+    variant.m_body = utils::make_shared_variant(bcf_init1());
+  }
+  else {
+    bcf_clear1(variant.m_body.get());   // keeps the capacity of the shared and individual buffers
+  }
+  variant.m_header = m_header;
+  variant.invalidate_field_slots();
+
+  build_from_scratch(variant.m_body);
+
+  if ( m_enable_validation ) {
+    post_build_validation(variant.m_body);
+  }
+}
+
 VariantBuilder& VariantBuilder::clear() {
   m_contig.clear();
   m_start_pos.clear();
@@ -556,23 +623,21 @@ void VariantBuilder::build_from_scratch(const std::shared_ptr<bcf1_t>& new_varia
                                                  int32_t(m_shared_region.ref_allele_length());
   new_variant_body->n_allele = 1 + m_shared_region.num_alt_alleles();
 
-  // Shared region (always encoded, since at a minimum the ref allele will be present)
+  // Shared region (always encoded, since at a minimum the ref allele will be present), straight into the body
   new_variant_body->n_info = m_shared_region.num_present_info_fields();
-  auto shared_buffer = utils::initialize_htslib_buffer(m_shared_region.estimate_total_size());
-  m_shared_region.encode_into(&shared_buffer);
-  new_variant_body->shared = shared_buffer;
+  utils::reserve_htslib_buffer(&new_variant_body->shared, m_shared_region.estimate_total_size());
+  m_shared_region.encode_into(&new_variant_body->shared);
 
   // Individual region (conditionally encoded)
   new_variant_body->n_sample = m_header.n_samples();
   new_variant_body->n_fmt = m_individual_region.num_present_fields();
 
   if ( m_individual_region.num_present_fields() > 0 ) {
-    auto indiv_buffer = utils::initialize_htslib_buffer(m_individual_region.estimate_total_size());
-    m_individual_region.encode_into(&indiv_buffer);
-    new_variant_body->indiv = indiv_buffer;
+    utils::reserve_htslib_buffer(&new_variant_body->indiv, m_individual_region.estimate_total_size());
+    m_individual_region.encode_into(&new_variant_body->indiv);
   }
   else {
-    new_variant_body->indiv = {0, 0, 0};
+    new_variant_body->indiv.l = 0;
   }
 }
 
@@ -5,6 +5,7 @@
 #include "variant_builder_shared_region.h"
 #include "variant_builder_individual_region.h"
 #include "variant_builder_multi_sample_vector.h"
+#include "variant_builder_column.h"
 #include "genotype.h"
 
 #include <vector>
@@ -205,6 +206,23 @@ class VariantBuilder {
    */
   VariantBuilder& set_enable_validation(const bool enable_validation);
 
+  static constexpr uint32_t default_min_parallel_encoding_size = 1u << 20;  ///< about three int fields of 100k samples
+
+  /**
+   * @brief Encode the individual fields of wide records on several threads
+   *
+   * Each individual field of a record is then encoded into its own buffer on a pool of threads started for the
+   * build, and the buffers are spliced in field order, so the records are byte for byte the same as when the fields
+   * are encoded serially. Starting the threads costs more than encoding a small record, so only records whose
+   * individual fields are estimated to take at least min_encoded_size bytes are encoded in parallel.
+   *
+   * @param n_threads number of threads encoding the fields (the calling thread is one of them), 1 (the default) encodes serially
+   * @param min_encoded_size estimated encoded size of the individual fields of a record from which they are encoded in parallel
+   *
+   * @note the unit of work is a whole field, so a record gets at most one thread per individual field it has
+   */
+  VariantBuilder& set_encoding_threads(const uint32_t n_threads, const uint32_t min_encoded_size = default_min_parallel_encoding_size);
+
 
   /******************************************************************************
    *
@@ -1020,6 +1038,80 @@ class VariantBuilder {
   VariantBuilder& set_string_individual_field(const uint32_t field_index, std::vector<std::string>&& values_for_all_samples);
 
 
+  /******************************************************************************
+   *
+   * Functions for setting individual/FORMAT fields in bulk from caller owned columns
+   * (see VariantBuilderColumn: only the pointers are kept until build time, and the
+   * values are encoded straight out of the caller's memory)
+   *
+   ******************************************************************************/
+
+  /**
+   * @brief Set the genotypes (GT) field for all samples at once from a column of allele indices
+   *
+   * @param genotypes_for_all_samples allele indices of all samples (-1 for missing alleles, padded with vector end values)
+   *
+   * @note The alleles are encoded at build time with the semantics of Genotype::encode_genotype(), which is when
+   *       invalid alleles are reported (by an invalid_argument exception)
+   * @note Does not support genotypes with phased alleles
+   */
+  VariantBuilder& set_genotypes(const VariantBuilderColumn<int32_t>& genotypes_for_all_samples);
+
+  /**
+   * @brief Set an integer individual field for all samples at once by name from a column
+   *
+   * @param tag name of the individual field to set
+   * @param values_for_all_samples field values for all samples (see VariantBuilderColumn)
+   *
+   * @note Less efficient than setting using the field index
+   */
+  VariantBuilder& set_integer_individual_field(const std::string& tag, const VariantBuilderColumn<int32_t>& values_for_all_samples);
+
+  /**
+   * @brief Set an integer individual field for all samples at once by index from a column
+   *
+   * @param field_index index of the individual field to set (from a header lookup)
+   * @param values_for_all_samples field values for all samples (see VariantBuilderColumn)
+   */
+  VariantBuilder& set_integer_individual_field(const uint32_t field_index, const VariantBuilderColumn<int32_t>& values_for_all_samples);
+
+  /**
+   * @brief Set a float individual field for all samples at once by name from a column
+   *
+   * @param tag name of the individual field to set
+   * @param values_for_all_samples field values for all samples (see VariantBuilderColumn)
+   *
+   * @note Less efficient than setting using the field index
+   */
+  VariantBuilder& set_float_individual_field(const std::string& tag, const VariantBuilderColumn<float>& values_for_all_samples);
+
+  /**
+   * @brief Set a float individual field for all samples at once by index from a column
+   *
+   * @param field_index index of the individual field to set (from a header lookup)
+   * @param values_for_all_samples field values for all samples (see VariantBuilderColumn)
+   */
+  VariantBuilder& set_float_individual_field(const uint32_t field_index, const VariantBuilderColumn<float>& values_for_all_samples);
+
+  /**
+   * @brief Set a string individual field for all samples at once by name from a flat buffer with offsets
+   *
+   * @param tag name of the individual field to set
+   * @param values_for_all_samples field values for all samples (see VariantBuilderStringColumn)
+   *
+   * @note Less efficient than setting using the field index
+   */
+  VariantBuilder& set_string_individual_field(const std::string& tag, const VariantBuilderStringColumn& values_for_all_samples);
+
+  /**
+   * @brief Set a string individual field for all samples at once by index from a flat buffer with offsets
+   *
+   * @param field_index index of the individual field to set (from a header lookup)
+   * @param values_for_all_samples field values for all samples (see VariantBuilderStringColumn)
+   */
+  VariantBuilder& set_string_individual_field(const uint32_t field_index, const VariantBuilderStringColumn& values_for_all_samples);
+
+
   /******************************************************************************
    *
    * Functions for setting individual/FORMAT fields by sample
@@ -1298,6 +1390,18 @@ class VariantBuilder {
    */
   Variant build() const;
 
+  /**
+   * @brief Build the current state of the builder into an existing Variant record, reusing its memory
+   *
+   * @param variant the record to overwrite. Its body (and the buffers of its encoded data) is reused if nothing
+   *        else refers to it, otherwise (or if the record is missing) a new body is allocated, so rebuilding the
+   *        same record in a loop stops allocating once it has grown to the widest record
+   *
+   * @note the record takes the header of this builder
+   * @note if the build fails validation the record is left with an invalid (but destructible) body
+   */
+  void build_into(Variant& variant) const;
+
   /**
    * @brief Clear all field values in this builder to prepare it for the next build operation
    *
@@ -1323,7 +1427,7 @@ class VariantBuilder {
   VariantBuilderIndividualRegion m_individual_region;
   bool m_enable_validation;
 
-  void build_from_scratch(const std::shared_ptr<bcf1_t>& new_variant_body) const;
+  void build_from_scratch(const std::shared_ptr<bcf1_t>& new_variant_body) const;  ///< @note the body must be new or cleared
   void post_build_validation(const std::shared_ptr<bcf1_t>& new_variant_body) const;
 };
 
@@ -0,0 +1,59 @@
+#ifndef gamgee__variant_builder_column__guard
+#define gamgee__variant_builder_column__guard
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gamgee {
+
+/**
+ * @brief A caller owned array with the values of an integer or float individual field for all samples, for the
+ *        columnar setters of VariantBuilder
+ *
+ * The values of sample i are the values_per_sample values starting at data + i * stride. The stride defaults to
+ * values_per_sample (a flat, sample major array), but a larger one lets the builder read a column straight out of
+ * a wider row-per-sample table. As in a VariantBuilderMultiSampleVector, samples with fewer values are padded with
+ * the end of vector value of the type and missing values use its missing value:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * // struct SampleCall { int32_t alleles[2]; int32_t gq; float af; };   std::vector<SampleCall> calls(n_samples);
+ * const auto stride = uint32_t(sizeof(SampleCall) / sizeof(int32_t));
+ * builder.set_genotypes(VariantBuilderColumn<int32_t>{calls[0].alleles, 2, stride})
+ *        .set_integer_individual_field(gq_index, VariantBuilderColumn<int32_t>{&calls[0].gq, 1, stride});
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * @warning the builder only keeps the pointer: the values must stay valid and unchanged until the record is built
+ */
+template<class VALUE_TYPE>
+struct VariantBuilderColumn {
+  const VALUE_TYPE* data;      ///< the first value of the first sample
+  uint32_t values_per_sample;  ///< values of each sample (0 removes the field)
+  uint32_t stride;             ///< distance between the first values of consecutive samples, in values
+
+  VariantBuilderColumn(const VALUE_TYPE* data, const uint32_t values_per_sample, const uint32_t stride = 0) :
+    data {data},
+    values_per_sample {values_per_sample},
+    stride {stride == 0 ? values_per_sample : stride}
+  {}
+
+  const VALUE_TYPE* sample_values(const uint32_t sample_index) const { return data + std::size_t{sample_index} * stride; }
+  bool contiguous() const { return stride == values_per_sample; }   ///< whether all the values form a single block
+};
+
+/**
+ * @brief A caller owned flat buffer with the values of a string individual field for all samples, for the columnar
+ *        setters of VariantBuilder
+ *
+ * The value of sample i is the characters from data + offsets[i] up to data + offsets[i + 1], so offsets has one
+ * entry per sample plus one. An empty value is missing.
+ *
+ * @warning the builder only keeps the pointers: the buffers must stay valid and unchanged until the record is built
+ */
+struct VariantBuilderStringColumn {
+  const char* data;
+  const uint32_t* offsets;
+};
+
+}
+
+#endif  /* gamgee__variant_builder_column__guard */
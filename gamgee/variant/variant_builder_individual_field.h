@@ -4,6 +4,8 @@
 #include "htslib/kstring.h"
 #include "htslib/vcf.h"
 
+#include "variant_builder_column.h"
+
 #include "../missing.h"
 #include "../utils/hts_memory.h"
 #include "../utils/short_value_optimized_storage.h"
@@ -11,6 +13,7 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <cstring>
 #include <stdexcept>
 
 namespace gamgee {
@@ -26,6 +29,11 @@ namespace gamgee {
  *  handle the setting of many small per-sample values without performing any extra dynamic memory
  *  allocation most of the time
  *
+ * -or in a caller owned column (VariantBuilderColumn or VariantBuilderStringColumn), of which only the pointers
+ *  are kept. Columns are encoded straight from the caller's memory into the final byte array, with the integer
+ *  width chosen by a min/max scan and GT allele indices encoded on the fly (the GT field is the only integer field
+ *  whose header type is BCF_HT_STR)
+ *
  * There cannot be both bulk and per-sample changes -- this is treated as an error, since it would be far
  * too expensive to reconcile the two.
  *
@@ -47,6 +55,8 @@ class VariantBuilderIndividualField {
     m_flattened_bulk_changes{},
     m_nested_bulk_changes{},
     m_per_sample_changes {num_samples, short_value_upper_bound},
+    m_column {nullptr, 0},
+    m_column_offsets {nullptr},
     m_removed { false }
   {}
 
@@ -63,6 +73,7 @@ class VariantBuilderIndividualField {
 
   void set_entire_field(std::vector<BULK_CHANGE_TYPE>&& bulk_changes) {
     m_flattened_bulk_changes = std::move(bulk_changes);
+    m_column.data = nullptr;
     if ( ! m_nested_bulk_changes.empty() ) m_nested_bulk_changes.clear();
     m_max_sample_value_length = max_sample_value_length(m_flattened_bulk_changes);
     m_removed = false;
@@ -70,6 +81,7 @@ class VariantBuilderIndividualField {
 
   void set_entire_field(const std::vector<BULK_CHANGE_TYPE>& bulk_changes) {
     m_flattened_bulk_changes = bulk_changes;
+    m_column.data = nullptr;
     if ( ! m_nested_bulk_changes.empty() ) m_nested_bulk_changes.clear();
     m_max_sample_value_length = max_sample_value_length(m_flattened_bulk_changes);
     m_removed = false;
@@ -77,17 +89,41 @@ class VariantBuilderIndividualField {
 
   void set_entire_field(std::vector<std::vector<BULK_CHANGE_TYPE>>&& bulk_changes) {
     m_nested_bulk_changes = std::move(bulk_changes);
+    m_column.data = nullptr;
     if ( ! m_flattened_bulk_changes.empty() ) m_flattened_bulk_changes.clear();
     m_max_sample_value_length = max_sample_value_length(m_nested_bulk_changes);
     m_removed = false;
   }
   void set_entire_field(const std::vector<std::vector<BULK_CHANGE_TYPE>>& bulk_changes) {
     m_nested_bulk_changes = bulk_changes;
+    m_column.data = nullptr;
     if ( ! m_flattened_bulk_changes.empty() ) m_flattened_bulk_changes.clear();
     m_max_sample_value_length = max_sample_value_length(m_nested_bulk_changes);
     m_removed = false;
   }
 
+  /**
+   * Columnar setters, keeping pointers to caller owned values (see VariantBuilderColumn)
+   */
+
+  void set_entire_field(const VariantBuilderColumn<ENCODED_TYPE>& column) {
+    clear_vector_bulk_changes();
+    m_column = column;
+    m_max_sample_value_length = column.values_per_sample;
+    m_removed = false;
+  }
+
+  void set_entire_field(const VariantBuilderStringColumn& column) {
+    clear_vector_bulk_changes();
+    m_column = VariantBuilderColumn<ENCODED_TYPE>{column.data, 0};
+    m_column_offsets = column.offsets;
+    m_max_sample_value_length = 0;
+    for ( auto i = 0u; i < m_num_samples; ++i ) {
+      m_max_sample_value_length = std::max(m_max_sample_value_length, column.offsets[i + 1] - column.offsets[i]);
+    }
+    m_removed = false;
+  }
+
   /**
    * @brief Stores a value for just a single sample efficiently using the ShortValueOptimizedStorage layer
    */
@@ -105,7 +141,8 @@ class VariantBuilderIndividualField {
   bool missing() const { return m_max_sample_value_length == 0u; }
   bool present() const { return ! missing() && ! removed(); }
 
-  bool has_bulk_changes() const { return ! m_flattened_bulk_changes.empty() || ! m_nested_bulk_changes.empty(); }
+  bool has_bulk_changes() const { return ! m_flattened_bulk_changes.empty() || ! m_nested_bulk_changes.empty() || has_column(); }
+  bool has_column() const { return m_column.data != nullptr; }
   bool has_per_sample_changes() const { return m_per_sample_changes.num_values() > 0; }
 
   /**
@@ -113,8 +150,8 @@ class VariantBuilderIndividualField {
    */
   void clear() {
     if ( has_bulk_changes() ) {
-      m_flattened_bulk_changes.clear();
-      m_nested_bulk_changes.clear();
+      clear_vector_bulk_changes();
+      m_column.data = nullptr;
     }
 
     if ( has_per_sample_changes() ) {
@@ -155,6 +192,9 @@ class VariantBuilderIndividualField {
     else if ( ! m_nested_bulk_changes.empty() ) {
       encode_into(destination, m_nested_bulk_changes);
     }
+    else if ( has_column() ) {
+      encode_into(destination, m_column);
+    }
     else if ( has_per_sample_changes() ) {
       encode_into(destination, m_per_sample_changes);
     }
@@ -173,6 +213,8 @@ class VariantBuilderIndividualField {
   std::vector<BULK_CHANGE_TYPE> m_flattened_bulk_changes;                ///< stores bulk changes to this field in the form of a flattened and pre-padded vector
   std::vector<std::vector<BULK_CHANGE_TYPE>> m_nested_bulk_changes;      ///< stores bulk changes to this field in the form of a nested vector, with each inner vector representing values for one sample
   utils::ShortValueOptimizedStorage<ENCODED_TYPE> m_per_sample_changes;  ///< stores per-sample changes to this field efficiently
+  VariantBuilderColumn<ENCODED_TYPE> m_column;                           ///< caller owned values of this field (data is null unless set by column)
+  const uint32_t* m_column_offsets;                                      ///< per sample offsets into m_column.data for string columns
   bool m_removed;                                                        ///< keeps track of whether the caller has explicitly requested that this field be removed
 
   /**
@@ -312,6 +354,132 @@ class VariantBuilderIndividualField {
     }
   }
 
+  void encode_into(kstring_t* destination, const VariantBuilderColumn<int32_t>& column) const {
+    const auto genotypes = m_field_type == BCF_HT_STR;  // GT is the only int field with a string type in the header
+    auto min_value = INT32_MAX;
+    auto max_value = INT32_MIN + 1;
+    if ( column.contiguous() ) {
+      scan_min_max_int_values(column.data, m_num_samples * column.values_per_sample, genotypes, min_value, max_value);
+    }
+    else {
+      for ( auto i = 0u; i < m_num_samples; ++i ) {
+        scan_min_max_int_values(column.sample_values(i), column.values_per_sample, genotypes, min_value, max_value);
+      }
+    }
+
+    if ( genotypes ) {
+      // Only legal value below -1 is the vector end value, which the scan skipped, as in Genotype::encode_genotype()
+      if ( min_value < -1 ) {
+        throw std::invalid_argument{"Genotype vector must consist only of allele indices, -1 for missing values, or vector end values"};
+      }
+      // allele indices are encoded as (allele + 1) << 1, which preserves their order
+      if ( min_value <= max_value ) {
+        min_value = (min_value + 1) << 1;
+        max_value = (max_value + 1) << 1;
+      }
+    }
+
+    const auto encoded_type = utils::int_encoded_type(min_value, max_value);
+    bcf_enc_int1(destination, m_field_index);
+    bcf_enc_size(destination, column.values_per_sample, encoded_type);
+    switch ( encoded_type ) {
+      case BCF_BT_INT8:
+        encode_int_column<int8_t>(destination, column, genotypes, bcf_int8_missing, bcf_int8_vector_end);
+        break;
+      case BCF_BT_INT16:
+        encode_int_column<int16_t>(destination, column, genotypes, bcf_int16_missing, bcf_int16_vector_end);
+        break;
+      case BCF_BT_INT32:
+        encode_int_column<int32_t>(destination, column, genotypes, bcf_int32_missing, bcf_int32_vector_end);
+        break;
+      default:
+        throw std::logic_error("Invalid target type in encode_into() for an int column");
+    }
+  }
+
+  void encode_into(kstring_t* destination, const VariantBuilderColumn<float>& column) const {
+    bcf_enc_int1(destination, m_field_index);
+    bcf_enc_size(destination, column.values_per_sample, BCF_BT_FLOAT);
+    if ( column.contiguous() ) {
+      kputsn(reinterpret_cast<const char*>(column.data), std::size_t{m_num_samples} * column.values_per_sample * sizeof(float), destination);
+      return;
+    }
+    for ( auto i = 0u; i < m_num_samples; ++i ) {
+      kputsn(reinterpret_cast<const char*>(column.sample_values(i)), column.values_per_sample * sizeof(float), destination);
+    }
+  }
+
+  void encode_into(kstring_t* destination, const VariantBuilderColumn<char>& column) const {
+    bcf_enc_int1(destination, m_field_index);
+    bcf_enc_size(destination, m_max_sample_value_length, BCF_BT_CHAR);
+    for ( auto i = 0u; i < m_num_samples; ++i ) {
+      encode_and_pad_sample_values(destination, column.data + m_column_offsets[i], m_column_offsets[i + 1] - m_column_offsets[i], m_max_sample_value_length);
+    }
+  }
+
+  /**
+   * @brief Writes the values of an int column as TARGET_TYPE straight into the (grown) destination buffer, with the
+   *        genotypes encoded on the way when writing GT
+   *
+   * Values are converted a chunk at a time on the stack (the destination offset isn't aligned for TARGET_TYPE), by
+   * loops free of branches and calls that the compiler can vectorize. A contiguous column is a single run of values.
+   */
+  template<class TARGET_TYPE>
+  void encode_int_column(kstring_t* destination, const VariantBuilderColumn<int32_t>& column, const bool genotypes,
+                         const TARGET_TYPE missing, const TARGET_TYPE vector_end) const {
+    constexpr auto chunk_size = 1024u;
+    const auto encoded_bytes = std::size_t{m_num_samples} * column.values_per_sample * sizeof(TARGET_TYPE);
+    if ( ks_resize(destination, destination->l + encoded_bytes) != 0 ) {
+      throw std::runtime_error{"Out of memory encoding an individual field column"};
+    }
+    const auto num_runs = column.contiguous() ? 1u : m_num_samples;
+    const auto run_length = column.contiguous() ? std::size_t{m_num_samples} * column.values_per_sample : std::size_t{column.values_per_sample};
+    TARGET_TYPE chunk[chunk_size];
+    auto chunk_length = 0u;
+    for ( auto run = 0u; run < num_runs; ++run ) {
+      const auto* values = column.sample_values(run);
+      for ( auto start = std::size_t{0}; start < run_length; ) {
+        const auto count = uint32_t(std::min<std::size_t>(run_length - start, chunk_size - chunk_length));
+        auto* encoded = chunk + chunk_length;
+        if ( genotypes ) {
+          for ( auto i = 0u; i < count; ++i ) {
+            const auto value = values[start + i];
+            encoded[i] = value == bcf_int32_vector_end ? vector_end : TARGET_TYPE((value + 1) << 1);
+          }
+        }
+        else {
+          for ( auto i = 0u; i < count; ++i ) {
+            const auto value = values[start + i];
+            encoded[i] = value == bcf_int32_vector_end ? vector_end : (value == bcf_int32_missing ? missing : TARGET_TYPE(value));
+          }
+        }
+        start += count;
+        chunk_length += count;
+        if ( chunk_length == chunk_size || (run + 1 == num_runs && start == run_length) ) {
+          memcpy(destination->s + destination->l, chunk, chunk_length * sizeof(TARGET_TYPE));
+          destination->l += chunk_length * sizeof(TARGET_TYPE);
+          chunk_length = 0;
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief A branch free variation on find_min_max_int_values() that the compiler can vectorize, for columns. Raw
+   *        genotypes only skip the vector end values, so that invalid negative alleles show up in the minimum.
+   */
+  void scan_min_max_int_values(const int32_t* values, const uint32_t num_values, const bool genotypes, int32_t& min, int32_t& max) const {
+    auto local_min = min;
+    auto local_max = max;
+    for ( auto i = 0u; i < num_values; ++i ) {
+      const auto skipped = values[i] == bcf_int32_vector_end || (values[i] == bcf_int32_missing && ! genotypes);
+      local_min = std::min(local_min, skipped ? INT32_MAX : values[i]);
+      local_max = std::max(local_max, skipped ? INT32_MIN + 1 : values[i]);
+    }
+    min = local_min;
+    max = local_max;
+  }
+
   /**
    * @brief Handles encoding and padding of per-sample values, with the exception of int8 and int16
    *        which are handled separately
@@ -432,6 +600,11 @@ class VariantBuilderIndividualField {
     });
   }
 
+  void clear_vector_bulk_changes() {
+    if ( ! m_flattened_bulk_changes.empty() ) m_flattened_bulk_changes.clear();
+    if ( ! m_nested_bulk_changes.empty() ) m_nested_bulk_changes.clear();
+  }
+
   /**
    * @brief The length of the longest sample value in a flat, non-string vector is simply the length divided
    *        by the number of samples
@@ -1,5 +1,11 @@
 #include "variant_builder_individual_region.h"
 
+#include "../utils/hts_memory.h"
+#include "../utils/parallel_utils.h"
+
+#include <cstring>
+#include <memory>
+
 using namespace std;
 
 namespace gamgee {
@@ -21,7 +27,9 @@ VariantBuilderIndividualRegion::VariantBuilderIndividualRegion(const VariantHead
     m_int_fields{},
     m_float_fields{},
     m_string_fields{},
-    m_enable_validation { enable_validation }
+    m_enable_validation { enable_validation },
+    m_encoding_threads { 1 },
+    m_min_parallel_encoding_size { 0 }
 {
   const auto num_indiv_fields = header.n_individual_fields();
   m_int_fields.reserve(num_indiv_fields);
@@ -97,33 +105,106 @@ uint32_t VariantBuilderIndividualRegion::estimate_total_size() const {
 }
 
 /**
- * @brief Encode all individual fields into the provided byte buffer in the proper order
- *        and format for final insertion into a Variant object.
+ * @brief Calls function(field) on every present individual field, in encoding order
  */
-void VariantBuilderIndividualRegion::encode_into(kstring_t* buffer) const {
+template<class FUNCTION>
+void VariantBuilderIndividualRegion::for_each_present_field(const FUNCTION& function) const {
   // Theoretically possible that GT is not declared at all in the header
   const auto gt_field_is_declared = ! missing(m_gt_field_index);
   const auto gt_physical_index = gt_field_is_declared ? m_field_lookup_table[m_gt_field_index] : missing_values::int32;
 
   // GT must be encoded first, as per the spec
   if ( gt_field_is_declared && m_int_fields[gt_physical_index].present() ) {
-    m_int_fields[gt_physical_index].encode_into(buffer);
+    function(make_pair(int32_t{BCF_HT_INT}, uint32_t(gt_physical_index)));
   }
 
   // TODO: order the remaining format fields in a more sensible (or at least customizable) way than by type,
   //       such as by global field index
   for ( auto i = 0u; i < m_int_fields.size(); ++i ) {
     if ( (int32_t(i) != gt_physical_index || ! gt_field_is_declared) && m_int_fields[i].present() ) {
-      m_int_fields[i].encode_into(buffer);
+      function(make_pair(int32_t{BCF_HT_INT}, i));
     }
   }
 
-  for ( auto& field : m_float_fields ) {
-    if ( field.present() ) field.encode_into(buffer);
+  for ( auto i = 0u; i < m_float_fields.size(); ++i ) {
+    if ( m_float_fields[i].present() ) function(make_pair(int32_t{BCF_HT_REAL}, i));
   }
 
-  for ( auto& field : m_string_fields ) {
-    if ( field.present() ) field.encode_into(buffer);
+  for ( auto i = 0u; i < m_string_fields.size(); ++i ) {
+    if ( m_string_fields[i].present() ) function(make_pair(int32_t{BCF_HT_STR}, i));
+  }
+}
+
+/**
+ * @brief Encode all individual fields into the provided byte buffer in the proper order
+ *        and format for final insertion into a Variant object.
+ */
+void VariantBuilderIndividualRegion::encode_into(kstring_t* buffer) const {
+  if ( m_encoding_threads > 1 && m_num_present_fields > 1 && estimate_total_size() >= m_min_parallel_encoding_size ) {
+    encode_in_parallel(buffer);
+    return;
+  }
+  for_each_present_field([buffer, this] (const pair<int32_t, uint32_t>& field) { encode_field(field, buffer); });
+}
+
+/**
+ * @brief Encode every present field into its own buffer (sized from its size estimate) on the encoding threads, then
+ *        append the buffers to the provided one in encoding order
+ */
+void VariantBuilderIndividualRegion::encode_in_parallel(kstring_t* buffer) const {
+  // local to the build (rather than reused members) so that concurrent builds don't share them: this path only runs
+  // for records large enough that a few allocations per field don't show next to the encoding
+  auto encoding_order = vector<pair<int32_t, uint32_t>>{};
+  encoding_order.reserve(m_num_present_fields);
+  for_each_present_field([&encoding_order] (const pair<int32_t, uint32_t>& field) { encoding_order.push_back(field); });
+  const auto num_fields = uint32_t(encoding_order.size());
+  auto field_buffers = vector<unique_ptr<kstring_t, utils::KStringDeleter>>{};
+  field_buffers.reserve(num_fields);
+  for ( auto i = 0u; i < num_fields; ++i ) {
+    field_buffers.push_back(utils::make_unique_kstring());
+  }
+
+  utils::for_each_index(num_fields, m_encoding_threads, [this, &encoding_order, &field_buffers] (const uint32_t i) {
+    auto* field_buffer = field_buffers[i].get();
+    utils::reserve_htslib_buffer(field_buffer, estimated_encoded_size(encoding_order[i]));
+    encode_field(encoding_order[i], field_buffer);
+  });
+
+  auto encoded_size = buffer->l;
+  for ( auto i = 0u; i < num_fields; ++i ) {
+    encoded_size += field_buffers[i]->l;
+  }
+  if ( ks_resize(buffer, encoded_size) != 0 ) {
+    throw runtime_error{"Out of memory splicing the encoded individual fields"};
+  }
+  for ( auto i = 0u; i < num_fields; ++i ) {
+    memcpy(buffer->s + buffer->l, field_buffers[i]->s, field_buffers[i]->l);
+    buffer->l += field_buffers[i]->l;
+  }
+}
+
+void VariantBuilderIndividualRegion::encode_field(const pair<int32_t, uint32_t>& field, kstring_t* buffer) const {
+  switch ( field.first ) {
+    case BCF_HT_INT:
+      m_int_fields[field.second].encode_into(buffer);
+      break;
+    case BCF_HT_REAL:
+      m_float_fields[field.second].encode_into(buffer);
+      break;
+    default:
+      m_string_fields[field.second].encode_into(buffer);
+      break;
+  }
+}
+
+uint32_t VariantBuilderIndividualRegion::estimated_encoded_size(const pair<int32_t, uint32_t>& field) const {
+  switch ( field.first ) {
+    case BCF_HT_INT:
+      return m_int_fields[field.second].estimated_encoded_size();
+    case BCF_HT_REAL:
+      return m_float_fields[field.second].estimated_encoded_size();
+    default:
+      return m_string_fields[field.second].estimated_encoded_size();
   }
 }
 
@@ -7,6 +7,8 @@
 #include "htslib/kstring.h"
 #include "htslib/vcf.h"
 
+#include <algorithm>
+#include <utility>
 #include <vector>
 #include <string>
 #include <stdexcept>
@@ -19,6 +21,11 @@ namespace gamgee {
  * The individual region includes the various kinds of FORMAT fields.
  * This class manages the validation and bookkeeping, but not the encoding and storage, of these fields. The
  * storage/encoding for each field is handled by the lower-level VariantBuilderIndividualField class.
+ *
+ * With several encoding threads, the fields of wide records are encoded on a pool of threads started for the build,
+ * each into its own buffer, and the buffers are then spliced in field order, so that the result is the same as when the
+ * fields are encoded one after the other into the destination. The buffers belong to the build, not to the region, so
+ * building stays const and safe to call from several threads on the same builder.
  */
 class VariantBuilderIndividualRegion {
  public:
@@ -31,6 +38,10 @@ class VariantBuilderIndividualRegion {
   ~VariantBuilderIndividualRegion() = default;
 
   void set_enable_validation(const bool enable_validation) { m_enable_validation = enable_validation; }
+  void set_encoding_threads(const uint32_t n_threads, const uint32_t min_parallel_encoding_size) {
+    m_encoding_threads = std::max(n_threads, 1u);
+    m_min_parallel_encoding_size = min_parallel_encoding_size;
+  }
 
   int32_t gt_index() const { return m_gt_field_index; }
   uint32_t num_present_fields() const { return m_num_present_fields; }
@@ -102,6 +113,8 @@ class VariantBuilderIndividualRegion {
   std::vector<VariantBuilderIndividualField<float, float>> m_float_fields;        ///< float fields, indexed using m_field_lookup_table
   std::vector<VariantBuilderIndividualField<char, std::string>> m_string_fields;  ///< string fields, indexed using m_field_lookup_table
   bool m_enable_validation;                                                       ///< should we validate?
+  uint32_t m_encoding_threads;                                                    ///< number of threads encoding the fields (1 encodes serially)
+  uint32_t m_min_parallel_encoding_size;                                          ///< estimated encoded size under which the fields are encoded serially anyway
 
   /**
    * Definitions of the size of a "short value" for each type -- used by the VariantBuilderIndividualField class
@@ -114,6 +127,12 @@ class VariantBuilderIndividualRegion {
   static const uint32_t string_field_short_value_threshold;
 
   void build_lookup_tables();
+  void encode_in_parallel(kstring_t* buffer) const;
+  void encode_field(const std::pair<int32_t, uint32_t>& field, kstring_t* buffer) const;
+  uint32_t estimated_encoded_size(const std::pair<int32_t, uint32_t>& field) const;
+
+  template<class FUNCTION>
+  void for_each_present_field(const FUNCTION& function) const;
 
   template<class FIELD_ID_TYPE, class BULK_FIELD_VALUES_TYPE, class FIELD_TYPE>
   void bulk_set_field(const FIELD_ID_TYPE& field_id, BULK_FIELD_VALUES_TYPE&& field_values, const int32_t provided_type, std::vector<FIELD_TYPE>& fields_of_type, const bool allow_gt = false) {
@@ -198,6 +217,25 @@ class VariantBuilderIndividualRegion {
     }
   }
 
+  template<class ELEMENT_TYPE>
+  void validate_multi_sample_vector_length(const VariantBuilderColumn<ELEMENT_TYPE>& column) const {
+    // A column has a value for every sample by construction: only its layout can be wrong
+    if ( column.values_per_sample > 0 && (column.data == nullptr || column.stride < column.values_per_sample) ) {
+      throw std::invalid_argument(std::string{"Invalid column for individual field: null data or stride ("} + std::to_string(column.stride) + ") smaller than the number of values per sample (" + std::to_string(column.values_per_sample) + ")");
+    }
+  }
+
+  void validate_multi_sample_vector_length(const VariantBuilderStringColumn& column) const {
+    if ( column.offsets == nullptr || (column.data == nullptr && column.offsets[m_header.n_samples()] != column.offsets[0]) ) {
+      throw std::invalid_argument(std::string{"Invalid string column for individual field: null offsets, or null data with non-empty values"});
+    }
+    for ( auto i = 0u; i < m_header.n_samples(); ++i ) {
+      if ( column.offsets[i + 1] < column.offsets[i] ) {
+        throw std::invalid_argument(std::string{"Decreasing offsets in string column for individual field at sample "} + std::to_string(i));
+      }
+    }
+  }
+
   void update_present_field_count(const bool field_was_already_present, const bool field_currently_present) {
     if ( ! field_was_already_present && field_currently_present ) {
       ++m_num_present_fields;
@@ -51,15 +51,13 @@ class VariantBuilderMultiSampleVector {
    * @note: DO NOT INSTANTIATE THIS CLASS DIRECTLY! ALWAYS GET AN INSTANCE FROM A VARIANTBUILDER OBJECT
    */
   VariantBuilderMultiSampleVector(const uint32_t num_samples, const uint32_t max_values_per_sample, const ELEMENT_TYPE missing_value, const ELEMENT_TYPE end_of_vector_value) :
-    m_multi_sample_values(num_samples * max_values_per_sample, end_of_vector_value),  // Fill with end_of_vector_value
-    m_num_samples{num_samples},
-    m_max_values_per_sample{max_values_per_sample}
+    m_multi_sample_values{},
+    m_num_samples{0},
+    m_max_values_per_sample{0},
+    m_missing_value{missing_value},
+    m_end_of_vector_value{end_of_vector_value}
   {
-    // Place a single missing value at the start of each sample's values (the rest of the vector has already
-    // been padded with vector end values)
-    for ( auto sample_start = 0u; sample_start < m_multi_sample_values.size(); sample_start += m_max_values_per_sample ) {
-      m_multi_sample_values[sample_start] = missing_value;
-    }
+    reset(num_samples, max_values_per_sample);
   }
 
   // Both copyable and moveable, with default destruction
@@ -111,6 +109,27 @@ class VariantBuilderMultiSampleVector {
     }
   }
 
+  /**
+   * @brief Set all samples back to a missing value, possibly changing the number of samples and the field width
+   *
+   * @param num_samples number of samples we will be storing in this vector
+   * @param max_values_per_sample maximum number of values across all samples
+   *
+   * @note Reuses the storage of the vector, so a vector that is reset for every record (instead of getting a new
+   *       one from the builder) stops allocating once it has grown to the widest record.
+   */
+  inline void reset(const uint32_t num_samples, const uint32_t max_values_per_sample) {
+    m_num_samples = num_samples;
+    m_max_values_per_sample = max_values_per_sample;
+    m_multi_sample_values.assign(num_samples * max_values_per_sample, m_end_of_vector_value);  // Fill with end_of_vector_value
+
+    // Place a single missing value at the start of each sample's values (the rest of the vector has already
+    // been padded with vector end values)
+    for ( auto sample_start = 0u; sample_start < m_multi_sample_values.size(); sample_start += m_max_values_per_sample ) {
+      m_multi_sample_values[sample_start] = m_missing_value;
+    }
+  }
+
   /**
    * @brief Get a reference to the internal one-dimensional vector used for value storage
    */
@@ -130,6 +149,8 @@ class VariantBuilderMultiSampleVector {
   std::vector<ELEMENT_TYPE> m_multi_sample_values;
   uint32_t m_num_samples;
   uint32_t m_max_values_per_sample;
+  ELEMENT_TYPE m_missing_value;
+  ELEMENT_TYPE m_end_of_vector_value;
 
   friend class VariantBuilder; // VariantBuilder needs access to internals in order to build efficiently
 };
@@ -0,0 +1,161 @@
+#include "variant_decoding_pool.h"
+
+#include "../utils/hts_memory.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace gamgee {
+
+constexpr uint32_t VariantDecodingPool::default_queue_capacity;
+
+VariantDecodingPool::VariantDecodingPool(const std::vector<std::shared_ptr<htsFile>>& variant_files, const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers,
+                                         const VariantUnpackLevel unpack_level, const uint32_t n_threads, const uint32_t queue_capacity) :
+  m_queues {},
+  m_workers {},
+  m_unpack_level {unpack_level}
+{
+  m_queues.reserve(variant_files.size());
+  for (auto i = 0u; i < variant_files.size(); ++i) {
+    m_queues.push_back(std::make_unique<Queue>());
+    auto& queue = *m_queues.back();
+    queue.file = variant_files[i];
+    queue.header = variant_headers[i];
+    queue.slots.resize(std::max(queue_capacity, 1u));
+    for (auto& slot : queue.slots)
+      slot = utils::make_shared_variant(bcf_init1());
+  }
+  const auto n_workers = std::min(std::max(n_threads, 1u), uint32_t(m_queues.size()));
+  for (auto worker = 0u; worker < n_workers; ++worker)
+    m_workers.push_back(std::make_unique<Worker>());
+  // all the workers must exist before any of them runs (they find their queues through m_workers.size())
+  try {
+    for (auto worker = 0u; worker < n_workers; ++worker)
+      m_workers[worker]->thread = std::thread{[this, worker]() { run_worker(worker); }};
+  }
+  catch (...) {   // couldn't start a thread: the destructor won't run, so stop the ones already running
+    stop();
+    throw;
+  }
+}
+
+VariantDecodingPool::~VariantDecodingPool() {
+  stop();
+}
+
+void VariantDecodingPool::stop() {
+  m_cancelled.store(true, std::memory_order_seq_cst);
+  for (auto& worker : m_workers) {
+    {
+      std::lock_guard<std::mutex> lock {worker->mutex};
+      worker->condition.notify_all();
+    }
+    if (worker->thread.joinable())
+      worker->thread.join();
+  }
+}
+
+bool VariantDecodingPool::next(const uint32_t input, std::shared_ptr<bcf1_t>& record) {
+  auto& queue = *m_queues[input];
+  const auto head = queue.head.load(std::memory_order_relaxed);
+  const auto ready = [&queue, head]() { return head < queue.tail.load() || queue.finished.load(); };
+  if (!ready()) {
+    for (auto spin = 0u; spin < 64 && !ready(); ++spin)
+      std::this_thread::yield();
+    std::unique_lock<std::mutex> lock {m_consumer_mutex};
+    m_consumer_parked.store(true, std::memory_order_seq_cst);   // must be visible before the condition is checked again (see wake_consumer)
+    m_consumer_condition.wait(lock, ready);
+    m_consumer_parked.store(false, std::memory_order_relaxed);
+  }
+  if (head < queue.tail.load()) {   // records published before finishing are always served first
+    std::swap(record, queue.slots[head % queue.slots.size()]);
+    queue.head.store(head + 1, std::memory_order_seq_cst);
+    wake_worker(input);
+    return true;
+  }
+  if (queue.error)
+    std::rethrow_exception(queue.error);
+  return false;
+}
+
+void VariantDecodingPool::run_worker(const uint32_t worker) {
+  const auto n_workers = uint32_t(m_workers.size());
+  auto& self = *m_workers[worker];
+  while (!m_cancelled.load()) {
+    auto active = false;
+    auto progress = false;
+    for (auto input = worker; input < m_queues.size(); input += n_workers) {
+      auto& queue = *m_queues[input];
+      if (queue.finished.load(std::memory_order_relaxed))   // only this worker ever sets it
+        continue;
+      active = true;
+      progress |= fill(queue);
+    }
+    if (!active)
+      return;
+    if (!progress) {   // all the queues are full: wait for the consumer to take something
+      std::unique_lock<std::mutex> lock {self.mutex};
+      self.parked.store(true, std::memory_order_seq_cst);
+      self.condition.wait(lock, [this, worker]() { return has_work(worker) || m_cancelled.load(); });
+      self.parked.store(false, std::memory_order_relaxed);
+    }
+  }
+}
+
+bool VariantDecodingPool::fill(Queue& queue) {
+  auto filled = false;
+  try {
+    auto tail = queue.tail.load(std::memory_order_relaxed);
+    while (tail - queue.head.load() < queue.slots.size() && !m_cancelled.load(std::memory_order_relaxed)) {
+      auto* record = queue.slots[tail % queue.slots.size()].get();
+      if (m_unpack_level != VariantUnpackLevel::ALL)
+        record->max_unpack = BCF_UN_SHR;   // stops the VCF parser before the per sample columns (the BCF reader ignores it)
+      if (bcf_read1(queue.file.get(), queue.header.get(), record) < 0) {
+        queue.finished.store(true, std::memory_order_seq_cst);
+        wake_consumer();
+        return true;
+      }
+      unpack_variant_record(record, queue.header.get(), m_unpack_level);
+      queue.tail.store(++tail, std::memory_order_seq_cst);
+      wake_consumer();
+      filled = true;
+    }
+  }
+  catch (...) {
+    queue.error = std::current_exception();   // published by the store to finished
+    queue.finished.store(true, std::memory_order_seq_cst);
+    wake_consumer();
+    filled = true;
+  }
+  return filled;
+}
+
+bool VariantDecodingPool::has_work(const uint32_t worker) const {
+  for (auto input = worker; input < m_queues.size(); input += m_workers.size()) {
+    const auto& queue = *m_queues[input];
+    if (!queue.finished.load() && queue.tail.load() - queue.head.load() < queue.slots.size())
+      return true;
+  }
+  return false;
+}
+
+// the state change that satisfies the other side's condition is always stored (sequentially consistent) before
+// the parked flag is read, and the parked flag is stored before the other side re-checks its condition, so at
+// least one of the two sides sees the other and no wake up is ever lost
+
+void VariantDecodingPool::wake_consumer() {
+  if (m_consumer_parked.load(std::memory_order_seq_cst)) {
+    std::lock_guard<std::mutex> lock {m_consumer_mutex};
+    m_consumer_condition.notify_all();
+  }
+}
+
+void VariantDecodingPool::wake_worker(const uint32_t input) {
+  auto& worker = *m_workers[input % m_workers.size()];
+  if (worker.parked.load(std::memory_order_seq_cst)) {
+    std::lock_guard<std::mutex> lock {worker.mutex};
+    worker.condition.notify_all();
+  }
+}
+
+}
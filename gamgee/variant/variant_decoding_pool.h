@@ -0,0 +1,106 @@
+#ifndef gamgee__variant_decoding_pool__guard
+#define gamgee__variant_decoding_pool__guard
+
+#include "../utils/variant_utils.h"
+
+#include "htslib/vcf.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gamgee {
+
+/**
+ * @brief reads and decodes many variant files on a pool of worker threads, one bounded queue of records per file
+ *
+ * Every worker owns a share of the files (file i goes to worker i % n_threads) and keeps reading records into
+ * the free slots of their queues. A single consumer (e.g. the merge of a MultipleVariantIterator) takes the
+ * records out file by file with next(), giving back a record to be read into in exchange, so the records are
+ * pooled: after the queues fill up for the first time nothing is allocated any more.
+ *
+ * Each queue is a single producer, single consumer ring: the indices only grow and a thread blocks only when
+ * there is nothing for it to do (all its queues full, or the queue it's waiting on empty).
+ *
+ * @note the files must not be read by anyone else while the pool is alive
+ */
+class VariantDecodingPool {
+ public:
+  static constexpr uint32_t default_queue_capacity = 8;  ///< records read ahead of the consumer for every file by default
+
+  /**
+   * @brief starts reading the files
+   *
+   * @param variant_files   vcf/bcf files opened via the bcf_open() macro from htslib (headers already read)
+   * @param variant_headers the headers of the files
+   * @param unpack_level    how much of each record to decode (see VariantUnpackLevel)
+   * @param n_threads       number of worker threads (at most one per file is used)
+   * @param queue_capacity  maximum number of records decoded ahead of the consumer for every file
+   */
+  VariantDecodingPool(const std::vector<std::shared_ptr<htsFile>>& variant_files, const std::vector<std::shared_ptr<bcf_hdr_t>>& variant_headers,
+                      const VariantUnpackLevel unpack_level, const uint32_t n_threads, const uint32_t queue_capacity = default_queue_capacity);
+
+  /**
+   * @brief stops and joins the workers
+   */
+  ~VariantDecodingPool();
+
+  VariantDecodingPool(const VariantDecodingPool&) = delete;
+  VariantDecodingPool& operator=(const VariantDecodingPool&) = delete;
+  VariantDecodingPool(VariantDecodingPool&&) = delete;
+  VariantDecodingPool& operator=(VariantDecodingPool&&) = delete;
+
+  /**
+   * @brief waits for the next record of a file and exchanges it with a record the consumer is done with
+   *
+   * @param input the index of the file
+   * @param record a record nothing else refers to, replaced by the next record of the file
+   * @return false at the end of the file (record is left untouched)
+   * @throws whatever exception stopped the worker reading the file, once all the records read before it have been taken
+   */
+  bool next(const uint32_t input, std::shared_ptr<bcf1_t>& record);
+
+  uint32_t n_threads() const { return uint32_t(m_workers.size()); } ///< @brief number of worker threads
+
+ private:
+  struct Queue {
+    std::shared_ptr<htsFile> file;
+    std::shared_ptr<bcf_hdr_t> header;
+    std::vector<std::shared_ptr<bcf1_t>> slots;  ///< the pooled records (never reallocated)
+    std::atomic<uint64_t> head {0};               ///< number of records taken by the consumer
+    std::atomic<uint64_t> tail {0};               ///< number of records published by the worker
+    std::atomic<bool> finished {false};           ///< the worker has published the last record of the file
+    std::exception_ptr error {};                  ///< the exception that stopped the worker, published by finished
+  };
+
+  struct Worker {
+    std::thread thread {};
+    std::atomic<bool> parked {false};             ///< the worker is (about to be) blocked on its condition variable
+    std::mutex mutex {};
+    std::condition_variable condition {};
+  };
+
+  std::vector<std::unique_ptr<Queue>> m_queues;   ///< one per file
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  VariantUnpackLevel m_unpack_level;
+  std::atomic<bool> m_cancelled {false};          ///< the pool is going away
+  std::atomic<bool> m_consumer_parked {false};    ///< the consumer is (about to be) blocked on its condition variable
+  std::mutex m_consumer_mutex {};
+  std::condition_variable m_consumer_condition {};
+
+  void stop();                                    ///< cancels and joins the workers
+  void run_worker(const uint32_t worker);
+  bool fill(Queue& queue);                        ///< reads records into the free slots of a queue, returns whether it read any
+  bool has_work(const uint32_t worker) const;     ///< whether a queue of the worker is neither finished nor full
+  void wake_consumer();
+  void wake_worker(const uint32_t input);
+};
+
+}
+
+#endif // gamgee__variant_decoding_pool__guard
@@ -1,12 +1,70 @@
 #include "variant_header_merger.h"
 
+#include "../exceptions.h"
+#include "../missing.h"
 #include "../utils/variant_utils.h"
 #include "../utils/hts_memory.h"
+#include "../utils/parallel_utils.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unordered_set>
 
 using namespace std;
 
 namespace gamgee
 {
+  namespace
+  {
+    const auto cache_magic = string{"gamgee header merger cache 2\n"};
+
+    bool same_text(const char* lhs, const char* rhs)
+    {
+      return lhs == rhs || (lhs && rhs && strcmp(lhs, rhs) == 0);
+    }
+
+    //the same lines, in the same order, give the same field and chromosome dictionaries
+    bool same_header_lines(const bcf_hdr_t* lhs, const bcf_hdr_t* rhs)
+    {
+      if(lhs->nhrec != rhs->nhrec)
+        return false;
+      for(auto i=0;i<lhs->nhrec;++i)
+      {
+        auto lhs_hrec = lhs->hrec[i];
+        auto rhs_hrec = rhs->hrec[i];
+        if(lhs_hrec->type != rhs_hrec->type || lhs_hrec->nkeys != rhs_hrec->nkeys
+            || !same_text(lhs_hrec->key, rhs_hrec->key) || !same_text(lhs_hrec->value, rhs_hrec->value))
+          return false;
+        for(auto j=0;j<lhs_hrec->nkeys;++j)
+          if(!same_text(lhs_hrec->keys[j], rhs_hrec->keys[j]) || !same_text(lhs_hrec->vals[j], rhs_hrec->vals[j]))
+            return false;
+      }
+      //the field mappings are copied by index, so the dictionaries must match too (e.g. IDX keys of BCF headers)
+      for(auto dict_type : { BCF_DT_ID, BCF_DT_CTG })
+      {
+        if(lhs->n[dict_type] != rhs->n[dict_type])
+          return false;
+        for(auto j=0;j<lhs->n[dict_type];++j)
+          if(!same_text(lhs->id[dict_type][j].key, rhs->id[dict_type][j].key))
+            return false;
+      }
+      return true;
+    }
+
+    template<class VALUE>
+    void write_value(ofstream& file, const VALUE value)
+    {
+      file.write(reinterpret_cast<const char*>(&value), sizeof(VALUE));
+    }
+
+    template<class VALUE>
+    bool read_value(ifstream& file, VALUE& value)
+    {
+      return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(VALUE)));
+    }
+  }
+
   //VariantHeaderMerger functions
   template<bool fields_forward_LUT_ordering, bool fields_reverse_LUT_ordering, bool samples_forward_LUT_ordering, bool samples_reverse_LUT_ordering>
   void 
@@ -44,12 +102,10 @@ namespace gamgee
     {
       if(curr_header->samples[j] && bcf_hdr_id2int(curr_header, BCF_DT_SAMPLE, curr_header->samples[j]) >= 0)
       {
-        if(m_sample2idx_merged.find(curr_header->samples[j]) == m_sample2idx_merged.end())
-        {
-          auto curr_size = m_sample2idx_merged.size();
-          m_sample2idx_merged[curr_header->samples[j]] = curr_size;
-        }
-        m_samples_LUT.add_input_merged_idx_pair(input_vcf_idx, j, m_sample2idx_merged[curr_header->samples[j]]);
+        //the merged header has every sample once, where it first appeared (read only, so safe from many threads)
+        auto merged_idx = bcf_hdr_id2int(m_merged_vcf_header_ptr.get(), BCF_DT_SAMPLE, curr_header->samples[j]);
+        assert(merged_idx >= 0 && merged_idx < bcf_hdr_nsamples(m_merged_vcf_header_ptr));
+        m_samples_LUT.add_input_merged_idx_pair(input_vcf_idx, j, merged_idx);
       }
       else
         m_samples_LUT.reset_merged_idx_for_input(input_vcf_idx, j);
@@ -59,19 +115,67 @@ namespace gamgee
   template<bool fields_forward_LUT_ordering, bool fields_reverse_LUT_ordering, bool samples_forward_LUT_ordering, bool samples_reverse_LUT_ordering>
   void 
   VariantHeaderMerger<fields_forward_LUT_ordering, fields_reverse_LUT_ordering, samples_forward_LUT_ordering, samples_reverse_LUT_ordering>::
-  add_header(const shared_ptr<bcf_hdr_t>& header_ptr)
+  copy_header_fields_mapping(unsigned source_vcf_idx, unsigned input_vcf_idx)
+  {
+    auto curr_header = m_input_vcf_headers[input_vcf_idx].get();
+    for(auto j=0;j<curr_header->n[BCF_DT_ID];++j)
+    {
+      auto merged_idx = m_header_fields_LUT.get_merged_idx_for_input(source_vcf_idx, j);
+      if(!missing(merged_idx))
+        m_header_fields_LUT.add_input_merged_idx_pair(input_vcf_idx, j, merged_idx);
+    }
+  }
+
+  template<bool fields_forward_LUT_ordering, bool fields_reverse_LUT_ordering, bool samples_forward_LUT_ordering, bool samples_reverse_LUT_ordering>
+  int
+  VariantHeaderMerger<fields_forward_LUT_ordering, fields_reverse_LUT_ordering, samples_forward_LUT_ordering, samples_reverse_LUT_ordering>::
+  find_input_with_same_lines(const bcf_hdr_t* curr_header, uint64_t lines_fingerprint) const
+  {
+    auto iter = m_fingerprint2input.find(lines_fingerprint);
+    if(iter == m_fingerprint2input.end())
+      return -1;
+    //guards against hash collisions
+    return same_header_lines(curr_header, m_input_vcf_headers[iter->second].get()) ? static_cast<int>(iter->second) : -1;
+  }
+
+  template<bool fields_forward_LUT_ordering, bool fields_reverse_LUT_ordering, bool samples_forward_LUT_ordering, bool samples_reverse_LUT_ordering>
+  void
+  VariantHeaderMerger<fields_forward_LUT_ordering, fields_reverse_LUT_ordering, samples_forward_LUT_ordering, samples_reverse_LUT_ordering>::
+  merge_header(const shared_ptr<bcf_hdr_t>& header_ptr)
   {
     if(m_merged_vcf_header_ptr)
       merge_variant_headers(m_merged_vcf_header_ptr, header_ptr);
     else
       m_merged_vcf_header_ptr = utils::make_shared_variant_header(utils::variant_header_deep_copy(header_ptr.get()));
-    auto header_raw_ptr = header_ptr.get();
     assert(m_merged_vcf_header_ptr);
+  }
+
+  template<bool fields_forward_LUT_ordering, bool fields_reverse_LUT_ordering, bool samples_forward_LUT_ordering, bool samples_reverse_LUT_ordering>
+  void 
+  VariantHeaderMerger<fields_forward_LUT_ordering, fields_reverse_LUT_ordering, samples_forward_LUT_ordering, samples_reverse_LUT_ordering>::
+  add_header(const shared_ptr<bcf_hdr_t>& header_ptr)
+  {
+    auto lines_fingerprint = variant_header_lines_fingerprint(header_ptr.get());
+    auto source_vcf_idx = find_input_with_same_lines(header_ptr.get(), lines_fingerprint);
+    if(source_vcf_idx < 0)
+      merge_header(header_ptr);
+    else        //the same lines have nothing to add to the merged header, the samples may
+    {
+      add_variant_header_samples(m_merged_vcf_header_ptr.get(), header_ptr.get());
+      bcf_hdr_sync(m_merged_vcf_header_ptr.get());
+    }
+    auto header_raw_ptr = header_ptr.get();
     m_input_vcf_headers.push_back(header_ptr);
     resize_luts_if_needed();
 
     unsigned input_vcf_idx = m_input_vcf_headers.size()-1;
-    add_header_fields_mapping(header_raw_ptr, input_vcf_idx);
+    if(source_vcf_idx >= 0)
+      copy_header_fields_mapping(source_vcf_idx, input_vcf_idx);
+    else
+    {
+      m_fingerprint2input.emplace(lines_fingerprint, input_vcf_idx);
+      add_header_fields_mapping(header_raw_ptr, input_vcf_idx);
+    }
     add_samples_mapping(header_raw_ptr, input_vcf_idx);
   }
 
@@ -86,10 +190,44 @@ namespace gamgee
   template<bool fields_forward_LUT_ordering, bool fields_reverse_LUT_ordering, bool samples_forward_LUT_ordering, bool samples_reverse_LUT_ordering>
   void 
   VariantHeaderMerger<fields_forward_LUT_ordering, fields_reverse_LUT_ordering, samples_forward_LUT_ordering, samples_reverse_LUT_ordering>::
-  add_headers(const vector<shared_ptr<bcf_hdr_t>>& headers)
+  add_headers(const vector<shared_ptr<bcf_hdr_t>>& headers, const unsigned n_threads)
   {
-    for(const auto& header : headers)
-      add_header(header);
+    auto first_vcf_idx = static_cast<unsigned>(m_input_vcf_headers.size());
+    auto lines_fingerprints = vector<uint64_t>(headers.size());
+    utils::for_each_index(headers.size(), n_threads, [&](const size_t i) { lines_fingerprints[i] = variant_header_lines_fingerprint(headers[i].get()); });
+    //merging is sequential (the merged header is shared), the lines of each distinct header are merged once
+    auto source_vcf_idxs = vector<int>(headers.size());
+    auto samples_added = false;
+    for(auto i=0u;i<headers.size();++i)
+    {
+      source_vcf_idxs[i] = find_input_with_same_lines(headers[i].get(), lines_fingerprints[i]);
+      if(source_vcf_idxs[i] < 0)
+      {
+        merge_header(headers[i]);
+        m_fingerprint2input.emplace(lines_fingerprints[i], first_vcf_idx+i);
+      }
+      else
+      {
+        add_variant_header_samples(m_merged_vcf_header_ptr.get(), headers[i].get());
+        samples_added = true;
+      }
+      m_input_vcf_headers.push_back(headers[i]);
+    }
+    if(headers.empty())
+      return;
+    if(samples_added)   //one sync for all the samples of the headers that weren't merged
+      bcf_hdr_sync(m_merged_vcf_header_ptr.get());
+    resize_luts_if_needed();
+    //every input has its own cells in the LUTs, and the merged header is only read from now on
+    utils::for_each_index(headers.size(), n_threads, [&](const size_t i) {
+        if(source_vcf_idxs[i] < 0)
+          add_header_fields_mapping(headers[i].get(), first_vcf_idx+i);
+        add_samples_mapping(headers[i].get(), first_vcf_idx+i);
+      });
+    utils::for_each_index(headers.size(), n_threads, [&](const size_t i) {
+        if(source_vcf_idxs[i] >= 0)
+          copy_header_fields_mapping(source_vcf_idxs[i], first_vcf_idx+i);
+      });
   }
 
   template<bool fields_forward_LUT_ordering, bool fields_reverse_LUT_ordering, bool samples_forward_LUT_ordering, bool samples_reverse_LUT_ordering>
@@ -134,6 +272,112 @@ namespace gamgee
       m_merged_field_idx_enum_lut.add_input_merged_idx_pair(0u, field_enum, val);
   }
 
+  template<bool fields_forward_LUT_ordering, bool fields_reverse_LUT_ordering, bool samples_forward_LUT_ordering, bool samples_reverse_LUT_ordering>
+  void
+  VariantHeaderMerger<fields_forward_LUT_ordering, fields_reverse_LUT_ordering, samples_forward_LUT_ordering, samples_reverse_LUT_ordering>::
+  write_cache(const string& filename) const
+  {
+    auto file = ofstream{filename, ios::binary | ios::trunc};
+    if(!file)
+      throw FileOpenException{filename};
+    file.write(cache_magic.data(), cache_magic.size());
+    write_value(file, static_cast<uint32_t>(m_input_vcf_headers.size()));
+    for(const auto& header : m_input_vcf_headers)
+      write_value(file, variant_header_fingerprint(header.get()));
+    //in BCF form, so the lines keep their IDX and the merged header read back has the same field indices
+    auto text_length = 0;
+    auto text = static_cast<char*>(nullptr);
+    if(m_merged_vcf_header_ptr)
+      text = bcf_hdr_fmt_text(m_merged_vcf_header_ptr.get(), 1, &text_length);
+    write_value(file, static_cast<uint32_t>(text_length));
+    file.write(text, text_length);
+    free(text);
+    for(auto i=0u;i<m_input_vcf_headers.size();++i)
+    {
+      auto curr_header = m_input_vcf_headers[i].get();
+      write_value(file, static_cast<uint32_t>(curr_header->n[BCF_DT_ID]));
+      for(auto j=0;j<curr_header->n[BCF_DT_ID];++j)
+        write_value(file, static_cast<int32_t>(m_header_fields_LUT.get_merged_idx_for_input(i, j)));
+      write_value(file, static_cast<uint32_t>(bcf_hdr_nsamples(curr_header)));
+      for(auto j=0;j<bcf_hdr_nsamples(curr_header);++j)
+        write_value(file, static_cast<int32_t>(m_samples_LUT.get_merged_idx_for_input(i, j)));
+    }
+    if(!file.flush())
+      throw FileOpenException{filename};
+  }
+
+  template<bool fields_forward_LUT_ordering, bool fields_reverse_LUT_ordering, bool samples_forward_LUT_ordering, bool samples_reverse_LUT_ordering>
+  bool
+  VariantHeaderMerger<fields_forward_LUT_ordering, fields_reverse_LUT_ordering, samples_forward_LUT_ordering, samples_reverse_LUT_ordering>::
+  read_cache(const string& filename, const vector<shared_ptr<bcf_hdr_t>>& headers)
+  {
+    auto file = ifstream{filename, ios::binary};
+    auto magic = string(cache_magic.size(), '\0');
+    if(!file || !file.read(&magic[0], magic.size()) || magic != cache_magic)
+      return false;
+    auto num_input_vcfs = 0u;
+    if(!read_value(file, num_input_vcfs) || num_input_vcfs != headers.size() || headers.empty())
+      return false;
+    auto fingerprints = vector<uint64_t>(headers.size());
+    for(auto i=0u;i<headers.size();++i)
+      if(!read_value(file, fingerprints[i]) || fingerprints[i] != variant_header_fingerprint(headers[i].get()))
+        return false;
+    auto text_length = 0u;
+    if(!read_value(file, text_length) || text_length == 0u)
+      return false;
+    auto text = string(text_length, '\0');
+    if(!file.read(&text[0], text_length))
+      return false;
+    auto merged_header = utils::make_shared_variant_header(bcf_hdr_init("r"));
+    if(bcf_hdr_parse(merged_header.get(), &text[0]) != 0)
+      return false;
+    //reads every mapping before touching the merger, so a stale or corrupt cache leaves it as it was
+    auto merged_idxs = vector<int32_t>{};
+    auto seen_fingerprints = unordered_set<uint64_t>{};
+    for(auto i=0u;i<headers.size();++i)
+    {
+      auto curr_header = headers[i].get();
+      auto distinct = seen_fingerprints.insert(fingerprints[i]).second;
+      for(auto dict_type : { BCF_DT_ID, BCF_DT_SAMPLE })
+      {
+        auto num_values = 0u;
+        if(!read_value(file, num_values) || num_values != static_cast<unsigned>(curr_header->n[dict_type]))
+          return false;
+        for(auto j=0u;j<num_values;++j)
+        {
+          auto merged_idx = int32_t{0};
+          if(!read_value(file, merged_idx))
+            return false;
+          merged_idxs.push_back(merged_idx);
+          if(missing(merged_idx))
+            continue;
+          if(merged_idx < 0 || merged_idx >= merged_header->n[dict_type])
+            return false;
+          //the names of each distinct header must match those of the merged header at the cached indices
+          if(distinct && strcmp(curr_header->id[dict_type][j].key, merged_header->id[dict_type][merged_idx].key) != 0)
+            return false;
+        }
+      }
+    }
+    reset();
+    m_merged_vcf_header_ptr = merged_header;
+    m_input_vcf_headers = headers;
+    for(auto i=0u;i<headers.size();++i)
+      m_fingerprint2input.emplace(variant_header_lines_fingerprint(headers[i].get()), i);
+    resize_luts_if_needed();
+    auto next_merged_idx = merged_idxs.cbegin();
+    for(auto i=0u;i<headers.size();++i)
+    {
+      for(auto j=0;j<headers[i]->n[BCF_DT_ID];++j, ++next_merged_idx)
+        if(!missing(*next_merged_idx))
+          m_header_fields_LUT.add_input_merged_idx_pair(i, j, *next_merged_idx);
+      for(auto j=0;j<bcf_hdr_nsamples(headers[i]);++j, ++next_merged_idx)
+        if(!missing(*next_merged_idx))
+          m_samples_LUT.add_input_merged_idx_pair(i, j, *next_merged_idx);
+    }
+    return true;
+  }
+
   //explicit initialization to avoid link errors
   template class VariantHeaderMerger<true, true, true, true>;
   template class VariantHeaderMerger<false, false, false, false>;
@@ -2,8 +2,10 @@
 #define __gamgee_variant_header_merger__
 
 #include <boost/shared_ptr.hpp>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "../utils/merged_vcf_lut.h"
 
@@ -39,7 +41,7 @@ namespace gamgee
    * The class contains two LUTs - m_header_fields_LUT and m_samples_LUT of type MergedVCFLUTBase<> for storing mapping for
    * header fields (FMT, FLT, INFO) and samples respectively. The class is templated to select the 'best' memory layout.
    * 
-   * Each of the two MergedVCFLUTBase<> objects (m_header_fields_LUT, m_samples_LUT) contains two matrices (vector<vector<int>>):
+   * Each of the two MergedVCFLUTBase<> objects (m_header_fields_LUT, m_samples_LUT) contains two matrices (FlatLUT):
    * m_inputs_2_merged_lut and m_merged_2_inputs_lut. The first stores the mapping from input VCF fields to the merged VCF fields while
    * the second stores the mapping in the opposite direction.
    * You can layout each matrix in one of the 2 following ways:
@@ -71,6 +73,22 @@ namespace gamgee
    * auto merged_PL_idx = Z.get_merged_header_idx_for_input(input_vcf_idx, input_PL_idx);
    * auto refind_input_PL_idx = Z.get_input_header_idx_for_merged(input_vcf_idx, merged_PL_idx);
    * assert(refind_input_PL_idx == input_PL_idx);
+   *
+   * Large cohorts usually have many headers with the same lines, that only differ by their samples. Headers are
+   * interned by a hash of their lines (variant_header_lines_fingerprint()): a header with the same lines as one already
+   * added is not merged again, its field mappings are copies of those of the first one, and only its samples are added
+   * to the merged header and mapped. add_headers() can also map the fields and samples of the new
+   * headers on a pool of threads (only merging them into the merged header is sequential):
+   * VariantHeaderMerger W;
+   * W.add_headers(hdr_vec1, 8u);
+   *
+   * The merged header and the LUTs can be saved to a cache file and loaded back for the same input headers, which
+   * skips the merging altogether:
+   * if(!W.read_cache("cohort.merger", hdr_vec1))
+   * {
+   *   W.add_headers(hdr_vec1, 8u);
+   *   W.write_cache("cohort.merger");
+   * }
    */
 
   template<bool fields_forward_LUT_ordering, bool fields_reverse_LUT_ordering, bool samples_forward_LUT_ordering, bool samples_reverse_LUT_ordering>
@@ -161,7 +179,7 @@ namespace gamgee
       void reset()
       {
         m_input_vcf_headers.clear();
-        m_sample2idx_merged.clear();
+        m_fingerprint2input.clear();
         m_merged_vcf_header_ptr = nullptr;
         m_num_merged_fields_allocated = 0u;
         m_num_merged_samples_allocated = 0u;
@@ -194,13 +212,31 @@ namespace gamgee
       /**
        * @brief add a vector of new VCF headers into the merged header and update LUTs
        * @param headers vector of new input VCF headers to add
+       * @param n_threads number of threads hashing the headers and mapping their fields and samples (the calling thread is one of them)
        */
-      void add_headers(const std::vector<std::shared_ptr<bcf_hdr_t>>& headers);
+      void add_headers(const std::vector<std::shared_ptr<bcf_hdr_t>>& headers, const unsigned n_threads = 1u);
       /**
        * @brief add a vector of new VCF headers into the merged header and update LUTs
        * @param headers vector of new input VCF headers to add
        */
       void add_headers(const std::vector<VariantHeader>& headers); 
+      /**
+       * @brief saves the merged header and the LUTs of the input headers added so far, see read_cache()
+       * @param filename the cache file to (over)write
+       * @throws FileOpenException if the file can't be written
+       * @note the file is meant for the machine that wrote it (native byte order)
+       */
+      void write_cache(const std::string& filename) const;
+      /**
+       * @brief replaces the content of the merger with the merged header and LUTs of a cache file
+       * The cache is only used if it was written for headers identical to these ones (same variant_header_fingerprint(),
+       * in the same order), otherwise the merger is left untouched. The field and sample names of every distinct input header are
+       * checked against the merged header before the cache is used.
+       * @param filename the cache file written by write_cache()
+       * @param headers the input VCF headers, in the order they were added when the cache was written
+       * @return whether the cache was used (false if the file doesn't exist, is corrupt or belongs to other headers)
+       */
+      bool read_cache(const std::string& filename, const std::vector<std::shared_ptr<bcf_hdr_t>>& headers);
       /**
        * @brief Get merged VCF header shared_ptr
        * @return return the merged VCF header shared_ptr
@@ -220,6 +256,29 @@ namespace gamgee
        */
       inline int get_merged_sample_idx_for_input(unsigned inputGVCFIdx, int inputSampleIdx) const
       { return m_samples_LUT.get_merged_idx_for_input(inputGVCFIdx, inputSampleIdx); }
+      /**
+       * @brief Get the merged VCF sample idx of every sample of the input VCF of index inputGVCFIdx at once
+       * @note one copy of the row of the input when the samples LUT is input ordered (e.g. InputOrderedVariantHeaderMerger)
+       * @param inputGVCFIdx index of the input VCF file
+       * @param numInputSamples number of samples in the input VCF file
+       * @param mergedSampleIdxs array of numInputSamples values, filled with the merged sample idxs
+       */
+      inline void get_merged_sample_idxs_for_input(unsigned inputGVCFIdx, unsigned numInputSamples, int* mergedSampleIdxs) const
+      { m_samples_LUT.get_merged_idxs_for_input(inputGVCFIdx, numInputSamples, mergedSampleIdxs); }
+      /**
+       * @brief Rearrange one value per sample of the input VCF of index inputGVCFIdx into the sample order of the merged VCF
+       * @note a single gather over the row of the input, see MergedVCFLUTBase::gather_input_values()
+       * @param inputGVCFIdx index of the input VCF file
+       * @param inputValues one value per sample of the input VCF file
+       * @param numInputSamples number of samples in the input VCF file
+       * @param mergedValues array of numMergedSamples values to fill
+       * @param numMergedSamples number of samples in the merged VCF
+       * @param missingValue value for the merged samples that are not in the input VCF file
+       */
+      template<class VALUE>
+      inline void gather_merged_sample_values(unsigned inputGVCFIdx, const VALUE* inputValues, unsigned numInputSamples,
+          VALUE* mergedValues, unsigned numMergedSamples, const VALUE missingValue) const
+      { m_samples_LUT.gather_input_values(inputGVCFIdx, inputValues, numInputSamples, mergedValues, numMergedSamples, missingValue); }
       /**
        * @brief Get header field (FLT/FMT/INFO) idx for the merged VCF corresponding to field idx inputIdx in the input VCF of index inputGVCFIdx
        * @param inputGVCFIdx index of the input VCF file
@@ -286,6 +345,22 @@ namespace gamgee
        * @brief function to resize LUTs if needed
        */
       void resize_luts_if_needed();
+      /**
+       * @brief merges a header into the merged header (or copies it if it's the first one)
+       */
+      void merge_header(const std::shared_ptr<bcf_hdr_t>& hdr);
+      /**
+       * @brief finds an input header added before with the same lines as a new one
+       * @param curr_header the new header
+       * @param lines_fingerprint variant_header_lines_fingerprint() of the new header
+       * @return index of the first input with the same fingerprint, whose lines and field dictionary are indeed the same
+       * as those of the new header (no hash collision), -1 if there's none
+       */
+      int find_input_with_same_lines(const bcf_hdr_t* curr_header, uint64_t lines_fingerprint) const;
+      /**
+       * @brief gives an input VCF the same field mappings as an input VCF with the same header lines added before
+       */
+      void copy_header_fields_mapping(unsigned source_vcf_idx, unsigned input_vcf_idx);
       //LUT for VCF header fields (FMT/FLT/INFO)
       utils::MergedVCFLUTBase<fields_forward_LUT_ordering, fields_reverse_LUT_ordering> m_header_fields_LUT;
       //LUT for samples
@@ -294,10 +369,10 @@ namespace gamgee
       void add_header_fields_mapping(bcf_hdr_t* curr_header, unsigned input_vcf_idx);
       //Samples mapping
       void add_samples_mapping(bcf_hdr_t* curr_header, unsigned input_vcf_idx);
-      //Global sample names to idx mapping
-      std::unordered_map<std::string,int> m_sample2idx_merged;
       //Input VCF headers
       std::vector<std::shared_ptr<bcf_hdr_t>> m_input_vcf_headers;
+      //First input with each hash of the header lines
+      std::unordered_map<uint64_t,unsigned> m_fingerprint2input;
       //Merged header
       std::shared_ptr<bcf_hdr_t> m_merged_vcf_header_ptr;
       //sizes of the LUTs - to determine when to reallocate
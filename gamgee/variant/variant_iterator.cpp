@@ -7,13 +7,23 @@ using namespace std;
 
 namespace gamgee {
 
-VariantIterator::VariantIterator(const std::shared_ptr<htsFile>& variant_file_ptr, const std::shared_ptr<bcf_hdr_t>& variant_header_ptr) :
+VariantIterator::VariantIterator(const std::shared_ptr<htsFile>& variant_file_ptr, const std::shared_ptr<bcf_hdr_t>& variant_header_ptr,
+                                 const VariantUnpackLevel unpack_level) :
+  VariantIterator {variant_file_ptr, variant_header_ptr, unpack_level, true}
+{}
+
+VariantIterator::VariantIterator(const std::shared_ptr<htsFile>& variant_file_ptr, const std::shared_ptr<bcf_hdr_t>& variant_header_ptr,
+                                 const VariantUnpackLevel unpack_level, const bool fetch_first_record) :
   m_variant_file_ptr {variant_file_ptr},
   m_variant_header_ptr {variant_header_ptr},
   m_variant_record_ptr {utils::make_shared_variant(bcf_init1())},      ///< important to initialize the record buffer in the constructor so we can reuse it across the iterator
-  m_variant_record {m_variant_header_ptr, m_variant_record_ptr}
+  m_variant_record {m_variant_header_ptr, m_variant_record_ptr},
+  m_unpack_level {unpack_level}
 {
-  fetch_next_record();
+  if (m_unpack_level != VariantUnpackLevel::ALL)
+    m_variant_record_ptr->max_unpack = BCF_UN_SHR;                      // stops the VCF parser before the per sample columns (the BCF reader ignores it)
+  if (fetch_first_record)
+    fetch_next_record();
 }
 
 Variant& VariantIterator::operator*() {
@@ -41,7 +51,10 @@ void VariantIterator::fetch_next_record() {
  if (bcf_read1(m_variant_file_ptr.get(), m_variant_header_ptr.get(), m_variant_record_ptr.get()) < 0) {
     m_variant_file_ptr.reset();
     m_variant_record = Variant{};
+    return;
   }
+  unpack_variant_record(m_variant_record_ptr.get(), m_variant_header_ptr.get(), m_unpack_level);
+  m_variant_record.invalidate_field_slots();
 }
 
 }
@@ -3,6 +3,8 @@
 
 #include "variant.h"
 
+#include "../utils/variant_utils.h"
+
 #include "htslib/vcf.h"
 
 #include <memory>
@@ -25,8 +27,10 @@ class VariantIterator {
    *
    * @param variant_file_ptr   shared pointer to a vcf/bcf file opened via the bcf_open() macro from htslib
    * @param variant_header_ptr shared pointer to a vcf/bcf file header created with the bcf_hdr_read() macro from htslib
+   * @param unpack_level       how much of each record to decode (see VariantUnpackLevel)
    */
-  VariantIterator(const std::shared_ptr<htsFile>& variant_file_ptr, const std::shared_ptr<bcf_hdr_t>& variant_header_ptr);
+  VariantIterator(const std::shared_ptr<htsFile>& variant_file_ptr, const std::shared_ptr<bcf_hdr_t>& variant_header_ptr,
+                  const VariantUnpackLevel unpack_level = VariantUnpackLevel::ALL);
 
   /**
    * @brief a VariantIterator move constructor guarantees all objects will have the same state.
@@ -81,10 +85,20 @@ class VariantIterator {
   bool empty() const;
 
  protected:
+  /**
+   * @brief initializes a new iterator without reading its first record, for the iterators that position the file
+   * themselves (e.g. through an index) before reading
+   *
+   * @param fetch_first_record whether to read the first record of the stream, as the public constructor does
+   */
+  VariantIterator(const std::shared_ptr<htsFile>& variant_file_ptr, const std::shared_ptr<bcf_hdr_t>& variant_header_ptr,
+                  const VariantUnpackLevel unpack_level, const bool fetch_first_record);
+
   std::shared_ptr<htsFile> m_variant_file_ptr;          ///< pointer to the vcf/bcf file
   std::shared_ptr<bcf_hdr_t> m_variant_header_ptr;      ///< pointer to the variant header
   std::shared_ptr<bcf1_t> m_variant_record_ptr;         ///< pointer to the internal structure of the variant record. Useful to only allocate it once.
   Variant m_variant_record;                             ///< temporary record to hold between fetch (operator++) and serve (operator*)
+  VariantUnpackLevel m_unpack_level {VariantUnpackLevel::ALL}; ///< how much of each record is decoded as it's read
 
   virtual void fetch_next_record();                     ///< fetches next Variant record into existing htslib memory without making a copy
 };
@@ -42,6 +42,13 @@ namespace gamgee {
  * for (auto& record : SingleVariantReader{filename})
  *   do_something_with_record(record);
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * Site only workloads can skip the per sample data altogether and large BGZF compressed files can be
+ * inflated by worker threads:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * for (auto& record : SingleVariantReader{filename, VariantReaderOptions{4, VariantUnpackLevel::INFO}})
+ *   do_something_with_site(record);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  */
 template<class ITERATOR>
 class VariantReader {
@@ -52,10 +59,12 @@ class VariantReader {
    * objects
    *
    * @param filename the name of the variant file
+   * @param options decompression threads and unpack level (see VariantReaderOptions)
    */
-  explicit VariantReader(const std::string& filename) :
+  explicit VariantReader(const std::string& filename, const VariantReaderOptions& options = VariantReaderOptions{}) :
     m_variant_file_ptr {},
-    m_variant_header_ptr {}
+    m_variant_header_ptr {},
+    m_options {options}
   {
     init_reader(filename);
   }
@@ -65,10 +74,12 @@ class VariantReader {
    * objects
    *
    * @param filenames a vector containing a single element: the name of the variant file
+   * @param options decompression threads and unpack level (see VariantReaderOptions)
    */
-  explicit VariantReader(const std::vector<std::string>& filenames) :
+  explicit VariantReader(const std::vector<std::string>& filenames, const VariantReaderOptions& options = VariantReaderOptions{}) :
     m_variant_file_ptr {},
-    m_variant_header_ptr {}
+    m_variant_header_ptr {},
+    m_options {options}
   {
     if (filenames.size() > 1)
       throw SingleInputException{"filenames", filenames.size()};
@@ -84,10 +95,13 @@ class VariantReader {
    * @param filename the name of the variant file
    * @param samples the list of samples you want included/excluded from your iteration
    * @param include whether you want these samples to be included or excluded from your iteration.  default = true (include)
+   * @param options decompression threads and unpack level (see VariantReaderOptions)
    */
-  VariantReader(const std::string& filename, const std::vector<std::string>& samples, const bool include = true) :
+  VariantReader(const std::string& filename, const std::vector<std::string>& samples, const bool include = true,
+                const VariantReaderOptions& options = VariantReaderOptions{}) :
     m_variant_file_ptr {},
-    m_variant_header_ptr {}
+    m_variant_header_ptr {},
+    m_options {options}
   {
     init_reader(filename);
     subset_variant_samples(m_variant_header_ptr.get(), samples, include);
@@ -101,10 +115,13 @@ class VariantReader {
    * @param filenames a vector containing a single element: the name of the variant file
    * @param samples the list of samples you want included/excluded from your iteration
    * @param include whether you want these samples to be included or excluded from your iteration.  default = true (include)
+   * @param options decompression threads and unpack level (see VariantReaderOptions)
    */
-  VariantReader(const std::vector<std::string>& filenames, const std::vector<std::string>& samples, const bool include = true) :
+  VariantReader(const std::vector<std::string>& filenames, const std::vector<std::string>& samples, const bool include = true,
+                const VariantReaderOptions& options = VariantReaderOptions{}) :
     m_variant_file_ptr {},
-    m_variant_header_ptr {}
+    m_variant_header_ptr {},
+    m_options {options}
   {
     if (filenames.size() > 1)
       throw SingleInputException{"filenames", filenames.size()};
@@ -135,7 +152,7 @@ class VariantReader {
    * @return a ITERATOR ready to start parsing the file
    */
   ITERATOR begin() const {
-    return ITERATOR{ m_variant_file_ptr, m_variant_header_ptr };
+    return ITERATOR{ m_variant_file_ptr, m_variant_header_ptr, m_options.unpack_level };
   }
 
   /**
@@ -155,6 +172,7 @@ class VariantReader {
  private:
   std::shared_ptr<htsFile> m_variant_file_ptr;          ///< pointer to the internal file structure of the variant/bam/cram file
   std::shared_ptr<bcf_hdr_t> m_variant_header_ptr;      ///< pointer to the internal header structure of the variant/bam/cram file
+  VariantReaderOptions m_options;                       ///< decompression threads and unpack level
 
   /**
    * @brief initialize the VariantReader (helper function for constructors)
@@ -170,6 +188,7 @@ class VariantReader {
       throw FileOpenException{filename};
     }
     m_variant_file_ptr = utils::make_shared_hts_file(file_ptr);
+    set_variant_decompression_threads(file_ptr, m_options.decompression_threads);
 
     auto* header_ptr = bcf_hdr_read(file_ptr);
     if ( header_ptr == nullptr ) {
@@ -1,49 +1,296 @@
 #include "variant_writer.h"
 
+#include "../exceptions.h"
 #include "../utils/hts_memory.h"
 
+#include "htslib/bgzf.h"
+#include "htslib/hts.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 #include <zlib.h>
 
 namespace gamgee {
 
-VariantWriter::VariantWriter(const std::string& output_fname, const bool binary, const int compression_level) :
-  m_out_file {utils::make_unique_hts_file(open_file(output_fname, write_mode(binary, compression_level)))},
-  m_header {nullptr}
-{}
+constexpr auto csi_min_shift = 14;   // as bcftools index
+constexpr auto tbi_min_shift = 14;
+constexpr auto tbi_levels = 5;
 
-VariantWriter::VariantWriter(const VariantHeader& header, const std::string& output_fname, const bool binary, const int compression_level) :
-  m_out_file {utils::make_unique_hts_file(open_file(output_fname, write_mode(binary, compression_level)))},
-  m_header{header}
+VariantWriter::VariantWriter(const std::string& output_fname, const bool binary, const int compression_level, const VariantWriterOptions& options) :
+  m_out_file {utils::make_unique_hts_file(open_file(output_fname, write_mode(binary, compression_level, options.index), options.index))},
+  m_header {nullptr},
+  m_output_fname {output_fname},
+  m_binary {binary},
+  m_indexed {options.index},
+  m_index {},
+  m_finished_chromosomes {},
+  m_last_chromosome {-1},
+  m_last_position {0},
+  m_writing_thread {}
 {
+  init_writer(options);
+}
+
+VariantWriter::VariantWriter(const VariantHeader& header, const std::string& output_fname, const bool binary, const int compression_level, const VariantWriterOptions& options) :
+  m_out_file {utils::make_unique_hts_file(open_file(output_fname, write_mode(binary, compression_level, options.index), options.index))},
+  m_header{header},
+  m_output_fname {output_fname},
+  m_binary {binary},
+  m_indexed {options.index},
+  m_index {},
+  m_finished_chromosomes {},
+  m_last_chromosome {-1},
+  m_last_position {0},
+  m_writing_thread {}
+{
+  init_writer(options);
   write_header();
 }
 
-std::string VariantWriter::write_mode(const bool binary, const int compression_level) const {
+VariantWriter::~VariantWriter() {
+  try {
+    close();
+  }
+  catch (...) {}  // destructors can't throw: call close() to see the errors
+}
+
+VariantWriter& VariantWriter::operator=(VariantWriter&& other) {
+  if (this != &other) {
+    close();
+    m_out_file = std::move(other.m_out_file);
+    m_header = std::move(other.m_header);
+    m_output_fname = std::move(other.m_output_fname);
+    m_binary = other.m_binary;
+    m_indexed = other.m_indexed;
+    m_index = std::move(other.m_index);
+    m_finished_chromosomes = std::move(other.m_finished_chromosomes);
+    m_last_chromosome = other.m_last_chromosome;
+    m_last_position = other.m_last_position;
+    m_writing_thread = std::move(other.m_writing_thread);
+  }
+  return *this;
+}
+
+std::string VariantWriter::write_mode(const bool binary, const int compression_level, const bool indexed) const {
   if (compression_level != Z_DEFAULT_COMPRESSION) {
     if (!binary)
       throw new std::runtime_error{"Cannot specify compression level for VCF files"};
     return "wb" + std::to_string(compression_level);
   }
+  else if (indexed && !binary)
+    return "wz";  // only bgzipped VCF can be indexed
   else
     return binary ? "wb" : "w";
 }
 
-void VariantWriter::add_header(const VariantHeader& header) { 
+void VariantWriter::init_writer(const VariantWriterOptions& options) {
+  // the return value is deliberately ignored: older htslib versions (and plain text files) are simply written
+  // by the writing thread
+  if (options.compression_threads > 0 && !m_indexed)
+    hts_set_threads(m_out_file.get(), int(options.compression_threads));
+  if (options.queue_size > 0) {
+    m_writing_thread = std::make_unique<WritingThread>();
+    m_writing_thread->file = m_out_file.get();
+    m_writing_thread->capacity = options.queue_size;
+    auto& writing = *m_writing_thread;  // stays put when the writer is moved
+    m_writing_thread->thread = std::thread{[&writing] { write_queued_records(writing); }};
+  }
+}
+
+void VariantWriter::add_header(const VariantHeader& header) {
   m_header = header;
   write_header();
 }
 
-void VariantWriter::add_record(const Variant& body) { 
-  bcf_write1(m_out_file.get(), m_header.m_header.get(), body.m_body.get());
+void VariantWriter::add_record(const Variant& body) {
+  if (m_index)
+    check_order(body.m_body.get());
+  if (m_writing_thread)
+    queue_record(utils::make_shared_variant(utils::variant_deep_copy(body.m_body.get())));
+  else
+    write_record(m_out_file.get(), m_header.m_header.get(), m_index.get(), body.m_body.get());
+}
+
+void VariantWriter::add_record(Variant&& body) {
+  if (!m_writing_thread || body.m_body.use_count() != 1)  // someone else may still change the record: copy it
+    return add_record(static_cast<const Variant&>(body));
+  if (m_index)
+    check_order(body.m_body.get());
+  queue_record(std::move(body.m_body));
+}
+
+void VariantWriter::close() {
+  auto error = m_writing_thread ? stop_writing_thread() : std::exception_ptr{};
+  m_writing_thread.reset();
+  if (m_index && m_out_file && !error) {
+    // the final offset is where the end of file block goes
+    auto* bgzf = m_out_file->fp.bgzf;
+    bgzf_flush(bgzf);
+    hts_idx_finish(m_index.get(), bgzf_tell(bgzf));
+    hts_idx_save(m_index.get(), m_output_fname.c_str(), m_binary ? HTS_FMT_CSI : HTS_FMT_TBI);
+  }
+  m_index.reset();
+  m_out_file.reset();
+  if (error)
+    std::rethrow_exception(error);
 }
 
-htsFile* VariantWriter::open_file(const std::string& output_fname, const std::string& mode) {
+htsFile* VariantWriter::open_file(const std::string& output_fname, const std::string& mode, const bool indexed) {
+  if (indexed && (output_fname.empty() || output_fname == "-"))
+    throw std::invalid_argument{"Cannot index the standard output"};
   return hts_open(output_fname.empty() ? "-" : output_fname.c_str(), mode.c_str());
 }
 
-void VariantWriter::write_header() const {
+void VariantWriter::write_header() {
+  if (m_writing_thread)
+    drain_queue();
   bcf_hdr_write(m_out_file.get(), m_header.m_header.get());
+  if (m_indexed)
+    init_index();
+  if (m_writing_thread) {
+    auto lock = std::unique_lock<std::mutex>{m_writing_thread->mutex};
+    m_writing_thread->header = m_header.m_header;
+    m_writing_thread->index = m_index.get();
+  }
+}
+
+/**
+ * @brief starts the index of the records following the header that was just written
+ */
+void VariantWriter::init_index() {
+  const auto* header = m_header.m_header.get();
+  const auto n_chromosomes = header->n[BCF_DT_CTG];
+  const auto offset = bgzf_tell(m_out_file->fp.bgzf);
+  auto* index = static_cast<hts_idx_t*>(nullptr);
+  if (m_binary) {
+    // as bcf_index_build(): enough levels for the longest chromosome (assumed to be 2Gb if none has a length)
+    auto max_length = int64_t{0};
+    for (auto chromosome = 0; chromosome < n_chromosomes; ++chromosome)
+      max_length = std::max(max_length, int64_t(header->id[BCF_DT_CTG][chromosome].val->info[0]));
+    max_length = (max_length > 0 ? max_length : (int64_t{1} << 31) - 1) + 256;
+    auto n_levels = 0;
+    for (auto size = int64_t{1} << csi_min_shift; max_length > size; size <<= 3)
+      ++n_levels;
+    index = hts_idx_init(n_chromosomes, HTS_FMT_CSI, offset, csi_min_shift, n_levels);
+  }
+  else {
+    index = hts_idx_init(n_chromosomes, HTS_FMT_TBI, offset, tbi_min_shift, tbi_levels);
+    if (index != nullptr) {
+      // the tabix configuration of VCF (as tbx_conf_vcf) followed by the chromosome names in the order of their ids
+      const int32_t configuration[] = {2, 1, 2, 0, '#', 0};
+      auto names = std::string{};
+      for (auto chromosome = 0; chromosome < n_chromosomes; ++chromosome)
+        names.append(header->id[BCF_DT_CTG][chromosome].key).push_back('\0');
+      const auto names_length = int32_t(names.size());
+      auto meta = std::vector<uint8_t>(sizeof(configuration) + sizeof(names_length) + names.size());
+      memcpy(meta.data(), configuration, sizeof(configuration));
+      memcpy(meta.data() + sizeof(configuration), &names_length, sizeof(names_length));
+      memcpy(meta.data() + sizeof(configuration) + sizeof(names_length), names.data(), names.size());
+      hts_idx_set_meta(index, int(meta.size()), meta.data(), 1);
+    }
+  }
+  if (index == nullptr)
+    throw HtslibException{-1};
+  m_index = utils::make_shared_hts_index(index);
+  m_finished_chromosomes.assign(n_chromosomes, false);
+  m_last_chromosome = -1;
+  m_last_position = 0;
+}
+
+/**
+ * @brief checks that a record can follow the previous one in an indexed output
+ * @note the chromosomes don't have to follow the order of the header, but each has to be in a single block
+ */
+void VariantWriter::check_order(const bcf1_t* body) {
+  const auto chromosome = body->rid;
+  if (chromosome != m_last_chromosome) {
+    if (chromosome < 0 || uint32_t(chromosome) >= m_finished_chromosomes.size() || m_finished_chromosomes[chromosome]) {
+      const auto valid = chromosome >= 0 && chromosome < m_header.m_header->n[BCF_DT_CTG];
+      throw UnsortedRecordException{valid ? m_header.m_header->id[BCF_DT_CTG][chromosome].key : std::to_string(chromosome), uint32_t(body->pos + 1)};
+    }
+    if (m_last_chromosome >= 0)
+      m_finished_chromosomes[m_last_chromosome] = true;
+    m_last_chromosome = chromosome;
+  }
+  else if (body->pos < m_last_position)
+    throw UnsortedRecordException{m_header.m_header->id[BCF_DT_CTG][chromosome].key, uint32_t(body->pos + 1)};
+  m_last_position = body->pos;
+}
+
+void VariantWriter::write_record(htsFile* file, bcf_hdr_t* header, hts_idx_t* index, bcf1_t* body) {
+  const auto error = bcf_write1(file, header, body);
+  if (error < 0)
+    throw HtslibException{error};
+  if (index == nullptr)
+    return;
+  // the offset right after the record, as bcf_index_build() pushes it
+  const auto index_error = hts_idx_push(index, body->rid, body->pos, body->pos + body->rlen, bgzf_tell(file->fp.bgzf), 1);
+  if (index_error < 0)
+    throw HtslibException{index_error};
 }
 
+void VariantWriter::queue_record(std::shared_ptr<bcf1_t>&& body) {
+  auto& writing = *m_writing_thread;
+  auto lock = std::unique_lock<std::mutex>{writing.mutex};
+  writing.progress.wait(lock, [&writing] { return writing.records.size() < writing.capacity || writing.error; });
+  if (writing.error)
+    std::rethrow_exception(writing.error);
+  writing.records.push_back(std::move(body));
+  writing.work.notify_one();
+}
+
+void VariantWriter::drain_queue() {
+  auto& writing = *m_writing_thread;
+  auto lock = std::unique_lock<std::mutex>{writing.mutex};
+  writing.progress.wait(lock, [&writing] { return (writing.records.empty() && !writing.writing) || writing.error; });
+  if (writing.error)
+    std::rethrow_exception(writing.error);
+}
+
+std::exception_ptr VariantWriter::stop_writing_thread() {
+  auto& writing = *m_writing_thread;
+  {
+    auto lock = std::unique_lock<std::mutex>{writing.mutex};
+    writing.stopping = true;
+    writing.work.notify_one();
+  }
+  writing.thread.join();
+  return writing.error;
+}
+
+/**
+ * @brief writes the records of the queue until it is stopped (and empty) or a record can't be written
+ */
+void VariantWriter::write_queued_records(WritingThread& writing) {
+  auto lock = std::unique_lock<std::mutex>{writing.mutex};
+  while (true) {
+    writing.work.wait(lock, [&writing] { return !writing.records.empty() || writing.stopping; });
+    if (writing.records.empty())
+      return;
+    const auto body = std::move(writing.records.front());
+    writing.records.pop_front();
+    writing.writing = true;
+    const auto header = writing.header;
+    const auto index = writing.index;
+    writing.progress.notify_all();
+    lock.unlock();
+    try {
+      write_record(writing.file, header.get(), index, body.get());
+    }
+    catch (...) {
+      lock.lock();
+      writing.error = std::current_exception();
+      writing.writing = false;
+      writing.records.clear();
+      writing.progress.notify_all();
+      return;
+    }
+    lock.lock();
+    writing.writing = false;
+    if (writing.records.empty())
+      writing.progress.notify_all();
+  }
+}
 
 }
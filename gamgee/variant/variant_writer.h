@@ -1,8 +1,14 @@
 #ifndef gamgee__variant_writer__guard
 #define gamgee__variant_writer__guard
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <zlib.h>
 
 #include "variant.h"
@@ -14,8 +20,32 @@
 
 namespace gamgee {
 
+/**
+ * @brief options of a VariantWriter
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * auto writer = VariantWriter{header, "out.bcf", true, Z_DEFAULT_COMPRESSION, VariantWriterOptions{4, 1024, true}};
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+struct VariantWriterOptions {
+  uint32_t compression_threads = 0;  ///< worker threads deflating BGZF blocks (0 = deflate in the writing thread). Not used by indexed outputs (see VariantWriter)
+  uint32_t queue_size = 0;           ///< records queued for a background writing thread (0 = write in the calling thread)
+  bool index = false;                ///< builds a CSI (BCF) or TBI (VCF, which is then bgzipped) index of the output while writing it
+};
+
 /**
  * @brief utility class to write out a VCF/BCF file to any stream
+ *
+ * With a queue size, add_record() only copies the record into a bounded queue and a background thread encodes
+ * and writes it, so the caller can go on producing records. Errors of the writing thread are thrown by the next
+ * add_record(), add_header() or close().
+ *
+ * An indexed output gets its index (the output file name plus .csi or .tbi) saved when it is closed, so it doesn't
+ * need another pass to be indexed. The records must then be sorted: every chromosome in a single block with
+ * non-decreasing positions, which add_record() checks as the records arrive.
+ *
+ * @note the index needs the exact offset of every record in the file, which htslib's multi-threaded BGZF writing
+ * doesn't report, so indexed outputs are deflated by the writing thread (the background one if there's a queue)
  * @todo add serialization option
  */
 class VariantWriter {
@@ -27,9 +57,12 @@ class VariantWriter {
    * @param output_fname file to write to. The default is stdout (as defined by htslib)
    * @param binary whether the output should be in BCF (true) or VCF format (false)
    * @param compression_level optional zlib compression level. 0 for none, 1 for best speed, 9 for best compression
+   * @param options threads, queueing and indexing of the output
    * @note the header is copied and managed internally
+   * @throws std::invalid_argument if an index is requested for the standard output
    */
-  explicit VariantWriter(const std::string& output_fname = "-", const bool binary = true, const int compression_level = Z_DEFAULT_COMPRESSION);
+  explicit VariantWriter(const std::string& output_fname = "-", const bool binary = true, const int compression_level = Z_DEFAULT_COMPRESSION,
+                         const VariantWriterOptions& options = VariantWriterOptions{});
 
   /**
    * @brief Creates a new VariantWriter with the header extracted from a Variant record and using the specified output file name
@@ -37,9 +70,17 @@ class VariantWriter {
    * @param output_fname file to write to. The default is stdout  (as defined by htslib)
    * @param binary whether the output should be in BCF (true) or VCF format (false)
    * @param compression_level optional zlib compression level. 0 for none, 1 for best speed, 9 for best compression
+   * @param options threads, queueing and indexing of the output
    * @note the header is copied and managed internally
+   * @throws std::invalid_argument if an index is requested for the standard output
    */
-  explicit VariantWriter(const VariantHeader& header, const std::string& output_fname = "-", const bool binary = true, const int compression_level = Z_DEFAULT_COMPRESSION);
+  explicit VariantWriter(const VariantHeader& header, const std::string& output_fname = "-", const bool binary = true, const int compression_level = Z_DEFAULT_COMPRESSION,
+                         const VariantWriterOptions& options = VariantWriterOptions{});
+
+  /**
+   * @brief closes the output (see close()), ignoring any error
+   */
+  ~VariantWriter();
 
   /**
    * @brief a VariantWriter cannot be copied safely, as it is iterating over a stream.
@@ -49,18 +90,26 @@ class VariantWriter {
   VariantWriter& operator=(const VariantWriter& other) = delete;
 
   /**
-   * @brief a VariantWriter can be moved
+   * @brief a VariantWriter can be moved (assigning to a writer closes its output first)
    */
 
   VariantWriter(VariantWriter&& other) = default;
-  VariantWriter& operator=(VariantWriter&& other) = default;
+  VariantWriter& operator=(VariantWriter&& other);
 
   /**
    * @brief Adds a record to the file stream
-   * @param body the record
+   * @param body the record (copied if it is queued)
+   * @throws UnsortedRecordException if the output is indexed and the record is out of order
    */
   void add_record(const Variant& body);
 
+  /**
+   * @brief Adds a record to the file stream, handing it over to the queue if nothing else refers to it
+   * @param body the record
+   * @throws UnsortedRecordException if the output is indexed and the record is out of order
+   */
+  void add_record(Variant&& body);
+
   /**
    * @brief Adds a header to the file stream.
    * @param header the header
@@ -68,13 +117,51 @@ class VariantWriter {
    */
   void add_header(const VariantHeader& header);
 
+  /**
+   * @brief writes the queued records, saves the index and closes the output
+   * @note no records can be added afterwards. Closing twice does nothing.
+   * @throws HtslibException if a record couldn't be written or indexed
+   */
+  void close();
+
  private:
+  struct WritingThread {
+    htsFile* file;
+    std::shared_ptr<bcf_hdr_t> header {};           ///< the header the queued records are written with
+    hts_idx_t* index {nullptr};
+    uint32_t capacity;
+    std::deque<std::shared_ptr<bcf1_t>> records {};  ///< the queued records, owned by the queue
+    bool writing {false};                            ///< a record taken from the queue is being written
+    bool stopping {false};
+    std::exception_ptr error {};                     ///< the exception that stopped the thread
+    std::mutex mutex {};
+    std::condition_variable work {};                 ///< wakes the thread
+    std::condition_variable progress {};             ///< wakes the callers waiting for room or for the queue to drain
+    std::thread thread {};
+  };
+
   std::unique_ptr<htsFile, utils::HtsFileDeleter> m_out_file;  ///< the file or stream to write out to ("-" means stdout)
   VariantHeader m_header;               ///< holds a copy of the header throughout the production of the output (necessary for every record that gets added)
-
-  static htsFile* open_file(const std::string& output_fname, const std::string& binary);
-  void write_header() const;
-  std::string write_mode(const bool binary, const int compression_level) const;
+  std::string m_output_fname;
+  bool m_binary;
+  bool m_indexed;
+  std::shared_ptr<hts_idx_t> m_index;   ///< the index of the records written so far (null unless the output is indexed and has a header)
+  std::vector<bool> m_finished_chromosomes; ///< chromosomes that can't have more records in an indexed output
+  int32_t m_last_chromosome;
+  int32_t m_last_position;
+  std::unique_ptr<WritingThread> m_writing_thread; ///< the background writer (null if records are written in the calling thread)
+
+  static htsFile* open_file(const std::string& output_fname, const std::string& mode, const bool indexed);
+  void write_header();
+  std::string write_mode(const bool binary, const int compression_level, const bool indexed) const;
+  void init_writer(const VariantWriterOptions& options);
+  void init_index();
+  void check_order(const bcf1_t* body);
+  void queue_record(std::shared_ptr<bcf1_t>&& body);
+  void drain_queue();                           ///< waits until the queued records are written
+  std::exception_ptr stop_writing_thread();     ///< writes the queued records and joins the thread
+  static void write_queued_records(WritingThread& writing);
+  static void write_record(htsFile* file, bcf_hdr_t* header, hts_idx_t* index, bcf1_t* body);
 };
 
 }
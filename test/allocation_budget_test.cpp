@@ -0,0 +1,103 @@
+#include "sam/sam_reader.h"
+#include "variant/variant_reader.h"
+#include "variant/variant_builder.h"
+#include "utils/allocation_counter.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace std;
+using namespace gamgee;
+using namespace gamgee::utils;
+
+// note: the counts are always captured before calling the BOOST_CHECK macros, which may allocate themselves
+
+BOOST_AUTO_TEST_CASE( allocation_scope_counts_heap_allocations ) {
+  auto scope = AllocationScope{};
+  const auto nothing = scope.counts();
+  auto values = make_unique<vector<int32_t>>(100);
+  const auto vector_allocations = scope.counts();
+  BOOST_CHECK_EQUAL(nothing.allocations, 0u);
+  BOOST_CHECK_EQUAL(vector_allocations.allocations, 2u);   // the vector object and its buffer
+  BOOST_CHECK_GE(vector_allocations.bytes, 100 * sizeof(int32_t));
+
+  scope.reset();
+  auto ptr = malloc(128);
+  ptr = realloc(ptr, 256);
+  free(ptr);
+  const auto c_allocations = scope.counts();
+  if (allocation_counting_includes_malloc()) {
+    BOOST_CHECK_EQUAL(c_allocations.allocations, 2u);
+    BOOST_CHECK_EQUAL(c_allocations.bytes, 384u);
+  }
+  else
+    BOOST_CHECK_EQUAL(c_allocations.allocations, 0u);
+
+  scope.reset();
+  auto aligned = static_cast<void*>(nullptr);
+  const auto aligned_result = posix_memalign(&aligned, 64, 100);
+  free(aligned);
+  free(aligned_alloc(64, 128));
+  const auto aligned_allocations = scope.counts();
+  BOOST_CHECK_EQUAL(aligned_result, 0);
+  if (allocation_counting_includes_malloc()) {
+    BOOST_CHECK_EQUAL(aligned_allocations.allocations, 2u);
+    BOOST_CHECK_EQUAL(aligned_allocations.bytes, 228u);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( sam_iterator_steady_state_does_not_allocate ) {
+  auto reader = SingleSamReader{"testdata/test_simple.bam"};
+  auto iterator = reader.begin();   // the first (and largest) record sizes the reusable htslib buffer
+  const auto end = reader.end();
+  const auto scope = AllocationScope{};
+  auto records = 0u;
+  auto checksum = 0u;
+  for (++iterator; iterator != end; ++iterator) {
+    const auto& record = *iterator;
+    checksum += record.alignment_start() + record.cigar().size() + record.bases().size() + record.base_quals()[0];
+    checksum += record.integer_tag("NM").value();
+    ++records;
+  }
+  const auto allocations = scope.allocations();
+  BOOST_CHECK_EQUAL(records, 32u);
+  BOOST_CHECK(checksum > 0u);
+  BOOST_CHECK_EQUAL(allocations, 0u);
+}
+
+BOOST_AUTO_TEST_CASE( variant_iterator_steady_state_allocation_budget ) {
+  auto reader = SingleVariantReader{"testdata/test_variants.bcf"};
+  auto iterator = reader.begin();
+  const auto end = reader.end();
+  const auto scope = AllocationScope{};
+  auto records = 0u;
+  auto checksum = 0u;
+  for (++iterator; iterator != end; ++iterator) {
+    checksum += (*iterator).alignment_start();
+    ++records;
+  }
+  const auto allocations = scope.allocations();
+  // the record buffers are reused, so only the occasional growth of a buffer is acceptable (never one or more per record)
+  BOOST_CHECK_EQUAL(records, 6u);
+  BOOST_CHECK(checksum > 0u);
+  BOOST_CHECK_LT(allocations, records);
+}
+
+BOOST_AUTO_TEST_CASE( variant_builder_build_into_steady_state_does_not_allocate ) {
+  const auto header = SingleVariantReader{"testdata/test_variants_for_variantbuilder.vcf"}.header();
+  auto builder = VariantBuilder{header};
+  auto variant = Variant{};
+  builder.set_chromosome(0).set_alignment_start(1).set_ref_allele("A").set_alt_allele("C").build_into(variant);  // sizes the buffers
+  const auto scope = AllocationScope{};
+  auto checksum = 0u;
+  for (auto record = 2u; record < 100u; ++record) {
+    builder.clear().set_chromosome(0).set_alignment_start(record).set_ref_allele("A").set_alt_allele("C").build_into(variant);
+    checksum += variant.alignment_start();
+  }
+  const auto allocations = scope.allocations();
+  BOOST_CHECK(checksum > 0u);
+  BOOST_CHECK_EQUAL(allocations, 0u);
+}
@@ -0,0 +1,121 @@
+#include "variant/field_handle.h"
+#include "variant/variant_reader.h"
+#include "variant/indexed_variant_reader.h"
+#include "variant/indexed_variant_iterator.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace gamgee;
+
+// the records of test.g.vcf have different FORMAT and INFO lists, so a stale field table would return the wrong fields
+const auto field_handle_inputs = vector<string>{"testdata/test_variants.vcf", "testdata/test_variants.bcf", "testdata/test.g.vcf"};
+
+BOOST_AUTO_TEST_CASE( field_handle_against_tag_accessors ) {
+  for (const auto& filename : field_handle_inputs) {
+    auto reader = SingleVariantReader{filename};
+    const auto header = reader.header();
+    const auto gq = FieldHandle<int32_t>::individual(header, "GQ");
+    const auto pl = FieldHandle<int32_t>::individual(header, "PL");
+    const auto dp = FieldHandle<int32_t>::individual(header, "DP");
+    const auto individual_af = FieldHandle<float>::individual(header, "AF");
+    const auto as = FieldHandle<string>::individual(header, "AS");
+    const auto an = FieldHandle<int32_t>::shared(header, "AN");
+    const auto shared_af = FieldHandle<float>::shared(header, "AF");
+    const auto desc = FieldHandle<string>::shared(header, "DESC");
+    const auto end = FieldHandle<int32_t>::shared(header, "END");
+    for (const auto& record : reader) {
+      const auto copy = record;   // a fresh copy builds its own field table
+      // in a different order than above, to look fields up both before and after the table is built
+      BOOST_CHECK(record.shared_field(end) == copy.shared_field_as_integer("END"));
+      BOOST_CHECK(record.individual_field(dp) == copy.individual_field_as_integer("DP"));
+      BOOST_CHECK(record.individual_field(gq) == copy.integer_individual_field("GQ"));
+      BOOST_CHECK(record.individual_field(pl) == copy.integer_individual_field("PL"));
+      BOOST_CHECK(record.individual_field(individual_af) == copy.float_individual_field("AF"));
+      BOOST_CHECK(record.individual_field(as) == copy.string_individual_field("AS"));
+      BOOST_CHECK(record.shared_field(an) == copy.integer_shared_field("AN"));
+      BOOST_CHECK(record.shared_field(shared_af) == copy.float_shared_field("AF"));
+      BOOST_CHECK(record.shared_field(desc) == copy.string_shared_field("DESC"));
+      BOOST_CHECK_EQUAL(record.individual_field(dp).empty(), copy.individual_field_as_integer("DP").empty());
+      BOOST_CHECK_EQUAL(record.shared_field(end).empty(), copy.shared_field_as_integer("END").empty());
+      BOOST_CHECK_EQUAL(record.boolean_shared_field("VALIDATED"), copy.boolean_shared_field(header.field_index("VALIDATED")));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( field_handle_known_values ) {
+  auto reader = SingleVariantReader{"testdata/test.g.vcf"};
+  const auto header = reader.header();
+  const auto gq = FieldHandle<int32_t>::individual(header, "GQ");
+  const auto dp = FieldHandle<int32_t>::individual(header, "DP");
+  const auto an = FieldHandle<int32_t>::shared(header, "AN");
+  const auto end = FieldHandle<int32_t>::shared(header, "END");
+  BOOST_CHECK(gq.present());
+  BOOST_CHECK(gq.is_individual());
+  BOOST_CHECK(end.is_shared());
+  BOOST_CHECK_EQUAL(gq.index(), header.field_index("GQ"));
+  BOOST_CHECK_EQUAL(gq.type(), BCF_HT_INT);
+  auto gqs = vector<int32_t>{};
+  auto dps = vector<bool>{};
+  auto ans = vector<bool>{};
+  auto ends = vector<int32_t>{};
+  for (const auto& record : reader) {
+    gqs.push_back(record.individual_field(gq)[2][0]);
+    dps.push_back(!record.individual_field(dp).empty());
+    ans.push_back(!record.shared_field(an).empty());
+    ends.push_back(record.shared_field(end).empty() ? -1 : record.shared_field(end)[0]);
+  }
+  BOOST_CHECK(gqs == (vector<int32_t>{650, 0, 35}));
+  BOOST_CHECK(dps == (vector<bool>{false, true, false}));
+  BOOST_CHECK(ans == (vector<bool>{true, false, true}));
+  BOOST_CHECK(ends == (vector<int32_t>{-1, 20000123, -1}));
+}
+
+BOOST_AUTO_TEST_CASE( field_handle_indexed_reader ) {
+  const auto filename = string{"testdata/var_idx/test_variants.bcf"};
+  auto reader = IndexedVariantReader<IndexedVariantIterator>{filename, {}};
+  const auto gq = FieldHandle<int32_t>::individual(reader.header(), "GQ");
+  auto handle_values = vector<int32_t>{};
+  for (const auto& record : reader)
+    for (const auto& value : record.individual_field(gq))
+      handle_values.push_back(value[0]);
+  auto tag_values = vector<int32_t>{};
+  for (const auto& record : SingleVariantReader{filename})
+    for (const auto& value : record.integer_individual_field("GQ"))
+      tag_values.push_back(value[0]);
+  BOOST_CHECK(handle_values == tag_values);
+}
+
+BOOST_AUTO_TEST_CASE( field_handle_errors_and_missing_fields ) {
+  auto reader = SingleVariantReader{"testdata/test_variants.vcf"};
+  const auto header = reader.header();
+  BOOST_CHECK_THROW(FieldHandle<float>::individual(header, "GQ"), runtime_error);
+  BOOST_CHECK_THROW(FieldHandle<int32_t>::shared(header, "DESC"), runtime_error);
+  const auto not_there = FieldHandle<int32_t>::individual(header, "NOT_THERE");
+  BOOST_CHECK(!not_there.present());
+  const auto info_only = FieldHandle<int32_t>::individual(header, "AN");   // AN is only a shared field
+  BOOST_CHECK(!info_only.present());
+  const auto unresolved = FieldHandle<int32_t>{};
+  const auto gq = FieldHandle<int32_t>::individual(header, "GQ");
+  const auto an = FieldHandle<int32_t>::shared(header, "AN");
+  for (const auto& record : reader) {
+    BOOST_CHECK(record.individual_field(not_there).empty());
+    BOOST_CHECK(record.individual_field(info_only).empty());
+    BOOST_CHECK(record.individual_field(unresolved).empty());
+    BOOST_CHECK_THROW(record.shared_field(gq), invalid_argument);
+    BOOST_CHECK_THROW(record.individual_field(an), invalid_argument);
+    // the raw accessors find the same bytes through a handle, an index or a tag, and nothing for the others
+    const auto raw_gq = record.raw_individual_field(gq);
+    BOOST_REQUIRE(raw_gq != nullptr);
+    BOOST_CHECK_EQUAL(raw_gq, record.raw_individual_field(uint32_t(header.field_index("GQ"))));
+    BOOST_CHECK_EQUAL(raw_gq, record.raw_individual_field("GQ"));
+    BOOST_CHECK_EQUAL(raw_gq->id, header.field_index("GQ"));
+    BOOST_CHECK(record.raw_individual_field(not_there) == nullptr);
+    BOOST_CHECK(record.raw_individual_field(an) == nullptr);
+    BOOST_CHECK_EQUAL(uint32_t(record.raw_body()->n_sample), record.n_samples());
+  }
+}
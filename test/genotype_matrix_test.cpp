@@ -0,0 +1,91 @@
+#include "variant/genotype_matrix.h"
+#include "variant/variant_reader.h"
+#include "missing.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace gamgee;
+
+const auto genotype_matrix_inputs = vector<string>{"testdata/test_variants.vcf", "testdata/test_variants.bcf", "testdata/test_variants_alternate_ploidy.vcf",
+                                                   "testdata/test_variants_mixed_ploidy.vcf", "testdata/test_variants_multiple_alt.vcf", "testdata/test_variants_missing_data.vcf"};
+
+// the slow but obvious implementation: through the Genotype API
+vector<int8_t> expected_column(const Variant& record, const GenotypeMatrixEncoding encoding, const int32_t allele) {
+  auto column = vector<int8_t>{};
+  for (const auto& genotype : record.genotypes()) {
+    auto count = int8_t{0};
+    auto missing_allele = false;
+    for (const auto key : genotype.allele_keys()) {
+      missing_allele |= missing(key);
+      count += encoding == GenotypeMatrixEncoding::DOSAGE ? key > 0 : key == allele;
+    }
+    column.push_back(missing_allele || genotype.size() == 0 ? GenotypeMatrix::missing : count);
+  }
+  return column;
+}
+
+void check_genotype_matrix(const GenotypeMatrixEncoding encoding, const uint32_t allele) {
+  const auto builder = GenotypeMatrixBuilder{encoding, allele};
+  for (const auto& filename : genotype_matrix_inputs) {
+    auto reader = SingleVariantReader{filename};
+    auto matrix = GenotypeMatrix{reader.header().n_samples(), 100};
+    auto it = reader.begin();
+    const auto end = reader.end();
+    const auto n_variants = builder.fill(it, end, matrix);
+    BOOST_CHECK(n_variants > 0u);
+    auto variant = 0u;
+    for (const auto& record : SingleVariantReader{filename}) {
+      const auto expected = expected_column(record, encoding, allele);
+      BOOST_REQUIRE_EQUAL(expected.size(), matrix.n_samples());
+      for (auto sample = 0u; sample < matrix.n_samples(); ++sample)
+        BOOST_CHECK_EQUAL(int(matrix(sample, variant)), int(expected[sample]));
+      ++variant;
+    }
+    BOOST_CHECK_EQUAL(n_variants, variant);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( genotype_matrix_dosage )          { check_genotype_matrix(GenotypeMatrixEncoding::DOSAGE, 1);       }
+BOOST_AUTO_TEST_CASE( genotype_matrix_allele_count )    { check_genotype_matrix(GenotypeMatrixEncoding::ALLELE_COUNT, 1); }
+BOOST_AUTO_TEST_CASE( genotype_matrix_second_alt_count ){ check_genotype_matrix(GenotypeMatrixEncoding::ALLELE_COUNT, 2); }
+BOOST_AUTO_TEST_CASE( genotype_matrix_ref_count )       { check_genotype_matrix(GenotypeMatrixEncoding::ALLELE_COUNT, 0); }
+
+BOOST_AUTO_TEST_CASE( genotype_matrix_known_values ) {
+  // first record of test_variants.vcf: 0/1 0/0 1/1
+  auto reader = SingleVariantReader{"testdata/test_variants.vcf"};
+  auto matrix = GenotypeMatrix{3, 1};
+  auto it = reader.begin();
+  const auto end = reader.end();
+  BOOST_CHECK_EQUAL(GenotypeMatrixBuilder{}.fill(it, end, matrix), 1u);
+  BOOST_CHECK_EQUAL(int(matrix(0, 0)), 1);
+  BOOST_CHECK_EQUAL(int(matrix(1, 0)), 0);
+  BOOST_CHECK_EQUAL(int(matrix(2, 0)), 2);
+}
+
+BOOST_AUTO_TEST_CASE( genotype_matrix_blocks ) {
+  auto reader = SingleVariantReader{"testdata/test_variants.bcf"};
+  auto matrix = GenotypeMatrix{reader.header().n_samples(), 3};
+  BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(matrix.data()) % GenotypeMatrix::alignment, 0u);
+  BOOST_CHECK_EQUAL(matrix.stride() % GenotypeMatrix::alignment, 0u);
+  const auto builder = GenotypeMatrixBuilder{};
+  auto it = reader.begin();
+  const auto end = reader.end();
+  auto blocks = vector<uint32_t>{};
+  while (const auto n_variants = builder.fill(it, end, matrix))
+    blocks.push_back(n_variants);
+  const auto expected = vector<uint32_t>{3, 3, 1};
+  BOOST_CHECK_EQUAL_COLLECTIONS(blocks.begin(), blocks.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE( genotype_matrix_sample_mismatch ) {
+  auto reader = SingleVariantReader{"testdata/test_variants.vcf"};
+  auto matrix = GenotypeMatrix{reader.header().n_samples() + 1, 3};
+  auto it = reader.begin();
+  const auto end = reader.end();
+  BOOST_CHECK_THROW(GenotypeMatrixBuilder{}.fill(it, end, matrix), invalid_argument);
+}
@@ -0,0 +1,141 @@
+#include "variant/genotype_summary.h"
+#include "variant/variant_reader.h"
+#include "missing.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace gamgee;
+
+const auto genotype_summary_inputs = vector<string>{"testdata/test_variants.vcf", "testdata/test_variants.bcf", "testdata/test_variants_alternate_ploidy.vcf",
+                                                    "testdata/test_variants_mixed_ploidy.vcf", "testdata/test_variants_multiple_alt.vcf", "testdata/test_variants_missing_data.vcf",
+                                                    "testdata/test_variants_phased.vcf"};
+
+// the slow but obvious implementation: through the allele keys of every Genotype
+void check_genotype_summary(const GenotypeSummary& summary, const Variant& record) {
+  auto hom_ref = 0u, het = 0u, hom_var = 0u, missing_samples = 0u, partially_missing = 0u;
+  auto allele_counts = vector<uint32_t>(record.n_alleles());
+  auto ploidy_counts = vector<uint32_t>(summary.max_ploidy() + 1);
+  for (const auto& genotype : record.genotypes()) {
+    const auto keys = genotype.allele_keys();
+    auto called = 0u;
+    auto mixed = false;
+    for (const auto key : keys) {
+      if (missing(key))
+        continue;
+      ++allele_counts[key];
+      ++called;
+      for (const auto other : keys)
+        mixed |= !missing(other) && other != key;
+    }
+    ++ploidy_counts[keys.size()];
+    if (called == 0) ++missing_samples;
+    else if (called < keys.size()) ++partially_missing;
+    else if (mixed) ++het;
+    else if (keys[0] == 0) ++hom_ref;
+    else ++hom_var;
+    // the Genotype API agrees for fully called diploids (or any called sample for the homozygous classes)
+    if (called == keys.size() && called > 0) {
+      BOOST_CHECK_EQUAL(genotype.hom_ref(), !mixed && keys[0] == 0);
+      BOOST_CHECK_EQUAL(genotype.hom_var(), !mixed && keys[0] != 0);
+      if (keys.size() == 2 && genotype.size() == 2)
+        BOOST_CHECK_EQUAL(genotype.het(), mixed);
+    }
+  }
+  BOOST_CHECK_EQUAL(summary.n_samples(), record.n_samples());
+  BOOST_CHECK_EQUAL(summary.hom_ref(), hom_ref);
+  BOOST_CHECK_EQUAL(summary.het(), het);
+  BOOST_CHECK_EQUAL(summary.hom_var(), hom_var);
+  BOOST_CHECK_EQUAL(summary.missing(), missing_samples);
+  BOOST_CHECK_EQUAL(summary.partially_missing(), partially_missing);
+  BOOST_CHECK_EQUAL(summary.called(), hom_ref + het + hom_var);
+  BOOST_REQUIRE_EQUAL(summary.n_alleles(), record.n_alleles());
+  auto allele_number = 0u;
+  for (auto allele = 0u; allele < record.n_alleles(); ++allele) {
+    BOOST_CHECK_EQUAL(summary.allele_count(allele), allele_counts[allele]);
+    allele_number += allele_counts[allele];
+  }
+  BOOST_CHECK_EQUAL(summary.allele_number(), allele_number);
+  BOOST_CHECK_EQUAL(summary.alt_allele_count(), allele_number - allele_counts[0]);
+  for (auto ploidy = 0u; ploidy <= summary.max_ploidy(); ++ploidy)
+    BOOST_CHECK_EQUAL(summary.ploidy_count(ploidy), ploidy_counts[ploidy]);
+}
+
+BOOST_AUTO_TEST_CASE( genotype_summary_against_allele_keys ) {
+  auto summary = GenotypeSummary{};
+  for (const auto& filename : genotype_summary_inputs) {
+    for (const auto& record : SingleVariantReader{filename}) {
+      check_genotype_summary(GenotypeSummary{record}, record);
+      summary.assign(record);   // reusing the same object across sites
+      check_genotype_summary(summary, record);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( genotype_summary_known_values ) {
+  auto reader = SingleVariantReader{"testdata/test_variants_phased.vcf"};
+  auto it = reader.begin();
+
+  // 0|1 1|1 0/1 ./. 0|0
+  auto summary = GenotypeSummary{*it};
+  BOOST_CHECK_EQUAL(summary.hom_ref(), 1u);
+  BOOST_CHECK_EQUAL(summary.het(), 2u);
+  BOOST_CHECK_EQUAL(summary.hom_var(), 1u);
+  BOOST_CHECK_EQUAL(summary.missing(), 1u);
+  BOOST_CHECK_EQUAL(summary.partially_missing(), 0u);
+  BOOST_CHECK_EQUAL(summary.allele_count(0), 4u);
+  BOOST_CHECK_EQUAL(summary.allele_count(1), 4u);
+  BOOST_CHECK_EQUAL(summary.allele_number(), 8u);
+  BOOST_CHECK_CLOSE(summary.allele_frequency(1), 0.5, 1e-9);
+  BOOST_CHECK_EQUAL(summary.max_ploidy(), 2u);
+  BOOST_CHECK_EQUAL(summary.ploidy_count(2), 5u);
+  BOOST_CHECK_EQUAL(summary.phased(), 3u);
+  BOOST_CHECK_CLOSE(summary.phased_fraction(), 0.6, 1e-9);
+
+  // 1|2 0 .|1 2/2 0|0
+  ++it;
+  summary.assign(*it);
+  BOOST_CHECK_EQUAL(summary.hom_ref(), 2u);
+  BOOST_CHECK_EQUAL(summary.het(), 1u);
+  BOOST_CHECK_EQUAL(summary.hom_var(), 1u);
+  BOOST_CHECK_EQUAL(summary.missing(), 0u);
+  BOOST_CHECK_EQUAL(summary.partially_missing(), 1u);
+  BOOST_CHECK_EQUAL(summary.allele_count(0), 3u);
+  BOOST_CHECK_EQUAL(summary.allele_count(1), 2u);
+  BOOST_CHECK_EQUAL(summary.allele_count(2), 3u);
+  BOOST_CHECK_EQUAL(summary.alt_allele_count(), 5u);
+  BOOST_CHECK_EQUAL(summary.allele_number(), 8u);
+  BOOST_CHECK_EQUAL(summary.ploidy_count(1), 1u);
+  BOOST_CHECK_EQUAL(summary.ploidy_count(2), 4u);
+  BOOST_CHECK_EQUAL(summary.phased(), 3u);
+  BOOST_CHECK_CLOSE(summary.phased_fraction(), 0.75, 1e-9);
+
+  // 0|0|1 1/1/1 0|0 . 1
+  ++it;
+  summary.assign(*it);
+  BOOST_CHECK_EQUAL(summary.hom_ref(), 1u);
+  BOOST_CHECK_EQUAL(summary.het(), 1u);
+  BOOST_CHECK_EQUAL(summary.hom_var(), 2u);
+  BOOST_CHECK_EQUAL(summary.missing(), 1u);
+  BOOST_CHECK_EQUAL(summary.allele_count(0), 4u);
+  BOOST_CHECK_EQUAL(summary.allele_count(1), 5u);
+  BOOST_CHECK_EQUAL(summary.allele_number(), 9u);
+  BOOST_CHECK_EQUAL(summary.max_ploidy(), 3u);
+  BOOST_CHECK_EQUAL(summary.ploidy_count(1), 2u);
+  BOOST_CHECK_EQUAL(summary.ploidy_count(2), 1u);
+  BOOST_CHECK_EQUAL(summary.ploidy_count(3), 2u);
+  BOOST_CHECK_EQUAL(summary.ploidy_count(4), 0u);
+  BOOST_CHECK_EQUAL(summary.phased(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE( genotype_summary_empty ) {
+  const auto summary = GenotypeSummary{};
+  BOOST_CHECK_EQUAL(summary.n_samples(), 0u);
+  BOOST_CHECK_EQUAL(summary.allele_number(), 0u);
+  BOOST_CHECK_EQUAL(summary.alt_allele_count(), 0u);
+  BOOST_CHECK_EQUAL(summary.max_ploidy(), 0u);
+  BOOST_CHECK_EQUAL(summary.phased_fraction(), 0.0);
+}
@@ -0,0 +1,126 @@
+#include "variant/gvcf_combiner.h"
+#include "variant/multiple_variant_reader.h"
+#include "variant/reference_block_splitting_variant_iterator.h"
+#include "missing.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace gamgee;
+
+using GVCFReader = MultipleVariantReader<ReferenceBlockSplittingVariantIterator>;
+
+// SAMPLE1 has a SNP at 106 inside a reference block, SAMPLE2 has a deletion at 104 (ACG -> A)
+const auto combiner_test_files = vector<string>{"testdata/gvcf_combiner/sample1.g.vcf", "testdata/gvcf_combiner/sample2.g.vcf"};
+
+void check_values(const IndividualFieldValue<int32_t>& values, const vector<int32_t>& truth) {
+  BOOST_REQUIRE_EQUAL(values.size(), truth.size());
+  for (auto i = 0u; i < truth.size(); ++i)
+    BOOST_CHECK_EQUAL(values[i], truth[i]);
+}
+
+BOOST_AUTO_TEST_CASE( gvcf_combiner_combines_split_positions ) {
+  auto reader = GVCFReader{combiner_test_files};
+  auto combiner = GVCFCombiner{reader.get_variant_header_merger(), reader.get_input_vcf_headers()};
+  BOOST_CHECK_EQUAL(combiner.header().n_samples(), 2u);
+  auto combined = vector<Variant>{};
+  for (const auto& records : reader)
+    combined.push_back(combiner.combine(records));
+  BOOST_REQUIRE_EQUAL(combined.size(), 4u);
+
+  // both reference blocks, cut where the deletion starts
+  const auto& block = combined[0];
+  BOOST_CHECK_EQUAL(block.alignment_start(), 100u);
+  BOOST_CHECK_EQUAL(block.alignment_stop(), 103u);
+  BOOST_CHECK_EQUAL(block.ref(), "A");
+  BOOST_CHECK(block.alt() == vector<string>{"<NON_REF>"});
+  BOOST_CHECK_EQUAL(block.integer_shared_field("END")[0], 103);
+  check_values(block.integer_individual_field("PL")[0], {0, 30, 300});
+  check_values(block.integer_individual_field("PL")[1], {0, 24, 240});
+  BOOST_CHECK(block.genotypes()[0].hom_ref());
+  BOOST_CHECK(block.genotypes()[1].hom_ref());
+
+  // the reference block of SAMPLE1 takes the values of its <NON_REF> for the deletion allele
+  const auto& deletion = combined[1];
+  BOOST_CHECK_EQUAL(deletion.alignment_start(), 104u);
+  BOOST_CHECK_EQUAL(deletion.alignment_stop(), 106u);
+  BOOST_CHECK_EQUAL(deletion.ref(), "ACG");
+  BOOST_CHECK(deletion.alt() == (vector<string>{"A", "<NON_REF>"}));
+  BOOST_CHECK(deletion.genotypes()[0].hom_ref());
+  BOOST_CHECK(deletion.genotypes()[1].allele_keys() == (vector<int32_t>{1, 1}));
+  check_values(deletion.integer_individual_field("PL")[0], {0, 30, 300, 30, 300, 300});
+  check_values(deletion.integer_individual_field("PL")[1], {200, 27, 0, 210, 30, 220});
+  BOOST_CHECK(missing(deletion.integer_individual_field("AD")[0][0]));
+  check_values(deletion.integer_individual_field("AD")[1], {0, 9, 0});
+  check_values(deletion.integer_individual_field("SB")[1], {0, 0, 4, 5});
+  BOOST_CHECK_EQUAL(deletion.integer_individual_field("DP")[0][0], 10);
+  BOOST_CHECK_EQUAL(deletion.integer_individual_field("DP")[1][0], 9);
+
+  // only SAMPLE1 has a record at the SNP
+  const auto& snp = combined[2];
+  BOOST_CHECK_EQUAL(snp.alignment_start(), 106u);
+  BOOST_CHECK_EQUAL(snp.ref(), "C");
+  BOOST_CHECK(snp.alt() == (vector<string>{"T", "<NON_REF>"}));
+  BOOST_CHECK(snp.genotypes()[0].allele_keys() == (vector<int32_t>{0, 1}));
+  BOOST_CHECK(snp.genotypes()[1].missing());
+  check_values(snp.integer_individual_field("AD")[0], {5, 6, 0});
+  check_values(snp.integer_individual_field("PL")[0], {120, 0, 150, 135, 168, 300});
+  check_values(snp.integer_individual_field("SB")[0], {2, 3, 3, 3});
+  BOOST_CHECK(missing(snp.integer_individual_field("PL")[1][0]));
+
+  const auto& last_block = combined[3];
+  BOOST_CHECK_EQUAL(last_block.alignment_start(), 107u);
+  BOOST_CHECK_EQUAL(last_block.alignment_stop(), 110u);
+  BOOST_CHECK_EQUAL(last_block.integer_shared_field("END")[0], 110);
+  BOOST_CHECK_EQUAL(last_block.integer_individual_field("GQ")[0][0], 36);
+  BOOST_CHECK_EQUAL(last_block.integer_individual_field("GQ")[1][0], 27);
+}
+
+BOOST_AUTO_TEST_CASE( gvcf_combiner_merges_alleles_across_inputs ) {
+  // the SNPs at 41 and 102 (test3 and test4) are combined with the reference blocks of the other files
+  const auto filenames = vector<string>{"testdata/ref_block/test1.vcf", "testdata/ref_block/test2.vcf", "testdata/ref_block/test3.vcf",
+    "testdata/ref_block/test4.vcf", "testdata/ref_block/test5.vcf"};
+  auto reader = GVCFReader{filenames, false};
+  auto combiner = GVCFCombiner{reader.get_variant_header_merger(), reader.get_input_vcf_headers()};
+  auto n_positions = 0u;
+  for (const auto& records : reader) {
+    const auto combined = combiner.combine(records);
+    BOOST_CHECK_EQUAL(combined.alignment_start(), records[0].first.alignment_start());
+    BOOST_CHECK_EQUAL(combined.n_samples(), combiner.header().n_samples());
+    if (combined.alignment_start() == 41 || combined.alignment_start() == 102)
+      BOOST_CHECK(combined.alt() == (vector<string>{"C", "<NON_REF>"}));
+    ++n_positions;
+  }
+  BOOST_CHECK_EQUAL(n_positions, 18u);
+  BOOST_CHECK_THROW(combiner.combine(vector<VariantIndexPair>{}), invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE( gvcf_combiner_combines_into_the_same_record ) {
+  auto reader = GVCFReader{combiner_test_files};
+  auto combiner = GVCFCombiner{reader.get_variant_header_merger(), reader.get_input_vcf_headers()};
+  auto expected_reader = GVCFReader{combiner_test_files};
+  auto expected_combiner = GVCFCombiner{expected_reader.get_variant_header_merger(), expected_reader.get_input_vcf_headers()};
+  auto expected = expected_reader.begin();
+  auto combined = Variant{};
+  auto n_positions = 0u;
+  for (const auto& records : reader) {
+    combiner.combine_into(records, combined);
+    const auto truth = expected_combiner.combine(*expected);
+    BOOST_CHECK_EQUAL(combined.alignment_start(), truth.alignment_start());
+    BOOST_CHECK_EQUAL(combined.alignment_stop(), truth.alignment_stop());
+    BOOST_CHECK(combined.alt() == truth.alt());
+    BOOST_CHECK_EQUAL(combined.n_samples(), truth.n_samples());
+    for (auto sample = 0u; sample < truth.n_samples(); ++sample) {
+      BOOST_CHECK(combined.genotypes()[sample] == truth.genotypes()[sample]);
+      BOOST_CHECK(combined.integer_individual_field("PL")[sample] == truth.integer_individual_field("PL")[sample]);
+    }
+    ++expected;
+    ++n_positions;
+  }
+  BOOST_CHECK_EQUAL(n_positions, 4u);
+  BOOST_CHECK_THROW(combiner.combine_into(vector<VariantIndexPair>{}, combined), invalid_argument);
+}
@@ -0,0 +1,70 @@
+#include "utils/loser_tree.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace gamgee::utils;
+
+// merges the streams with a LoserTree, returning the (key, stream) pairs in the order they came out
+vector<pair<uint64_t, uint32_t>> loser_tree_merge(const vector<vector<uint64_t>>& streams) {
+  auto positions = vector<uint32_t>(streams.size(), 0);
+  auto keys = vector<uint64_t>{};
+  for (const auto& stream : streams)
+    keys.push_back(stream.empty() ? LoserTree::exhausted : stream[0]);
+  auto tree = LoserTree{keys};
+  BOOST_CHECK_EQUAL(tree.size(), streams.size());
+  auto result = vector<pair<uint64_t, uint32_t>>{};
+  while (!tree.empty()) {
+    const auto stream = tree.top();
+    result.emplace_back(tree.top_key(), stream);
+    const auto position = ++positions[stream];
+    tree.replace_top(position < streams[stream].size() ? streams[stream][position] : LoserTree::exhausted);
+  }
+  return result;
+}
+
+// the merge must be sorted by key, with ties in stream order
+vector<pair<uint64_t, uint32_t>> sorted_merge(const vector<vector<uint64_t>>& streams) {
+  auto result = vector<pair<uint64_t, uint32_t>>{};
+  for (auto stream = 0u; stream < streams.size(); ++stream)
+    for (const auto key : streams[stream])
+      result.emplace_back(key, stream);
+  sort(result.begin(), result.end());
+  return result;
+}
+
+BOOST_AUTO_TEST_CASE( loser_tree_merges_streams ) {
+  const auto inputs = vector<vector<vector<uint64_t>>>{
+    {},
+    {{}},
+    {{1, 2, 3}},
+    {{1, 4, 7}, {2, 5, 8}, {3, 6, 9}},
+    {{5, 5, 5}, {5, 5}, {}, {5}},
+    {{}, {1}, {}, {1, 2}, {0, 2}},
+    {{10, 20}, {1, 2, 3, 4, 5, 6, 7}, {15}, {0, 30}, {2, 2}, {}, {21}}
+  };
+  for (const auto& streams : inputs)
+    BOOST_CHECK(loser_tree_merge(streams) == sorted_merge(streams));
+}
+
+BOOST_AUTO_TEST_CASE( loser_tree_many_streams ) {
+  // every stream size from 1 to 40 exercises trees with and without a power of two number of leaves
+  for (auto n_streams = 1u; n_streams <= 40; ++n_streams) {
+    auto streams = vector<vector<uint64_t>>(n_streams);
+    for (auto stream = 0u; stream < n_streams; ++stream)
+      for (auto value = 0u; value < stream % 5; ++value)
+        streams[stream].push_back((stream * 7 + value * 3) % 11 + value * 11);
+    BOOST_CHECK(loser_tree_merge(streams) == sorted_merge(streams));
+  }
+}
+
+BOOST_AUTO_TEST_CASE( loser_tree_location_keys ) {
+  BOOST_CHECK(LoserTree::location_key(0, 0) < LoserTree::location_key(0, 1));
+  BOOST_CHECK(LoserTree::location_key(0, 2000000000) < LoserTree::location_key(1, 0));
+  BOOST_CHECK(LoserTree::location_key(3, 100) < LoserTree::exhausted);
+  BOOST_CHECK(LoserTree{}.empty());
+}
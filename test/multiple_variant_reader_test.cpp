@@ -2,9 +2,13 @@
 #include "variant/variant_header_builder.h"
 #include "variant/multiple_variant_reader.h"
 #include "variant/multiple_variant_iterator.h"
+#include "variant/budgeted_variant_inputs.h"
+#include "variant/reference_block_splitting_variant_iterator.h"
 #include "test_utils.h"
 
 #include <boost/test/unit_test.hpp>
+#include <stdexcept>
+#include <tuple>
 #include <unordered_set>
 
 using namespace std;
@@ -155,6 +159,164 @@ BOOST_AUTO_TEST_CASE( gvcf_test_multiple ) {
   }
 }
 
+BOOST_AUTO_TEST_CASE( multiple_variant_reader_recycled_records ) {
+  // the records of test.g.vcf have different FORMAT lists, so a recycled record with stale fields would show here
+  auto has_dp = vector<vector<bool>>(2);
+  auto reader = MultipleVariantReader<MultipleVariantIterator>{vector<string>{"testdata/test.g.vcf", "testdata/test.g.bcf"}};
+  for (auto& vec : reader) {
+    for (const auto& pair : vec)
+      has_dp[pair.second].push_back(!pair.first.integer_individual_field("DP").empty());
+  }
+  for (const auto& file_has_dp : has_dp)
+    BOOST_CHECK(file_has_dp == (vector<bool>{false, true, false}));
+}
+
+BOOST_AUTO_TEST_CASE( multiple_variant_reader_retained_records ) {
+  auto moved = vector<Variant>{};
+  auto copied = vector<Variant>{};
+  auto gqs = vector<IndividualField<IndividualFieldValue<int32_t>>>{};
+  auto reader = MultipleVariantReader<MultipleVariantIterator>{vector<string>{"testdata/test.g.vcf", "testdata/test.g.bcf"}};
+  for (auto& vec : reader) {
+    BOOST_REQUIRE_EQUAL(vec.size(), 2u);
+    copied.push_back(vec[0].first);
+    gqs.push_back(vec[0].first.integer_individual_field("GQ"));
+    moved.push_back(std::move(vec[1].first));
+  }
+  BOOST_REQUIRE_EQUAL(moved.size(), gvcf_truth_ref.size());
+  for (auto truth_index = 0u; truth_index < moved.size(); ++truth_index) {
+    for (const auto& record : {moved[truth_index], copied[truth_index]}) {
+      BOOST_CHECK_EQUAL(record.ref(), gvcf_truth_ref[truth_index]);
+      BOOST_CHECK_EQUAL(record.alignment_start(), gvcf_truth_alignment_starts[truth_index]);
+      BOOST_CHECK_EQUAL(record.alignment_stop(), gvcf_truth_alignment_stops[truth_index]);
+      BOOST_CHECK_EQUAL(record.id(), gvcf_truth_id[truth_index]);
+    }
+    BOOST_CHECK(gqs[truth_index] == copied[truth_index].integer_individual_field("GQ"));
+  }
+  BOOST_CHECK_EQUAL(gqs[0][2][0], 650);
+  BOOST_CHECK_EQUAL(gqs[2][2][0], 35);
+}
+
+// the (file index, location, reference allele) of every record of every vector, in order
+template<class ITERATOR>
+vector<vector<tuple<uint32_t, uint32_t, uint32_t, string>>> merged_records(const vector<string>& filenames, const VariantReaderOptions& options) {
+  auto result = vector<vector<tuple<uint32_t, uint32_t, uint32_t, string>>>{};
+  for (const auto& vec : MultipleVariantReader<ITERATOR>{filenames, false, options}) {
+    result.emplace_back();
+    for (const auto& pair : vec)
+      result.back().emplace_back(pair.second, pair.first.chromosome(), pair.first.alignment_start(), pair.first.ref());
+  }
+  return result;
+}
+
+BOOST_AUTO_TEST_CASE( multiple_variant_reader_decoding_threads ) {
+  const auto filenames = vector<string>{"testdata/test_variants.vcf", "testdata/test_variants_multiple_alt.vcf", "testdata/test.g.vcf", "testdata/test.g.bcf", "testdata/test_variants.bcf"};
+  for (const auto unpack_level : {VariantUnpackLevel::ALL, VariantUnpackLevel::INFO}) {
+    auto options = VariantReaderOptions{0, unpack_level};
+    const auto truth = merged_records<MultipleVariantIterator>(filenames, options);
+    const auto split_truth = merged_records<ReferenceBlockSplittingVariantIterator>(filenames, options);
+    BOOST_CHECK(!truth.empty());
+    for (const auto n_threads : {1u, 2u, 5u, 16u}) {
+      options.decoding_threads = n_threads;
+      BOOST_CHECK(merged_records<MultipleVariantIterator>(filenames, options) == truth);
+      BOOST_CHECK(merged_records<ReferenceBlockSplittingVariantIterator>(filenames, options) == split_truth);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( multiple_variant_reader_decoding_threads_fields_and_early_exit ) {
+  auto options = VariantReaderOptions{};
+  options.decoding_threads = 2;
+  auto truth_index = 0u;
+  for (const auto& vec : MultipleVariantReader<MultipleVariantIterator>{{"testdata/test_variants.vcf", "testdata/test_variants.bcf", "testdata/test_variants.vcf.gz"}, false, options}) {
+    BOOST_CHECK_EQUAL(vec.size(), 3u);
+    for (const auto& pair : vec) {
+      BOOST_CHECK_EQUAL(pair.first.alignment_start(), 10000000u);
+      BOOST_CHECK_EQUAL(pair.first.integer_individual_field("GQ").n_samples(), 3u);
+    }
+    ++truth_index;
+    break;   // leaves the workers blocked on full queues, which the iterator must stop and join
+  }
+  BOOST_CHECK_EQUAL(truth_index, 1u);
+}
+
+BOOST_AUTO_TEST_CASE( multiple_variant_reader_max_open_files ) {
+  // bgzipped vcfs are reopened like the bcfs
+  const auto filenames = vector<string>{"testdata/test_variants.bcf", "testdata/test.g.bcf", "testdata/var_idx/test_variants.bcf", "testdata/test_variants.vcf.gz",
+    "testdata/test.g.bcf", "testdata/var_idx/test_variants_csi.vcf.gz", "testdata/test_variants.bcf"};
+  const auto truth = merged_records<MultipleVariantIterator>(filenames, VariantReaderOptions{});
+  const auto split_truth = merged_records<ReferenceBlockSplittingVariantIterator>(filenames, VariantReaderOptions{});
+  for (const auto max_open_files : {1u, 2u, 4u}) {
+    for (const auto max_buffered_bytes : {uint64_t{1}, uint64_t{1} << 20}) {
+      auto options = VariantReaderOptions{};
+      options.max_open_files = max_open_files;
+      options.max_buffered_bytes = max_buffered_bytes;
+      BOOST_CHECK(merged_records<MultipleVariantIterator>(filenames, options) == truth);
+      BOOST_CHECK(merged_records<ReferenceBlockSplittingVariantIterator>(filenames, options) == split_truth);
+    }
+  }
+  // an uncompressed vcf can't be reopened, so it stays open on top of the others, and needs room in the budget
+  const auto pinned_filenames = vector<string>{"testdata/test_variants.bcf", "testdata/test.g.bcf", "testdata/test_variants.vcf", "testdata/var_idx/test_variants.bcf"};
+  const auto pinned_truth = merged_records<MultipleVariantIterator>(pinned_filenames, VariantReaderOptions{});
+  auto pinned_options = VariantReaderOptions{};
+  pinned_options.max_open_files = 2;
+  BOOST_CHECK(merged_records<MultipleVariantIterator>(pinned_filenames, pinned_options) == pinned_truth);
+  pinned_options.max_open_files = 1;
+  BOOST_CHECK_THROW(merged_records<MultipleVariantIterator>(pinned_filenames, pinned_options), invalid_argument);
+  // every iterator reads the files from the start again
+  auto options = VariantReaderOptions{};
+  options.max_open_files = 2;
+  const auto bcf_filenames = vector<string>{"testdata/test_variants.bcf", "testdata/test.g.bcf", "testdata/var_idx/test_variants.bcf"};
+  auto truth_records = 0u;
+  for (const auto& vec : MultipleVariantReader<MultipleVariantIterator>{bcf_filenames, false})
+    truth_records += vec.size();
+  const auto reader = MultipleVariantReader<MultipleVariantIterator>{bcf_filenames, false, options};
+  for (auto pass = 0u; pass < 2; ++pass) {
+    auto n_records = 0u;
+    for (const auto& vec : reader)
+      n_records += vec.size();
+    BOOST_CHECK_EQUAL(n_records, truth_records);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( budgeted_variant_inputs_open_files ) {
+  const auto filenames = vector<string>{"testdata/test_variants.bcf", "testdata/test.g.bcf", "testdata/test_variants.vcf.gz", "testdata/var_idx/test_variants.bcf", "testdata/test.g.bcf"};
+  auto files = vector<shared_ptr<htsFile>>{};
+  auto headers = vector<shared_ptr<bcf_hdr_t>>{};
+  auto offsets = vector<int64_t>{};
+  for (const auto& filename : filenames) {
+    auto* file_ptr = bcf_open(filename.c_str(), "r");
+    headers.push_back(utils::make_shared_variant_header(bcf_hdr_read(file_ptr)));
+    BOOST_CHECK(BudgetedVariantInputs::resumable(filename, file_ptr));
+    offsets.push_back(BudgetedVariantInputs::tell(file_ptr));
+    files.push_back(nullptr);
+    hts_close(file_ptr);
+  }
+  auto options = VariantReaderOptions{};
+  options.max_open_files = 2;
+  options.max_buffered_bytes = 1;   // one record per batch
+  auto inputs = BudgetedVariantInputs{filenames, files, headers, offsets, options};
+  BOOST_CHECK_EQUAL(inputs.open_files(), 0u);
+  auto starts = vector<vector<uint32_t>>(filenames.size());
+  auto record = utils::make_shared_variant(bcf_init1());
+  for (auto active = true; active; ) {
+    active = false;
+    for (auto input = 0u; input < filenames.size(); ++input) {
+      if (inputs.next(input, record)) {
+        starts[input].push_back(uint32_t(record->pos + 1));
+        active = true;
+      }
+      BOOST_CHECK_LE(inputs.open_files(), 2u);
+    }
+  }
+  BOOST_CHECK_EQUAL(inputs.open_files(), 0u);
+  for (auto input = 0u; input < filenames.size(); ++input) {
+    auto truth = vector<uint32_t>{};
+    for (const auto& variant : SingleVariantReader{filenames[input]})
+      truth.push_back(variant.alignment_start());
+    BOOST_CHECK(starts[input] == truth);
+  }
+}
+
 BOOST_AUTO_TEST_CASE( multiple_variant_reader_nonexistent_file ) {
   // Single non-existent file
   BOOST_CHECK_THROW(MultipleVariantReader<MultipleVariantIterator>(vector<string>{"foo/bar/nonexistent.vcf"}), FileOpenException);
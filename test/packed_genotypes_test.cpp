@@ -0,0 +1,125 @@
+#include "variant/packed_genotypes.h"
+#include "variant/variant_builder.h"
+#include "variant/variant_header_builder.h"
+#include "variant/variant_reader.h"
+#include "missing.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace gamgee;
+
+const auto packed_genotypes_inputs = vector<string>{"testdata/test_variants.vcf", "testdata/test_variants.bcf", "testdata/test_variants_alternate_ploidy.vcf",
+                                                    "testdata/test_variants_mixed_ploidy.vcf", "testdata/test_variants_multiple_alt.vcf", "testdata/test_variants_missing_data.vcf"};
+
+// the slow but obvious implementation: through the Genotype API
+PackedGenotype expected_code(const Genotype& genotype) {
+  const auto keys = genotype.allele_keys();
+  if (keys.empty())
+    return PackedGenotype::MISSING;
+  for (const auto key : keys)
+    if (missing(key))
+      return PackedGenotype::MISSING;
+  return genotype.hom_ref() ? PackedGenotype::HOM_REF : genotype.hom_var() ? PackedGenotype::HOM_VAR : PackedGenotype::HET;
+}
+
+void check_packed_genotypes(const PackedGenotypes& packed, const Variant& record) {
+  const auto genotypes = record.genotypes();
+  BOOST_REQUIRE_EQUAL(packed.n_samples(), genotypes.size());
+  auto expected = PackedGenotypeCounts{0, 0, 0, 0};
+  for (auto sample = 0u; sample < genotypes.size(); ++sample) {
+    const auto code = expected_code(genotypes[sample]);
+    BOOST_CHECK(packed[sample] == code);
+    expected.hom_ref += code == PackedGenotype::HOM_REF;
+    expected.het += code == PackedGenotype::HET;
+    expected.hom_var += code == PackedGenotype::HOM_VAR;
+    expected.missing += code == PackedGenotype::MISSING;
+  }
+  const auto counts = packed.counts();
+  BOOST_CHECK_EQUAL(counts.hom_ref, expected.hom_ref);
+  BOOST_CHECK_EQUAL(counts.het, expected.het);
+  BOOST_CHECK_EQUAL(counts.hom_var, expected.hom_var);
+  BOOST_CHECK_EQUAL(counts.missing, expected.missing);
+  const auto called = packed.n_samples() - expected.missing;
+  BOOST_CHECK_EQUAL(packed.allele_count(), expected.het + 2 * expected.hom_var);
+  BOOST_CHECK_EQUAL(packed.allele_number(), 2 * called);
+  BOOST_CHECK_CLOSE(packed.call_rate(), double(called) / packed.n_samples(), 1e-9);
+  BOOST_CHECK_CLOSE(packed.heterozygosity(), called == 0 ? 0.0 : double(expected.het) / called, 1e-9);
+  // a site against itself only fills the diagonal, with the counts
+  const auto table = genotype_count_table(packed, packed);
+  for (auto i = 0u; i < 4; ++i)
+    for (auto j = 0u; j < 4; ++j)
+      if (i != j)
+        BOOST_CHECK_EQUAL(table[i][j], 0u);
+  BOOST_CHECK_EQUAL(table[0][0], counts.hom_ref);
+  BOOST_CHECK_EQUAL(table[1][1], counts.het);
+  BOOST_CHECK_EQUAL(table[2][2], counts.hom_var);
+  BOOST_CHECK_EQUAL(table[3][3], counts.missing);
+}
+
+BOOST_AUTO_TEST_CASE( packed_genotypes_against_genotype_api ) {
+  auto packed = PackedGenotypes{};
+  for (const auto& filename : packed_genotypes_inputs) {
+    for (const auto& record : SingleVariantReader{filename}) {
+      check_packed_genotypes(PackedGenotypes{record}, record);
+      packed.assign(record);   // reusing the same object across sites
+      check_packed_genotypes(packed, record);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( packed_genotypes_known_values ) {
+  // first record of test_variants.vcf: 0/1 0/0 1/1
+  const auto record = *(SingleVariantReader{"testdata/test_variants.vcf"}.begin());
+  const auto packed = PackedGenotypes{record};
+  BOOST_CHECK(packed[0] == PackedGenotype::HET);
+  BOOST_CHECK(packed[1] == PackedGenotype::HOM_REF);
+  BOOST_CHECK(packed[2] == PackedGenotype::HOM_VAR);
+  BOOST_REQUIRE_EQUAL(packed.words().size(), 1u);
+  BOOST_CHECK_EQUAL(packed.words()[0], 0x21u);   // 10 00 01
+  BOOST_CHECK_EQUAL(packed.allele_count(), 3u);
+  BOOST_CHECK_EQUAL(packed.allele_number(), 6u);
+}
+
+BOOST_AUTO_TEST_CASE( packed_genotypes_multiple_words ) {
+  // 70 samples span three words, the last one only partially used
+  const auto n_samples = 70u;
+  auto header_builder = VariantHeaderBuilder{};
+  header_builder.add_chromosome("1").add_individual_field("GT", "1", "String");
+  for (auto sample = 0u; sample < n_samples; ++sample)
+    header_builder.add_sample("S" + to_string(sample));
+  const auto header = header_builder.build();
+  auto builder = VariantBuilder{header};
+  builder.set_chromosome(0).set_alignment_start(1).set_ref_allele("A").set_alt_alleles({"C"});
+  auto first_genotypes = vector<vector<int32_t>>{};
+  auto second_genotypes = vector<vector<int32_t>>{};
+  const auto calls = vector<vector<int32_t>>{{0, 0}, {0, 1}, {1, 1}, {-1, -1}};
+  for (auto sample = 0u; sample < n_samples; ++sample) {
+    first_genotypes.push_back(calls[sample % 4]);
+    second_genotypes.push_back(calls[sample % 3]);
+  }
+  const auto first = builder.set_genotypes(first_genotypes).build();
+  const auto second = builder.set_genotypes(second_genotypes).build();
+  const auto first_packed = PackedGenotypes{first};
+  const auto second_packed = PackedGenotypes{second};
+  BOOST_CHECK_EQUAL(first_packed.words().size(), 3u);
+  check_packed_genotypes(first_packed, first);
+  check_packed_genotypes(second_packed, second);
+  auto expected = PackedGenotypeTable{};
+  for (auto sample = 0u; sample < n_samples; ++sample)
+    ++expected[sample % 4][sample % 3];
+  const auto table = genotype_count_table(first_packed, second_packed);
+  for (auto i = 0u; i < 4; ++i)
+    for (auto j = 0u; j < 4; ++j)
+      BOOST_CHECK_EQUAL(table[i][j], expected[i][j]);
+}
+
+BOOST_AUTO_TEST_CASE( packed_genotypes_sample_mismatch ) {
+  const auto first = *(SingleVariantReader{"testdata/test_variants.vcf"}.begin());
+  const auto second = *(SingleVariantReader{"testdata/test_variants_missing_data.vcf"}.begin());
+  BOOST_CHECK_THROW(genotype_count_table(PackedGenotypes{first}, PackedGenotypes{second}), invalid_argument);
+}
@@ -0,0 +1,132 @@
+#include "prefetching_reader.h"
+#include "fastq_reader.h"
+#include "sam/sam_reader.h"
+#include "variant/variant_reader.h"
+#include "variant/multiple_variant_reader.h"
+#include "variant/multiple_variant_iterator.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace gamgee;
+
+BOOST_AUTO_TEST_CASE( prefetching_sam_reader ) {
+  for (const auto lookahead : {1u, 3u, PrefetchingReader<SingleSamReader>::default_lookahead}) {
+    auto truth = vector<Sam>{};
+    for (const auto& record : SingleSamReader{"testdata/test_simple.bam"})
+      truth.push_back(record);
+    auto i = 0u;
+    for (const auto& record : PrefetchingReader<SingleSamReader>{SingleSamReader{"testdata/test_simple.bam"}, lookahead}) {
+      BOOST_REQUIRE_LT(i, truth.size());
+      BOOST_CHECK_EQUAL(record.name(), truth[i].name());
+      BOOST_CHECK_EQUAL(record.alignment_start(), truth[i].alignment_start());
+      BOOST_CHECK_EQUAL(record.bases().to_string(), truth[i].bases().to_string());
+      BOOST_CHECK_EQUAL(record.cigar().to_string(), truth[i].cigar().to_string());
+      ++i;
+    }
+    BOOST_CHECK_EQUAL(i, truth.size());
+  }
+}
+
+BOOST_AUTO_TEST_CASE( prefetching_variant_reader ) {
+  for (const auto& filename : {"testdata/test_variants.vcf", "testdata/test_variants.bcf"}) {
+    auto truth = vector<Variant>{};
+    for (const auto& record : SingleVariantReader{filename})
+      truth.push_back(record);
+    auto i = 0u;
+    auto reader = PrefetchingReader<SingleVariantReader>{SingleVariantReader{filename}, 2};
+    BOOST_CHECK_EQUAL(reader.reader().header().n_samples(), 3u);
+    for (const auto& record : reader) {
+      BOOST_REQUIRE_LT(i, truth.size());
+      BOOST_CHECK_EQUAL(record.alignment_start(), truth[i].alignment_start());
+      BOOST_CHECK_EQUAL(record.ref(), truth[i].ref());
+      const auto genotypes = record.genotypes();
+      const auto truth_genotypes = truth[i].genotypes();
+      BOOST_REQUIRE_EQUAL(genotypes.size(), truth_genotypes.size());
+      for (auto sample = 0u; sample < genotypes.size(); ++sample)
+        BOOST_CHECK(genotypes[sample] == truth_genotypes[sample]);
+      ++i;
+    }
+    BOOST_CHECK_EQUAL(i, truth.size());
+  }
+}
+
+BOOST_AUTO_TEST_CASE( prefetching_multiple_variant_reader ) {
+  const auto filenames = vector<string>{"testdata/test_variants.vcf", "testdata/test_variants.bcf"};
+  auto positions = 0u;
+  for (const auto& vec : PrefetchingReader<MultipleVariantReader<MultipleVariantIterator>>{MultipleVariantReader<MultipleVariantIterator>{filenames, false}}) {
+    BOOST_CHECK_EQUAL(vec.size(), 2u);
+    BOOST_CHECK_EQUAL(vec[0].first.alignment_start(), vec[1].first.alignment_start());
+    ++positions;
+  }
+  BOOST_CHECK_EQUAL(positions, 7u);
+}
+
+BOOST_AUTO_TEST_CASE( prefetching_fastq_reader ) {
+  auto records = 0u;
+  for (const auto& record : PrefetchingReader<FastqReader>{FastqReader{"testdata/complete_same_seq.fq"}, 1}) {
+    BOOST_CHECK_EQUAL(record.sequence(), "ACAAGAGATTTAAGAC");
+    ++records;
+  }
+  BOOST_CHECK_EQUAL(records, 3u);
+}
+
+BOOST_AUTO_TEST_CASE( prefetching_reader_early_exit ) {
+  // the background thread is blocked on a full ring when the loop is abandoned: it must still be stopped and joined
+  auto records = 0u;
+  for (const auto& record : PrefetchingReader<SingleSamReader>{SingleSamReader{"testdata/test_simple.bam"}, 2}) {
+    BOOST_CHECK(!record.empty());
+    if (++records == 3)
+      break;
+  }
+  BOOST_CHECK_EQUAL(records, 3u);
+}
+
+// minimal reader producing the numbers 0, 1, 2, ... and throwing when it reaches a given number
+class ThrowingReader {
+ public:
+  class Iterator {
+   public:
+    Iterator() : m_value {0}, m_throw_at {0}, m_end {true} {}
+    explicit Iterator(const uint32_t throw_at) : m_value {0}, m_throw_at {throw_at}, m_end {throw_at == 0} {}
+    bool operator!=(const Iterator& rhs) const { return m_end != rhs.m_end; }
+    uint32_t& operator*() { return m_value; }
+    uint32_t& operator++() {
+      if (++m_value == m_throw_at)
+        throw runtime_error{"failed reading record " + to_string(m_value)};
+      return m_value;
+    }
+   private:
+    uint32_t m_value;
+    uint32_t m_throw_at;
+    bool m_end;
+  };
+
+  explicit ThrowingReader(const uint32_t throw_at) : m_throw_at {throw_at} {}
+  Iterator begin() const { return Iterator{m_throw_at}; }
+  Iterator end() const { return Iterator{}; }
+
+ private:
+  uint32_t m_throw_at;
+};
+
+BOOST_AUTO_TEST_CASE( prefetching_reader_propagates_exceptions ) {
+  for (const auto lookahead : {1u, 4u, 100u}) {
+    auto expected = 0u;
+    try {
+      for (const auto value : PrefetchingReader<ThrowingReader>{ThrowingReader{10}, lookahead}) {
+        BOOST_CHECK_EQUAL(value, expected);    // every record read before the failure is served, in order
+        ++expected;
+      }
+      BOOST_FAIL("the reader's exception was not propagated");
+    }
+    catch (const runtime_error& e) {
+      BOOST_CHECK_EQUAL(string{e.what()}, "failed reading record 10");
+    }
+    BOOST_CHECK_EQUAL(expected, 10u);
+  }
+}
@@ -5,6 +5,7 @@
 
 #include <unordered_set>
 
+#include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
 
 using namespace std;
@@ -96,6 +97,42 @@ void test_lut_base()
     }
   BOOST_CHECK_EQUAL(lut.get_input_idx_for_merged(5u,7), 4);
   BOOST_CHECK_EQUAL(lut.get_merged_idx_for_input(5u,4), 7);
+  //bulk access to all the mappings of an input
+  lut.add_input_merged_idx_pair(5u, 0, 2);
+  lut.add_input_merged_idx_pair(5u, 9, 16);   // input field 9 is out of range below
+  auto merged_idxs = std::vector<int>(10u);
+  lut.get_merged_idxs_for_input(5u, 10u, merged_idxs.data());
+  for(auto j=0u;j<10u;++j)
+  {
+    if(j == 0u) BOOST_CHECK_EQUAL(merged_idxs[j], 2);
+    else if(j == 4u) BOOST_CHECK_EQUAL(merged_idxs[j], 7);
+    else if(j == 9u) BOOST_CHECK_EQUAL(merged_idxs[j], 16);
+    else BOOST_CHECK(gamgee::missing(merged_idxs[j]));
+  }
+  auto input_idxs = std::vector<int>(17u);
+  lut.get_input_idxs_for_merged(5u, 17u, input_idxs.data());
+  for(auto j=0u;j<17u;++j)
+  {
+    if(j == 2u) BOOST_CHECK_EQUAL(input_idxs[j], 0);
+    else if(j == 7u) BOOST_CHECK_EQUAL(input_idxs[j], 4);
+    else if(j == 16u) BOOST_CHECK_EQUAL(input_idxs[j], 9);
+    else BOOST_CHECK(gamgee::missing(input_idxs[j]));
+  }
+  const auto input_values = std::vector<float>{10.0f, 11.0f, 12.0f, 13.0f, 14.0f};
+  auto merged_values = std::vector<float>(17u);
+  lut.gather_input_values(5u, input_values.data(), 5u, merged_values.data(), 17u, -1.0f);
+  for(auto j=0u;j<17u;++j)
+    BOOST_CHECK_EQUAL(merged_values[j], j == 2u ? 10.0f : j == 7u ? 14.0f : -1.0f);
+  lut.gather_input_values(5u, input_values.data(), 0u, merged_values.data(), 17u, -1.0f);
+  for(auto j=0u;j<17u;++j)
+    BOOST_CHECK_EQUAL(merged_values[j], -1.0f);
+  lut.gather_input_values(4u, input_values.data(), 5u, merged_values.data(), 17u, -1.0f);
+  for(auto j=0u;j<17u;++j)
+    BOOST_CHECK_EQUAL(merged_values[j], -1.0f);
+  lut.reset_merged_idx_for_input(5u, 0);
+  lut.reset_input_idx_for_merged(5u, 2);
+  lut.reset_merged_idx_for_input(5u, 9);
+  lut.reset_input_idx_for_merged(5u, 16);
   //reset 1 direction of the LUT
   lut.reset_merged_idx_for_input(5u, 4);
   BOOST_CHECK(gamgee::missing(lut.get_merged_idx_for_input(5u, 4)));
@@ -285,6 +322,102 @@ BOOST_AUTO_TEST_CASE( variant_header_merger_test )
     BOOST_CHECK_MESSAGE(variant_header_merger_test_path_counters[i] > 0u, "VariantHeaderMerger test path corresponding to "<<i<<" was not exercised\n");
 }
 
+//a unique file in the temporary directory, removed when it goes out of scope
+struct TemporaryFile
+{
+  TemporaryFile() : name{(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string()} { }
+  ~TemporaryFile() { boost::filesystem::remove(name); }
+  const string name;
+};
+
+template<class VariantHeaderMergerTy>
+void check_same_mappings(const VariantHeaderMergerTy& merger, const VariantHeaderMergerTy& truth, const vector<shared_ptr<bcf_hdr_t>>& headers)
+{
+  BOOST_CHECK(merger.get_merged_header() == truth.get_merged_header());
+  for(auto input_vcf_idx=0u;input_vcf_idx<headers.size();++input_vcf_idx)
+  {
+    for(auto i=0;i<headers[input_vcf_idx]->n[BCF_DT_ID];++i)
+      BOOST_CHECK_EQUAL(merger.get_merged_header_idx_for_input(input_vcf_idx, i), truth.get_merged_header_idx_for_input(input_vcf_idx, i));
+    for(auto i=0;i<bcf_hdr_nsamples(headers[input_vcf_idx]);++i)
+      BOOST_CHECK_EQUAL(merger.get_merged_sample_idx_for_input(input_vcf_idx, i), truth.get_merged_sample_idx_for_input(input_vcf_idx, i));
+  }
+}
+
+BOOST_AUTO_TEST_CASE( variant_header_merger_threads_and_cache_test )
+{
+  //identical headers (interned) interleaved with distinct ones
+  auto many_hdr_test_files = vector<string>{ "testdata/ref_block/test2.vcf", "testdata/var_hdr_merge/test1.vcf",
+    "testdata/ref_block/problem2_file2.vcf", "testdata/ref_block/test2.vcf", "testdata/var_hdr_merge/test3.vcf",
+    "testdata/var_hdr_merge/test1.vcf", "testdata/ref_block/problem2_file2.vcf", "testdata/ref_block/test2.vcf" };
+  auto reader = GVCFReader{many_hdr_test_files, false};
+  const auto& headers = reader.get_input_vcf_headers();
+  BOOST_CHECK_EQUAL(variant_header_fingerprint(headers[0].get()), variant_header_fingerprint(headers[3].get()));
+  BOOST_CHECK_NE(variant_header_fingerprint(headers[0].get()), variant_header_fingerprint(headers[1].get()));
+  InputOrderedVariantHeaderMerger sequential_merger;
+  for(const auto& header : headers)
+    sequential_merger.add_header(header);
+  InputOrderedVariantHeaderMerger threaded_merger;
+  threaded_merger.add_headers(vector<shared_ptr<bcf_hdr_t>>(headers.begin(), headers.begin()+2), 4u);
+  threaded_merger.add_headers(vector<shared_ptr<bcf_hdr_t>>(headers.begin()+2, headers.end()), 4u);
+  check_same_mappings(threaded_merger, sequential_merger, headers);
+  check_same_mappings(reader.get_variant_header_merger(), sequential_merger, headers);
+
+  const auto cache_file = TemporaryFile{};
+  InputOrderedVariantHeaderMerger cached_merger;
+  BOOST_CHECK(!cached_merger.read_cache(cache_file.name, headers));
+  sequential_merger.write_cache(cache_file.name);
+  BOOST_CHECK(!cached_merger.read_cache(cache_file.name, vector<shared_ptr<bcf_hdr_t>>(headers.rbegin(), headers.rend())));
+  BOOST_CHECK(cached_merger.get_raw_merged_header() == nullptr);
+  BOOST_REQUIRE(cached_merger.read_cache(cache_file.name, headers));
+  check_same_mappings(cached_merger, sequential_merger, headers);
+}
+
+shared_ptr<bcf_hdr_t> make_gvcf_header(const vector<string>& samples, const bool with_dp)
+{
+  auto header = utils::make_shared_variant_header(bcf_hdr_init("w"));
+  bcf_hdr_append(header.get(), "##contig=<ID=1,length=1000>");
+  bcf_hdr_append(header.get(), "##INFO=<ID=END,Number=1,Type=Integer,Description=\"Stop position of the interval\">");
+  bcf_hdr_append(header.get(), "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">");
+  if(with_dp)
+    bcf_hdr_append(header.get(), "##FORMAT=<ID=DP,Number=1,Type=Integer,Description=\"Read depth\">");
+  for(const auto& sample : samples)
+    bcf_hdr_add_sample(header.get(), sample.c_str());
+  bcf_hdr_sync(header.get());
+  return header;
+}
+
+BOOST_AUTO_TEST_CASE( variant_header_merger_same_lines_different_samples_test )
+{
+  //single sample gVCFs of a cohort: the same lines, different samples
+  const auto headers = vector<shared_ptr<bcf_hdr_t>>{ make_gvcf_header({"NA1"}, false), make_gvcf_header({"NA2"}, false),
+    make_gvcf_header({"NA3"}, true), make_gvcf_header({"NA4", "NA1"}, false), make_gvcf_header({"NA5"}, true) };
+  BOOST_CHECK_EQUAL(variant_header_lines_fingerprint(headers[0].get()), variant_header_lines_fingerprint(headers[1].get()));
+  BOOST_CHECK_NE(variant_header_lines_fingerprint(headers[0].get()), variant_header_lines_fingerprint(headers[2].get()));
+  BOOST_CHECK_NE(variant_header_samples_fingerprint(headers[0].get()), variant_header_samples_fingerprint(headers[1].get()));
+  BOOST_CHECK_NE(variant_header_fingerprint(headers[0].get()), variant_header_fingerprint(headers[1].get()));
+  InputOrderedVariantHeaderMerger sequential_merger;
+  for(const auto& header : headers)
+    sequential_merger.add_header(header);
+  InputOrderedVariantHeaderMerger threaded_merger;
+  threaded_merger.add_headers(headers, 4u);
+  check_same_mappings(threaded_merger, sequential_merger, headers);
+  for(const auto* merger : { &sequential_merger, &threaded_merger })
+  {
+    const auto merged_header = merger->get_raw_merged_header().get();
+    BOOST_REQUIRE_EQUAL(bcf_hdr_nsamples(merged_header), 5);
+    for(auto input_vcf_idx=0u;input_vcf_idx<headers.size();++input_vcf_idx)
+    {
+      const auto header = headers[input_vcf_idx].get();
+      //every sample and field maps to the one with the same name in the merged header
+      for(auto i=0;i<bcf_hdr_nsamples(header);++i)
+        BOOST_CHECK_EQUAL(string{merged_header->samples[merger->get_merged_sample_idx_for_input(input_vcf_idx, i)]}, string{header->samples[i]});
+      for(auto i=0;i<header->n[BCF_DT_ID];++i)
+        BOOST_CHECK_EQUAL(string{bcf_hdr_int2id(merged_header, BCF_DT_ID, merger->get_merged_header_idx_for_input(input_vcf_idx, i))},
+            string{bcf_hdr_int2id(header, BCF_DT_ID, i)});
+    }
+  }
+}
+
 BOOST_AUTO_TEST_CASE( reference_block_iterator_move_test ) {
   auto reader0 = MultipleVariantReader<ReferenceBlockSplittingVariantIterator>{test_files, false};
   auto iter0 = reader0.begin();
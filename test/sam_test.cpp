@@ -371,6 +371,27 @@ BOOST_AUTO_TEST_CASE( sam_templated_copy_and_move_constructors ) {
   BOOST_CHECK_NE(m1.alignment_start(), c2.alignment_start());  // check that modifying the moved doesn't affect the copied
 }
 
+BOOST_AUTO_TEST_CASE( sam_copy_assignment_reuses_unshared_records ) {
+  auto it = SingleSamReader{"testdata/test_simple.bam"}.begin();
+  const auto first = Sam{*it};
+  ++it;
+  const auto second = Sam{*it};
+  BOOST_REQUIRE_NE(first.alignment_start(), second.alignment_start());
+  auto destination = first;
+  destination = second;       // nothing else refers to the record: it is overwritten in place
+  BOOST_CHECK_EQUAL(destination.alignment_start(), second.alignment_start());
+  BOOST_CHECK(destination.cigar() == second.cigar());
+
+  // a field object taken from the record keeps the values it had
+  const auto cigar = destination.cigar();
+  const auto bases = destination.bases();
+  destination = first;
+  BOOST_CHECK_EQUAL(destination.alignment_start(), first.alignment_start());
+  BOOST_CHECK(cigar == second.cigar());
+  BOOST_CHECK(bases == second.bases());
+  BOOST_CHECK(destination.cigar() == first.cigar());
+}
+
 void check_read_alignment_starts_and_stops(const Sam& read, const uint32_t astart, const uint32_t astop, const uint32_t ustart, const uint32_t ustop) {
   BOOST_CHECK_EQUAL(read.alignment_start(), astart);
   BOOST_CHECK_EQUAL(read.alignment_stop(), astop);
@@ -2,6 +2,14 @@
 #include <boost/dynamic_bitset.hpp>
 #include "variant/variant_reader.h"
 #include "variant/variant.h"
+#include "variant/sample_predicate.h"
+#include "missing.h"
+#include "utils/utils.h"
+
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
 
 
 using namespace std;
@@ -57,3 +65,103 @@ BOOST_AUTO_TEST_CASE( select_if_shared_field ) {
     BOOST_CHECK_EQUAL(r2.count(), truth_af_counts[truth_index++]);
   }
 }
+
+// the slow but obvious implementation of a SamplePredicate: through select_if on the float conversion of the field
+dynamic_bitset<> expected_selection(const Variant& record, const string& tag, const uint32_t value_index, const bool select_missing, const std::function<bool (double)>& compare) {
+  const auto values = record.individual_field_as_float(tag);
+  auto result = dynamic_bitset<>(record.n_samples());
+  for (auto sample = 0u; sample < record.n_samples(); ++sample) {
+    auto is_missing = values.empty() || value_index >= values[sample].size();
+    auto value = 0.0f;
+    if (!is_missing) {
+      value = values[sample][value_index];
+      is_missing = missing(value) || utils::bcf_is_vector_end_value(value);
+    }
+    result[sample] = select_missing ? is_missing : !is_missing && compare(value);
+  }
+  return result;
+}
+
+BOOST_AUTO_TEST_CASE( sample_predicates_against_select_if ) {
+  const auto never = [](const double) { return false; };
+  const auto predicates = vector<pair<SamplePredicate, std::function<bool (double)>>>{
+    {SamplePredicate::less(35),               [](const double v) { return v < 35; }},
+    {SamplePredicate::less_equal(35),         [](const double v) { return v <= 35; }},
+    {SamplePredicate::greater(35),            [](const double v) { return v > 35; }},
+    {SamplePredicate::greater_equal(35),      [](const double v) { return v >= 35; }},
+    {SamplePredicate::equal(0),               [](const double v) { return v == 0; }},
+    {SamplePredicate::not_equal(0),           [](const double v) { return v != 0; }},
+    {SamplePredicate::greater(3.1),           [](const double v) { return v > 3.1; }},
+    {SamplePredicate::in_range(10, 100),      [](const double v) { return v >= 10 && v <= 100; }},
+    {SamplePredicate::out_of_range(10, 100),  [](const double v) { return v < 10 || v > 100; }},
+    {SamplePredicate::greater(1e9),           [](const double v) { return v > 1e9; }},
+    {SamplePredicate::missing(),              never}};
+  const auto fields = vector<pair<string, vector<string>>>{
+    {"testdata/test_variants.vcf",              {"GQ", "PL", "AF", "VLINT", "VLFLOAT", "DP"}},
+    {"testdata/test_variants.bcf",              {"GQ", "PL", "AF"}},
+    {"testdata/test_variants_02.vcf",           {"GQ", "PL", "AF"}},
+    {"testdata/test_variants_missing_data.vcf", {"AD", "DP", "GQ", "PL"}}};
+  for (const auto& file : fields) {
+    for (const auto& record : SingleVariantReader{file.first}) {
+      for (const auto& tag : file.second) {
+        for (auto value_index = 0u; value_index < 4u; ++value_index) {
+          for (auto i = 0u; i < predicates.size(); ++i) {
+            const auto select_missing = i == predicates.size() - 1;
+            const auto mask = predicates[i].first.select(record, tag, value_index);
+            BOOST_REQUIRE_EQUAL(mask.size(), record.n_samples());
+            const auto expected = expected_selection(record, tag, value_index, select_missing, predicates[i].second);
+            BOOST_CHECK(mask.to_dynamic_bitset() == expected);
+            BOOST_CHECK_EQUAL(mask.count(), expected.count());
+          }
+        }
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( sample_predicates_known_values ) {
+  // GQs of the first record of test_variants.vcf are 25, 12 and 650 (int16 encoded)
+  const auto record = *(SingleVariantReader{"testdata/test_variants.vcf"}.begin());
+  const auto high_gq = SamplePredicate::greater_equal(20).select(record, "GQ");
+  BOOST_CHECK(high_gq[0]);
+  BOOST_CHECK(!high_gq[1]);
+  BOOST_CHECK(high_gq[2]);
+  BOOST_CHECK_EQUAL(high_gq.count(), 2u);
+  // same field by index
+  const auto gq_index = record.header().field_index("GQ");
+  BOOST_CHECK(SamplePredicate::greater_equal(20).select(record, gq_index) == high_gq);
+  // second PL value: 0, 10 and 100
+  const auto pl = SamplePredicate::in_range(1, 10).select(record, "PL", 1);
+  BOOST_CHECK(!pl[0] && pl[1] && !pl[2]);
+  // a field absent from the header: every sample is missing
+  BOOST_CHECK_EQUAL(SamplePredicate::missing().select(record, "NOT_A_FIELD").count(), 3u);
+  BOOST_CHECK_EQUAL(SamplePredicate::greater(0).select(record, "NOT_A_FIELD").count(), 0u);
+  BOOST_CHECK_THROW(SamplePredicate::equal(0).select(record, "AS"), invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE( sample_mask_set_operations ) {
+  // 130 samples span three words, the last one only partially used
+  auto evens = SampleMask{130};
+  auto thirds = SampleMask{130};
+  for (auto sample = 0u; sample < 130; ++sample) {
+    if (sample % 2 == 0) evens.set(sample);
+    if (sample % 3 == 0) thirds.set(sample);
+  }
+  BOOST_CHECK_EQUAL(evens.count(), 65u);
+  BOOST_CHECK_EQUAL(thirds.count(), 44u);
+  BOOST_CHECK_EQUAL((evens & thirds).count(), 22u);
+  BOOST_CHECK_EQUAL((evens | thirds).count(), 87u);
+  BOOST_CHECK_EQUAL((evens ^ thirds).count(), 65u);
+  BOOST_CHECK_EQUAL(SampleMask{evens}.and_not(thirds).count(), 43u);
+  BOOST_CHECK_EQUAL((~evens).count(), 65u);
+  BOOST_CHECK_EQUAL(SampleMask(130, true).count(), 130u);
+  BOOST_CHECK_EQUAL(SampleMask(130, true).words().back(), 3u);   // unused bits stay cleared
+  BOOST_CHECK(~SampleMask(130, true) == SampleMask{130});
+  BOOST_CHECK(SampleMask{130}.none());
+  BOOST_CHECK(evens.any());
+  const auto bitset = evens.to_dynamic_bitset();
+  BOOST_CHECK_EQUAL(bitset.size(), 130u);
+  BOOST_CHECK_EQUAL(bitset.count(), 65u);
+  BOOST_CHECK(bitset[128] && !bitset[129]);
+  BOOST_CHECK_THROW(evens &= SampleMask{129}, invalid_argument);
+}
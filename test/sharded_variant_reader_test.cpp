@@ -0,0 +1,123 @@
+#include "variant/sharded_variant_reader.h"
+#include "variant/variant_reader.h"
+#include "exceptions.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace gamgee;
+
+using Position = pair<string, uint32_t>;
+
+const auto sharded_test_file = string{"testdata/var_idx/test_variants.bcf"};
+const auto sharded_test_files = vector<string>{sharded_test_file, "testdata/var_idx/test_variants_csi.vcf.gz", "testdata/var_idx/test_variants_tabix.vcf.gz"};
+
+vector<Position> flat_positions(const string& filename) {
+  auto positions = vector<Position>{};
+  for (const auto& record : SingleVariantReader{filename})
+    positions.emplace_back(record.chromosome_name(), record.alignment_start());
+  return positions;
+}
+
+vector<Position> shard_positions(const VariantShard& shard) {
+  auto positions = vector<Position>{};
+  for (const auto& record : shard)
+    positions.emplace_back(record.chromosome_name(), record.alignment_start());
+  return positions;
+}
+
+BOOST_AUTO_TEST_CASE( sharded_variant_reader_genome_windows ) {
+  const auto reader = ShardedVariantReader{sharded_test_file, 100000000u};
+  // contigs 1 (300Mb), 20 (64Mb) and 22 (120Mb)
+  BOOST_CHECK(reader.shards() == (vector<string>{"1:1-100000000", "1:100000001-200000000", "1:200000001-300000000",
+        "20:1-64000000", "22:1-100000000", "22:100000001-120000000"}));
+  BOOST_CHECK((ShardedVariantReader{sharded_test_file, 0u}.shards() == vector<string>{"1", "20", "22"}));
+  BOOST_CHECK_EQUAL(ShardedVariantIterator::interval_start("20:10,001,001-20000000"), 10001001u);
+  BOOST_CHECK_EQUAL(ShardedVariantIterator::interval_start("20"), 0u);
+}
+
+BOOST_AUTO_TEST_CASE( sharded_variant_reader_ordered_output ) {
+  for (const auto& filename : sharded_test_files) {
+    const auto expected = flat_positions(filename);
+    BOOST_REQUIRE_GT(expected.size(), 0u);
+    // the record at 20:10001000 overlaps the windows on both sides of 10001000 but must only be read once
+    const auto interval_sets = vector<vector<string>>{{}, {"1", "20", "22"}, {"1", "20:1-10001000", "20:10001001-200000000", "22"}};
+    for (const auto n_threads : {1u, 2u, 3u, 8u}) {
+      for (const auto& intervals : interval_sets) {
+        auto positions = vector<Position>{};
+        auto shard_indices = vector<uint32_t>{};
+        ShardedVariantReader{filename, intervals, n_threads}.ordered(
+            [](const VariantShard& shard) { return make_pair(shard.index(), shard_positions(shard)); },
+            [&](pair<uint32_t, vector<Position>>&& result) {
+              shard_indices.push_back(result.first);
+              positions.insert(positions.end(), result.second.begin(), result.second.end());
+            });
+        BOOST_CHECK(positions == expected);
+        BOOST_CHECK_EQUAL(shard_indices.size(), max<size_t>(intervals.size(), 1u));
+        for (auto i = 0u; i < shard_indices.size(); ++i)
+          BOOST_CHECK_EQUAL(shard_indices[i], i);
+      }
+      const auto reader = ShardedVariantReader{filename, 1000000u, n_threads};   // mostly empty windows
+      auto positions = vector<Position>{};
+      for (const auto& shard : reader.map_shards(shard_positions))
+        positions.insert(positions.end(), shard.begin(), shard.end());
+      BOOST_CHECK(positions == expected);
+      const auto n_records = reader.reduce(0u, [](uint32_t& count, const Variant&) { ++count; }, [](uint32_t& total, uint32_t&& count) { total += count; });
+      BOOST_CHECK_EQUAL(n_records, expected.size());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( sharded_variant_reader_unsorted_intervals_and_unpack_levels ) {
+  using Record = pair<Position, bool>;   // position and whether the record has its genotypes
+  for (const auto& filename : sharded_test_files) {
+    // the shards come back in the order of the intervals, even if it is not the order of the file
+    auto expected = vector<Position>{};
+    for (const auto& chromosome : {"22", "1"})
+      for (const auto& position : flat_positions(filename))
+        if (position.first == chromosome)
+          expected.push_back(position);
+    BOOST_REQUIRE_GT(expected.size(), 1u);
+    for (const auto unpack_level : {VariantUnpackLevel::INFO, VariantUnpackLevel::ALL}) {
+      for (const auto n_threads : {1u, 2u}) {
+        const auto reader = ShardedVariantReader{filename, {"22", "1"}, n_threads, VariantReaderOptions{0, unpack_level}};
+        auto records = vector<Record>{};
+        reader.ordered([](const VariantShard& shard) {
+              auto shard_records = vector<Record>{};
+              for (const auto& record : shard)
+                shard_records.emplace_back(Position{record.chromosome_name(), record.alignment_start()}, !record.genotypes().empty());
+              return shard_records;
+            },
+            [&records](vector<Record>&& shard_records) { records.insert(records.end(), shard_records.begin(), shard_records.end()); });
+        BOOST_REQUIRE_EQUAL(records.size(), expected.size());
+        for (auto i = 0u; i < records.size(); ++i) {
+          BOOST_CHECK(records[i].first == expected[i]);
+          BOOST_CHECK_EQUAL(records[i].second, unpack_level == VariantUnpackLevel::ALL);
+        }
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( sharded_variant_reader_errors ) {
+  for (const auto n_threads : {1u, 4u}) {
+    const auto reader = ShardedVariantReader{sharded_test_file, {"1", "20", "22"}, n_threads};
+    auto consumed = vector<uint32_t>{};
+    BOOST_CHECK_THROW(reader.ordered([](const VariantShard& shard) {
+          if (shard.index() == 1)
+            throw runtime_error{"shard error"};
+          return shard.index();
+        },
+        [&consumed](uint32_t&& index) { consumed.push_back(index); }), runtime_error);
+    BOOST_CHECK(consumed == (vector<uint32_t>{0}));   // the shards after the failing one are not consumed
+    BOOST_CHECK_THROW(reader.ordered([](const VariantShard& shard) { return shard.index(); },
+        [](uint32_t&&) { throw logic_error{"consumer error"}; }), logic_error);
+  }
+  BOOST_CHECK_THROW(ShardedVariantReader(string{"testdata/var_idx/missing.bcf"}, vector<string>{}), FileOpenException);
+  BOOST_CHECK_THROW(ShardedVariantReader(string{"testdata/test_variants.bcf"}, vector<string>{}), IndexLoadException);
+}
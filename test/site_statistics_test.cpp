@@ -0,0 +1,211 @@
+#include "variant/site_statistics.h"
+#include "variant/variant_reader.h"
+#include "missing.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace gamgee;
+
+void check_same_values(const vector<double>& actual, const vector<double>& expected) {
+  BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+  for (auto i = 0u; i < actual.size(); ++i) {
+    BOOST_CHECK_EQUAL(std::isnan(actual[i]), std::isnan(expected[i]));
+    if (!std::isnan(expected[i]))
+      BOOST_CHECK_EQUAL(actual[i], expected[i]);
+  }
+}
+
+void check_same_table(const SiteStatisticsTable& actual, const SiteStatisticsTable& expected) {
+  BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+  BOOST_CHECK(actual.chromosome == expected.chromosome);
+  BOOST_CHECK(actual.alignment_start == expected.alignment_start);
+  BOOST_CHECK(actual.allele_count == expected.allele_count);
+  BOOST_CHECK(actual.allele_number == expected.allele_number);
+  check_same_values(actual.allele_frequency, expected.allele_frequency);
+  check_same_values(actual.hwe_p_value, expected.hwe_p_value);
+  check_same_values(actual.excess_het_p_value, expected.excess_het_p_value);
+  check_same_values(actual.call_rate, expected.call_rate);
+  check_same_values(actual.mean_depth, expected.mean_depth);
+  check_same_values(actual.het_allele_balance, expected.het_allele_balance);
+  BOOST_CHECK_EQUAL(actual.totals.n_sites(), expected.totals.n_sites());
+  BOOST_CHECK_EQUAL(actual.totals.n_snps(), expected.totals.n_snps());
+  BOOST_CHECK_EQUAL(actual.totals.n_indels(), expected.totals.n_indels());
+  BOOST_CHECK_EQUAL(actual.totals.n_pass(), expected.totals.n_pass());
+  BOOST_CHECK_EQUAL(actual.totals.n_known(), expected.totals.n_known());
+  BOOST_CHECK_EQUAL(actual.totals.call_rate(), expected.totals.call_rate());
+  BOOST_CHECK_EQUAL(actual.totals.titv().transitions, expected.totals.titv().transitions);
+  BOOST_CHECK_EQUAL(actual.totals.titv().transversions, expected.totals.titv().transversions);
+}
+
+BOOST_AUTO_TEST_CASE( site_statistics_hardy_weinberg ) {
+  auto probabilities = vector<double>{};
+  // 4 diploids with 4 copies of each allele: P(0 hets) = 3/35, P(2 hets) = 24/35, P(4 hets) = 8/35
+  auto p = SiteStatisticsCalculator::hardy_weinberg(1, 2, 1, probabilities);
+  BOOST_CHECK_CLOSE(p.first, 1.0, 1e-9);
+  BOOST_CHECK_CLOSE(p.second, 32.0 / 35, 1e-9);
+  p = SiteStatisticsCalculator::hardy_weinberg(0, 4, 0, probabilities);
+  BOOST_CHECK_CLOSE(p.first, 11.0 / 35, 1e-9);
+  BOOST_CHECK_CLOSE(p.second, 8.0 / 35, 1e-9);
+  p = SiteStatisticsCalculator::hardy_weinberg(2, 0, 2, probabilities);
+  BOOST_CHECK_CLOSE(p.first, 3.0 / 35, 1e-9);
+  BOOST_CHECK_CLOSE(p.second, 1.0, 1e-9);
+  // monomorphic sites are always in equilibrium
+  p = SiteStatisticsCalculator::hardy_weinberg(100, 0, 0, probabilities);
+  BOOST_CHECK_CLOSE(p.first, 1.0, 1e-9);
+  BOOST_CHECK_CLOSE(p.second, 1.0, 1e-9);
+  // the hom var and hom ref counts are symmetric
+  const auto forward = SiteStatisticsCalculator::hardy_weinberg(800, 150, 50, probabilities);
+  const auto backward = SiteStatisticsCalculator::hardy_weinberg(50, 150, 800, probabilities);
+  BOOST_CHECK_CLOSE(forward.first, backward.first, 1e-9);
+  BOOST_CHECK_LT(forward.first, 1e-6);   // far too few hets
+  BOOST_CHECK_CLOSE(forward.second, 1.0, 1e-6);
+  p = SiteStatisticsCalculator::hardy_weinberg(0, 0, 0, probabilities);
+  BOOST_CHECK(std::isnan(p.first));
+  BOOST_CHECK(std::isnan(p.second));
+}
+
+BOOST_AUTO_TEST_CASE( site_statistics_known_values ) {
+  auto reader = SingleVariantReader{"testdata/test_variants.vcf"};
+  auto it = reader.begin();
+  auto calculator = SiteStatisticsCalculator{};
+
+  // T>C, 0/1 0/0 1/1, PASS, db2342
+  auto site = calculator.compute(*it);
+  BOOST_CHECK_EQUAL(site.chromosome, 0u);
+  BOOST_CHECK_EQUAL(site.alignment_start, 10000000u);
+  BOOST_CHECK_EQUAL(site.allele_count, 3u);
+  BOOST_CHECK_EQUAL(site.allele_number, 6u);
+  BOOST_CHECK_CLOSE(site.allele_frequency, 0.5, 1e-9);
+  BOOST_CHECK_EQUAL(site.called, 3u);
+  BOOST_CHECK_CLOSE(site.call_rate, 1.0, 1e-9);
+  BOOST_CHECK_CLOSE(site.hwe_p_value, 1.0, 1e-9);      // P(1 het) = 0.6, P(3 hets) = 0.4
+  BOOST_CHECK_CLOSE(site.excess_het_p_value, 1.0, 1e-9);
+  BOOST_CHECK(std::isnan(site.mean_depth));            // no DP
+  BOOST_CHECK(std::isnan(site.het_allele_balance));    // no AD
+  BOOST_CHECK(site.is_snp);
+  BOOST_CHECK(!site.is_indel);
+  BOOST_CHECK(!site.is_multiallelic);
+  BOOST_CHECK(site.is_pass);
+  BOOST_CHECK(site.is_known);
+  BOOST_CHECK_EQUAL(site.transitions, 1u);
+  BOOST_CHECK_EQUAL(site.transversions, 0u);
+  BOOST_CHECK_EQUAL(calculator.last_summary().het(), 1u);
+
+  // GG>AA is neither a SNP nor an indel
+  ++it;
+  site = calculator.compute(*it);
+  BOOST_CHECK(!site.is_snp);
+  BOOST_CHECK(!site.is_indel);
+  BOOST_CHECK_EQUAL(site.transitions + site.transversions, 0u);
+
+  // TAGTGQA>T deletion, LOW_QUAL, no ID
+  ++it;
+  site = calculator.compute(*it);
+  BOOST_CHECK(!site.is_snp);
+  BOOST_CHECK(site.is_indel);
+  BOOST_CHECK(!site.is_pass);
+  BOOST_CHECK(!site.is_known);
+}
+
+BOOST_AUTO_TEST_CASE( site_statistics_depths_and_annotation ) {
+  auto header_builder = VariantHeaderBuilder{};
+  header_builder.add_chromosome("1")
+                .add_individual_field("GT", "1", "String")
+                .add_individual_field("AD", "R", "Integer")
+                .add_individual_field("DP", "1", "Integer");
+  for (auto sample = 0u; sample < 4u; ++sample)
+    header_builder.add_sample("S" + to_string(sample));
+  SiteStatisticsCalculator::add_info_fields(header_builder);
+  const auto header = header_builder.build();
+  auto builder = VariantBuilder{header};
+  builder.set_chromosome(0).set_alignment_start(100).set_ref_allele("A").set_alt_alleles({"C"})
+         .set_genotypes(vector<vector<int32_t>>{{0, 1}, {0, 1}, {0, 0}, {1, 1}})
+         .set_integer_individual_field("AD", vector<vector<int32_t>>{{10, 5}, {6, 4}, {20, 0}, {0, 15}})
+         .set_integer_individual_field("DP", vector<vector<int32_t>>{{15}, {10}, {missing_values::int32}, {15}});
+  const auto record = builder.build();
+
+  auto calculator = SiteStatisticsCalculator{};
+  const auto& site = calculator.compute(record);
+  BOOST_CHECK_CLOSE(site.mean_depth, 40.0 / 3, 1e-9);         // the missing DP is skipped
+  BOOST_CHECK_CLOSE(site.het_allele_balance, 9.0 / 25, 1e-9); // only the two hets
+  BOOST_CHECK_CLOSE(site.hwe_p_value, 1.0, 1e-9);
+  BOOST_CHECK_CLOSE(site.excess_het_p_value, 32.0 / 35, 1e-9);
+  BOOST_CHECK_EQUAL(site.transversions, 1u);
+
+  calculator.annotate(builder);
+  const auto annotated = builder.build();
+  BOOST_CHECK_EQUAL(annotated.integer_shared_field("AC")[0], 3);
+  BOOST_CHECK_EQUAL(annotated.integer_shared_field("AN")[0], 8);
+  BOOST_CHECK_CLOSE(annotated.float_shared_field("AF")[0], 0.375, 1e-4);
+  BOOST_CHECK_CLOSE(annotated.float_shared_field("HWE")[0], 1.0, 1e-4);
+  BOOST_CHECK_CLOSE(annotated.float_shared_field("ExcHet")[0], 32.0 / 35, 1e-4);
+  BOOST_CHECK_CLOSE(annotated.float_shared_field("CallRate")[0], 1.0, 1e-4);
+  BOOST_CHECK_CLOSE(annotated.float_shared_field("MeanDP")[0], 40.0 / 3, 1e-4);
+  BOOST_CHECK_CLOSE(annotated.float_shared_field("HetAB")[0], 0.36, 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE( site_statistics_sites_only ) {
+  auto header_builder = VariantHeaderBuilder{};
+  header_builder.add_chromosome("1");
+  const auto header = header_builder.build();
+  auto builder = VariantBuilder{header};
+  builder.set_chromosome(0).set_alignment_start(100).set_ref_allele("A").set_alt_alleles({"G"});
+  const auto record = builder.build();
+
+  auto calculator = SiteStatisticsCalculator{};
+  const auto& site = calculator.compute(record);
+  BOOST_CHECK_EQUAL(site.called, 0u);
+  BOOST_CHECK(std::isnan(site.call_rate));
+  auto totals = SiteStatisticsAccumulator{};
+  totals.add(site, record.n_samples());
+  BOOST_CHECK_EQUAL(totals.n_sites(), 1u);
+  BOOST_CHECK_EQUAL(totals.n_snps(), 1u);
+  BOOST_CHECK_EQUAL(totals.call_rate(), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE( site_statistics_accumulator_merge ) {
+  auto all = SiteStatisticsAccumulator{};
+  auto first = SiteStatisticsAccumulator{};
+  auto second = SiteStatisticsAccumulator{};
+  auto calculator = SiteStatisticsCalculator{};
+  auto index = 0u;
+  for (const auto& record : SingleVariantReader{"testdata/test_variants.vcf"}) {
+    const auto& site = calculator.compute(record);
+    all.add(site, record.n_samples());
+    (index++ % 2 == 0 ? first : second).add(site, record.n_samples());
+  }
+  first.merge(second);
+  BOOST_CHECK_EQUAL(first.n_sites(), all.n_sites());
+  BOOST_CHECK_EQUAL(first.n_snps(), all.n_snps());
+  BOOST_CHECK_EQUAL(first.n_indels(), all.n_indels());
+  BOOST_CHECK_EQUAL(first.n_multiallelic(), all.n_multiallelic());
+  BOOST_CHECK_EQUAL(first.n_pass(), all.n_pass());
+  BOOST_CHECK_EQUAL(first.n_known(), all.n_known());
+  BOOST_CHECK_EQUAL(first.call_rate(), all.call_rate());
+  BOOST_CHECK_EQUAL(first.titv().transitions, all.titv().transitions);
+  BOOST_CHECK_EQUAL(first.titv().transversions, all.titv().transversions);
+  BOOST_CHECK_EQUAL(first.titv_pass().transitions + first.titv_filtered().transitions, all.titv().transitions);
+  BOOST_CHECK_EQUAL(first.titv_known().transversions + first.titv_novel().transversions, all.titv().transversions);
+  BOOST_CHECK_EQUAL(all.n_sites(), index);
+}
+
+BOOST_AUTO_TEST_CASE( site_statistics_engine_shards ) {
+  const auto filename = string{"testdata/var_idx/test_variants.bcf"};
+  auto reader = SingleVariantReader{filename};
+  const auto expected = SiteStatisticsEngine::stream(reader);
+  BOOST_CHECK_GT(expected.size(), 0u);
+  // the record at 20:10001000 overlaps both of the middle intervals but must only be counted once
+  const auto interval_sets = vector<vector<string>>{{"1", "20", "22"}, {"1", "20:1-10001000", "20:10001001-200000000", "22"}};
+  for (const auto& intervals : interval_sets) {
+    for (const auto n_threads : {1u, 3u, 8u}) {
+      const auto table = SiteStatisticsEngine{n_threads}.run(filename, intervals);
+      check_same_table(table, expected);
+    }
+  }
+  check_same_table(SiteStatisticsEngine{4}.run(filename, {}), expected);
+}
@@ -104,6 +104,54 @@ BOOST_AUTO_TEST_CASE( synced_variant_reader_sparse_test ) {
   BOOST_CHECK_EQUAL(pos_truth_index, 6u);
 }
 
+BOOST_AUTO_TEST_CASE( synced_variant_iterator_detach_test ) {
+  const auto reader = SyncedVariantReader<SyncedVariantIterator>{synced_variant_sparse_inputs, synced_variant_chrom_full};
+  auto detached = vector<vector<Variant>>{};
+  auto kept = vector<Variant>{};
+  for (auto it = reader.begin(); it != reader.end(); ++it) {
+    auto& vec = *it;
+    if (detached.size() % 2 == 0 && !missing(vec[0]))
+      kept.push_back(std::move(vec[0]));   // a moved record is never copied into again
+    detached.push_back(it.detach());
+    BOOST_CHECK_EQUAL((*it).size(), synced_variant_sparse_inputs.size());
+    for (const auto& record : *it)
+      BOOST_CHECK(missing(record));
+  }
+  BOOST_REQUIRE_EQUAL(detached.size(), 6u);
+  auto kept_index = 0u;
+  for (auto pos_index = 0u; pos_index < detached.size(); ++pos_index) {
+    for (auto record_index = 0u; record_index < detached[pos_index].size(); ++record_index) {
+      const auto kept_record = pos_index % 2 == 0 && record_index == 0 && synced_variant_sparse_truth_present[pos_index][0];
+      const auto& record = kept_record ? kept[kept_index++] : detached[pos_index][record_index];
+      BOOST_CHECK_EQUAL(!missing(record), synced_variant_sparse_truth_present[pos_index][record_index]);
+      if (!missing(record)) {
+        BOOST_CHECK_EQUAL(record.chromosome_name(), synced_variant_sparse_truth_chrom[pos_index]);
+        BOOST_CHECK_EQUAL(record.alignment_start(), synced_variant_sparse_truth_start[pos_index]);
+      }
+    }
+  }
+  BOOST_CHECK_EQUAL(kept_index, kept.size());
+
+  // without detaching or keeping anything, every reader copies its lines into the same record
+  auto bodies = vector<const bcf1_t*>(synced_variant_sparse_inputs.size(), nullptr);
+  auto n_reused = 0u;
+  const auto reusing_reader = SyncedVariantReader<SyncedVariantIterator>{synced_variant_sparse_inputs, synced_variant_chrom_full};
+  for (auto it = reusing_reader.begin(); it != reusing_reader.end(); ++it) {
+    const auto& vec = *it;
+    for (auto idx = 0u; idx < vec.size(); ++idx) {
+      if (missing(vec[idx]))
+        continue;
+      const auto body = vec[idx].raw_body();
+      if (bodies[idx]) {
+        BOOST_CHECK(body == bodies[idx]);
+        ++n_reused;
+      }
+      bodies[idx] = body;
+    }
+  }
+  BOOST_CHECK_EQUAL(n_reused, 4u);   // every line but the first of each reader
+}
+
 BOOST_AUTO_TEST_CASE( synced_variant_reader_move_test ) {
   for (const auto input_files : {synced_variant_vcf_inputs, synced_variant_bcf_inputs}) {
     auto reader0 = SyncedVariantReader<SyncedVariantIterator>{input_files, synced_variant_chrom_full};
@@ -0,0 +1,127 @@
+#include "variant/variant_reader.h"
+#include "missing.h"
+#include "utils/utils.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+using namespace gamgee;
+
+const auto typed_field_inputs = vector<string>{"testdata/test_variants.vcf", "testdata/test_variants.bcf", "testdata/test_variants_missing_data.vcf"};
+
+// compares every raw value of a typed field with the converted values of the IndividualField API
+template<class FIELD>
+void check_typed_individual_field(const FIELD& typed, const Variant& record, const string& tag) {
+  using traits = typename FIELD::traits;
+  const auto integers = record.individual_field_as_integer(tag);
+  const auto floats = record.individual_field_as_float(tag);
+  BOOST_REQUIRE_EQUAL(typed.n_samples(), floats.n_samples());
+  for (auto sample = 0u; sample < typed.n_samples(); ++sample) {
+    const auto values = typed[sample];
+    BOOST_REQUIRE_EQUAL(values.size(), floats[sample].size());
+    auto n_values = 0u;
+    for (auto index = 0u; index < values.size(); ++index) {
+      const auto value = typed.value(sample, index);
+      BOOST_CHECK(utils::bcf_check_equal_element(value, values[index]));
+      if (is_integral<typename FIELD::value_type>::value)
+        BOOST_CHECK_EQUAL(traits::to_integer(value), integers[sample][index]);
+      BOOST_CHECK(utils::bcf_check_equal_element(traits::to_float(value), floats[sample][index]));
+      n_values += n_values == index && !traits::is_vector_end(value);
+    }
+    BOOST_CHECK_EQUAL(values.n_values(), n_values);
+    BOOST_CHECK_EQUAL(values.missing(), floats[sample].missing());
+  }
+}
+
+BOOST_AUTO_TEST_CASE( typed_individual_fields_against_individual_fields ) {
+  auto widths = set<size_t>{};
+  for (const auto& filename : typed_field_inputs) {
+    for (const auto& record : SingleVariantReader{filename}) {
+      for (const auto& tag : {"GQ", "PL", "AF", "VLINT", "VLFLOAT", "AD", "DP"}) {
+        const auto present = record.visit_individual_field(tag, [&](const auto& field) {
+          if (!field.empty()) {
+            widths.insert(sizeof(typename decay_t<decltype(field)>::value_type) + (is_integral<typename decay_t<decltype(field)>::value_type>::value ? 0 : 100));
+            check_typed_individual_field(field, record, tag);
+          }
+          return !field.empty();
+        });
+        BOOST_CHECK_EQUAL(present, !record.individual_field_as_integer(tag).empty());
+      }
+    }
+  }
+  // GQ 650 needs int16, PL 2000000000 needs int32 and the AF are floats
+  BOOST_CHECK(widths.count(1) == 1);
+  BOOST_CHECK(widths.count(2) == 1);
+  BOOST_CHECK(widths.count(4) == 1);
+  BOOST_CHECK(widths.count(104) == 1);
+}
+
+BOOST_AUTO_TEST_CASE( typed_shared_fields_against_shared_fields ) {
+  for (const auto& filename : typed_field_inputs) {
+    for (const auto& record : SingleVariantReader{filename}) {
+      for (const auto& tag : {"AN", "AF", "VLINT", "VLFLOAT", "AC"}) {
+        record.visit_shared_field(tag, [&](const auto& field) {
+          using traits = typename decay_t<decltype(field)>::traits;
+          const auto floats = record.shared_field_as_float(tag);
+          BOOST_REQUIRE_EQUAL(field.size(), floats.size());
+          auto index = 0u;
+          for (const auto value : field) {
+            BOOST_CHECK(utils::bcf_check_equal_element(traits::to_float(value), floats[index]));
+            BOOST_CHECK(utils::bcf_check_equal_element(value, field[index]));
+            ++index;
+          }
+          BOOST_CHECK_EQUAL(field.values().size(), index);
+        });
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( typed_fields_missing_flags_and_strings ) {
+  const auto record = *(SingleVariantReader{"testdata/test_variants.vcf"}.begin());
+  const auto visit_size = [](const auto& field) { return field.empty() ? -1 : int(field.size()); };
+  BOOST_CHECK_EQUAL(record.visit_individual_field("NOT_THERE", visit_size), -1);
+  BOOST_CHECK_EQUAL(record.visit_shared_field("NOT_THERE", visit_size), -1);
+  BOOST_CHECK_EQUAL(record.visit_shared_field("VALIDATED", visit_size), -1);   // flags have no values
+  BOOST_CHECK_EQUAL(record.visit_individual_field("GQ", visit_size), 3);
+  BOOST_CHECK_THROW(record.visit_individual_field("AS", visit_size), invalid_argument);
+  BOOST_CHECK_THROW(record.visit_shared_field("DESC", visit_size), invalid_argument);
+  record.visit_individual_field("GQ", [](const auto& gq) {
+    BOOST_CHECK_THROW(gq[3], out_of_range);
+    BOOST_CHECK_EQUAL(gq.values_per_sample(), 1u);
+  });
+}
+
+BOOST_AUTO_TEST_CASE( typed_field_value_traits ) {
+  BOOST_CHECK(BcfValueTraits<int8_t>::is_missing(bcf_int8_missing));
+  BOOST_CHECK(BcfValueTraits<int8_t>::is_vector_end(bcf_int8_vector_end));
+  BOOST_CHECK(!BcfValueTraits<int8_t>::is_value(bcf_int8_missing));
+  BOOST_CHECK(!BcfValueTraits<int8_t>::is_value(bcf_int8_vector_end));
+  BOOST_CHECK(BcfValueTraits<int8_t>::is_value(-126));
+  BOOST_CHECK_EQUAL(BcfValueTraits<int8_t>::to_integer(bcf_int8_missing), bcf_int32_missing);
+  BOOST_CHECK_EQUAL(BcfValueTraits<int16_t>::to_integer(bcf_int16_vector_end), bcf_int32_vector_end);
+  BOOST_CHECK_EQUAL(BcfValueTraits<int16_t>::to_integer(-300), -300);
+  BOOST_CHECK(missing(BcfValueTraits<int16_t>::to_float(bcf_int16_missing)));
+  BOOST_CHECK(BcfValueTraits<int32_t>::is_missing(bcf_int32_missing));
+  auto missing_float = 0.0f;
+  auto vector_end_float = 0.0f;
+  bcf_float_set_missing(missing_float);
+  bcf_float_set_vector_end(vector_end_float);
+  BOOST_CHECK(BcfValueTraits<float>::is_missing(missing_float));
+  BOOST_CHECK(BcfValueTraits<float>::is_vector_end(vector_end_float));
+  BOOST_CHECK(!BcfValueTraits<float>::is_value(missing_float));
+  BOOST_CHECK(BcfValueTraits<float>::is_value(1.5f));
+  BOOST_CHECK_EQUAL(BcfValueTraits<float>::to_integer(missing_float), bcf_int32_missing);
+  const auto values = vector<int16_t>{3, bcf_int16_missing, bcf_int16_vector_end, bcf_int16_vector_end};
+  const auto typed = TypedFieldValue<int16_t>{values.data(), uint32_t(values.size())};
+  BOOST_CHECK_EQUAL(typed.size(), 4u);
+  BOOST_CHECK_EQUAL(typed.n_values(), 2u);
+  BOOST_CHECK(!typed.missing());
+  BOOST_CHECK(TypedFieldValue<int16_t>(values.data() + 1, 3).missing());
+}
@@ -1785,3 +1785,137 @@ BOOST_AUTO_TEST_CASE( disable_builder_validation ) {
   builder.set_enable_validation(false);
   builder.set_alignment_stop(4).build();
 }
+
+BOOST_AUTO_TEST_CASE( build_into_existing_record ) {
+  auto header = SingleVariantReader{"testdata/test_variants_for_variantbuilder.vcf"}.header();
+  auto builder = VariantBuilder{header};
+  const auto an_index = header.field_index("AN");
+
+  // a missing record gets a new body
+  auto variant = Variant{};
+  builder.set_chromosome(0).set_alignment_start(10).set_ref_allele("A").set_alt_allele("C").set_integer_shared_field(an_index, 4);
+  builder.build_into(variant);
+  BOOST_CHECK_EQUAL(variant.chromosome(), 0u);
+  BOOST_CHECK_EQUAL(variant.alignment_start(), 10u);
+  BOOST_CHECK_EQUAL(variant.ref(), "A");
+  BOOST_CHECK_EQUAL(variant.integer_shared_field("AN")[0], 4);
+
+  // rebuilding replaces every field, including the ones the new record doesn't have
+  const auto an = variant.integer_shared_field("AN");   // refers to the body, which must not be overwritten
+  builder.clear().set_chromosome(2).set_alignment_start(20).set_ref_allele("GATTACA").set_alt_alleles({"G", "GA"});
+  builder.set_genotypes(vector<vector<int32_t>>{{0, 1}, {1, 1}, {0, 0}});
+  builder.build_into(variant);
+  const auto expected = builder.build();
+  BOOST_CHECK_EQUAL(an[0], 4);
+  BOOST_CHECK_EQUAL(variant.chromosome(), expected.chromosome());
+  BOOST_CHECK_EQUAL(variant.alignment_start(), expected.alignment_start());
+  BOOST_CHECK_EQUAL(variant.alignment_stop(), expected.alignment_stop());
+  BOOST_CHECK_EQUAL(variant.ref(), expected.ref());
+  BOOST_CHECK(variant.alt() == expected.alt());
+  BOOST_CHECK(missing(variant.integer_shared_field("AN")));
+  BOOST_CHECK(variant.genotypes()[1] == expected.genotypes()[1]);
+
+  // and again into the same (now unshared) body, with fewer fields
+  builder.clear().set_chromosome(1).set_alignment_start(30).set_ref_allele("T");
+  builder.build_into(variant);
+  BOOST_CHECK_EQUAL(variant.chromosome(), 1u);
+  BOOST_CHECK_EQUAL(variant.alignment_start(), 30u);
+  BOOST_CHECK_EQUAL(variant.ref(), "T");
+  BOOST_CHECK(missing(variant.alt()));
+  BOOST_CHECK(missing(variant.genotypes()));
+
+  // a failed build leaves a record that can still be rebuilt
+  BOOST_CHECK_THROW(builder.clear().set_alignment_start(30).set_ref_allele("T").build_into(variant), logic_error);
+  builder.clear().set_chromosome(1).set_alignment_start(40).set_ref_allele("T").build_into(variant);
+  BOOST_CHECK_EQUAL(variant.alignment_start(), 40u);
+}
+
+BOOST_AUTO_TEST_CASE( set_individual_fields_from_columns ) {
+  auto header = SingleVariantReader{"testdata/test_variants_for_variantbuilder.vcf"}.header();
+  auto builder = VariantBuilder{header};
+
+  // a row per sample, as callers typically hold them: each field is read through the stride
+  struct SampleCall { int32_t alleles[2]; int32_t gq; float af[2]; };
+  const auto calls = vector<SampleCall>{{{0, 1}, 10, {0.5f, 1.5f}}, {{1, -1}, bcf_int32_missing, {2.5f, 3.5f}}, {{2, bcf_int32_vector_end}, 300, {4.5f, 5.5f}}};
+  const auto stride = uint32_t(sizeof(SampleCall) / sizeof(int32_t));
+  const auto pl = vector<int32_t>{0, 70000, 3, bcf_int32_missing, 4, bcf_int32_vector_end, 1, 2, 3};   // contiguous
+  const auto as = string{"abcdefgh"};
+  const auto as_offsets = vector<uint32_t>{0, 3, 3, 8};
+
+  for ( const auto use_indices : {false, true} ) {
+    builder.clear().set_chromosome(0).set_alignment_start(1).set_ref_allele("A").set_alt_alleles({"C", "G"});
+    builder.set_genotypes(VariantBuilderColumn<int32_t>{calls[0].alleles, 2, stride});
+    if ( use_indices ) {
+      builder.set_integer_individual_field(header.field_index("GQ"), VariantBuilderColumn<int32_t>{&calls[0].gq, 1, stride})
+             .set_integer_individual_field(header.field_index("PL"), VariantBuilderColumn<int32_t>{pl.data(), 3})
+             .set_float_individual_field(header.field_index("AF"), VariantBuilderColumn<float>{calls[0].af, 2, stride})
+             .set_string_individual_field(header.field_index("AS"), VariantBuilderStringColumn{as.data(), as_offsets.data()});
+    }
+    else {
+      builder.set_integer_individual_field("GQ", VariantBuilderColumn<int32_t>{&calls[0].gq, 1, stride})
+             .set_integer_individual_field("PL", VariantBuilderColumn<int32_t>{pl.data(), 3})
+             .set_float_individual_field("AF", VariantBuilderColumn<float>{calls[0].af, 2, stride})
+             .set_string_individual_field("AS", VariantBuilderStringColumn{as.data(), as_offsets.data()});
+    }
+    const auto variant = builder.build();
+    check_genotype_field(variant, {{0, 1}, {1, -1}, {2}});
+    check_integer_individual_field(variant, "GQ", {{10}, {bcf_int32_missing}, {300}});
+    check_integer_individual_field(variant, "PL", {{0, 70000, 3}, {bcf_int32_missing, 4, bcf_int32_vector_end}, {1, 2, 3}});
+    check_float_individual_field(variant, "AF", {{0.5f, 1.5f}, {2.5f, 3.5f}, {4.5f, 5.5f}});
+    check_string_individual_field(variant, "AS", {"abc", "", "defgh"});
+  }
+
+  // columns must match the flattened vector setters
+  const auto flat = vector<int32_t>{0, 1, 1, 1, 0, 0};
+  const auto from_column = builder.clear().set_chromosome(0).set_alignment_start(1).set_ref_allele("A").set_genotypes(VariantBuilderColumn<int32_t>{flat.data(), 2}).build();
+  const auto from_vector = builder.clear().set_chromosome(0).set_alignment_start(1).set_ref_allele("A").set_genotypes(vector<vector<int32_t>>{{0, 1}, {1, 1}, {0, 0}}).build();
+  for ( auto sample = 0u; sample < 3u; ++sample ) {
+    BOOST_CHECK(from_column.genotypes()[sample] == from_vector.genotypes()[sample]);
+  }
+
+  // invalid alleles are reported at build time, and invalid layouts when setting
+  const auto invalid = vector<int32_t>{0, 1, -2, 1, 0, 0};
+  builder.clear().set_chromosome(0).set_alignment_start(1).set_ref_allele("A").set_genotypes(VariantBuilderColumn<int32_t>{invalid.data(), 2});
+  BOOST_CHECK_THROW(builder.build(), invalid_argument);
+  BOOST_CHECK_THROW(builder.set_integer_individual_field("GQ", VariantBuilderColumn<int32_t>{flat.data(), 2, 1}), invalid_argument);
+  BOOST_CHECK_THROW(builder.set_integer_individual_field("GQ", VariantBuilderColumn<int32_t>{nullptr, 1}), invalid_argument);
+  BOOST_CHECK_THROW(builder.set_string_individual_field("AS", VariantBuilderStringColumn{as.data(), nullptr}), invalid_argument);
+  BOOST_CHECK_THROW(builder.set_integer_individual_field("GT", VariantBuilderColumn<int32_t>{flat.data(), 2}), invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE( encode_individual_fields_in_parallel ) {
+  auto header = SingleVariantReader{"testdata/test_variants_for_variantbuilder.vcf"}.header();
+  auto builder = VariantBuilder{header};
+  const auto pl = vector<int32_t>{0, 70000, 3, bcf_int32_missing, 4, bcf_int32_vector_end, 1, 2, 3};
+
+  // the same record, serially and on several threads (small as it is, since the minimum size is 0)
+  for ( const auto n_threads : {1u, 2u, 8u} ) {
+    builder.set_encoding_threads(n_threads, 0);
+    builder.clear().set_chromosome(0).set_alignment_start(1).set_ref_allele("A").set_alt_alleles({"C", "G"});
+    builder.set_genotypes(vector<vector<int32_t>>{{0, 1}, {1, -1}, {2}})
+           .set_integer_individual_field("GQ", vector<vector<int32_t>>{{10}, {}, {300}})
+           .set_integer_individual_field("PL", VariantBuilderColumn<int32_t>{pl.data(), 3})
+           .set_float_individual_field("AF", vector<vector<float>>{{0.5f, 1.5f}, {2.5f, 3.5f}, {4.5f, 5.5f}})
+           .set_string_individual_field("AS", vector<string>{"abc", "", "defgh"})
+           .set_string_individual_field("ZSFMT", "NA12891", "z");
+    for ( const auto& variant : {builder.build(), builder.build()} ) {   // the buffers are reused by the second build
+      check_genotype_field(variant, {{0, 1}, {1, -1}, {2}});
+      check_integer_individual_field(variant, "GQ", {{10}, {bcf_int32_missing}, {300}});
+      check_integer_individual_field(variant, "PL", {{0, 70000, 3}, {bcf_int32_missing, 4, bcf_int32_vector_end}, {1, 2, 3}});
+      check_float_individual_field(variant, "AF", {{0.5f, 1.5f}, {2.5f, 3.5f}, {4.5f, 5.5f}});
+      check_string_individual_field(variant, "AS", {"abc", "", "defgh"});
+      check_string_individual_field(variant, "ZSFMT", {"", "z", ""});
+    }
+  }
+
+  // errors of the fields encoded by the other threads reach the caller
+  const auto invalid = vector<int32_t>{0, 1, -2, 1, 0, 0};
+  builder.set_encoding_threads(4, 0);
+  builder.clear().set_chromosome(0).set_alignment_start(1).set_ref_allele("A").set_integer_individual_field("GQ", vector<vector<int32_t>>{{1}, {2}, {3}});
+  builder.set_genotypes(VariantBuilderColumn<int32_t>{invalid.data(), 2});
+  BOOST_CHECK_THROW(builder.build(), invalid_argument);
+
+  // records smaller than the minimum size are still encoded serially
+  builder.set_encoding_threads(4).set_genotypes(vector<vector<int32_t>>{{0, 1}, {1, 1}, {0, 0}});
+  check_genotype_field(builder.build(), {{0, 1}, {1, 1}, {0, 0}});
+}
@@ -1003,6 +1003,47 @@ BOOST_AUTO_TEST_CASE( single_variant_reader_vector_too_large )
   BOOST_CHECK_THROW((SingleVariantReader{vector<string>{"testdata/test_variants.vcf", "testdata/test_variants.vcf"}}), std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE( single_variant_reader_decompression_threads )
+{
+  for (const auto& filename : {"testdata/test_variants.vcf", "testdata/test_variants.bcf", "testdata/test_variants.vcf.gz"}) {
+    auto truth_index = 0u;
+    for (const auto& record : SingleVariantReader{filename, VariantReaderOptions{2}})
+      check_all_apis(record, truth_index++);
+    BOOST_CHECK_EQUAL(truth_index, truth_ref.size());
+  }
+}
+
+BOOST_AUTO_TEST_CASE( single_variant_reader_unpack_levels )
+{
+  for (const auto level : {VariantUnpackLevel::STRINGS, VariantUnpackLevel::FILTERS, VariantUnpackLevel::INFO}) {
+    for (const auto& filename : {"testdata/test_variants.vcf", "testdata/test_variants.bcf", "testdata/test_variants.vcf.gz"}) {
+      auto truth_index = 0u;
+      for (const auto& record : SingleVariantReader{filename, VariantReaderOptions{0, level}}) {
+        BOOST_CHECK_EQUAL(record.chromosome(), truth_chromosome[truth_index]);
+        BOOST_CHECK_EQUAL(record.alignment_start(), truth_alignment_starts[truth_index]);
+        BOOST_CHECK_EQUAL(record.ref(), truth_ref[truth_index]);
+        check_alt_api(record, truth_index);
+        check_filters_api(record, truth_index);       // site fields beyond the level are decoded on demand
+        check_shared_field_api(record, truth_index);
+        BOOST_CHECK_EQUAL(record.n_samples(), 3u);  // the samples are kept, but their data is never decoded
+        BOOST_CHECK(record.genotypes().empty());
+        BOOST_CHECK(record.integer_individual_field("GQ").empty());
+        const auto copy = record;                   // and deep copies don't carry it either
+        BOOST_CHECK_EQUAL(copy.n_samples(), 3u);
+        BOOST_CHECK(copy.genotypes().empty());
+        BOOST_CHECK_EQUAL(copy.ref(), truth_ref[truth_index]);
+        ++truth_index;
+      }
+      BOOST_CHECK_EQUAL(truth_index, truth_ref.size());
+    }
+  }
+  // the default level keeps everything
+  auto truth_index = 0u;
+  for (const auto& record : SingleVariantReader{"testdata/test_variants.bcf", VariantReaderOptions{0, VariantUnpackLevel::ALL}})
+    check_all_apis(record, truth_index++);
+  BOOST_CHECK_EQUAL(truth_index, truth_ref.size());
+}
+
 BOOST_AUTO_TEST_CASE( variant_reader_move_constructor ) {
   auto r0 = SingleVariantReader{"testdata/test_variants.bcf"};
   auto r1 = SingleVariantReader{"testdata/test_variants.bcf"};
@@ -1074,6 +1115,24 @@ BOOST_AUTO_TEST_CASE( multiple_variant_reader_test ) {
   }
 }
 
+BOOST_AUTO_TEST_CASE( multiple_variant_reader_options_test ) {
+  auto truth_index = 0u;
+  const auto filenames = vector<string>{"testdata/test_variants.vcf", "testdata/test_variants.bcf", "testdata/test_variants.vcf.gz"};
+  const auto reader = MultipleVariantReader<MultipleVariantIterator>{filenames, false, VariantReaderOptions{2, VariantUnpackLevel::INFO}};
+  for (const auto& vec : reader) {
+    BOOST_CHECK_EQUAL(vec.size(), truth_file_indices_3x5[truth_index].size());
+    for (const auto& pair : vec) {
+      const auto& record = pair.first;
+      BOOST_CHECK_EQUAL(record.alignment_start(), truth_alignment_starts[truth_index]);
+      check_shared_field_api(record, truth_index);
+      BOOST_CHECK_EQUAL(record.n_samples(), 3u);
+      BOOST_CHECK(record.genotypes().empty());
+    }
+    ++truth_index;
+  }
+  BOOST_CHECK_EQUAL(truth_index, truth_file_indices_3x5.size());
+}
+
 BOOST_AUTO_TEST_CASE( multiple_variant_reader_move_test ) {
   auto reader0 = MultipleVariantReader<MultipleVariantIterator>{{"testdata/test_variants.vcf", "testdata/test_variants.bcf"}, false};;
   auto reader1 = MultipleVariantReader<MultipleVariantIterator>{{"testdata/test_variants.vcf", "testdata/test_variants.bcf"}, false};;
@@ -1145,6 +1204,20 @@ BOOST_AUTO_TEST_CASE( indexed_variant_reader_full_test ) {
   }
 }
 
+BOOST_AUTO_TEST_CASE( indexed_variant_reader_options_test ) {
+  for (const auto& filename : indexed_variant_bcf_inputs) {
+    auto truth_index = 0u;
+    const auto reader = IndexedVariantReader<IndexedVariantIterator>{filename, indexed_variant_chrom_full, VariantReaderOptions{2, VariantUnpackLevel::FILTERS}};
+    for (const auto& record : reader) {
+      BOOST_CHECK_EQUAL(record.alignment_start(), truth_alignment_starts[truth_index]);
+      check_filters_api(record, truth_index);
+      BOOST_CHECK(record.genotypes().empty());
+      ++truth_index;
+    }
+    BOOST_CHECK_EQUAL(truth_index, 5u);
+  }
+}
+
 // SyncedVariantReader / SyncedVariantIterator
 // see also synced_variant_reader_test
 
@@ -128,3 +128,24 @@ BOOST_AUTO_TEST_CASE( test_field_lengths ) {
   BOOST_CHECK_EQUAL(header.field_length("VLINT", BCF_HL_FMT), 0xfffffu);
 }
 
+BOOST_AUTO_TEST_CASE( variant_copy_assignment_reuses_unshared_records ) {
+  auto it = SingleVariantReader{"testdata/test_variants.bcf"}.begin();
+  const auto first = Variant{*it};
+  ++it;
+  const auto second = Variant{*it};
+  BOOST_REQUIRE_NE(first.alignment_start(), second.alignment_start());
+  auto destination = first;
+  const auto* const body = destination.raw_body();
+  destination = second;       // nothing else refers to the record: it is overwritten in place
+  BOOST_CHECK_EQUAL(destination.raw_body(), body);
+  BOOST_CHECK_EQUAL(destination.alignment_start(), second.alignment_start());
+
+  // a field object taken from the record keeps it alive with the values it had, the next assignment allocates
+  const auto genotypes = destination.genotypes();
+  destination = first;
+  BOOST_CHECK_NE(destination.raw_body(), body);
+  BOOST_CHECK_EQUAL(destination.alignment_start(), first.alignment_start());
+  BOOST_REQUIRE_EQUAL(genotypes.size(), second.n_samples());
+  for (auto sample = 0u; sample < genotypes.size(); ++sample)
+    BOOST_CHECK(genotypes[sample] == second.genotypes()[sample]);
+}
@@ -0,0 +1,115 @@
+#include "variant/variant_writer.h"
+#include "variant/variant_reader.h"
+#include "variant/variant_iterator.h"
+#include "variant/indexed_variant_reader.h"
+#include "variant/indexed_variant_iterator.h"
+#include "exceptions.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace gamgee;
+
+using Position = pair<string, uint32_t>;
+
+const auto variant_writer_input = string{"testdata/var_idx/test_variants.bcf"};
+
+vector<Position> written_positions(const string& filename, const vector<string>& intervals = {}) {
+  auto positions = vector<Position>{};
+  if (intervals.empty()) {
+    for (const auto& record : SingleVariantReader{filename})
+      positions.emplace_back(record.chromosome_name(), record.alignment_start());
+  }
+  else {
+    for (const auto& record : IndexedVariantReader<IndexedVariantIterator>{filename, intervals})
+      positions.emplace_back(record.chromosome_name(), record.alignment_start());
+  }
+  return positions;
+}
+
+BOOST_AUTO_TEST_CASE( variant_writer_indexed_output ) {
+  const auto expected = written_positions(variant_writer_input);
+  const auto expected_20 = written_positions(variant_writer_input, {"20"});
+  BOOST_REQUIRE_GT(expected_20.size(), 0u);
+  for (const auto binary : {true, false}) {
+    const auto output = string{binary ? "testdata/var_idx/variant_writer.tmp.bcf" : "testdata/var_idx/variant_writer.tmp.vcf.gz"};
+    const auto index = output + (binary ? ".csi" : ".tbi");
+    for (const auto queue_size : {0u, 1u, 16u}) {
+      {
+        auto reader = SingleVariantReader{variant_writer_input};
+        auto writer = VariantWriter{reader.header(), output, binary, Z_DEFAULT_COMPRESSION, VariantWriterOptions{2, queue_size, true}};
+        auto moved = false;
+        for (const auto& record : reader) {
+          if (moved)
+            writer.add_record(record);
+          else
+            writer.add_record(Variant{record});   // a copy nothing else refers to is handed over
+          moved = !moved;
+        }
+        writer.close();
+      }
+      BOOST_CHECK(written_positions(output) == expected);
+      BOOST_CHECK(written_positions(output, {"20"}) == expected_20);
+      remove(index.c_str());
+      remove(output.c_str());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( variant_writer_unsorted_records ) {
+  const auto output = string{"testdata/var_idx/variant_writer_unsorted.tmp.bcf"};
+  for (const auto queue_size : {0u, 4u}) {
+    auto records = vector<Variant>{};
+    auto reader = SingleVariantReader{variant_writer_input};
+    for (const auto& record : reader)
+      records.push_back(record);
+    BOOST_REQUIRE_GT(records.size(), 2u);
+    auto writer = VariantWriter{reader.header(), output, true, Z_DEFAULT_COMPRESSION, VariantWriterOptions{0, queue_size, true}};
+    // 1:10000000, 20:10001000, 20:10002000 ... 22:10006000
+    writer.add_record(records[2]);
+    BOOST_CHECK_THROW(writer.add_record(records[1]), UnsortedRecordException);   // a position before the previous one
+    writer.add_record(records.back());
+    BOOST_CHECK_THROW(writer.add_record(records[1]), UnsortedRecordException);   // a chromosome that was left
+    writer.close();
+    BOOST_CHECK_EQUAL(written_positions(output).size(), 2u);
+    remove((output + ".csi").c_str());
+    remove(output.c_str());
+  }
+  BOOST_CHECK_THROW(VariantWriter("-", true, Z_DEFAULT_COMPRESSION, VariantWriterOptions{0, 0, true}), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE( variant_writer_site_only_records ) {
+  // records read without their per sample data still have the samples of the header, so they can be written back
+  for (const auto binary : {true, false}) {
+    const auto output = string{binary ? "testdata/var_idx/variant_writer_sites.tmp.bcf" : "testdata/var_idx/variant_writer_sites.tmp.vcf"};
+    auto expected = vector<Position>{};
+    {
+      auto reader = SingleVariantReader{variant_writer_input, VariantReaderOptions{0, VariantUnpackLevel::INFO}};
+      auto writer = VariantWriter{reader.header(), output, binary};
+      for (const auto& record : reader) {
+        BOOST_CHECK_EQUAL(record.n_samples(), reader.header().n_samples());
+        expected.emplace_back(record.chromosome_name(), record.alignment_start());
+        writer.add_record(record);
+      }
+    }
+    auto positions = vector<Position>{};
+    auto reader = SingleVariantReader{output};
+    BOOST_CHECK_EQUAL(reader.header().n_samples(), 3u);
+    for (const auto& record : reader) {
+      positions.emplace_back(record.chromosome_name(), record.alignment_start());
+      if (binary)
+        BOOST_CHECK_EQUAL(record.n_samples(), 3u);
+      BOOST_CHECK(record.genotypes().empty());
+      BOOST_CHECK(record.integer_individual_field("GQ").empty());
+    }
+    BOOST_CHECK(positions == expected);
+    BOOST_CHECK(!positions.empty());
+    remove(output.c_str());
+  }
+}